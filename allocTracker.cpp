@@ -0,0 +1,249 @@
+/* This file is part of NFLdecisionTree. It creates decision trees to classify
+    situations within NFL football games, and displays the plays historically
+    called in those situations given a set of opponents.
+
+    Copyright (C) 2013   Ezra Erb
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 3 as published
+    by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    I'd appreciate a note if you find this program useful or make
+    updates. Please contact me through LinkedIn (my profile also has
+    a link to the code depository)
+*/
+// The entire file compiles to nothing unless tracking is wanted
+#ifdef NFL_ALLOC_TRACKING
+#include<ostream>
+#include<iomanip>
+#include<cstdlib>
+#include<cstddef>
+#include<new>
+#include<atomic>
+#include"allocTracker.h"
+#include"runStats.h"
+
+#ifndef _WIN32
+#include<sys/resource.h>
+#endif
+
+using std::ostream;
+using std::endl;
+using std::setw;
+using std::left;
+using std::right;
+using std::atomic;
+
+// Names of the subsystems for output. Must match the enum in the header
+static const char* SubsystemNames[] = { "other", "loader", "data_store", "index", "tree", "stats" };
+
+static const unsigned short SubsystemCount = sizeof(SubsystemNames) / sizeof(SubsystemNames[0]);
+
+/* Totals per subsystem. Any thread can allocate, so they are atomic. They are zeroed
+    before any code runs, so allocations made during static initialization are safe */
+static atomic<unsigned long long> AllocationCounts[SubsystemCount];
+static atomic<unsigned long long> BytesAllocated[SubsystemCount];
+static atomic<unsigned long long> LiveBytes[SubsystemCount];
+static atomic<unsigned long long> PeakLiveBytes[SubsystemCount];
+static atomic<unsigned long long> TotalLiveBytes;
+static atomic<unsigned long long> TotalPeakLiveBytes;
+
+// Subsystem being charged, per thread. New threads start with 'other'
+static thread_local AllocTracker::Subsystem CurrentSubsystem = AllocTracker::other_memory;
+
+/* Every allocation is preceeded by a header recording its size and subsystem. It is
+    padded to a full alignment unit, so the memory handed out stays properly aligned */
+struct AllocHeader {
+    std::size_t size;
+    AllocTracker::Subsystem subsystem;
+};
+static const std::size_t HeaderSize = 16;
+static_assert(sizeof(AllocHeader) <= HeaderSize, "Allocation header too large");
+static_assert(alignof(std::max_align_t) <= HeaderSize, "Allocation header breaks alignment");
+
+// Raises a peak to a new value if it is higher
+static void updatePeak(atomic<unsigned long long>& peak, unsigned long long value)
+{
+    unsigned long long oldPeak = peak.load(std::memory_order_relaxed);
+    while ((value > oldPeak) &&
+           (!peak.compare_exchange_weak(oldPeak, value, std::memory_order_relaxed)))
+        ; // Failed exchange reloads the old peak, so just try again
+}
+
+unsigned short AllocTracker::getSubsystemCount()
+{
+    return SubsystemCount;
+}
+
+// Name of a subsystem, for output
+const char* AllocTracker::getSubsystemName(Subsystem subsystem)
+{
+    return SubsystemNames[subsystem];
+}
+
+// Subsystem new allocations on this thread are charged to
+AllocTracker::Subsystem AllocTracker::getCurrentSubsystem()
+{
+    return CurrentSubsystem;
+}
+
+void AllocTracker::setCurrentSubsystem(Subsystem subsystem)
+{
+    CurrentSubsystem = subsystem;
+}
+
+// Totals for a subsystem
+unsigned long long AllocTracker::getAllocationCount(Subsystem subsystem)
+{
+    return AllocationCounts[subsystem].load(std::memory_order_relaxed);
+}
+
+unsigned long long AllocTracker::getBytesAllocated(Subsystem subsystem)
+{
+    return BytesAllocated[subsystem].load(std::memory_order_relaxed);
+}
+
+unsigned long long AllocTracker::getLiveBytes(Subsystem subsystem)
+{
+    return LiveBytes[subsystem].load(std::memory_order_relaxed);
+}
+
+unsigned long long AllocTracker::getPeakLiveBytes(Subsystem subsystem)
+{
+    return PeakLiveBytes[subsystem].load(std::memory_order_relaxed);
+}
+
+// Most memory live at once for the whole program
+unsigned long long AllocTracker::getPeakLiveBytes()
+{
+    return TotalPeakLiveBytes.load(std::memory_order_relaxed);
+}
+
+// Record an allocation. Called by the allocator only
+void AllocTracker::recordAllocation(Subsystem subsystem, unsigned long long size)
+{
+    AllocationCounts[subsystem].fetch_add(1, std::memory_order_relaxed);
+    BytesAllocated[subsystem].fetch_add(size, std::memory_order_relaxed);
+    updatePeak(PeakLiveBytes[subsystem], LiveBytes[subsystem].fetch_add(size, std::memory_order_relaxed) + size);
+    updatePeak(TotalPeakLiveBytes, TotalLiveBytes.fetch_add(size, std::memory_order_relaxed) + size);
+}
+
+// Record a free. Called by the allocator only
+void AllocTracker::recordFree(Subsystem subsystem, unsigned long long size)
+{
+    LiveBytes[subsystem].fetch_sub(size, std::memory_order_relaxed);
+    TotalLiveBytes.fetch_sub(size, std::memory_order_relaxed);
+}
+
+// Outputs everything collected so far
+void AllocTracker::report(ostream& stream, ReportFormat format)
+{
+    /* Reporting allocates memory itself, which would change the numbers as they are
+        output. Charge it to its own subsystem and copy the numbers first */
+    ALLOC_SCOPE(stats_memory);
+    unsigned long long allocations[SubsystemCount];
+    unsigned long long bytes[SubsystemCount];
+    unsigned long long live[SubsystemCount];
+    unsigned long long peak[SubsystemCount];
+    unsigned long long totalAllocations = 0;
+    unsigned long long totalBytes = 0;
+    unsigned long long totalLive = TotalLiveBytes.load(std::memory_order_relaxed);
+    unsigned long long totalPeak = getPeakLiveBytes();
+    unsigned short index;
+    for (index = 0; index < SubsystemCount; index++) {
+        allocations[index] = getAllocationCount((Subsystem)index);
+        bytes[index] = getBytesAllocated((Subsystem)index);
+        live[index] = getLiveBytes((Subsystem)index);
+        peak[index] = getPeakLiveBytes((Subsystem)index);
+        totalAllocations += allocations[index];
+        totalBytes += bytes[index];
+    }
+
+    /* The operating system's view of the most memory used. It includes code, stacks
+        and allocator overhead, so it is always larger than the tracked peak */
+    long peakResidentKb = 0;
+#ifndef _WIN32
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+        peakResidentKb = usage.ru_maxrss; // Kilobytes on Linux
+#endif
+
+    if (format == json_format) {
+        stream << "{\"subsystems\":[";
+        for (index = 0; index < SubsystemCount; index++) {
+            if (index)
+                stream << ",";
+            stream << "{\"name\":\"" << SubsystemNames[index] << "\",\"allocations\":" << allocations[index]
+                   << ",\"bytes\":" << bytes[index] << ",\"live_bytes\":" << live[index]
+                   << ",\"peak_live_bytes\":" << peak[index] << "}";
+        }
+        stream << "],\"total\":{\"allocations\":" << totalAllocations << ",\"bytes\":" << totalBytes
+               << ",\"live_bytes\":" << totalLive << ",\"peak_live_bytes\":" << totalPeak
+               << "},\"peak_resident_kb\":" << peakResidentKb << "}" << endl;
+    } // JSON output
+    else {
+        stream << left << setw(20) << "Subsystem" << right << setw(14) << "Allocations"
+               << setw(16) << "Bytes" << setw(16) << "Live bytes" << setw(16) << "Peak live" << endl;
+        for (index = 0; index < SubsystemCount; index++)
+            stream << left << setw(20) << SubsystemNames[index] << right << setw(14) << allocations[index]
+                   << setw(16) << bytes[index] << setw(16) << live[index] << setw(16) << peak[index] << endl;
+        stream << left << setw(20) << "total" << right << setw(14) << totalAllocations
+               << setw(16) << totalBytes << setw(16) << totalLive << setw(16) << totalPeak << endl;
+        stream << "Total peak is the most live at once, not the sum of subsystem peaks" << endl;
+        if (peakResidentKb)
+            stream << "Peak resident set " << peakResidentKb << " KB" << endl;
+    } // Table output
+}
+
+/* Replace the global allocator to add the header. The array versions and the other
+    deletes call these by default. Compilers warn unless the sized deletes are replaced
+    along with them, so those and the array delete they need forward to these below.
+    This replaces the byte counting version in runStats.cpp, so it does that job as well */
+void* operator new(std::size_t size)
+{
+#ifdef NFL_RUN_STATS
+    RunStats::addCount(RunStats::bytes_allocated, size);
+#endif
+    void* block = malloc(size + HeaderSize);
+    if (!block)
+        throw std::bad_alloc();
+    AllocHeader* header = (AllocHeader*)block;
+    header->size = size;
+    header->subsystem = CurrentSubsystem;
+    AllocTracker::recordAllocation(header->subsystem, size);
+    return (char*)block + HeaderSize;
+}
+
+void operator delete(void* pointer) noexcept
+{
+    if (!pointer)
+        return;
+    AllocHeader* header = (AllocHeader*)((char*)pointer - HeaderSize);
+    AllocTracker::recordFree(header->subsystem, header->size);
+    free(header);
+}
+
+// The header holds the size, so the one passed is not needed
+void operator delete(void* pointer, std::size_t) noexcept
+{
+    operator delete(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+    operator delete(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept
+{
+    operator delete(pointer);
+}
+#endif
@@ -0,0 +1,112 @@
+/* This file is part of NFLdecisionTree. It creates decision trees to classify
+    situations within NFL football games, and displays the plays historically
+    called in those situations given a set of opponents.
+
+    Copyright (C) 2013   Ezra Erb
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 3 as published
+    by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    I'd appreciate a note if you find this program useful or make
+    updates. Please contact me through LinkedIn (my profile also has
+    a link to the code depository)
+*/
+
+/* This class tracks memory allocations by the part of the program that made them,
+    to find how much memory a run needs and where it goes. It replaces the global
+    allocator, so it sees everything, including allocations inside the standard
+    containers. Each allocation records the subsystem that made it, so freeing it
+    later credits the same subsystem even if different code does the freeing.
+
+    Code marks which subsystem it belongs to with the ALLOC_SCOPE macro at the top
+    of a block. Scopes nest, and allocations outside any scope count as 'other'.
+    Tracking adds a small header and some atomic updates to every allocation, so
+    it is compiled in only when NFL_ALLOC_TRACKING is defined. The macro compiles
+    to nothing otherwise.
+
+    Everything is static, since there is only one allocator */
+
+using std::ostream; // Header deliberately not included, clients should already have it
+
+class AllocTracker {
+public:
+    /* Parts of the program memory is charged to. WARNING: Must be kept in sync
+        with the names in allocTracker.cpp! */
+    enum Subsystem { other_memory, loader_memory, data_store_memory, index_memory,
+                     tree_memory, stats_memory };
+
+    // Report formats
+    enum ReportFormat { table_format, json_format };
+
+    // Number of subsystems, for iterating through them
+    static unsigned short getSubsystemCount();
+
+    // Name of a subsystem, for output
+    static const char* getSubsystemName(Subsystem subsystem);
+
+    // Subsystem new allocations on this thread are charged to
+    static Subsystem getCurrentSubsystem();
+    static void setCurrentSubsystem(Subsystem subsystem);
+
+    // Totals for a subsystem
+    static unsigned long long getAllocationCount(Subsystem subsystem);
+    static unsigned long long getBytesAllocated(Subsystem subsystem);
+    static unsigned long long getLiveBytes(Subsystem subsystem);
+    static unsigned long long getPeakLiveBytes(Subsystem subsystem);
+
+    /* Most memory live at once for the whole program. This is NOT the sum of the
+        subsystem peaks, since they usually happen at different times */
+    static unsigned long long getPeakLiveBytes();
+
+    // Outputs everything collected so far
+    static void report(ostream& stream, ReportFormat format);
+
+    // Record allocations and frees. Called by the allocator only
+    static void recordAllocation(Subsystem subsystem, unsigned long long size);
+    static void recordFree(Subsystem subsystem, unsigned long long size);
+};
+
+// Charges allocations to a subsystem for as long as the object exists
+class AllocScope {
+public:
+    explicit AllocScope(AllocTracker::Subsystem subsystem);
+    ~AllocScope();
+
+private:
+    AllocTracker::Subsystem _previous;
+
+    // Prohibit copying, which would restore the wrong subsystem
+    AllocScope(const AllocScope& other);
+    AllocScope& operator=(const AllocScope& other);
+};
+
+inline AllocScope::AllocScope(AllocTracker::Subsystem subsystem)
+    : _previous(AllocTracker::getCurrentSubsystem())
+{
+    AllocTracker::setCurrentSubsystem(subsystem);
+}
+
+inline AllocScope::~AllocScope()
+{
+    AllocTracker::setCurrentSubsystem(_previous);
+}
+
+/* Instrumentation macro. This is the only thing code being measured should use.
+    TRICKY NOTE: The scope objects need a unique name in case several are in the same
+    block. The double macro is the standard way to paste the line number onto it */
+#ifdef NFL_ALLOC_TRACKING
+#define ALLOC_NAME_HELPER(name, line) name##line
+#define ALLOC_NAME(name, line) ALLOC_NAME_HELPER(name, line)
+#define ALLOC_SCOPE(subsystem) AllocScope ALLOC_NAME(allocScope, __LINE__)(AllocTracker::subsystem)
+#else
+#define ALLOC_SCOPE(subsystem)
+#endif
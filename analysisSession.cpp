@@ -0,0 +1,152 @@
+/* This file is part of NFLdecisionTree. It creates decision trees to classify
+    situations within NFL football games, and displays the plays historically
+    called in those situations given a set of opponents.
+
+    Copyright (C) 2013   Ezra Erb
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 3 as published
+    by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    I'd appreciate a note if you find this program useful or make
+    updates. Please contact me through LinkedIn (my profile also has
+    a link to the code depository)
+*/
+#include<string>
+#include<vector>
+#include<algorithm>
+#include<iterator>
+#include<cstring>
+
+#include"singlePlay.h" // Needed by playIndexSet.h
+#include"playIndexSet.h" // Needed by dataStore.h
+#include"playStats.h" // Needed by dataStore.h
+#include"allocTracker.h" // Needed by dataStore.h
+#include"dataStore.h"
+#include"playLoader.h" // Needed by leagueStore.h
+#include"leagueStore.h"
+#include"analysisSession.h"
+#include"traceLog.h"
+
+using std::string;
+using std::vector;
+using std::find;
+using std::remove;
+using std::merge;
+using std::set_difference;
+using std::back_inserter;
+
+/* Constructor. Selects the plays for a matchup from an attached league store, which
+    must outlast the session */
+AnalysisSession::AnalysisSession(const LeagueStore& league, const string& thisTeam, const string& otherTeam,
+                                 const vector<string>& thisSimiliar, const vector<string>& otherSimiliar)
+    : _league(league), _thisTeam(thisTeam), _otherTeam(otherTeam), _thisSimiliar(thisSimiliar),
+      _otherSimiliar(otherSimiliar), _workingSet()
+{
+    TRACE_SCOPE("session_select", "teams", thisSimiliar.size() + otherSimiliar.size());
+    // The matchup itself is always wanted
+    addPair(_thisTeam, _otherTeam);
+    /* A team listed twice is only wanted once, as with selectPlays(). Teams without plays
+        stay on the lists, since they are output with the tree */
+    string offense;
+    string defense;
+    vector<string>::const_iterator team;
+    for (team = thisSimiliar.begin(); team != thisSimiliar.end(); team++)
+        if ((find(thisSimiliar.begin(), team, *team) == team) && getPair(similiar_to_us, *team, offense, defense))
+            addPair(offense, defense);
+    for (team = otherSimiliar.begin(); team != otherSimiliar.end(); team++)
+        if ((find(otherSimiliar.begin(), team, *team) == team) && getPair(similiar_to_opponent, *team, offense, defense))
+            addPair(offense, defense);
+}
+
+/* Adds a similiar team. Returns false, changing nothing, if it is already on the list
+    or has no plays in the league store */
+bool AnalysisSession::addSimiliar(SimiliarSide side, const string& team)
+{
+    vector<string>& teamList = getList(side);
+    if ((find(teamList.begin(), teamList.end(), team) != teamList.end()) || (!_league.hasTeam(team)))
+        return false;
+    TRACE_SCOPE("session_add", "plays", _workingSet.size());
+    teamList.push_back(team);
+    string offense;
+    string defense;
+    if (getPair(side, team, offense, defense))
+        addPair(offense, defense);
+    return true;
+}
+
+// Removes a similiar team. Returns false if it is not on the list
+bool AnalysisSession::removeSimiliar(SimiliarSide side, const string& team)
+{
+    vector<string>& teamList = getList(side);
+    if (find(teamList.begin(), teamList.end(), team) == teamList.end())
+        return false;
+    TRACE_SCOPE("session_remove", "plays", _workingSet.size());
+    // Listed more than once only if given that way at the start
+    teamList.erase(remove(teamList.begin(), teamList.end(), team), teamList.end());
+    string offense;
+    string defense;
+    if (getPair(side, team, offense, defense))
+        removePair(offense, defense);
+    return true;
+}
+
+// Fills an empty data store with the working set and builds its indexes
+void AnalysisSession::selectPlays(DataStore& dataStore) const
+{
+    _league.insertPlays(_workingSet, dataStore);
+}
+
+/* Returns the pair of teams whose plays a similiar team adds, as offense and defense.
+    Returns false if the team adds nothing, because its plays are always wanted */
+bool AnalysisSession::getPair(SimiliarSide side, const string& team, string& offense, string& defense) const
+{
+    // The rules are the same as PlayLoader::processPlay
+    if (side == similiar_to_us) {
+        offense = team;
+        defense = _otherTeam;
+        // Plays with the wanted team on offense are always wanted
+        return (team != _thisTeam);
+    }
+    else {
+        offense = _thisTeam;
+        defense = team;
+        return (team != _otherTeam);
+    }
+}
+
+// Merges the plays of a pair of teams into the working set
+void AnalysisSession::addPair(const string& offense, const string& defense)
+{
+    vector<unsigned int> pairPlays;
+    _league.findPairPlays(offense, defense, pairPlays);
+    if (pairPlays.empty())
+        return;
+    // Both lists are in load order, so merging keeps the working set in load order
+    vector<unsigned int> newSet;
+    newSet.reserve(_workingSet.size() + pairPlays.size());
+    merge(_workingSet.begin(), _workingSet.end(), pairPlays.begin(), pairPlays.end(), back_inserter(newSet));
+    _workingSet.swap(newSet);
+}
+
+// Takes the plays of a pair of teams out of the working set
+void AnalysisSession::removePair(const string& offense, const string& defense)
+{
+    vector<unsigned int> pairPlays;
+    _league.findPairPlays(offense, defense, pairPlays);
+    if (pairPlays.empty())
+        return;
+    vector<unsigned int> newSet;
+    newSet.reserve(_workingSet.size());
+    set_difference(_workingSet.begin(), _workingSet.end(), pairPlays.begin(), pairPlays.end(),
+                   back_inserter(newSet));
+    _workingSet.swap(newSet);
+}
@@ -0,0 +1,133 @@
+/* This file is part of NFLdecisionTree. It creates decision trees to classify
+    situations within NFL football games, and displays the plays historically
+    called in those situations given a set of opponents.
+
+    Copyright (C) 2013   Ezra Erb
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 3 as published
+    by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    I'd appreciate a note if you find this program useful or make
+    updates. Please contact me through LinkedIn (my profile also has
+    a link to the code depository)
+*/
+
+/* This class holds the plays selected for a matchup while an analyst changes the similiar
+    teams, one at a time, to see how the tree changes. Choosing similiar teams is an art,
+    so it usually takes several tries, and reloading every play for each try wastes nearly
+    all of the time.
+
+    The plays come from a league store, which stays attached for the whole session. The
+    session holds the working set, the numbers of the plays wanted, in load order. Every
+    play in it comes from one pair of teams: the wanted team against the opponent or a team
+    similiar to it, or a team similiar to the wanted team against the opponent. Adding or
+    removing a similiar team only merges in or takes out the plays of its pair, which the
+    league store finds from its team lists without looking at anything else.
+
+    Filling a data store from the working set assigns the pass types of busted pass plays,
+    which depend on every play wanted earlier in the season, so the data store and tree are
+    rebuilt from it after each change. Both take a small fraction of the time needed to
+    load the plays, and the tree is identical to one from a fresh run with the same teams */
+using std::string; // Header deliberately not included, clients should already have it
+using std::vector;
+
+class AnalysisSession {
+public:
+    // The two lists of similiar teams
+    enum SimiliarSide { similiar_to_us, similiar_to_opponent };
+
+    /* Constructor. Selects the plays for a matchup from an attached league store, which
+        must outlast the session */
+    AnalysisSession(const LeagueStore& league, const string& thisTeam, const string& otherTeam,
+                    const vector<string>& thisSimiliar, const vector<string>& otherSimiliar);
+
+    // Use the default destructor
+
+    /* Adds a similiar team. Returns false, changing nothing, if it is already on the list
+        or has no plays in the league store */
+    bool addSimiliar(SimiliarSide side, const string& team);
+
+    // Removes a similiar team. Returns false if it is not on the list
+    bool removeSimiliar(SimiliarSide side, const string& team);
+
+    // Fills an empty data store with the working set and builds its indexes
+    void selectPlays(DataStore& dataStore) const;
+
+    // Teams in the matchup. Similiar teams are in the order added
+    const string& getThisTeam() const;
+    const string& getOtherTeam() const;
+    const vector<string>& getThisSimiliar() const;
+    const vector<string>& getOtherSimiliar() const;
+
+    // Number of plays in the working set
+    unsigned int getPlayCount() const;
+
+private:
+    const LeagueStore& _league;
+    string _thisTeam;
+    string _otherTeam;
+    vector<string> _thisSimiliar;
+    vector<string> _otherSimiliar;
+
+    // Numbers of the plays wanted, in load order
+    vector<unsigned int> _workingSet;
+
+    /* Returns the pair of teams whose plays a similiar team adds, as offense and defense.
+        Returns false if the team adds nothing, because its plays are always wanted */
+    bool getPair(SimiliarSide side, const string& team, string& offense, string& defense) const;
+
+    // Merges the plays of a pair of teams into the working set
+    void addPair(const string& offense, const string& defense);
+
+    // Takes the plays of a pair of teams out of the working set
+    void removePair(const string& offense, const string& defense);
+
+    // Returns the list of similiar teams for a side
+    vector<string>& getList(SimiliarSide side);
+
+    // Prohibit copying; the working set is large and there is no need for it
+    AnalysisSession(const AnalysisSession& other);
+    AnalysisSession& operator=(const AnalysisSession& other);
+};
+
+// Teams in the matchup. Similiar teams are in the order added
+inline const string& AnalysisSession::getThisTeam() const
+{
+    return _thisTeam;
+}
+
+inline const string& AnalysisSession::getOtherTeam() const
+{
+    return _otherTeam;
+}
+
+inline const vector<string>& AnalysisSession::getThisSimiliar() const
+{
+    return _thisSimiliar;
+}
+
+inline const vector<string>& AnalysisSession::getOtherSimiliar() const
+{
+    return _otherSimiliar;
+}
+
+// Number of plays in the working set
+inline unsigned int AnalysisSession::getPlayCount() const
+{
+    return (unsigned int)_workingSet.size();
+}
+
+// Returns the list of similiar teams for a side
+inline vector<string>& AnalysisSession::getList(SimiliarSide side)
+{
+    return (side == similiar_to_us) ? _thisSimiliar : _otherSimiliar;
+}
@@ -0,0 +1,127 @@
+/* This file is part of NFLdecisionTree. It creates decision trees to classify
+    situations within NFL football games, and displays the plays historically
+    called in those situations given a set of opponents.
+
+    Copyright (C) 2013   Ezra Erb
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 3 as published
+    by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    I'd appreciate a note if you find this program useful or make
+    updates. Please contact me through LinkedIn (my profile also has
+    a link to the code depository)
+*/
+#include<iostream>
+#include<string>
+#include<vector>
+#include<cstring>
+#include<unistd.h>
+#include<sys/types.h>
+#include<sys/wait.h>
+#include<sys/resource.h>
+#include"baseException.h"
+#include"childProcess.h"
+
+using std::cout;
+using std::string;
+using std::vector;
+using std::exception;
+
+// Longest error message passed back from the child
+static const unsigned int MaxErrorSize = 200;
+
+ChildTask::~ChildTask()
+{
+    // Nothing to do, but needed to delete through the base class
+}
+
+// Reads exactly the given number of bytes from a pipe. Returns false if it closes early
+static bool readFully(int handle, char* buffer, unsigned int size)
+{
+    unsigned int total = 0;
+    while (total < size) {
+        ssize_t received = read(handle, buffer + total, size - total);
+        if (received <= 0)
+            return false;
+        total += received;
+    }
+    return true;
+}
+
+// Writes exactly the given number of bytes to a pipe
+static bool writeFully(int handle, const char* buffer, unsigned int size)
+{
+    unsigned int total = 0;
+    while (total < size) {
+        ssize_t written = write(handle, buffer + total, size - total);
+        if (written <= 0)
+            return false;
+        total += written;
+    }
+    return true;
+}
+
+// Runs a task in a child process and waits for it
+bool ChildProcess::run(ChildTask& task, void* results, unsigned int resultSize, long& peakResidentKb,
+                       string& errorMessage)
+{
+    peakResidentKb = 0;
+    errorMessage.clear();
+    int pipeHandles[2];
+    if (pipe(pipeHandles) != 0)
+        throw BaseException(__FILE__, __LINE__, "Could not create pipe to benchmark child");
+    cout.flush(); // Otherwise the child inherits and repeats anything buffered
+    pid_t child = fork();
+    if (child < 0)
+        throw BaseException(__FILE__, __LINE__, "Could not create benchmark child process");
+
+    /* The child sends a flag for success, then either the results or an error message.
+        Both are fixed size, so the parent knows how much to read */
+    if (child == 0) {
+        close(pipeHandles[0]);
+        vector<char> buffer(resultSize > MaxErrorSize ? resultSize : MaxErrorSize, 0);
+        char succeeded = 1;
+        try {
+            task.run(&buffer[0]);
+        }
+        catch (exception& e) {
+            succeeded = 0;
+            buffer.assign(buffer.size(), 0);
+            strncpy(&buffer[0], e.what(), MaxErrorSize - 1);
+        }
+        bool sent = writeFully(pipeHandles[1], &succeeded, 1) &&
+            writeFully(pipeHandles[1], &buffer[0], succeeded ? resultSize : MaxErrorSize);
+        close(pipeHandles[1]);
+        // Skip destructors and exit handlers, which belong to the parent
+        _exit(sent ? 0 : 1);
+    } // Child process
+
+    close(pipeHandles[1]);
+    char succeeded = 0;
+    bool received = readFully(pipeHandles[0], &succeeded, 1);
+    if (received) {
+        if (succeeded)
+            received = readFully(pipeHandles[0], (char*)results, resultSize);
+        else {
+            vector<char> message(MaxErrorSize, 0);
+            if (readFully(pipeHandles[0], &message[0], MaxErrorSize))
+                errorMessage = string(&message[0]);
+        }
+    }
+    close(pipeHandles[0]);
+    int status = 0;
+    struct rusage usage;
+    if (wait4(child, &status, 0, &usage) != child)
+        return false;
+    peakResidentKb = usage.ru_maxrss; // Kilobytes on Linux
+    return received && succeeded && WIFEXITED(status) && (WEXITSTATUS(status) == 0);
+}
@@ -0,0 +1,51 @@
+/* This file is part of NFLdecisionTree. It creates decision trees to classify
+    situations within NFL football games, and displays the plays historically
+    called in those situations given a set of opponents.
+
+    Copyright (C) 2013   Ezra Erb
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 3 as published
+    by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    I'd appreciate a note if you find this program useful or make
+    updates. Please contact me through LinkedIn (my profile also has
+    a link to the code depository)
+*/
+
+/* Runs benchmark work in a child process. Peak memory can only be measured for a
+    whole process, and a process's peak never goes down, so every measurement that
+    includes memory needs a fresh process. The work is described by a subclass of
+    ChildTask, whose run() fills in a fixed size block of results in the child. The
+    block is copied back to the parent through a pipe, so it must not contain
+    pointers.
+
+    NOTE: This uses fork(), so it only builds on POSIX systems */
+
+using std::string; // Header deliberately not included, clients should already have it
+
+class ChildTask {
+public:
+    virtual ~ChildTask();
+
+    /* Does the work and fills in the results. Runs in the child. Exceptions are
+        caught and reported as a failure */
+    virtual void run(void* results) = 0;
+};
+
+class ChildProcess {
+public:
+    /* Runs a task in a child process and waits for it. Returns false if the child
+        failed, with the reason in errorMessage if known. Peak resident memory of the
+        child comes back in kilobytes */
+    static bool run(ChildTask& task, void* results, unsigned int resultSize, long& peakResidentKb,
+                    string& errorMessage);
+};
@@ -0,0 +1,345 @@
+/* This file is part of NFLdecisionTree. It creates decision trees to classify
+    situations within NFL football games, and displays the plays historically
+    called in those situations given a set of opponents.
+
+    Copyright (C) 2013   Ezra Erb
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 3 as published
+    by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    I'd appreciate a note if you find this program useful or make
+    updates. Please contact me through LinkedIn (my profile also has
+    a link to the code depository)
+*/
+
+/* Compares the split criteria on speed and accuracy with k-fold cross validation. Run it as
+        criterionBenchmark DATA_DIRECTORY [FOLDS] [RUNS] [--seasons FIRST LAST]
+                           [--binary-splits] [--json]
+    The plays are those for the result.txt matchup, from real data or data written by
+    generatePlays. Each play goes in one of FOLDS folds (default 5) by its load order. For
+    each criterion and fold, a tree is built and pruned from the other folds RUNS times
+    (default 5), and every play of the fold is then looked up in it.
+
+    For each criterion, it reports:
+    - Build time: building and pruning one tree, in milliseconds (median and 90th percentile)
+    - Accuracy: how often the most common play type of the leaf found is the one called
+    - Probability: the average share of the leaf's plays with the type called, which
+      rewards a tree for being confident only when it is right
+    - Unseen: how often the leaf has no plays of the type called at all
+    A criterion that builds faster with the same accuracy is a straight win. */
+#include<iostream>
+#include<string>
+#include<vector>
+#include<map>
+#include<chrono>
+#include<cstdlib>
+#include"baseException.h"
+#include"singlePlay.h"
+#include"playIndexSet.h"
+#include"playStats.h"
+#include"allocTracker.h"
+#include"dataStore.h"
+#include"playLoader.h"
+#include"decisionNode.h"
+#include"sampleStats.h"
+
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+using std::map;
+using std::exception;
+
+// Returns the current time in seconds, for timing builds
+static double getTime()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/* Plays only hold the category of each situation value, not the value itself. These
+    return a value in the middle of each category, which is all the tree looks at */
+static short getDistanceValue(SinglePlay::DistanceNeeded distanceNeeded)
+{
+    switch (distanceNeeded) {
+    case SinglePlay::one_or_less:
+        return 1;
+    case SinglePlay::four_to_one:
+        return 3;
+    case SinglePlay::ten_to_four:
+        return 7;
+    case SinglePlay::twenty_to_ten:
+        return 15;
+    default:
+        return 25;
+    }
+}
+
+static short getYardLineValue(SinglePlay::FieldLocation fieldLocation)
+{
+    switch (fieldLocation) {
+    case SinglePlay::own_red_zone:
+        return 95;
+    case SinglePlay::opp_red_zone:
+        return 5;
+    default:
+        return 50;
+    }
+}
+
+static short getMinutesValue(SinglePlay::TimeRemaining timeRemaining)
+{
+    return (timeRemaining == SinglePlay::inside_two_minutes) ? 1 : 45;
+}
+
+// Returns the own score for a score differential. The opposing score is always zero
+static short getScoreValue(SinglePlay::ScoreDifferential scoreDifferential)
+{
+    switch (scoreDifferential) {
+    case SinglePlay::down_over_fourteen:
+        return -21;
+    case SinglePlay::down_over_seven:
+        return -10;
+    case SinglePlay::down_seven_less:
+        return -3;
+    case SinglePlay::even:
+        return 0;
+    case SinglePlay::up_seven_less:
+        return 3;
+    case SinglePlay::up_over_seven:
+        return 10;
+    default:
+        return 21;
+    }
+}
+
+// Inserts a play into a data store, using the values above
+static void insertPlay(const SinglePlay& play, DataStore& dataStore)
+{
+    dataStore.insertPlay(play.getPlayType(), play.getDown(), getDistanceValue(play.getDistanceNeeded()),
+                         getYardLineValue(play.getFieldLocation()), getMinutesValue(play.getTimeRemaining()),
+                         getScoreValue(play.getScoreDifferential()), 0, play.getDistanceGained(),
+                         play.getTurnedOver());
+}
+
+// Checks that every value above maps back to its own category, so no play moves
+static void checkCategoryValues()
+{
+    bool valid = true;
+    unsigned short category;
+    for (category = 0; category < SinglePlay::getCategoryCount(SinglePlay::distance_needed); category++)
+        if (SinglePlay::distanceToDistanceNeeded(getDistanceValue((SinglePlay::DistanceNeeded)category)) != category)
+            valid = false;
+    for (category = 0; category < SinglePlay::getCategoryCount(SinglePlay::field_location); category++)
+        if (SinglePlay::yardsToFieldLocation(getYardLineValue((SinglePlay::FieldLocation)category)) != category)
+            valid = false;
+    for (category = 0; category < SinglePlay::getCategoryCount(SinglePlay::time_remaining); category++)
+        if (SinglePlay::minutesToTimeRemaining(getMinutesValue((SinglePlay::TimeRemaining)category)) != category)
+            valid = false;
+    for (category = 0; category < SinglePlay::getCategoryCount(SinglePlay::score_differential); category++)
+        if (SinglePlay::scoreToScoreDifferential(getScoreValue((SinglePlay::ScoreDifferential)category), 0) != category)
+            valid = false;
+    if (!valid)
+        throw BaseException(__FILE__, __LINE__, "Category values for criterion benchmark are out of date");
+}
+
+// Results for one criterion
+struct CriterionResult {
+    DecisionNode::SplitCriterion criterion;
+    SampleStats buildTimes; // Milliseconds
+    unsigned long testCount;
+    unsigned long correctCount;
+    unsigned long unseenCount;
+    double probabilityTotal;
+};
+
+// Cross validates one criterion over the plays
+static void crossValidate(const vector<SinglePlay>& plays, unsigned short folds, unsigned int runs,
+                          CriterionResult& result)
+{
+    DecisionNode::setSplitCriterion(result.criterion);
+    result.testCount = 0;
+    result.correctCount = 0;
+    result.unseenCount = 0;
+    result.probabilityTotal = 0.0;
+    unsigned short fold;
+    for (fold = 0; fold < folds; fold++) {
+        DataStore training;
+        vector<SinglePlay>::const_iterator play;
+        unsigned long playIndex;
+        for (play = plays.begin(), playIndex = 0; play != plays.end(); play++, playIndex++)
+            if (playIndex % folds != fold)
+                insertPlay(*play, training);
+        training.buildIndexes();
+
+        // Every run builds the same tree, so the last one is kept for testing
+        DecisionNode* tree = NULL;
+        unsigned int run;
+        for (run = 0; run < runs; run++) {
+            delete tree;
+            tree = NULL;
+            PlayIndexSet indexes(training.getIndexes());
+            double startTime = getTime();
+            tree = new DecisionNode(indexes, training.getPlaySummaryStats());
+            tree->pruneTree();
+            result.buildTimes.add((getTime() - startTime) * 1000.0);
+        } // Loop through runs
+
+        for (play = plays.begin(), playIndex = 0; play != plays.end(); play++, playIndex++) {
+            if (playIndex % folds != fold)
+                continue;
+            const DetailedPlayData& leaf = tree->findPlays(play->getDown(), getDistanceValue(play->getDistanceNeeded()),
+                                                           getYardLineValue(play->getFieldLocation()),
+                                                           getMinutesValue(play->getTimeRemaining()),
+                                                           getScoreValue(play->getScoreDifferential()), 0);
+            long leafTotal = 0;
+            long bestCount = 0;
+            SinglePlay::PlayType bestType = SinglePlay::punt;
+            DetailedPlayData::const_iterator playType;
+            for (playType = leaf.begin(); playType != leaf.end(); playType++) {
+                leafTotal += playType->second.getPlayCount();
+                if (playType->second.getPlayCount() > bestCount) {
+                    bestCount = playType->second.getPlayCount();
+                    bestType = playType->first;
+                }
+            } // Loop through play types of the leaf
+            result.testCount++;
+            if (bestType == play->getPlayType())
+                result.correctCount++;
+            playType = leaf.find(play->getPlayType());
+            if (playType == leaf.end())
+                result.unseenCount++;
+            else if (leafTotal > 0)
+                result.probabilityTotal += (double)playType->second.getPlayCount() / (double)leafTotal;
+        } // Loop through test plays
+        delete tree;
+    } // Loop through folds
+}
+
+// Returns a count as a percentage of the tests
+static double getPercent(unsigned long count, const CriterionResult& result)
+{
+    return (result.testCount == 0) ? 0.0 : (100.0 * (double)count / (double)result.testCount);
+}
+
+int main(int argc, char **argv)
+{
+    vector<string> args;
+    bool wantJson = false;
+    unsigned short firstSeason = 0;
+    unsigned short lastSeason = 0;
+    int argIndex;
+    for (argIndex = 1; argIndex < argc; argIndex++) {
+        string arg(argv[argIndex]);
+        if (arg == string("--json"))
+            wantJson = true;
+        else if (arg == string("--binary-splits"))
+            DecisionNode::setSplitMode(DecisionNode::binary_split);
+        else if ((arg == string("--seasons")) && (argIndex + 2 < argc)) {
+            firstSeason = (unsigned short)atoi(argv[argIndex + 1]);
+            lastSeason = (unsigned short)atoi(argv[argIndex + 2]);
+            argIndex += 2;
+        }
+        else
+            args.push_back(arg);
+    } // Loop through arguments
+    if ((args.size() < 1) || (args.size() > 3) || (firstSeason > lastSeason)) {
+        cout << "Invalid arguments. DATA_DIRECTORY [FOLDS] [RUNS] [--seasons FIRST LAST] [--binary-splits] [--json]" << endl;
+        exit(1);
+    }
+    unsigned short folds = (args.size() > 1) ? (unsigned short)atoi(args[1].c_str()) : 5;
+    unsigned int runs = (args.size() > 2) ? (unsigned int)atoi(args[2].c_str()) : 5;
+    if ((folds < 2) || (runs == 0)) {
+        cout << "Need at least two folds and one run" << endl;
+        exit(1);
+    }
+
+    try {
+        checkCategoryValues();
+        // Same matchup as result.txt
+        vector<string> thisSimiliar;
+        vector<string> otherSimiliar;
+        otherSimiliar.push_back(string("MIA"));
+        otherSimiliar.push_back(string("BUF"));
+        PlayLoader loader(args[0]);
+        DataStore data;
+        if (firstSeason)
+            loader.loadPlays(string("NE"), string("NYJ"), thisSimiliar, otherSimiliar, firstSeason, lastSeason, data);
+        else
+            loader.loadPlays(string("NE"), string("NYJ"), thisSimiliar, otherSimiliar, 3, data);
+
+        // Copy the plays out in load order, which the reference IDs give
+        PlayIndexSet allIndexes(data.getIndexes());
+        if (allIndexes.getIndexesAvailable().empty())
+            throw BaseException(__FILE__, __LINE__, "No plays for criterion benchmark");
+        const CategoryIndex& anyIndex = allIndexes.getIndex(*(allIndexes.getIndexesAvailable().begin()));
+        map<unsigned int, SinglePlay> orderedPlays;
+        CategoryIndex::const_iterator category;
+        PlayIndex::const_iterator playIndex;
+        for (category = anyIndex.begin(); category != anyIndex.end(); category++)
+            for (playIndex = category->begin(); playIndex != category->end(); playIndex++)
+                orderedPlays.insert(std::make_pair((*playIndex)->getRefId(), **playIndex));
+        vector<SinglePlay> plays;
+        map<unsigned int, SinglePlay>::const_iterator orderedPlay;
+        for (orderedPlay = orderedPlays.begin(); orderedPlay != orderedPlays.end(); orderedPlay++)
+            plays.push_back(orderedPlay->second);
+
+        vector<CriterionResult> results(3);
+        results[0].criterion = DecisionNode::gain_ratio_criterion;
+        results[1].criterion = DecisionNode::entropy_criterion;
+        results[2].criterion = DecisionNode::gini_criterion;
+        vector<CriterionResult>::iterator result;
+        for (result = results.begin(); result != results.end(); result++)
+            crossValidate(plays, folds, runs, *result);
+
+        if (wantJson) {
+            cout << "{\"plays\":" << plays.size() << ",\"folds\":" << folds << ",\"runs\":" << runs
+                 << ",\"criteria\":[";
+            for (result = results.begin(); result != results.end(); result++) {
+                if (result != results.begin())
+                    cout << ",";
+                cout << "{\"criterion\":\"" << DecisionNode::getCriterionName(result->criterion)
+                     << "\",\"build_ms\":{";
+                result->buildTimes.outputJson(cout);
+                cout << "},\"accuracy_percent\":" << getPercent(result->correctCount, *result)
+                     << ",\"mean_probability\":"
+                     << ((result->testCount == 0) ? 0.0 : result->probabilityTotal / (double)result->testCount)
+                     << ",\"unseen_percent\":" << getPercent(result->unseenCount, *result) << "}";
+            } // Loop through criteria
+            cout << "]}" << endl;
+        } // JSON output
+        else {
+            cout << plays.size() << " plays, " << folds << " folds, " << runs << " builds per fold" << endl;
+            cout << "Criterion     Build ms (median)       p90    Accuracy %   Probability      Unseen %" << endl;
+            for (result = results.begin(); result != results.end(); result++) {
+                cout.setf(std::ios::left, std::ios::adjustfield);
+                cout.width(14);
+                cout << DecisionNode::getCriterionName(result->criterion);
+                cout.setf(std::ios::right, std::ios::adjustfield);
+                cout.width(17);
+                cout << result->buildTimes.getMedian();
+                cout.width(10);
+                cout << result->buildTimes.getPercentile(90.0);
+                cout.width(14);
+                cout << getPercent(result->correctCount, *result);
+                cout.width(14);
+                cout << ((result->testCount == 0) ? 0.0 : result->probabilityTotal / (double)result->testCount);
+                cout.width(14);
+                cout << getPercent(result->unseenCount, *result) << endl;
+            } // Loop through criteria
+        } // Table output
+    }
+    catch (exception& e) { // Catch by reference so virtual methods work properly
+        cout << "Exception: " << e.what() << " thrown" << endl;
+        exit(1);
+    }
+    return 0;
+}
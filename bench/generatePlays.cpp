@@ -0,0 +1,66 @@
+/* This file is part of NFLdecisionTree. It creates decision trees to classify
+    situations within NFL football games, and displays the plays historically
+    called in those situations given a set of opponents.
+
+    Copyright (C) 2013   Ezra Erb
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 3 as published
+    by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    I'd appreciate a note if you find this program useful or make
+    updates. Please contact me through LinkedIn (my profile also has
+    a link to the code depository)
+*/
+
+/* Writes synthetic play by play files for benchmarking. Run it as
+    generatePlays DIRECTORY [SEASON_COUNT] [TEAM_COUNT] [SEED] [LAST_SEASON]
+    Defaults reproduce the four seasons the loader reads by default (2008 to 2011)
+    for the full league. Fifty seasons of 32 teams is about two million lines */
+#include<iostream>
+#include<string>
+#include<vector>
+#include<cstdlib>
+#include"baseException.h"
+#include"playGenerator.h"
+
+using std::cout;
+using std::endl;
+using std::string;
+using std::exception;
+
+int main(int argc, char **argv)
+{
+    if ((argc < 2) || (argc > 6)) {
+        cout << "Invalid arguments. DIRECTORY [SEASON_COUNT] [TEAM_COUNT] [SEED] [LAST_SEASON]" << endl;
+        exit(1);
+    }
+    string directory(argv[1]);
+    unsigned short seasonCount = (argc > 2) ? (unsigned short)atoi(argv[2]) : 4;
+    unsigned short teamCount = (argc > 3) ? (unsigned short)atoi(argv[3])
+        : (unsigned short)PlayGenerator::MaxTeamCount;
+    unsigned long long seed = (argc > 4) ? strtoull(argv[4], 0, 10) : 2013;
+    unsigned short lastSeason = (argc > 5) ? (unsigned short)atoi(argv[5]) : 2011;
+    if ((seasonCount == 0) || (seasonCount > lastSeason)) {
+        cout << "Invalid season count " << seasonCount << endl;
+        exit(1);
+    }
+
+    try {
+        PlayGenerator generator(seed, teamCount);
+        generator.writeSeasons(directory, lastSeason - seasonCount + 1, lastSeason);
+    }
+    catch (exception& e) { // Catch by reference so virtual methods work properly
+        cout << "Exception: " << e.what() << " thrown" << endl;
+        exit(1);
+    }
+    return 0;
+}
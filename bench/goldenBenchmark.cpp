@@ -0,0 +1,241 @@
+/* This file is part of NFLdecisionTree. It creates decision trees to classify
+    situations within NFL football games, and displays the plays historically
+    called in those situations given a set of opponents.
+
+    Copyright (C) 2013   Ezra Erb
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 3 as published
+    by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    I'd appreciate a note if you find this program useful or make
+    updates. Please contact me through LinkedIn (my profile also has
+    a link to the code depository)
+*/
+
+/* Runs the full program pipeline repeatedly on a fixed data set, checks the tree it
+    produces is byte for byte identical to a known good copy, and summarizes how long
+    it took and how much memory it used. Every optimization should leave the output
+    unchanged, so this checks both speed and correctness in one command. Run it as
+        goldenBenchmark DATA_DIRECTORY GOLDEN_FILE [RUNS] [WARMUP_RUNS] [--json]
+    The teams match the result.txt shipped with the program (NE against NYJ, with MIA
+    and BUF similiar to NYJ). The golden file goldenResult.txt in this directory
+    matches the data written by generatePlays with its default settings.
+
+    Each run happens in its own child process, since peak memory can only be measured
+    for a whole process. Times are measured inside the child so process startup isn't
+    included. Time to first tree covers loading and building the tree; total time adds
+    pruning and output. Warmup runs fill the file cache and are not counted.
+
+    The program exits with status 2 if any run produced different output.
+    NOTE: This uses fork(), so it only builds on POSIX systems */
+#include<iostream>
+#include<fstream>
+#include<sstream>
+#include<string>
+#include<vector>
+#include<chrono>
+#include<cstdlib>
+#include"baseException.h"
+#include"singlePlay.h"
+#include"playIndexSet.h"
+#include"playStats.h"
+#include"allocTracker.h"
+#include"dataStore.h"
+#include"playLoader.h"
+#include"decisionNode.h"
+#include"resultWriter.h"
+#include"sampleStats.h"
+#include"childProcess.h"
+
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+using std::ifstream;
+using std::stringstream;
+using std::exception;
+
+// Result of one run, passed back from the child process
+struct RunResult {
+    bool outputMatches;
+    unsigned int firstDifferentLine; // Lines count from one. Zero if output matches
+    double firstTreeSeconds;
+    double totalSeconds;
+};
+
+// Current time in seconds from some arbitrary starting point
+static double getWallSeconds()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Returns the first line where two strings differ, counting from one. Zero if identical
+static unsigned int findFirstDifferentLine(const string& first, const string& second)
+{
+    if (first == second)
+        return 0;
+    unsigned int line = 1;
+    string::size_type index;
+    for (index = 0; (index < first.size()) && (index < second.size()); index++) {
+        if (first[index] != second[index])
+            return line;
+        if (first[index] == '\n')
+            line++;
+    }
+    // One is a prefix of the other
+    return line;
+}
+
+/* Runs the pipeline exactly as the main program does, and compares the output to
+    the golden copy */
+static void runPipeline(const string& dataDirectory, const string& golden, RunResult& result)
+{
+    double startTime = getWallSeconds();
+    string thisTeam("NE");
+    string otherTeam("NYJ");
+    vector<string> thisSimiliar;
+    vector<string> otherSimiliar;
+    otherSimiliar.push_back(string("MIA"));
+    otherSimiliar.push_back(string("BUF"));
+
+    PlayLoader loader(dataDirectory);
+    DataStore data;
+    loader.loadPlays(thisTeam, otherTeam, thisSimiliar, otherSimiliar, 3, data);
+    PlayIndexSet dataView(data.getIndexes());
+    DecisionNode tree(dataView, data.getPlaySummaryStats());
+    result.firstTreeSeconds = getWallSeconds() - startTime;
+
+    tree.pruneTree();
+    stringstream output;
+    ResultWriter::write(output, thisTeam, otherTeam, thisSimiliar, otherSimiliar, tree);
+    result.totalSeconds = getWallSeconds() - startTime;
+
+    result.firstDifferentLine = findFirstDifferentLine(output.str(), golden);
+    result.outputMatches = (result.firstDifferentLine == 0);
+}
+
+// Runs the pipeline in a child process
+class GoldenTask : public ChildTask {
+public:
+    GoldenTask(const string& dataDirectory, const string& golden)
+        : _dataDirectory(dataDirectory), _golden(golden)
+    {
+    }
+
+    void run(void* results)
+    {
+        runPipeline(_dataDirectory, _golden, *(RunResult*)results);
+    }
+
+private:
+    string _dataDirectory;
+    string _golden;
+};
+
+// Outputs one summary line of the table
+static void outputSummary(const char* name, const SampleStats& stats, double scale)
+{
+    cout << name << "\tmin " << stats.getMin() * scale << "\tmedian " << stats.getMedian() * scale
+         << "\tmean " << stats.getMean() * scale << "\tstddev " << stats.getStdDev() * scale
+         << "\tp90 " << stats.getPercentile(90.0) * scale << "\tmax " << stats.getMax() * scale << endl;
+}
+
+int main(int argc, char **argv)
+{
+    // Strip the only option out first, so the rest are positional
+    vector<string> args;
+    bool wantJson = false;
+    int argIndex;
+    for (argIndex = 1; argIndex < argc; argIndex++) {
+        if (string(argv[argIndex]) == string("--json"))
+            wantJson = true;
+        else
+            args.push_back(string(argv[argIndex]));
+    }
+    if ((args.size() < 2) || (args.size() > 4)) {
+        cout << "Invalid arguments. DATA_DIRECTORY GOLDEN_FILE [RUNS] [WARMUP_RUNS] [--json]" << endl;
+        exit(1);
+    }
+    string dataDirectory(args[0]);
+    unsigned int runCount = (args.size() > 2) ? (unsigned int)atoi(args[2].c_str()) : 10;
+    unsigned int warmupCount = (args.size() > 3) ? (unsigned int)atoi(args[3].c_str()) : 1;
+    if (runCount == 0) {
+        cout << "Invalid run count " << args[2] << endl;
+        exit(1);
+    }
+
+    try {
+        ifstream goldenFile(args[1].c_str(), std::ios::in | std::ios::binary);
+        if (!goldenFile.is_open())
+            throw BaseException(__FILE__, __LINE__, "Could not open golden file");
+        stringstream goldenBuffer;
+        goldenBuffer << goldenFile.rdbuf();
+        string golden(goldenBuffer.str());
+
+        SampleStats firstTreeTimes;
+        SampleStats totalTimes;
+        SampleStats peakResident;
+        unsigned int mismatchCount = 0;
+        unsigned int runIndex;
+        for (runIndex = 0; runIndex < warmupCount + runCount; runIndex++) {
+            RunResult result;
+            long peakResidentKb;
+            string errorMessage;
+            GoldenTask task(dataDirectory, golden);
+            if (!ChildProcess::run(task, &result, sizeof(result), peakResidentKb, errorMessage)) {
+                cout << "Run " << runIndex << " failed";
+                if (!errorMessage.empty())
+                    cout << ": " << errorMessage;
+                cout << endl;
+                exit(1);
+            }
+            // Warmup output is checked too. Wrong is wrong
+            if (!result.outputMatches) {
+                if (!mismatchCount)
+                    cout << "Output differs from golden file starting at line "
+                         << result.firstDifferentLine << endl;
+                mismatchCount++;
+            }
+            if (runIndex < warmupCount)
+                continue;
+            firstTreeTimes.add(result.firstTreeSeconds);
+            totalTimes.add(result.totalSeconds);
+            peakResident.add((double)peakResidentKb);
+        } // Loop through runs
+
+        if (wantJson) {
+            cout << "{\"runs\":" << runCount << ",\"warmup_runs\":" << warmupCount
+                 << ",\"output_matches\":" << (mismatchCount ? "false" : "true")
+                 << ",\"first_tree_seconds\":{";
+            firstTreeTimes.outputJson(cout);
+            cout << "},\"total_seconds\":{";
+            totalTimes.outputJson(cout);
+            cout << "},\"peak_resident_kb\":{";
+            peakResident.outputJson(cout);
+            cout << "}}" << endl;
+        } // JSON output
+        else {
+            cout << runCount << " runs after " << warmupCount << " warmup, output "
+                 << (mismatchCount ? "DIFFERS FROM" : "matches") << " golden file" << endl;
+            outputSummary("First tree ms", firstTreeTimes, 1000.0);
+            outputSummary("Total ms     ", totalTimes, 1000.0);
+            outputSummary("Peak RSS KB  ", peakResident, 1.0);
+        } // Table output
+        if (mismatchCount)
+            exit(2);
+    }
+    catch (exception& e) { // Catch by reference so virtual methods work properly
+        cout << "Exception: " << e.what() << " thrown" << endl;
+        exit(1);
+    }
+    return 0;
+}
@@ -0,0 +1,294 @@
+/* This file is part of NFLdecisionTree. It creates decision trees to classify
+    situations within NFL football games, and displays the plays historically
+    called in those situations given a set of opponents.
+
+    Copyright (C) 2013   Ezra Erb
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 3 as published
+    by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    I'd appreciate a note if you find this program useful or make
+    updates. Please contact me through LinkedIn (my profile also has
+    a link to the code depository)
+*/
+
+/* Measures query latency while the tree being queried is rebuilt and swapped in through
+    a TreePublisher. Run it as
+        hotSwapBenchmark DATA_DIRECTORY [READERS] [ROUNDS] [--json]
+    The data can be real or written by generatePlays, and the plays are those for the same
+    matchup as result.txt.
+
+    Each reader thread calls findPlays over a fixed grid of situations as fast as it can,
+    taking the tree through a ReadGuard for every query, and times batches of queries. The
+    main thread rebuilds and prunes the tree, publishes it, and rests for as long as the
+    build took, for the given number of rounds. Batch times are reported in nanoseconds per
+    query, separately for batches run while a tree was being built and batches run while
+    nothing was. If publishing never holds up readers, the two match closely; on a machine
+    with fewer processors than readers plus one, the building thread takes processor time
+    from the readers, which shows up in both. Batches that span the start or end of a build
+    are dropped. */
+#include<iostream>
+#include<string>
+#include<vector>
+#include<map>
+#include<chrono>
+#include<thread>
+#include<atomic>
+#include<cstdlib>
+#include"baseException.h"
+#include"singlePlay.h"
+#include"playIndexSet.h"
+#include"playStats.h"
+#include"allocTracker.h"
+#include"dataStore.h"
+#include"playLoader.h"
+#include"decisionNode.h"
+#include"treePublisher.h"
+#include"sampleStats.h"
+
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+using std::exception;
+using std::atomic;
+using std::thread;
+
+// Queries timed together. Single queries are too short to time reliably
+static const unsigned int QueriesPerBatch = 256;
+
+/* Results of every query are added here, so the compiler can't decide the work is
+    unused and remove it */
+static atomic<unsigned long> ResultSink(0);
+
+// A situation to look up, in the raw values findPlays takes
+struct Situation {
+    short down;
+    short distanceNeeded;
+    short yardLine;
+    short minutes;
+    short ownScore;
+    short oppScore;
+};
+
+// What one reader thread shares with the main thread
+struct ReaderWork {
+    TreePublisher* publisher;
+    const vector<Situation>* situations;
+    const atomic<bool>* building;
+    const atomic<bool>* stop;
+    vector<double> idleTimes; // Nanoseconds per query, for each batch
+    vector<double> buildingTimes;
+};
+
+// Builds a grid of situations covering every category of every characteristic
+static void buildSituations(vector<Situation>& situations)
+{
+    static const short Distances[] = { 1, 3, 7, 15, 25 };
+    static const short YardLines[] = { 5, 50, 95 };
+    static const short Minutes[] = { 1, 10, 31, 45 };
+    static const short Margins[] = { -21, -10, -3, 0, 3, 10, 21 };
+    short down;
+    unsigned short distance, yardLine, minute, margin;
+    for (down = 1; down <= 4; down++)
+        for (distance = 0; distance < sizeof(Distances) / sizeof(Distances[0]); distance++)
+            for (yardLine = 0; yardLine < sizeof(YardLines) / sizeof(YardLines[0]); yardLine++)
+                for (minute = 0; minute < sizeof(Minutes) / sizeof(Minutes[0]); minute++)
+                    for (margin = 0; margin < sizeof(Margins) / sizeof(Margins[0]); margin++) {
+                        Situation situation;
+                        situation.down = down;
+                        situation.distanceNeeded = Distances[distance];
+                        situation.yardLine = YardLines[yardLine];
+                        situation.minutes = Minutes[minute];
+                        situation.ownScore = 21 + Margins[margin];
+                        situation.oppScore = 21;
+                        situations.push_back(situation);
+                    } // Innermost loop
+}
+
+// Reader thread. Queries in timed batches until told to stop
+static void runReader(ReaderWork* work)
+{
+    unsigned short readerId = work->publisher->registerReader();
+    unsigned long sink = 0;
+    unsigned int position = 0;
+    while (!work->stop->load()) {
+        bool buildingBefore = work->building->load();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        unsigned int query;
+        for (query = 0; query < QueriesPerBatch; query++) {
+            const Situation& situation = (*work->situations)[position];
+            position = (position + 1) % work->situations->size();
+            TreePublisher::ReadGuard guard(*work->publisher, readerId);
+            sink += guard.getTree()->findPlays(situation.down, situation.distanceNeeded, situation.yardLine,
+                                               situation.minutes, situation.ownScore,
+                                               situation.oppScore).size();
+        } // Loop through queries
+        double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        if (work->building->load() != buildingBefore)
+            continue; // Spans a change, so belongs to neither
+        if (buildingBefore)
+            work->buildingTimes.push_back(elapsed / (double)QueriesPerBatch);
+        else
+            work->idleTimes.push_back(elapsed / (double)QueriesPerBatch);
+    } // Loop until stopped
+    work->publisher->unregisterReader(readerId);
+    ResultSink += sink;
+}
+
+// Outputs the batch times for one phase
+static void outputPhase(const string& name, const SampleStats& times, bool wantJson, bool firstOutput)
+{
+    if (wantJson) {
+        if (!firstOutput)
+            cout << ",";
+        cout << "\"" << name << "\":{";
+        times.outputJson(cout);
+        cout << ",\"p99\":" << times.getPercentile(99.0) << "}";
+        return;
+    }
+    cout.width(12);
+    cout << std::left << name << std::right;
+    cout.width(10);
+    cout << times.getCount();
+    cout.width(12);
+    cout << times.getMin();
+    cout.width(12);
+    cout << times.getMedian();
+    cout.width(12);
+    cout << times.getPercentile(90.0);
+    cout.width(12);
+    cout << times.getPercentile(99.0);
+    cout.width(12);
+    cout << times.getMax() << endl;
+}
+
+int main(int argc, char **argv)
+{
+    vector<string> args;
+    bool wantJson = false;
+    int argIndex;
+    for (argIndex = 1; argIndex < argc; argIndex++) {
+        string arg(argv[argIndex]);
+        if (arg == string("--json"))
+            wantJson = true;
+        else
+            args.push_back(arg);
+    } // Loop through arguments
+    if ((args.size() < 1) || (args.size() > 3)) {
+        cout << "Invalid arguments. DATA_DIRECTORY [READERS] [ROUNDS] [--json]" << endl;
+        exit(1);
+    }
+    unsigned int readerCount = (args.size() >= 2) ? (unsigned int)atoi(args[1].c_str()) : 2;
+    unsigned int roundCount = (args.size() >= 3) ? (unsigned int)atoi(args[2].c_str()) : 20;
+    if ((readerCount == 0) || (readerCount > TreePublisher::MaxReaders) || (roundCount == 0)) {
+        cout << "Readers must be 1 to " << TreePublisher::MaxReaders << " and rounds at least 1" << endl;
+        exit(1);
+    }
+
+    try {
+        // Load plays the same way the main program does
+        string thisTeam("NE");
+        string otherTeam("NYJ");
+        vector<string> thisSimiliar;
+        vector<string> otherSimiliar;
+        otherSimiliar.push_back(string("MIA"));
+        otherSimiliar.push_back(string("BUF"));
+        PlayLoader loader(args[0]);
+        DataStore data;
+        loader.loadPlays(thisTeam, otherTeam, thisSimiliar, otherSimiliar, 3, data);
+
+        vector<Situation> situations;
+        buildSituations(situations);
+
+        TreePublisher publisher;
+        {
+            PlayIndexSet indexes(data.getIndexes());
+            DecisionNode* tree = new DecisionNode(indexes, data.getPlaySummaryStats());
+            tree->pruneTree();
+            publisher.publish(tree);
+        }
+
+        atomic<bool> building(false);
+        atomic<bool> stop(false);
+        vector<ReaderWork> work(readerCount);
+        vector<thread> readers;
+        unsigned int readerIndex;
+        for (readerIndex = 0; readerIndex < readerCount; readerIndex++) {
+            work[readerIndex].publisher = &publisher;
+            work[readerIndex].situations = &situations;
+            work[readerIndex].building = &building;
+            work[readerIndex].stop = &stop;
+        }
+        for (readerIndex = 0; readerIndex < readerCount; readerIndex++)
+            readers.push_back(thread(runReader, &work[readerIndex]));
+
+        /* Rebuild and publish. Resting as long as each build took gives the readers about
+            as much idle time as building time to compare against */
+        SampleStats buildTimes;
+        unsigned int round;
+        for (round = 0; round < roundCount; round++) {
+            building.store(true);
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            PlayIndexSet indexes(data.getIndexes());
+            DecisionNode* tree = new DecisionNode(indexes, data.getPlaySummaryStats());
+            tree->pruneTree();
+            publisher.publish(tree);
+            std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now() - start;
+            building.store(false);
+            buildTimes.add(std::chrono::duration<double, std::micro>(elapsed).count());
+            std::this_thread::sleep_for(elapsed);
+        } // Loop through rounds
+        stop.store(true);
+        vector<thread>::iterator readerPtr;
+        for (readerPtr = readers.begin(); readerPtr != readers.end(); readerPtr++)
+            readerPtr->join();
+        publisher.reclaim();
+
+        SampleStats idleTimes;
+        SampleStats buildingTimes;
+        vector<double>::const_iterator timePtr;
+        for (readerIndex = 0; readerIndex < readerCount; readerIndex++) {
+            for (timePtr = work[readerIndex].idleTimes.begin(); timePtr != work[readerIndex].idleTimes.end(); timePtr++)
+                idleTimes.add(*timePtr);
+            for (timePtr = work[readerIndex].buildingTimes.begin();
+                 timePtr != work[readerIndex].buildingTimes.end(); timePtr++)
+                buildingTimes.add(*timePtr);
+        } // Loop through readers
+
+        cout.setf(std::ios::fixed);
+        cout.precision(1);
+        if (wantJson) {
+            cout << "{\"readers\":" << readerCount << ",\"rounds\":" << roundCount
+                 << ",\"queries_per_batch\":" << QueriesPerBatch
+                 << ",\"median_build_us\":" << buildTimes.getMedian()
+                 << ",\"retired_after_run\":" << publisher.getRetiredCount() << ",\"ns_per_query\":{";
+            outputPhase(string("idle"), idleTimes, true, true);
+            outputPhase(string("building"), buildingTimes, true, false);
+            cout << "}}" << endl;
+        }
+        else {
+            cout << readerCount << " readers, " << roundCount << " rebuilds taking a median of "
+                 << buildTimes.getMedian() << " microseconds, " << publisher.getRetiredCount()
+                 << " trees left unreclaimed" << endl;
+            cout << "Nanoseconds per query, over batches of " << QueriesPerBatch << " queries" << endl;
+            cout << "Phase          Batches         Min      Median         p90         p99         Max" << endl;
+            outputPhase(string("idle"), idleTimes, false, true);
+            outputPhase(string("building"), buildingTimes, false, false);
+        }
+    }
+    catch (exception& e) { // Catch by reference so virtual methods work properly
+        cout << "Exception: " << e.what() << " thrown" << endl;
+        exit(1);
+    }
+    return 0;
+}
@@ -0,0 +1,733 @@
+/* This file is part of NFLdecisionTree. It creates decision trees to classify
+    situations within NFL football games, and displays the plays historically
+    called in those situations given a set of opponents.
+
+    Copyright (C) 2013   Ezra Erb
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 3 as published
+    by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    I'd appreciate a note if you find this program useful or make
+    updates. Please contact me through LinkedIn (my profile also has
+    a link to the code depository)
+*/
+
+/* Times the inner loops of the program in isolation, so a slowdown in any one of them
+    shows up without needing a profiler. Run it as
+        kernelBenchmark DATA_DIRECTORY [ITERATIONS] [WARMUP_ITERATIONS] [--season YEAR]
+                        [--kernel NAME] [--json]
+    The data can be real or written by generatePlays. Lines for the parsing kernels come
+    from the season file given (default 2011); everything else uses the plays loaded for
+    the same matchup as result.txt. --kernel runs only kernels whose names start with NAME.
+
+    Each kernel is a class that performs a fixed batch of operations per iteration.
+    Times are reported per operation, in nanoseconds. Kernels that change their input
+    get a fresh copy before every iteration, made outside the timed part.
+
+    Kernels:
+        process_play_TYPE   PlayLoader::processPlay, one kind of line at a time
+        extract_yardage     PlayLoader::extractPlayYardageTurnover
+        split_CHARACTERISTIC PlayIndexSet::splitIndexByCharacteristic on the full index
+        info_gain_ratio     DecisionNode::getSplitScore for every characteristic, with gain ratio
+        info_gain_entropy   Same, with plain information gain
+        info_gain_gini      Same, with the drop in Gini impurity
+        merge_data          PlaySummaryFactory::mergeData of two halves of the plays
+        find_plays          DecisionNode::findPlays for every loaded situation
+        categorize_play     SinglePlay's converters for every loaded situation, one at a time
+        categorize_batch    SinglePlay's column converters for the same situations */
+#include<iostream>
+#include<fstream>
+#include<sstream>
+#include<string>
+#include<vector>
+#include<map>
+#include<chrono>
+#include<cstdlib>
+#include"baseException.h"
+#include"singlePlay.h"
+#include"playIndexSet.h"
+#include"playStats.h"
+#include"allocTracker.h"
+#include"dataStore.h"
+#include"playLoader.h"
+#include"decisionNode.h"
+#include"sampleStats.h"
+
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+using std::map;
+using std::ifstream;
+using std::stringstream;
+using std::exception;
+
+// Most lines of each kind used by the parsing kernels. Keeps iterations short
+static const unsigned int MaxLinesPerKind = 2000;
+
+/* Results of every kernel are added here, so the compiler can't decide the work is
+    unused and remove it */
+static volatile unsigned long ResultSink = 0;
+
+/* The program classes allow this class to call their private methods. It does nothing
+    but pass the calls through, so kernels don't need to be friends themselves */
+class KernelAccess {
+public:
+    static void processPlay(PlayLoader& loader, const string& playString, const string& thisTeam,
+                            const string& otherTeam, const vector<string>& thisSimiliar,
+                            const vector<string>& otherSimiliar, unsigned short& sackCount,
+                            PlayBatch& batch)
+    {
+        loader.processPlay(playString, thisTeam, otherTeam, thisSimiliar, otherSimiliar, sackCount, batch);
+    }
+
+    static bool classifyDescription(PlayLoader& loader, const string& description, unsigned short& sackCount,
+                                    SinglePlay::PlayType& playType, short& distanceGained, bool& turnedOver)
+    {
+        return loader.classifyDescription(description, sackCount, playType, distanceGained, turnedOver);
+    }
+
+    static void extractPlayYardageTurnover(PlayLoader& loader, const string& description,
+                                           short& distanceGained, bool& turnedOver)
+    {
+        loader.extractPlayYardageTurnover(description, 0, distanceGained, turnedOver);
+    }
+
+    static double getSplitScore(DecisionNode::SplitCriterion splitCriterion, const PlayCountMap& plays,
+                                long playTotal, const vector<vector<long> >& splitPlayCounts,
+                                const vector<long>& splitPlayTotals)
+    {
+        return DecisionNode::getSplitScore(splitCriterion, plays, playTotal, splitPlayCounts, splitPlayTotals);
+    }
+};
+
+// A piece of code to time
+class Kernel {
+public:
+    explicit Kernel(const string& name);
+    virtual ~Kernel();
+
+    const string& getName() const;
+
+    // Number of operations one iteration performs. Times are reported per operation
+    virtual unsigned int getOperationCount() const = 0;
+
+    // Untimed preparation before each iteration, for kernels that change their input
+    virtual void prepare();
+
+    // The timed work
+    virtual void run() = 0;
+
+private:
+    string _name;
+};
+
+Kernel::Kernel(const string& name)
+    : _name(name)
+{
+    // All in the initialization list
+}
+
+Kernel::~Kernel()
+{
+    // Nothing to do, but needed to delete through the base class
+}
+
+const string& Kernel::getName() const
+{
+    return _name;
+}
+
+void Kernel::prepare()
+{
+    // Most kernels don't change their input
+}
+
+// A line from a data file, with the teams it is for
+struct PlayLine {
+    string line;
+    string offense;
+    string defense;
+    string description;
+    short down;
+    short distanceNeeded;
+    short yardLine;
+    short minutes;
+    short ownScore;
+    short oppScore;
+};
+
+// Processes one kind of line
+class ProcessPlayKernel : public Kernel {
+public:
+    ProcessPlayKernel(const string& name, const vector<PlayLine>& lines, bool wanted)
+        : Kernel(name), _lines(lines), _wanted(wanted), _loader(string(".")), _batch()
+    {
+    }
+
+    unsigned int getOperationCount() const
+    {
+        return _lines.size();
+    }
+
+    // Plays pile up in the batch, so start with an empty one each time
+    void prepare()
+    {
+        _batch.clear();
+    }
+
+    void run()
+    {
+        /* Wanted lines use their own teams, so they always pass the filter. Unwanted
+            ones use teams that never play */
+        vector<string> noTeams;
+        string noTeam("XXX");
+        unsigned short sackCount = 0;
+        vector<PlayLine>::const_iterator index;
+        for (index = _lines.begin(); index != _lines.end(); index++)
+            KernelAccess::processPlay(_loader, index->line, _wanted ? index->offense : noTeam,
+                                      _wanted ? index->defense : noTeam, noTeams, noTeams,
+                                      sackCount, _batch);
+        ResultSink += sackCount;
+    }
+
+private:
+    vector<PlayLine> _lines;
+    bool _wanted;
+    PlayLoader _loader;
+    PlayBatch _batch;
+};
+
+// Finds yardage in play descriptions
+class ExtractYardageKernel : public Kernel {
+public:
+    explicit ExtractYardageKernel(const vector<string>& descriptions)
+        : Kernel(string("extract_yardage")), _descriptions(descriptions), _loader(string("."))
+    {
+    }
+
+    unsigned int getOperationCount() const
+    {
+        return _descriptions.size();
+    }
+
+    void run()
+    {
+        short distanceGained;
+        bool turnedOver;
+        vector<string>::const_iterator index;
+        for (index = _descriptions.begin(); index != _descriptions.end(); index++) {
+            KernelAccess::extractPlayYardageTurnover(_loader, *index, distanceGained, turnedOver);
+            ResultSink += distanceGained + (turnedOver ? 1 : 0);
+        }
+    }
+
+private:
+    vector<string> _descriptions;
+    PlayLoader _loader;
+};
+
+// Splits the full index on one characteristic
+class SplitIndexKernel : public Kernel {
+public:
+    // Splits per iteration. Each needs its own copy of the index
+    static const unsigned int BatchSize = 20;
+
+    SplitIndexKernel(const string& name, const PlayIndexSet& indexes,
+                     SinglePlay::PlayCharacteristic characteristic)
+        : Kernel(name), _original(indexes), _copies(), _characteristic(characteristic)
+    {
+    }
+
+    unsigned int getOperationCount() const
+    {
+        return BatchSize;
+    }
+
+    void prepare()
+    {
+        _copies.assign(BatchSize, _original);
+    }
+
+    void run()
+    {
+        vector<PlayIndexSet>::iterator index;
+        for (index = _copies.begin(); index != _copies.end(); index++)
+            ResultSink += index->splitIndexByCharacteristic(_characteristic).size();
+    }
+
+private:
+    PlayIndexSet _original;
+    vector<PlayIndexSet> _copies;
+    SinglePlay::PlayCharacteristic _characteristic;
+};
+
+// Inputs to one information gain calculation
+struct InfoGainInput {
+    PlayCountMap plays;
+    long playTotal;
+    vector<vector<long> > splitPlayCounts;
+    vector<long> splitPlayTotals;
+};
+
+// Finds the score of splitting the full index on each characteristic, with one criterion
+class InfoGainKernel : public Kernel {
+public:
+    // Passes over all the characteristics per iteration
+    static const unsigned int BatchSize = 200;
+
+    InfoGainKernel(DecisionNode::SplitCriterion splitCriterion, const string& name,
+                   const vector<InfoGainInput>& inputs)
+        : Kernel(name), _splitCriterion(splitCriterion), _inputs(inputs)
+    {
+    }
+
+    unsigned int getOperationCount() const
+    {
+        return BatchSize * _inputs.size();
+    }
+
+    void run()
+    {
+        double total = 0.0;
+        unsigned int batch;
+        vector<InfoGainInput>::iterator index;
+        for (batch = 0; batch < BatchSize; batch++)
+            for (index = _inputs.begin(); index != _inputs.end(); index++)
+                total += KernelAccess::getSplitScore(_splitCriterion, index->plays, index->playTotal,
+                                                     index->splitPlayCounts, index->splitPlayTotals);
+        ResultSink += (unsigned long)total;
+    }
+
+private:
+    DecisionNode::SplitCriterion _splitCriterion;
+    vector<InfoGainInput> _inputs;
+};
+
+// Merges play statistics
+class MergeDataKernel : public Kernel {
+public:
+    // Merges per iteration. Each needs its own copy of the result
+    static const unsigned int BatchSize = 200;
+
+    /* Both sets of statistics must have their distances in the pool. Merges add to it, so
+        it is put back as it started before each batch */
+    MergeDataKernel(const DetailedPlayData& first, const DetailedPlayData& second, DistancePool& distancePool)
+        : Kernel(string("merge_data")), _first(first), _second(second), _results(),
+          _distancePool(distancePool), _startPool(distancePool)
+    {
+    }
+
+    unsigned int getOperationCount() const
+    {
+        return BatchSize;
+    }
+
+    void prepare()
+    {
+        _results.assign(BatchSize, _first);
+        _distancePool = _startPool;
+    }
+
+    void run()
+    {
+        vector<DetailedPlayData>::iterator index;
+        for (index = _results.begin(); index != _results.end(); index++) {
+            PlaySummaryFactory::mergeData(*index, _second);
+            ResultSink += index->size();
+        }
+    }
+
+private:
+    DetailedPlayData _first;
+    DetailedPlayData _second;
+    vector<DetailedPlayData> _results;
+    DistancePool& _distancePool;
+    DistancePool _startPool; // Copy of the pool before any merges
+};
+
+// Looks up situations in the finished tree
+class FindPlaysKernel : public Kernel {
+public:
+    FindPlaysKernel(const DecisionNode& tree, const vector<PlayLine>& situations)
+        : Kernel(string("find_plays")), _tree(tree), _situations(situations)
+    {
+    }
+
+    unsigned int getOperationCount() const
+    {
+        return _situations.size();
+    }
+
+    void run()
+    {
+        vector<PlayLine>::const_iterator index;
+        for (index = _situations.begin(); index != _situations.end(); index++)
+            ResultSink += _tree.findPlays(index->down, index->distanceNeeded, index->yardLine,
+                                          index->minutes, index->ownScore, index->oppScore).size();
+    }
+
+private:
+    const DecisionNode& _tree;
+    vector<PlayLine> _situations;
+};
+
+// Converts situations to categories one at a time
+class CategorizePlayKernel : public Kernel {
+public:
+    explicit CategorizePlayKernel(const vector<PlayLine>& situations)
+        : Kernel(string("categorize_play")), _situations(situations)
+    {
+    }
+
+    unsigned int getOperationCount() const
+    {
+        return _situations.size();
+    }
+
+    void run()
+    {
+        unsigned long total = 0;
+        vector<PlayLine>::const_iterator index;
+        for (index = _situations.begin(); index != _situations.end(); index++)
+            total += SinglePlay::distanceToDistanceNeeded(index->distanceNeeded) +
+                     SinglePlay::yardsToFieldLocation(index->yardLine) +
+                     SinglePlay::minutesToTimeRemaining(index->minutes) +
+                     SinglePlay::scoreToScoreDifferential(index->ownScore, index->oppScore);
+        ResultSink += total;
+    }
+
+private:
+    vector<PlayLine> _situations;
+};
+
+// Converts the same situations as columns
+class CategorizeBatchKernel : public Kernel {
+public:
+    explicit CategorizeBatchKernel(const vector<PlayLine>& situations)
+        : Kernel(string("categorize_batch")), _distancesNeeded(), _yardLines(), _minutes(), _ownScores(),
+          _oppScores(), _categories(situations.size() * 4 + 1)
+    {
+        vector<PlayLine>::const_iterator index;
+        for (index = situations.begin(); index != situations.end(); index++) {
+            _distancesNeeded.push_back(index->distanceNeeded);
+            _yardLines.push_back(index->yardLine);
+            _minutes.push_back(index->minutes);
+            _ownScores.push_back(index->ownScore);
+            _oppScores.push_back(index->oppScore);
+        }
+    }
+
+    unsigned int getOperationCount() const
+    {
+        return _distancesNeeded.size();
+    }
+
+    void run()
+    {
+        unsigned long count = _distancesNeeded.size();
+        if (!count)
+            return;
+        SinglePlay::categorizeDistances(&_distancesNeeded[0], count, &_categories[0]);
+        SinglePlay::categorizeYardLines(&_yardLines[0], count, &_categories[count]);
+        SinglePlay::categorizeMinutes(&_minutes[0], count, &_categories[count * 2]);
+        SinglePlay::categorizeScores(&_ownScores[0], &_oppScores[0], count, &_categories[count * 3]);
+        ResultSink += _categories[count - 1] + _categories[count * 4 - 1];
+    }
+
+private:
+    vector<short> _distancesNeeded;
+    vector<short> _yardLines;
+    vector<short> _minutes;
+    vector<short> _ownScores;
+    vector<short> _oppScores;
+    vector<unsigned char> _categories;
+};
+
+/* Splits a data file line into fields. Returns false for lines that aren't plays,
+    like the header */
+static bool parseLine(const string& line, PlayLine& result)
+{
+    vector<string> fields;
+    string::size_type start = 0;
+    string::size_type end;
+    while ((end = line.find(',', start)) != string::npos) {
+        fields.push_back(string(line, start, end - start));
+        start = end + 1;
+    }
+    fields.push_back(string(line, start));
+    if ((fields.size() < 13) || (fields[0] == string("gameid")))
+        return false;
+    result.line = line;
+    result.minutes = (short)atoi(fields[2].c_str());
+    result.offense = fields[4];
+    result.defense = fields[5];
+    result.down = fields[6].empty() ? 0 : (short)atoi(fields[6].c_str());
+    result.distanceNeeded = (short)atoi(fields[7].c_str());
+    result.yardLine = (short)atoi(fields[8].c_str());
+    result.description = fields[9];
+    result.ownScore = (short)atoi(fields[10].c_str());
+    result.oppScore = (short)atoi(fields[11].c_str());
+    return true;
+}
+
+// Returns the kind of line, used to group lines for the processPlay kernels
+static string getLineKind(PlayLoader& loader, const PlayLine& line)
+{
+    if (line.down == 0)
+        return string("no_down");
+    unsigned short sackCount = 0;
+    SinglePlay::PlayType playType;
+    short distanceGained;
+    bool turnedOver;
+    if (!KernelAccess::classifyDescription(loader, line.description, sackCount, playType,
+                                           distanceGained, turnedOver))
+        return string("not_a_play");
+    switch (playType) {
+    case SinglePlay::run_left:
+    case SinglePlay::run_middle:
+    case SinglePlay::run_right:
+        return string("run");
+    case SinglePlay::field_goal:
+        return string("field_goal");
+    case SinglePlay::punt:
+        return string("punt");
+    default:
+        return string("pass");
+    }
+}
+
+// Builds the inputs for the information gain kernel exactly as DecisionNode does
+static void buildInfoGainInputs(const PlayIndexSet& indexes, vector<InfoGainInput>& inputs)
+{
+    vector<long> defaultPlayCounts(SinglePlay::getPlayTypeCount(), 0);
+    PlayCharacteristicSet::const_iterator testIndex;
+    for (testIndex = indexes.getIndexesAvailable().begin();
+         testIndex != indexes.getIndexesAvailable().end(); testIndex++) {
+        InfoGainInput input;
+        input.playTotal = 0;
+        const CategoryIndex& splitIndex = indexes.getIndex(*testIndex);
+        CategoryIndex::const_iterator catIndex;
+        PlayIndex::const_iterator playIndex;
+        for (catIndex = splitIndex.begin(); catIndex != splitIndex.end(); catIndex++)
+            if (!catIndex->empty()) {
+                input.splitPlayCounts.push_back(defaultPlayCounts);
+                for (playIndex = catIndex->begin(); playIndex != catIndex->end(); playIndex++) {
+                    input.splitPlayCounts.back().at((unsigned short)((*playIndex)->getPlayType()))++;
+                    input.plays[(*playIndex)->getPlayType()]++;
+                }
+                input.splitPlayTotals.push_back(catIndex->size());
+                input.playTotal += catIndex->size();
+            } // Category has plays
+        // Splits of one category are never calculated
+        if (input.splitPlayTotals.size() > 1)
+            inputs.push_back(input);
+    } // Loop through characteristics
+}
+
+// Times one kernel and outputs the results
+static void timeKernel(Kernel& kernel, unsigned int iterations, unsigned int warmupIterations,
+                       bool wantJson, bool& firstOutput)
+{
+    SampleStats times;
+    unsigned int iteration;
+    for (iteration = 0; iteration < warmupIterations + iterations; iteration++) {
+        kernel.prepare();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        kernel.run();
+        double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        if (iteration >= warmupIterations)
+            times.add(elapsed / (double)kernel.getOperationCount());
+    } // Loop through iterations
+
+    if (wantJson) {
+        if (!firstOutput)
+            cout << ",";
+        cout << "{\"name\":\"" << kernel.getName() << "\",\"operations\":" << kernel.getOperationCount()
+             << ",\"ns_per_operation\":{";
+        times.outputJson(cout);
+        cout << ",\"p99\":" << times.getPercentile(99.0) << "}}";
+    } // JSON output
+    else {
+        cout.width(24);
+        cout << std::left << kernel.getName() << std::right;
+        cout.width(8);
+        cout << kernel.getOperationCount();
+        cout.setf(std::ios::fixed);
+        cout.precision(1);
+        cout.width(12);
+        cout << times.getMin();
+        cout.width(12);
+        cout << times.getMedian();
+        cout.width(12);
+        cout << times.getPercentile(90.0);
+        cout.width(12);
+        cout << times.getPercentile(99.0);
+        cout.width(12);
+        cout << times.getMax() << endl;
+    } // Table output
+    firstOutput = false;
+}
+
+int main(int argc, char **argv)
+{
+    vector<string> args;
+    bool wantJson = false;
+    unsigned short season = 2011;
+    string kernelFilter;
+    int argIndex;
+    for (argIndex = 1; argIndex < argc; argIndex++) {
+        string arg(argv[argIndex]);
+        if (arg == string("--json"))
+            wantJson = true;
+        else if ((arg == string("--season")) && (argIndex + 1 < argc)) {
+            argIndex++;
+            season = (unsigned short)atoi(argv[argIndex]);
+        }
+        else if ((arg == string("--kernel")) && (argIndex + 1 < argc)) {
+            argIndex++;
+            kernelFilter = argv[argIndex];
+        }
+        else
+            args.push_back(arg);
+    } // Loop through arguments
+    if ((args.size() < 1) || (args.size() > 3)) {
+        cout << "Invalid arguments. DATA_DIRECTORY [ITERATIONS] [WARMUP_ITERATIONS] [--season YEAR] "
+             << "[--kernel NAME] [--json]" << endl;
+        exit(1);
+    }
+    string dataDirectory(args[0]);
+    unsigned int iterations = (args.size() > 1) ? (unsigned int)atoi(args[1].c_str()) : 100;
+    unsigned int warmupIterations = (args.size() > 2) ? (unsigned int)atoi(args[2].c_str()) : 10;
+    if (iterations == 0) {
+        cout << "Invalid iteration count " << args[1] << endl;
+        exit(1);
+    }
+
+    vector<Kernel*> kernels;
+    try {
+        // Read the lines for the parsing kernels, grouped by kind
+        stringstream fileName;
+#ifdef _WIN32
+        fileName << dataDirectory << "\\" << season << "_nfl_pbp_data.csv";
+#else
+        fileName << dataDirectory << "/" << season << "_nfl_pbp_data.csv";
+#endif
+        ifstream seasonFile(fileName.str().c_str());
+        if (!seasonFile.is_open())
+            throw BaseException(__FILE__, __LINE__, "Could not open season file for kernel benchmark");
+        PlayLoader loader(dataDirectory);
+        map<string, vector<PlayLine> > linesByKind;
+        vector<PlayLine> unwantedLines;
+        vector<string> yardageDescriptions;
+        string line;
+        while (getline(seasonFile, line)) {
+            PlayLine playLine;
+            if (!parseLine(line, playLine))
+                continue;
+            string kind(getLineKind(loader, playLine));
+            if (linesByKind[kind].size() < MaxLinesPerKind)
+                linesByKind[kind].push_back(playLine);
+            if (unwantedLines.size() < MaxLinesPerKind)
+                unwantedLines.push_back(playLine);
+            if (((kind == string("run")) || (kind == string("pass"))) &&
+                (playLine.description.find(string(" for ")) != string::npos) &&
+                (yardageDescriptions.size() < MaxLinesPerKind))
+                yardageDescriptions.push_back(playLine.description);
+        } // Loop through lines
+        seasonFile.close();
+
+        // Load plays for the remaining kernels, the same way the main program does
+        string thisTeam("NE");
+        string otherTeam("NYJ");
+        vector<string> thisSimiliar;
+        vector<string> otherSimiliar;
+        otherSimiliar.push_back(string("MIA"));
+        otherSimiliar.push_back(string("BUF"));
+        DataStore data;
+        loader.loadPlays(thisTeam, otherTeam, thisSimiliar, otherSimiliar, 3, data);
+        PlayIndexSet fullIndexes(data.getIndexes());
+
+        map<string, vector<PlayLine> >::const_iterator kindIndex;
+        for (kindIndex = linesByKind.begin(); kindIndex != linesByKind.end(); kindIndex++)
+            kernels.push_back(new ProcessPlayKernel(string("process_play_") + kindIndex->first,
+                                                    kindIndex->second, true));
+        kernels.push_back(new ProcessPlayKernel(string("process_play_filtered"), unwantedLines, false));
+        kernels.push_back(new ExtractYardageKernel(yardageDescriptions));
+
+        PlayCharacteristicSet::const_iterator characteristic;
+        for (characteristic = fullIndexes.getIndexesAvailable().begin();
+             characteristic != fullIndexes.getIndexesAvailable().end(); characteristic++) {
+            stringstream name;
+            name << "split_" << *characteristic;
+            kernels.push_back(new SplitIndexKernel(name.str(), fullIndexes, *characteristic));
+        }
+
+        // The tree is needed for finding plays
+        PlayIndexSet treeIndexes(fullIndexes);
+        DecisionNode tree(treeIndexes, data.getPlaySummaryStats());
+        tree.pruneTree();
+        vector<InfoGainInput> infoGainInputs;
+        buildInfoGainInputs(fullIndexes, infoGainInputs);
+        kernels.push_back(new InfoGainKernel(DecisionNode::gain_ratio_criterion, string("info_gain_ratio"),
+                                             infoGainInputs));
+        kernels.push_back(new InfoGainKernel(DecisionNode::entropy_criterion, string("info_gain_entropy"),
+                                             infoGainInputs));
+        kernels.push_back(new InfoGainKernel(DecisionNode::gini_criterion, string("info_gain_gini"),
+                                             infoGainInputs));
+
+        // Merge the statistics for the first down with those of the other downs
+        PlayIndexSet mergeIndexes(fullIndexes);
+        vector<PlayIndexSet> otherDowns(mergeIndexes.splitIndexByCharacteristic(SinglePlay::down_number));
+        if (otherDowns.empty())
+            throw BaseException(__FILE__, __LINE__, "Plays for kernel benchmark are all on one down");
+        DistancePool mergePool;
+        DetailedPlayData firstDown;
+        DetailedPlayData laterDown;
+        PlaySummaryFactory::buildDetailedData(mergeIndexes, data.getPlaySummaryStats(), mergePool, firstDown);
+        PlaySummaryFactory::buildDetailedData(otherDowns.front(), data.getPlaySummaryStats(), mergePool, laterDown);
+        kernels.push_back(new MergeDataKernel(firstDown, laterDown, mergePool));
+
+        // Look up the situation for every wanted play line
+        vector<PlayLine> situations;
+        for (kindIndex = linesByKind.begin(); kindIndex != linesByKind.end(); kindIndex++)
+            if (kindIndex->first != string("no_down"))
+                situations.insert(situations.end(), kindIndex->second.begin(), kindIndex->second.end());
+        kernels.push_back(new FindPlaysKernel(tree, situations));
+        kernels.push_back(new CategorizePlayKernel(situations));
+        kernels.push_back(new CategorizeBatchKernel(situations));
+
+        if (wantJson)
+            cout << "{\"iterations\":" << iterations << ",\"warmup_iterations\":" << warmupIterations
+                 << ",\"kernels\":[";
+        else {
+            cout << iterations << " iterations after " << warmupIterations
+                 << " warmup, nanoseconds per operation" << endl;
+            cout << "Kernel                  Ops/iter         Min      Median         p90         p99         Max" << endl;
+        }
+        bool firstOutput = true;
+        vector<Kernel*>::iterator kernelIndex;
+        for (kernelIndex = kernels.begin(); kernelIndex != kernels.end(); kernelIndex++)
+            if ((*kernelIndex)->getName().compare(0, kernelFilter.size(), kernelFilter) == 0)
+                timeKernel(**kernelIndex, iterations, warmupIterations, wantJson, firstOutput);
+        if (wantJson)
+            cout << "]}" << endl;
+    }
+    catch (exception& e) { // Catch by reference so virtual methods work properly
+        cout << "Exception: " << e.what() << " thrown" << endl;
+        exit(1);
+    }
+    vector<Kernel*>::iterator kernelIndex;
+    for (kernelIndex = kernels.begin(); kernelIndex != kernels.end(); kernelIndex++)
+        delete *kernelIndex;
+    return 0;
+}
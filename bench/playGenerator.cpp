@@ -0,0 +1,708 @@
+/* This file is part of NFLdecisionTree. It creates decision trees to classify
+    situations within NFL football games, and displays the plays historically
+    called in those situations given a set of opponents.
+
+    Copyright (C) 2013   Ezra Erb
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 3 as published
+    by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    I'd appreciate a note if you find this program useful or make
+    updates. Please contact me through LinkedIn (my profile also has
+    a link to the code depository)
+*/
+#include<string>
+#include<vector>
+#include<ostream>
+#include<fstream>
+#include<sstream>
+#include<cerrno>
+#include<cstring>
+#ifdef _WIN32
+#include<direct.h>
+#else
+#include<sys/stat.h>
+#endif
+#include"baseException.h"
+#include"playGenerator.h"
+
+using std::string;
+using std::vector;
+using std::ostream;
+using std::ofstream;
+using std::stringstream;
+using std::endl;
+
+/* Team abbreviations as they appear in the data files. They are listed by division,
+    so consecutive groups of four are divisional rivals */
+static const char* TeamNames[PlayGenerator::MaxTeamCount] = {
+    "BUF", "MIA", "NE", "NYJ", "BAL", "CIN", "CLE", "PIT",
+    "HOU", "IND", "JAC", "TEN", "DEN", "KC", "OAK", "SD",
+    "DAL", "NYG", "PHI", "WAS", "CHI", "DET", "GB", "MIN",
+    "ATL", "CAR", "NO", "TB", "ARI", "SF", "SEA", "STL" };
+
+// Surnames for generated players. Chosen to avoid any words the loader searches for
+static const char* Surnames[] = {
+    "Adams", "Baker", "Brooks", "Carter", "Davis", "Evans", "Foster", "Green",
+    "Harris", "Jackson", "Johnson", "Jones", "King", "Lewis", "Martin", "Moore",
+    "Nelson", "Owens", "Parker", "Reed", "Roberts", "Scott", "Smith", "Taylor",
+    "Thomas", "Turner", "Walker", "Ward", "Washington", "White", "Williams", "Young" };
+static const unsigned short SurnameCount = sizeof(Surnames) / sizeof(Surnames[0]);
+
+// Player positions used to build names
+/* NOTE: Defenders must be last, since callers add an offset to pick between several of them */
+enum PlayerPosition { pos_quarterback, pos_running_back, pos_receiver, pos_tight_end, pos_kicker,
+                      pos_punter, pos_long_snapper, pos_defender };
+
+// Constructor. Takes the seed and the number of teams in the league
+PlayGenerator::PlayGenerator(unsigned long long seed, unsigned short teamCount)
+    : _seed(seed), _state(seed), _teamCount(teamCount), _tendencies()
+{
+    // The schedule pairs teams up each week, so need an even number of them
+    if ((teamCount < 2) || (teamCount > MaxTeamCount) || (teamCount % 2))
+        throw BaseException(__FILE__, __LINE__, "PlayGenerator create failed, team count must be even and at most 32");
+
+    // Tendencies come from their own stream, so they don't depend on which seasons are generated
+    unsigned short team;
+    for (team = 0; team < _teamCount; team++) {
+        TeamTendency tendency;
+        tendency.passPercent = 48 + randomBelow(17);
+        tendency.deepPercent = 12 + randomBelow(14);
+        tendency.leftPercent = 25 + randomBelow(16);
+        tendency.rightPercent = 25 + randomBelow(16);
+        tendency.aggression = 10 + randomBelow(50);
+        _tendencies.push_back(tendency);
+    }
+}
+
+// Returns the abbreviation used for a team in the data files
+const char* PlayGenerator::getTeamName(unsigned short team)
+{
+    if (team >= MaxTeamCount)
+        return "UNKNOWN";
+    return TeamNames[team];
+}
+
+// Writes one file per season into the directory, named as the loader expects
+void PlayGenerator::writeSeasons(const string& directory, unsigned short firstSeason,
+                                 unsigned short lastSeason)
+{
+    // Create the directory if needed. Only the last level is created, like mkdir
+#ifdef _WIN32
+    int result = _mkdir(directory.c_str());
+#else
+    int result = mkdir(directory.c_str(), 0755);
+#endif
+    if ((result != 0) && (errno != EEXIST)) {
+        stringstream errorMessage;
+        errorMessage << "Error, could not create data directory " << directory << ": " << strerror(errno);
+        throw BaseException(__FILE__, __LINE__, errorMessage.str().c_str());
+    }
+
+    unsigned short season;
+    for (season = firstSeason; season <= lastSeason; season++) {
+        // File name and directory conventions must match PlayLoader::openSeasonFile()
+        stringstream fullFileName;
+#ifdef _WIN32
+        fullFileName << directory << "\\";
+#else
+        fullFileName << directory << "/";
+#endif
+        fullFileName << season << "_nfl_pbp_data.csv";
+        ofstream seasonFile(fullFileName.str().c_str());
+        if (!seasonFile.is_open()) {
+            stringstream errorMessage;
+            errorMessage << "Error, could not create data file " << fullFileName.str();
+            throw BaseException(__FILE__, __LINE__, errorMessage.str().c_str());
+        }
+        writeSeason(seasonFile, season);
+        seasonFile.close();
+    } // Loop through seasons
+}
+
+// Writes the plays for a single season, including the header line, to a stream
+void PlayGenerator::writeSeason(ostream& stream, unsigned short season)
+{
+    // Every season gets its own stream of random numbers, derived from the seed
+    _state = _seed ^ ((unsigned long long)season * 0x2545F4914F6CDD1DULL);
+
+    stream << "gameid,qtr,min,sec,off,def,down,togo,ydline,description,offscore,defscore,season" << endl;
+    unsigned short week;
+    for (week = 1; week <= 16; week++)
+        writeWeek(stream, season, week);
+}
+
+// Returns the next raw random value
+unsigned long long PlayGenerator::nextRandom()
+{
+    // SplitMix64. Small, fast, and gives the same values on every platform
+    _state += 0x9E3779B97F4A7C15ULL;
+    unsigned long long result = _state;
+    result = (result ^ (result >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    result = (result ^ (result >> 27)) * 0x94D049BB133111EBULL;
+    return result ^ (result >> 31);
+}
+
+// Returns a random value in [0...limit)
+short PlayGenerator::randomBelow(short limit)
+{
+    if (limit <= 0)
+        return 0;
+    return (short)(nextRandom() % (unsigned long long)limit);
+}
+
+// Generates the games for one week of a season. Teams play divisional rivals twice
+void PlayGenerator::writeWeek(ostream& stream, unsigned short season, unsigned short week)
+{
+    /* The first six weeks are a double round robin within each division of four
+        teams. This ensures the classic matchups show up every season. The rest of
+        the schedule rotates through the league using the circle method. Leagues
+        that can't be divided into divisions use the rotation for every week */
+    if ((_teamCount % 4 == 0) && (week <= 6)) {
+        // Pairings within a division for the three rounds of a round robin
+        static const unsigned short RoundPairs[3][4] = { {0, 1, 2, 3}, {0, 2, 1, 3}, {0, 3, 1, 2} };
+        unsigned short round = (week - 1) % 3;
+        bool secondLeg = (week > 3);
+        unsigned short division;
+        for (division = 0; division < _teamCount / 4; division++) {
+            unsigned short pair;
+            for (pair = 0; pair < 2; pair++) {
+                unsigned short first = division * 4 + RoundPairs[round][pair * 2];
+                unsigned short second = division * 4 + RoundPairs[round][pair * 2 + 1];
+                if (secondLeg)
+                    writeGame(stream, season, week, first, second);
+                else
+                    writeGame(stream, season, week, second, first);
+            }
+        } // Loop through divisions
+    } // Divisional week
+    else {
+        /* Circle method. Team zero stays fixed while the rest rotate. The rotation
+            depends on the season so matchups vary from year to year */
+        unsigned short rotation = (season + week) % (_teamCount - 1);
+        vector<unsigned short> order(_teamCount);
+        order[0] = 0;
+        unsigned short index;
+        for (index = 1; index < _teamCount; index++)
+            order[index] = 1 + ((index - 1 + rotation) % (_teamCount - 1));
+        for (index = 0; index < _teamCount / 2; index++) {
+            unsigned short first = order[index];
+            unsigned short second = order[_teamCount - 1 - index];
+            if ((week + index) % 2)
+                writeGame(stream, season, week, first, second);
+            else
+                writeGame(stream, season, week, second, first);
+        }
+    } // Rotation week
+}
+
+// Simulates one game and writes its plays
+void PlayGenerator::writeGame(ostream& stream, unsigned short season, unsigned short week,
+                              unsigned short home, unsigned short away)
+{
+    /* Game ID is the date followed by the teams, as in the real data. Games are
+        placed on Sundays starting in early September */
+    static const unsigned short MonthLengths[4] = {30, 31, 30, 31};
+    unsigned short month = 9;
+    unsigned short day = 8 + (week - 1) * 7;
+    while ((month < 12) && (day > MonthLengths[month - 9])) {
+        day -= MonthLengths[month - 9];
+        month++;
+    }
+    stringstream gameIdStream;
+    gameIdStream << season << (month < 10 ? "0" : "") << month << (day < 10 ? "0" : "") << day
+                 << "_" << TeamNames[away] << "@" << TeamNames[home];
+    string gameId(gameIdStream.str());
+
+    GameState state;
+    state.home = home;
+    state.away = away;
+    state.homeScore = 0;
+    state.awayScore = 0;
+    state.secondsLeft = 3600;
+    // Home team kicks off to start the game. The away team kicks off the second half
+    state.offense = home;
+    state.defense = away;
+    state.down = 1;
+    state.toGo = 10;
+    state.yardLine = 65;
+    kickoff(stream, gameId, season, state);
+
+    while (state.secondsLeft > 0)
+        writePlay(stream, gameId, season, state);
+}
+
+// Writes the plays for a single snap, updating the game state
+void PlayGenerator::writePlay(ostream& stream, const string& gameId, unsigned short season, GameState& state)
+{
+    const TeamTendency& tendency = _tendencies[state.offense];
+    short scoreDiff = getScore(state, state.offense) - getScore(state, state.defense);
+    bool lateGame = (state.secondsLeft < 300);
+    bool twoMinute = (state.secondsLeft < 120) ||
+                     ((state.secondsLeft >= 1800) && (state.secondsLeft < 1920));
+    string quarterback(playerName(state.offense, pos_quarterback));
+    string tackler(playerName(state.defense, pos_defender + randomBelow(3)));
+    stringstream description;
+
+    /* Penalties and reviews get their own lines in the data and don't use up a down.
+        The loader ignores them */
+    if (randomPercent(4)) {
+        short penaltyYards = randomPercent(60) ? 5 : 10;
+        bool onOffense = randomPercent(55);
+        description << "PENALTY on " << TeamNames[onOffense ? state.offense : state.defense] << "-"
+                    << playerName(onOffense ? state.offense : state.defense, randomBelow(7))
+                    << (onOffense ? " False Start " : " Defensive Offside ") << penaltyYards
+                    << " yards enforced at " << fieldPosition(state, state.yardLine) << " - No Play.";
+        writeLeader(stream, gameId, state, true);
+        stream << description.str() << ",";
+        writeTrailer(stream, season, state);
+        if (onOffense) {
+            state.yardLine += penaltyYards;
+            if (state.yardLine > 99)
+                state.yardLine = 99;
+            state.toGo += penaltyYards;
+        }
+        else {
+            if (penaltyYards >= state.yardLine)
+                penaltyYards = state.yardLine / 2;
+            state.yardLine -= penaltyYards;
+            state.toGo -= penaltyYards;
+            if (state.toGo <= 0) {
+                state.down = 1;
+                state.toGo = (state.yardLine < 10) ? state.yardLine : 10;
+            }
+        }
+        return;
+    } // Penalty
+    if (randomPercent(1)) {
+        writeLeader(stream, gameId, state, true);
+        stream << "The Replay Official reviewed the spot and the play under review was upheld.,";
+        writeTrailer(stream, season, state);
+        return;
+    } // Review
+
+    // Kneel downs run out the clock when leading at the very end of the game
+    if ((state.secondsLeft < 120) && (scoreDiff > 0) && (state.down < 4)) {
+        description << quarterback << " kneels to " << fieldPosition(state, state.yardLine + 1)
+                    << " for -1 yards.";
+        writeLeader(stream, gameId, state, true);
+        stream << description.str() << ",";
+        writeTrailer(stream, season, state);
+        state.yardLine++;
+        state.down++;
+        state.toGo++;
+        runClock(stream, gameId, season, state, 40);
+        return;
+    } // Kneel down
+
+    // Spikes stop the clock in the two minute drill
+    if (twoMinute && (scoreDiff <= 0) && (state.down < 3) && randomPercent(5)) {
+        description << quarterback << " spiked the ball to stop the clock.";
+        writeLeader(stream, gameId, state, true);
+        stream << description.str() << ",";
+        writeTrailer(stream, season, state);
+        state.down++;
+        runClock(stream, gameId, season, state, 3);
+        return;
+    } // Spike
+
+    // Fourth down. Kick unless short yardage and aggressive, or desperate
+    if (state.down == 4) {
+        bool goForIt = ((state.toGo <= 2) && (state.yardLine < 60) && randomPercent(tendency.aggression)) ||
+                       (lateGame && (scoreDiff < 0) && (scoreDiff >= -8 || state.yardLine > 37));
+        if (!goForIt) {
+            string snapper(playerName(state.offense, pos_long_snapper));
+            writeLeader(stream, gameId, state, true);
+            if (state.yardLine <= 37) {
+                string kickerName(playerName(state.offense, pos_kicker));
+                short kickDistance = state.yardLine + 17;
+                if (randomPercent(1)) {
+                    // Bad snap. Loader treats it as a field goal turnover
+                    description << "(Field Goal formation) " << kickerName << " Aborted. "
+                                << snapper << " FUMBLES at " << fieldPosition(state, state.yardLine + 7)
+                                << " recovered by " << TeamNames[state.defense] << "-" << tackler << ".";
+                    stream << description.str() << ",";
+                    writeTrailer(stream, season, state);
+                    changePossession(state, 100 - (state.yardLine + 7));
+                }
+                else if (randomPercent(100 - (kickDistance - 18) * 2)) {
+                    description << kickerName << " " << kickDistance << " yard field goal is GOOD Center-"
+                                << snapper << ".";
+                    stream << description.str() << ",";
+                    writeTrailer(stream, season, state);
+                    addScore(state, state.offense, 3);
+                    kickoff(stream, gameId, season, state);
+                }
+                else {
+                    description << kickerName << " " << kickDistance << " yard field goal is No Good Wide "
+                                << (randomPercent(50) ? "Left" : "Right") << " Center-" << snapper << ".";
+                    stream << description.str() << ",";
+                    writeTrailer(stream, season, state);
+                    changePossession(state, 100 - (state.yardLine + 7));
+                }
+            } // Field goal attempt
+            else {
+                string punterName(playerName(state.offense, pos_punter));
+                if (randomPercent(1)) {
+                    description << punterName << " punt is BLOCKED by " << tackler << " Center-" << snapper
+                                << ". RECOVERED by " << TeamNames[state.defense] << ".";
+                    stream << description.str() << ",";
+                    writeTrailer(stream, season, state);
+                    changePossession(state, 100 - state.yardLine);
+                }
+                else if (randomPercent(1)) {
+                    description << "(Punt formation) " << punterName << " Aborted. " << snapper
+                                << " FUMBLES at " << fieldPosition(state, state.yardLine)
+                                << " recovered by " << TeamNames[state.defense] << "-" << tackler << ".";
+                    stream << description.str() << ",";
+                    writeTrailer(stream, season, state);
+                    changePossession(state, 100 - state.yardLine);
+                }
+                else {
+                    short puntDistance = 35 + randomBelow(21);
+                    bool punted = randomPercent(10); // Older seasons use 'punted'
+                    if (puntDistance >= state.yardLine) {
+                        puntDistance = state.yardLine;
+                        description << punterName << (punted ? " punted " : " punts ") << puntDistance
+                                    << " yards to end zone Center-" << snapper << ". Touchback.";
+                        stream << description.str() << ",";
+                        writeTrailer(stream, season, state);
+                        changePossession(state, 80);
+                    }
+                    else {
+                        short returnYards = randomBelow(12);
+                        short landing = state.yardLine - puntDistance;
+                        if (returnYards > 100 - landing - 1)
+                            returnYards = 0;
+                        description << punterName << (punted ? " punted " : " punts ") << puntDistance
+                                    << " yards to " << fieldPosition(state, landing) << " Center-" << snapper
+                                    << ". " << playerName(state.defense, pos_receiver) << " to "
+                                    << fieldPosition(state, landing + returnYards) << " for " << returnYards
+                                    << " yards (" << playerName(state.offense, pos_defender) << ").";
+                        stream << description.str() << ",";
+                        writeTrailer(stream, season, state);
+                        changePossession(state, 100 - (landing + returnYards));
+                    }
+                }
+            } // Punt
+            runClock(stream, gameId, season, state, 6 + randomBelow(6));
+            return;
+        } // Kicking on fourth down
+    } // Fourth down
+
+    // Run or pass. Long yardage and trailing late both push toward passing
+    short passPercent = tendency.passPercent;
+    if (state.toGo >= 7)
+        passPercent += 20;
+    else if (state.toGo <= 2)
+        passPercent -= 25;
+    if (lateGame && (scoreDiff < 0))
+        passPercent += 30;
+    else if (lateGame && (scoreDiff > 0))
+        passPercent -= 30;
+    if (state.yardLine <= 10)
+        passPercent -= 5;
+    if (state.down == 1)
+        passPercent -= 8;
+
+    short distanceGained = 0;
+    bool turnedOver = false;
+    bool clockStops = false;
+    short direction = randomBelow(100); // Left, middle, or right by tendency
+    const char* directionName = "middle";
+    if (direction < tendency.leftPercent)
+        directionName = "left";
+    else if (direction < tendency.leftPercent + tendency.rightPercent)
+        directionName = "right";
+
+    writeLeader(stream, gameId, state, true);
+    if (randomPercent(passPercent)) {
+        bool deep = randomPercent(tendency.deepPercent + ((state.toGo >= 15) ? 20 : 0));
+        string target(playerName(state.offense, randomPercent(70) ? pos_receiver : pos_tight_end));
+        short outcome = randomBelow(1000);
+        if (twoMinute || (state.toGo >= 7))
+            description << "(Shotgun) ";
+        if (outcome < 60) {
+            // Sacked. Loader spreads these over the pass types
+            distanceGained = -(1 + randomBelow(10));
+            if (distanceGained <= state.yardLine - 100)
+                distanceGained = state.yardLine - 99;
+            description << quarterback << " sacked at " << fieldPosition(state, state.yardLine - distanceGained)
+                        << " " << yardage(distanceGained, false) << " (" << tackler << ").";
+            if (randomPercent(10)) {
+                description << " FUMBLES (" << tackler << ") RECOVERED by " << TeamNames[state.defense]
+                            << "-" << playerName(state.defense, pos_defender) << ".";
+                turnedOver = true;
+            }
+        } // Sack
+        else if (outcome < 67) {
+            // Quarterback drops the snap
+            description << quarterback << " FUMBLES (Aborted) at " << fieldPosition(state, state.yardLine)
+                        << " recovered by " << TeamNames[state.defense] << "-" << tackler << ".";
+            turnedOver = true;
+        } // Aborted pass
+        else {
+            /* Not all descriptions include the depth or direction of the pass. Leave them
+                out occasionally, as in the real data */
+            bool passed = randomPercent(2);
+            description << quarterback << (passed ? " passed " : " pass ");
+            bool incomplete = (outcome < 67 + 360);
+            bool intercepted = (!incomplete) && (outcome < 67 + 360 + 28);
+            if (incomplete)
+                description << "incomplete ";
+            if (deep)
+                description << "deep ";
+            else if (randomPercent(95))
+                description << "short ";
+            if (randomPercent(97))
+                description << directionName << " ";
+            if (incomplete) {
+                description << "to " << target << ".";
+                clockStops = true;
+            }
+            else if (intercepted) {
+                description << "intended for " << target << " INTERCEPTED by " << tackler << " at "
+                            << fieldPosition(state, state.yardLine - 10) << ". " << tackler << " to "
+                            << fieldPosition(state, state.yardLine - 5) << " for 5 yards.";
+                distanceGained = 5;
+                turnedOver = true;
+            }
+            else {
+                if (deep)
+                    distanceGained = 12 + randomBelow(35);
+                else
+                    distanceGained = randomBelow(16) - 2 + (randomPercent(10) ? randomBelow(20) : 0);
+                if (distanceGained > state.yardLine)
+                    distanceGained = state.yardLine;
+                description << "to " << target << " to " << fieldPosition(state, state.yardLine - distanceGained)
+                            << " " << yardage(distanceGained, false) << " (" << tackler << ").";
+                if (randomPercent(1)) {
+                    description << " FUMBLES (" << tackler << ") RECOVERED by " << TeamNames[state.defense]
+                                << "-" << playerName(state.defense, pos_defender) << ".";
+                    turnedOver = true;
+                }
+            }
+        } // Pass thrown
+    } // Pass play
+    else {
+        string runner(playerName(state.offense, randomPercent(85) ? pos_running_back : pos_quarterback));
+        distanceGained = randomBelow(10) - 2 + (randomPercent(8) ? randomBelow(30) : 0);
+        if (distanceGained > state.yardLine)
+            distanceGained = state.yardLine;
+        if (distanceGained <= state.yardLine - 100)
+            distanceGained = state.yardLine - 99;
+        string location(fieldPosition(state, state.yardLine - distanceGained));
+        if (randomPercent(1)) {
+            // Botched handoff
+            description << quarterback << " Aborted. " << runner << " FUMBLES at "
+                        << fieldPosition(state, state.yardLine) << " recovered by "
+                        << TeamNames[state.defense] << "-" << tackler << ".";
+            distanceGained = 0;
+            turnedOver = true;
+        }
+        else if ((distanceGained < 0) && randomPercent(10))
+            // Some negative runs only list the yards lost
+            description << runner << " lost " << -distanceGained << " yards.";
+        else {
+            static const char* Holes[3] = {"end", "guard", "tackle"};
+            short style = randomBelow(100);
+            if (string(directionName) != string("middle"))
+                description << runner << " " << directionName << " " << Holes[randomBelow(3)] << " to "
+                            << location << " " << yardage(distanceGained, true) << " (" << tackler << ").";
+            else if (style < 70)
+                description << runner << " up the middle to " << location << " "
+                            << yardage(distanceGained, true) << " (" << tackler << ").";
+            else if (style < 80)
+                description << runner << " rushed to " << location << " "
+                            << yardage(distanceGained, true) << " (" << tackler << ").";
+            else if (style < 88)
+                description << quarterback << " scrambles to " << location << " "
+                            << yardage(distanceGained, true) << " (" << tackler << ").";
+            else
+                // No direction at all. Loader treats these as runs up the middle
+                description << runner << " to " << location << " " << yardage(distanceGained, true)
+                            << " (" << tackler << ").";
+            if (randomPercent(1)) {
+                description << " FUMBLES (" << tackler << ") RECOVERED by " << TeamNames[state.defense]
+                            << "-" << playerName(state.defense, pos_defender) << ".";
+                turnedOver = true;
+            }
+        }
+    } // Run play
+    stream << description.str() << ",";
+    writeTrailer(stream, season, state);
+
+    // Update the game situation from the result of the play
+    short newYardLine = state.yardLine - distanceGained;
+    if (turnedOver)
+        changePossession(state, 100 - newYardLine);
+    else if (newYardLine <= 0) {
+        state.yardLine = 0;
+        scoreTouchdown(stream, gameId, season, state);
+    }
+    else {
+        state.yardLine = newYardLine;
+        if (distanceGained >= state.toGo) {
+            state.down = 1;
+            state.toGo = (state.yardLine < 10) ? state.yardLine : 10;
+        }
+        else {
+            state.down++;
+            state.toGo -= distanceGained;
+            if (state.down > 4)
+                changePossession(state, 100 - state.yardLine);
+        }
+    } // Offense keeps the ball
+    short seconds = clockStops ? 5 + randomBelow(4) : 25 + randomBelow(16);
+    if (twoMinute && !clockStops)
+        seconds = 10 + randomBelow(15);
+    runClock(stream, gameId, season, state, seconds);
+}
+
+// Writes a play line with no down, such as kickoffs and extra points
+void PlayGenerator::writeNonDownPlay(ostream& stream, const string& gameId, unsigned short season,
+                                     const GameState& state, const string& description)
+{
+    writeLeader(stream, gameId, state, false);
+    stream << description << ",";
+    writeTrailer(stream, season, state);
+}
+
+// Writes the fields that start every play line
+void PlayGenerator::writeLeader(ostream& stream, const string& gameId, const GameState& state, bool haveDown)
+{
+    short quarter = 1 + (3600 - state.secondsLeft) / 900;
+    if (quarter > 4)
+        quarter = 4;
+    stream << gameId << "," << quarter << "," << state.secondsLeft / 60 << "," << state.secondsLeft % 60
+           << "," << TeamNames[state.offense] << "," << TeamNames[state.defense] << ",";
+    if (haveDown)
+        stream << state.down << "," << state.toGo << ",";
+    else
+        stream << ",,";
+    stream << state.yardLine << ",";
+}
+
+// Writes the fields that end every play line
+void PlayGenerator::writeTrailer(ostream& stream, unsigned short season, const GameState& state)
+{
+    stream << getScore(state, state.offense) << "," << getScore(state, state.defense) << "," << season << "\n";
+}
+
+// Formats a field position as the data files do, for example 'NYJ 35'
+string PlayGenerator::fieldPosition(const GameState& state, short yardLine) const
+{
+    if (yardLine < 0)
+        yardLine = 0;
+    if (yardLine > 100)
+        yardLine = 100;
+    stringstream result;
+    if (yardLine < 50)
+        result << TeamNames[state.defense] << " " << yardLine;
+    else
+        // The fifty is written with the offense, so every position has a team name
+        result << TeamNames[state.offense] << " " << 100 - yardLine;
+    return result.str();
+}
+
+// Formats yardage gained as the data files do, for example 'for 7 yards'
+string PlayGenerator::yardage(short distanceGained, bool allowLossWording)
+{
+    stringstream result;
+    if (distanceGained == 0)
+        result << "for no gain";
+    else if ((distanceGained < 0) && allowLossWording && randomPercent(30))
+        result << "for a loss of " << -distanceGained << " yards";
+    else
+        result << "for " << distanceGained << " yards";
+    return result.str();
+}
+
+// Returns a player name for a team and position
+string PlayGenerator::playerName(unsigned short team, unsigned short position) const
+{
+    string result(1, (char)('A' + ((team * 7 + position * 3) % 26)));
+    result += ".";
+    result += Surnames[(team * 11 + position * 5) % SurnameCount];
+    return result;
+}
+
+// Changes possession, placing the ball for the new offense
+void PlayGenerator::changePossession(GameState& state, short newYardLine)
+{
+    unsigned short temp = state.offense;
+    state.offense = state.defense;
+    state.defense = temp;
+    if (newYardLine < 1)
+        newYardLine = 1;
+    else if (newYardLine > 99)
+        newYardLine = 99;
+    state.yardLine = newYardLine;
+    state.down = 1;
+    state.toGo = (state.yardLine < 10) ? state.yardLine : 10;
+}
+
+// Handles a touchdown, including the extra point and kickoff lines
+void PlayGenerator::scoreTouchdown(ostream& stream, const string& gameId, unsigned short season,
+                                   GameState& state)
+{
+    addScore(state, state.offense, 6);
+    state.yardLine = 2;
+    stringstream description;
+    description << playerName(state.offense, pos_kicker) << " extra point is GOOD Center-"
+                << playerName(state.offense, pos_long_snapper) << ".";
+    writeNonDownPlay(stream, gameId, season, state, description.str());
+    addScore(state, state.offense, 1);
+    kickoff(stream, gameId, season, state);
+}
+
+// Kicks off to the other team. The offense in the state is the kicking team
+void PlayGenerator::kickoff(ostream& stream, const string& gameId, unsigned short season, GameState& state)
+{
+    state.yardLine = 65;
+    stringstream description;
+    description << playerName(state.offense, pos_kicker) << " kicks 65 yards from "
+                << fieldPosition(state, 65) << " to " << fieldPosition(state, 0) << ". Touchback.";
+    /* A few kickoffs in the real data mistakenly have a down listed. The loader
+        recognizes them by the word 'kicked' */
+    if (randomPercent(1)) {
+        description.str("");
+        description << playerName(state.offense, pos_kicker) << " kicked 65 yards from "
+                    << fieldPosition(state, 65) << " to " << fieldPosition(state, 0) << ". Touchback.";
+        state.down = 1;
+        state.toGo = 0;
+        writeLeader(stream, gameId, state, true);
+        stream << description.str() << ",";
+        writeTrailer(stream, season, state);
+    }
+    else
+        writeNonDownPlay(stream, gameId, season, state, description.str());
+    changePossession(state, 80);
+}
+
+// Moves the clock, handling the half
+void PlayGenerator::runClock(ostream& stream, const string& gameId, unsigned short season,
+                             GameState& state, short seconds)
+{
+    short newSeconds = state.secondsLeft - seconds;
+    if ((state.secondsLeft > 1800) && (newSeconds <= 1800)) {
+        // Halftime. The away team kicks off to the home team
+        state.secondsLeft = 1800;
+        state.offense = state.away;
+        state.defense = state.home;
+        kickoff(stream, gameId, season, state);
+    }
+    else if (newSeconds < 0)
+        state.secondsLeft = 0;
+    else
+        state.secondsLeft = newSeconds;
+}
@@ -0,0 +1,176 @@
+/* This file is part of NFLdecisionTree. It creates decision trees to classify
+    situations within NFL football games, and displays the plays historically
+    called in those situations given a set of opponents.
+
+    Copyright (C) 2013   Ezra Erb
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 3 as published
+    by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    I'd appreciate a note if you find this program useful or make
+    updates. Please contact me through LinkedIn (my profile also has
+    a link to the code depository)
+*/
+
+/* This class generates synthetic play by play data files for benchmarking.
+    Real play data can't be checked into benchmark fixtures, and the seasons
+    the loader normally reads are far smaller than a league wide run. This
+    class writes files in exactly the format PlayLoader expects:
+        gameid,qtr,min,sec,off,def,down,togo,ydline,description,offscore,defscore,season
+    with descriptions covering every pattern the loader recognizes.
+
+    The output is completely determined by the seed. Each season is generated from
+    its own stream derived from the seed and the season year, so a given season
+    file is identical no matter how many other seasons are generated with it. The
+    random number generator is implemented here rather than taken from the
+    standard library, because the library distributions are not guarenteed to
+    give the same values on different platforms.
+
+    WARNING: The games are simulated just well enough that the decision tree has
+    realistic structure to find. Nobody should draw football conclusions from them */
+
+using std::string; // Clients will use lots of strings, so they should include the header
+using std::vector; // Ditto
+using std::ostream;
+
+class PlayGenerator {
+public:
+    // Largest number of teams supported. Matches the real league
+    enum {MaxTeamCount = 32};
+
+    // Constructor. Takes the seed and the number of teams in the league
+    PlayGenerator(unsigned long long seed, unsigned short teamCount);
+
+    // Use the default destructor
+
+    /* Writes one file per season into the directory, named as the loader expects. The
+        directory is created if it doesn't exist, but its parent must */
+    void writeSeasons(const string& directory, unsigned short firstSeason,
+                      unsigned short lastSeason);
+
+    // Writes the plays for a single season, including the header line, to a stream
+    void writeSeason(ostream& stream, unsigned short season);
+
+    // Returns the abbreviation used for a team in the data files
+    static const char* getTeamName(unsigned short team);
+
+    // Returns the number of teams in the generated league
+    unsigned short getTeamCount() const;
+
+private:
+    /* Per team play calling tendencies. They differ between teams so that
+        the choice of similiar teams actually changes the resulting tree */
+    struct TeamTendency {
+        short passPercent; // Base percentage of plays that are passes
+        short deepPercent; // Percentage of passes thrown deep
+        short leftPercent; // Percentage of plays going left
+        short rightPercent; // Percentage of plays going right
+        short aggression; // Percentage willing to go for it on fourth and short
+    };
+
+    // State of a single game as it is simulated
+    struct GameState {
+        unsigned short home;
+        unsigned short away;
+        unsigned short offense;
+        unsigned short defense;
+        short homeScore;
+        short awayScore;
+        short down;
+        short toGo;
+        short yardLine; // Yards to the opponent's goal line, as in the data files
+        short secondsLeft; // In the overall game
+    };
+
+    unsigned long long _seed;
+    unsigned long long _state; // Current state of the random number generator
+    unsigned short _teamCount;
+    vector<TeamTendency> _tendencies;
+
+    // Returns the next raw random value
+    unsigned long long nextRandom();
+
+    // Returns a random value in [0...limit)
+    short randomBelow(short limit);
+
+    // Returns true the given percent of the time
+    bool randomPercent(short percent);
+
+    // Generates the games for one week of a season. Teams play divisional rivals twice
+    void writeWeek(ostream& stream, unsigned short season, unsigned short week);
+
+    // Simulates one game and writes its plays
+    void writeGame(ostream& stream, unsigned short season, unsigned short week,
+                   unsigned short home, unsigned short away);
+
+    // Writes the plays for a single snap, updating the game state
+    void writePlay(ostream& stream, const string& gameId, unsigned short season, GameState& state);
+
+    // Writes a play line with no down, such as kickoffs and extra points
+    void writeNonDownPlay(ostream& stream, const string& gameId, unsigned short season,
+                          const GameState& state, const string& description);
+
+    // Writes the fields that start every play line
+    void writeLeader(ostream& stream, const string& gameId, const GameState& state, bool haveDown);
+
+    // Writes the fields that end every play line
+    void writeTrailer(ostream& stream, unsigned short season, const GameState& state);
+
+    // Formats a field position as the data files do, for example 'NYJ 35'
+    string fieldPosition(const GameState& state, short yardLine) const;
+
+    // Formats yardage gained as the data files do, for example 'for 7 yards'
+    string yardage(short distanceGained, bool allowLossWording);
+
+    // Returns a player name for a team and position
+    string playerName(unsigned short team, unsigned short position) const;
+
+    // Returns the score for a team in the current game
+    short getScore(const GameState& state, unsigned short team) const;
+    void addScore(GameState& state, unsigned short team, short points);
+
+    // Changes possession, placing the ball for the new offense
+    void changePossession(GameState& state, short newYardLine);
+
+    // Handles a score, including the extra point and kickoff lines
+    void scoreTouchdown(ostream& stream, const string& gameId, unsigned short season, GameState& state);
+    void kickoff(ostream& stream, const string& gameId, unsigned short season, GameState& state);
+
+    // Moves the clock, handling the half
+    void runClock(ostream& stream, const string& gameId, unsigned short season,
+                  GameState& state, short seconds);
+};
+
+inline unsigned short PlayGenerator::getTeamCount() const
+{
+    return _teamCount;
+}
+
+// Returns the score for a team in the current game
+inline short PlayGenerator::getScore(const GameState& state, unsigned short team) const
+{
+    return (team == state.home) ? state.homeScore : state.awayScore;
+}
+
+inline void PlayGenerator::addScore(GameState& state, unsigned short team, short points)
+{
+    if (team == state.home)
+        state.homeScore += points;
+    else
+        state.awayScore += points;
+}
+
+// Returns true the given percent of the time
+inline bool PlayGenerator::randomPercent(short percent)
+{
+    return randomBelow(100) < percent;
+}
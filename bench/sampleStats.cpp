@@ -0,0 +1,117 @@
+/* This file is part of NFLdecisionTree. It creates decision trees to classify
+    situations within NFL football games, and displays the plays historically
+    called in those situations given a set of opponents.
+
+    Copyright (C) 2013   Ezra Erb
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 3 as published
+    by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    I'd appreciate a note if you find this program useful or make
+    updates. Please contact me through LinkedIn (my profile also has
+    a link to the code depository)
+*/
+#include<vector>
+#include<ostream>
+#include<algorithm>
+#include<cmath>
+#include"sampleStats.h"
+
+using std::vector;
+using std::ostream;
+using std::sort;
+
+// Creates an empty set of samples
+SampleStats::SampleStats()
+    : _values(), _sorted(true)
+{
+    // All in the initialization list
+}
+
+// Adds a measurement
+void SampleStats::add(double value)
+{
+    _values.push_back(value);
+    _sorted = false;
+}
+
+// Number of measurements
+unsigned int SampleStats::getCount() const
+{
+    return _values.size();
+}
+
+double SampleStats::getMin() const
+{
+    return getPercentile(0.0);
+}
+
+double SampleStats::getMax() const
+{
+    return getPercentile(100.0);
+}
+
+double SampleStats::getMedian() const
+{
+    return getPercentile(50.0);
+}
+
+double SampleStats::getMean() const
+{
+    if (_values.empty())
+        return 0.0;
+    double total = 0.0;
+    vector<double>::const_iterator index;
+    for (index = _values.begin(); index != _values.end(); index++)
+        total += *index;
+    return total / (double)_values.size();
+}
+
+// Sample standard deviation. Zero with fewer than two measurements
+double SampleStats::getStdDev() const
+{
+    if (_values.size() < 2)
+        return 0.0;
+    double mean = getMean();
+    double total = 0.0;
+    vector<double>::const_iterator index;
+    for (index = _values.begin(); index != _values.end(); index++)
+        total += (*index - mean) * (*index - mean);
+    return sqrt(total / (double)(_values.size() - 1));
+}
+
+// Value below which the given percent of measurements fall, interpolated between them
+double SampleStats::getPercentile(double percent) const
+{
+    if (_values.empty())
+        return 0.0;
+    if (!_sorted) {
+        sort(_values.begin(), _values.end());
+        _sorted = true;
+    }
+    double position = (percent / 100.0) * (double)(_values.size() - 1);
+    if (position <= 0.0)
+        return _values.front();
+    if (position >= (double)(_values.size() - 1))
+        return _values.back();
+    unsigned int below = (unsigned int)position;
+    double fraction = position - (double)below;
+    return _values[below] + (fraction * (_values[below + 1] - _values[below]));
+}
+
+// Outputs the summary as the fields of a JSON object, without the braces
+void SampleStats::outputJson(ostream& stream) const
+{
+    stream << "\"count\":" << getCount() << ",\"min\":" << getMin() << ",\"median\":" << getMedian()
+           << ",\"mean\":" << getMean() << ",\"stddev\":" << getStdDev() << ",\"p90\":" << getPercentile(90.0)
+           << ",\"max\":" << getMax();
+}
@@ -0,0 +1,63 @@
+/* This file is part of NFLdecisionTree. It creates decision trees to classify
+    situations within NFL football games, and displays the plays historically
+    called in those situations given a set of opponents.
+
+    Copyright (C) 2013   Ezra Erb
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 3 as published
+    by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    I'd appreciate a note if you find this program useful or make
+    updates. Please contact me through LinkedIn (my profile also has
+    a link to the code depository)
+*/
+
+/* This class summarizes repeated measurements from a benchmark. Single timings
+    are too noisy to compare, so benchmarks take many and compare the summaries.
+    The median is usually the most useful value, since a few runs always get
+    delayed by something else on the machine and the mean chases them */
+
+using std::vector; // Header deliberately not included, clients should already have it
+using std::ostream;
+
+class SampleStats {
+public:
+    // Creates an empty set of samples
+    SampleStats();
+
+    // Adds a measurement
+    void add(double value);
+
+    // Number of measurements
+    unsigned int getCount() const;
+
+    // Summary values. All return zero for an empty set
+    double getMin() const;
+    double getMax() const;
+    double getMean() const;
+    double getMedian() const;
+
+    // Sample standard deviation. Zero with fewer than two measurements
+    double getStdDev() const;
+
+    // Value below which the given percent of measurements fall, interpolated between them
+    double getPercentile(double percent) const;
+
+    // Outputs the summary as the fields of a JSON object, without the braces
+    void outputJson(ostream& stream) const;
+
+private:
+    /* Measurements. Percentiles need them in order, so they are sorted when first
+        needed after an add. Mutable since sorting doesn't change the set of values */
+    mutable vector<double> _values;
+    mutable bool _sorted;
+};
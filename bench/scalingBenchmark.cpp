@@ -0,0 +1,363 @@
+/* This file is part of NFLdecisionTree. It creates decision trees to classify
+    situations within NFL football games, and displays the plays historically
+    called in those situations given a set of opponents.
+
+    Copyright (C) 2013   Ezra Erb
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 3 as published
+    by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    I'd appreciate a note if you find this program useful or make
+    updates. Please contact me through LinkedIn (my profile also has
+    a link to the code depository)
+*/
+
+/* Runs the pipeline (loading, index build, tree build and pruning) over a matrix of
+    worker thread counts and data set sizes, to find where parallel code stops paying
+    off. Run it as
+        scalingBenchmark WORK_DIRECTORY [MAX_THREADS] [RUNS] [--seasons LIST] [--json]
+    Synthetic data is written to WORK_DIRECTORY by PlayGenerator with its default seed,
+    for any seasons not already there. LIST is a comma seperated list of season counts
+    (default 1,4,16,50), each ending with 2011. Every season count is run for two scopes:
+    'matchup' is the result.txt matchup (NE against NYJ, MIA and BUF similiar to NYJ),
+    and 'league' makes every other team similiar to both sides, the most plays the
+    loader can select (36,557 plays at 16 seasons and 114,102 at 50, so its trees
+    depend on play counts well past the range of a short). Thread counts are powers of two up to MAX_THREADS (default the
+    number of processors), plus MAX_THREADS itself.
+
+    Each cell reports the median time over RUNS runs (default 3), the speedup and
+    efficiency relative to one thread on the same data, and the largest peak memory
+    of its runs. Every run is a fresh child process. Any cell whose tree differs from
+    the one thread result is flagged, and the program then exits with status 2.
+    NOTE: This uses fork(), so it only builds on POSIX systems */
+#include<iostream>
+#include<fstream>
+#include<sstream>
+#include<string>
+#include<vector>
+#include<chrono>
+#include<cstdlib>
+#include"baseException.h"
+#include"singlePlay.h"
+#include"playIndexSet.h"
+#include"playStats.h"
+#include"allocTracker.h"
+#include"dataStore.h"
+#include"playLoader.h"
+#include"decisionNode.h"
+#include"resultWriter.h"
+#include"parallelSettings.h"
+#include"playGenerator.h"
+#include"sampleStats.h"
+#include"childProcess.h"
+
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+using std::ifstream;
+using std::stringstream;
+using std::exception;
+
+// Newest season generated. Matches the loader's default
+static const unsigned short LastSeason = 2011;
+
+// Seed for the generated data. Matches generatePlays' default
+static const unsigned long long DataSeed = 2013;
+
+// One data set in the matrix
+struct DataSet {
+    unsigned short seasonCount;
+    bool leagueScope;
+};
+
+// Result of one run, passed back from the child process
+struct RunResult {
+    double loadSeconds; // Includes the index build, which the loader does
+    double treeSeconds;
+    double pruneSeconds;
+    double totalSeconds;
+    unsigned long long outputHash;
+    unsigned long long playCount;
+};
+
+// Current time in seconds from some arbitrary starting point
+static double getWallSeconds()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/* Hash of the output, to compare trees without sending them between processes. This
+    is the 64 bit FNV-1a hash, which is simple and plenty good enough to spot changes */
+static unsigned long long hashOutput(const string& output)
+{
+    unsigned long long hash = 14695981039346656037ULL;
+    string::const_iterator index;
+    for (index = output.begin(); index != output.end(); index++) {
+        hash ^= (unsigned char)*index;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Runs the pipeline on one data set with one thread count
+class ScalingTask : public ChildTask {
+public:
+    ScalingTask(const string& dataDirectory, const DataSet& dataSet, unsigned short workerCount)
+        : _dataDirectory(dataDirectory), _dataSet(dataSet), _workerCount(workerCount)
+    {
+    }
+
+    void run(void* results)
+    {
+        RunResult& result = *(RunResult*)results;
+        ParallelSettings::setWorkerCount(_workerCount);
+        string thisTeam("NE");
+        string otherTeam("NYJ");
+        vector<string> thisSimiliar;
+        vector<string> otherSimiliar;
+        if (_dataSet.leagueScope) {
+            unsigned short team;
+            for (team = 0; team < PlayGenerator::MaxTeamCount; team++) {
+                string teamName(PlayGenerator::getTeamName(team));
+                if ((teamName != thisTeam) && (teamName != otherTeam)) {
+                    thisSimiliar.push_back(teamName);
+                    otherSimiliar.push_back(teamName);
+                }
+            } // Loop through teams
+        } // Whole league
+        else {
+            otherSimiliar.push_back(string("MIA"));
+            otherSimiliar.push_back(string("BUF"));
+        } // One matchup
+
+        double startTime = getWallSeconds();
+        PlayLoader loader(_dataDirectory);
+        DataStore data;
+        loader.loadPlays(thisTeam, otherTeam, thisSimiliar, otherSimiliar,
+                         LastSeason - _dataSet.seasonCount + 1, LastSeason, data);
+        double loadTime = getWallSeconds();
+        PlayIndexSet dataView(data.getIndexes());
+        DecisionNode tree(dataView, data.getPlaySummaryStats());
+        double treeTime = getWallSeconds();
+        tree.pruneTree();
+        double pruneTime = getWallSeconds();
+
+        stringstream output;
+        ResultWriter::write(output, thisTeam, otherTeam, thisSimiliar, otherSimiliar, tree);
+        result.loadSeconds = loadTime - startTime;
+        result.treeSeconds = treeTime - loadTime;
+        result.pruneSeconds = pruneTime - treeTime;
+        result.totalSeconds = pruneTime - startTime;
+        result.outputHash = hashOutput(output.str());
+        result.playCount = countPlays(data.getPlaySummaryStats());
+    }
+
+private:
+    string _dataDirectory;
+    DataSet _dataSet;
+    unsigned short _workerCount;
+
+    // Total plays loaded
+    static unsigned long long countPlays(const OverallSummaryData& summary)
+    {
+        unsigned long long total = 0;
+        OverallSummaryData::const_iterator index;
+        for (index = summary.begin(); index != summary.end(); index++)
+            total += index->getTotalCount();
+        return total;
+    }
+};
+
+// Writes any season files not already in the directory
+static void generateData(const string& directory, unsigned short seasonCount)
+{
+    PlayGenerator generator(DataSeed, PlayGenerator::MaxTeamCount);
+    unsigned short season;
+    for (season = LastSeason - seasonCount + 1; season <= LastSeason; season++) {
+        stringstream fileName;
+        fileName << directory << "/" << season << "_nfl_pbp_data.csv";
+        ifstream existing(fileName.str().c_str());
+        if (existing.is_open())
+            continue;
+        generator.writeSeasons(directory, season, season);
+    } // Loop through seasons
+}
+
+// Parses a comma seperated list of season counts
+static bool parseSeasonList(const string& list, vector<unsigned short>& seasonCounts)
+{
+    seasonCounts.clear();
+    stringstream stream(list);
+    string item;
+    while (getline(stream, item, ',')) {
+        unsigned short count = (unsigned short)atoi(item.c_str());
+        if ((count == 0) || (count > LastSeason))
+            return false;
+        seasonCounts.push_back(count);
+    }
+    return !seasonCounts.empty();
+}
+
+int main(int argc, char **argv)
+{
+    vector<string> args;
+    bool wantJson = false;
+    vector<unsigned short> seasonCounts;
+    seasonCounts.push_back(1);
+    seasonCounts.push_back(4);
+    seasonCounts.push_back(16);
+    seasonCounts.push_back(50);
+    bool validArgs = true;
+    int argIndex;
+    for (argIndex = 1; argIndex < argc; argIndex++) {
+        string arg(argv[argIndex]);
+        if (arg == string("--json"))
+            wantJson = true;
+        else if ((arg == string("--seasons")) && (argIndex + 1 < argc)) {
+            argIndex++;
+            validArgs = validArgs && parseSeasonList(string(argv[argIndex]), seasonCounts);
+        }
+        else
+            args.push_back(arg);
+    } // Loop through arguments
+    if ((!validArgs) || (args.size() < 1) || (args.size() > 3)) {
+        cout << "Invalid arguments. WORK_DIRECTORY [MAX_THREADS] [RUNS] [--seasons LIST] [--json]" << endl;
+        exit(1);
+    }
+    string workDirectory(args[0]);
+    unsigned short maxThreads = (args.size() > 1) ? (unsigned short)atoi(args[1].c_str())
+        : ParallelSettings::getProcessorCount();
+    unsigned int runCount = (args.size() > 2) ? (unsigned int)atoi(args[2].c_str()) : 3;
+    if ((maxThreads == 0) || (runCount == 0)) {
+        cout << "Invalid thread or run count" << endl;
+        exit(1);
+    }
+
+    // Powers of two, then the maximum if it isn't one
+    vector<unsigned short> threadCounts;
+    unsigned short threads;
+    for (threads = 1; threads < maxThreads; threads *= 2)
+        threadCounts.push_back(threads);
+    threadCounts.push_back(maxThreads);
+
+    try {
+        unsigned short maxSeasons = 0;
+        vector<unsigned short>::const_iterator seasonIndex;
+        for (seasonIndex = seasonCounts.begin(); seasonIndex != seasonCounts.end(); seasonIndex++)
+            if (*seasonIndex > maxSeasons)
+                maxSeasons = *seasonIndex;
+        generateData(workDirectory, maxSeasons);
+
+        unsigned int mismatchCount = 0;
+        bool firstCell = true;
+        if (wantJson)
+            cout << "{\"runs\":" << runCount << ",\"cells\":[";
+        else
+            cout << "Seasons  Scope     Threads     Plays   Median ms   Speedup  Efficiency  Peak RSS KB  Output" << endl;
+        for (seasonIndex = seasonCounts.begin(); seasonIndex != seasonCounts.end(); seasonIndex++) {
+            unsigned short scope;
+            for (scope = 0; scope < 2; scope++) {
+                DataSet dataSet;
+                dataSet.seasonCount = *seasonIndex;
+                dataSet.leagueScope = (scope == 1);
+                double baseTime = 0.0;
+                unsigned long long baseHash = 0;
+                vector<unsigned short>::const_iterator threadIndex;
+                for (threadIndex = threadCounts.begin(); threadIndex != threadCounts.end(); threadIndex++) {
+                    SampleStats totalTimes;
+                    SampleStats loadTimes;
+                    SampleStats treeTimes;
+                    SampleStats pruneTimes;
+                    long peakResidentKb = 0;
+                    RunResult result;
+                    bool outputMatches = true;
+                    unsigned int runIndex;
+                    for (runIndex = 0; runIndex < runCount; runIndex++) {
+                        ScalingTask task(workDirectory, dataSet, *threadIndex);
+                        long runPeakKb;
+                        string errorMessage;
+                        if (!ChildProcess::run(task, &result, sizeof(result), runPeakKb, errorMessage)) {
+                            cout << "Run failed: " << errorMessage << endl;
+                            exit(1);
+                        }
+                        totalTimes.add(result.totalSeconds);
+                        loadTimes.add(result.loadSeconds);
+                        treeTimes.add(result.treeSeconds);
+                        pruneTimes.add(result.pruneSeconds);
+                        if (runPeakKb > peakResidentKb)
+                            peakResidentKb = runPeakKb;
+                        // The first run of the first thread count is the reference
+                        if ((threadIndex == threadCounts.begin()) && (runIndex == 0))
+                            baseHash = result.outputHash;
+                        else if (result.outputHash != baseHash)
+                            outputMatches = false;
+                    } // Loop through runs
+                    if (threadIndex == threadCounts.begin())
+                        baseTime = totalTimes.getMedian();
+                    double speedup = (totalTimes.getMedian() > 0.0) ? baseTime / totalTimes.getMedian() : 0.0;
+                    double efficiency = speedup / (double)*threadIndex;
+                    if (!outputMatches)
+                        mismatchCount++;
+
+                    if (wantJson) {
+                        if (!firstCell)
+                            cout << ",";
+                        cout << "{\"seasons\":" << dataSet.seasonCount << ",\"scope\":\""
+                             << (dataSet.leagueScope ? "league" : "matchup") << "\",\"threads\":" << *threadIndex
+                             << ",\"plays\":" << result.playCount << ",\"total_seconds\":{";
+                        totalTimes.outputJson(cout);
+                        cout << "},\"load_seconds\":{";
+                        loadTimes.outputJson(cout);
+                        cout << "},\"tree_seconds\":{";
+                        treeTimes.outputJson(cout);
+                        cout << "},\"prune_seconds\":{";
+                        pruneTimes.outputJson(cout);
+                        cout << "},\"speedup\":" << speedup << ",\"efficiency\":" << efficiency
+                             << ",\"peak_resident_kb\":" << peakResidentKb << ",\"output_matches\":"
+                             << (outputMatches ? "true" : "false") << "}";
+                    } // JSON output
+                    else {
+                        cout.setf(std::ios::fixed);
+                        cout.precision(2);
+                        cout.width(7);
+                        cout << dataSet.seasonCount << "  ";
+                        cout.width(8);
+                        cout << std::left << (dataSet.leagueScope ? "league" : "matchup") << std::right;
+                        cout.width(9);
+                        cout << *threadIndex;
+                        cout.width(10);
+                        cout << result.playCount;
+                        cout.width(12);
+                        cout << totalTimes.getMedian() * 1000.0;
+                        cout.width(10);
+                        cout << speedup;
+                        cout.width(12);
+                        cout << efficiency;
+                        cout.width(13);
+                        cout << peakResidentKb << "  " << (outputMatches ? "same" : "DIFFERS") << endl;
+                    } // Table output
+                    firstCell = false;
+                } // Loop through thread counts
+            } // Loop through scopes
+        } // Loop through season counts
+        if (wantJson)
+            cout << "],\"mismatches\":" << mismatchCount << "}" << endl;
+        if (mismatchCount)
+            exit(2);
+    }
+    catch (exception& e) { // Catch by reference so virtual methods work properly
+        cout << "Exception: " << e.what() << " thrown" << endl;
+        exit(1);
+    }
+    return 0;
+}
@@ -0,0 +1,293 @@
+/* This file is part of NFLdecisionTree. It creates decision trees to classify
+    situations within NFL football games, and displays the plays historically
+    called in those situations given a set of opponents.
+
+    Copyright (C) 2013   Ezra Erb
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 3 as published
+    by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    I'd appreciate a note if you find this program useful or make
+    updates. Please contact me through LinkedIn (my profile also has
+    a link to the code depository)
+*/
+
+/* Measures ingest into a VersionedStore while trees are built from its snapshots, and
+    checks every tree built matches one built the usual way. Run it as
+        snapshotBenchmark DATA_DIRECTORY [BUILDERS] [--seasons FIRST LAST] [--json]
+    The data can be real or written by generatePlays, and the plays are those for the same
+    matchup as result.txt. The default seasons are the ones the main program uses.
+
+    The main thread loads the seasons one at a time, latest first as the main program does,
+    inserting and publishing each, and times how long each insert and publish takes. Builder
+    threads meanwhile take a snapshot, build and prune a tree from it, and start again, until
+    the last season is published and they have built from it. Every tree built is compared
+    with the tree from a data store loaded with the same seasons, so a snapshot changed by
+    later inserts shows up as a mismatch. Build times are reported separately for trees of
+    versions still current when the build finished and of those already replaced. */
+#include<iostream>
+#include<sstream>
+#include<string>
+#include<vector>
+#include<map>
+#include<chrono>
+#include<thread>
+#include<atomic>
+#include<cstdlib>
+#include"baseException.h"
+#include"singlePlay.h"
+#include"playIndexSet.h"
+#include"playStats.h"
+#include"allocTracker.h"
+#include"dataStore.h"
+#include"playLoader.h"
+#include"decisionNode.h"
+#include"versionedStore.h"
+#include"sampleStats.h"
+
+using std::cout;
+using std::endl;
+using std::string;
+using std::stringstream;
+using std::vector;
+using std::map;
+using std::exception;
+using std::atomic;
+using std::thread;
+
+// A tree built by a builder thread, with the version it came from
+struct BuiltTree {
+    unsigned long long version;
+    string treeText;
+    double buildTime; // Microseconds
+    bool replaced; // Whether a newer version was published during the build
+};
+
+// What one builder thread shares with the main thread
+struct BuilderWork {
+    const VersionedStore* store;
+    const atomic<unsigned long long>* lastVersion; // Zero until the last season is published
+    vector<BuiltTree> trees;
+};
+
+// Builds and prunes a tree from the passed indexes, and returns its text
+static string buildTreeText(PlayIndexSet& indexes, const OverallSummaryData& summaryData)
+{
+    DecisionNode tree(indexes, summaryData);
+    tree.pruneTree();
+    stringstream treeText;
+    treeText << tree;
+    return treeText.str();
+}
+
+// Builder thread. Builds from snapshots until it has built from the last version
+static void runBuilder(BuilderWork* work)
+{
+    bool builtLast = false;
+    while (!builtLast) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        VersionedStore::Snapshot snapshot(*work->store);
+        if (!snapshot.getPlayCount()) {
+            std::this_thread::yield();
+            continue; // Nothing published yet
+        }
+        BuiltTree built;
+        built.version = snapshot.getVersion();
+        {
+            PlayIndexSet indexes(snapshot.getIndexes());
+            built.treeText = buildTreeText(indexes, snapshot.getPlaySummaryStats());
+        }
+        built.buildTime = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        VersionedStore::Snapshot latest(*work->store);
+        built.replaced = (latest.getVersion() != built.version);
+        builtLast = (built.version == work->lastVersion->load());
+        work->trees.push_back(built);
+    } // Loop until the last version is built
+}
+
+// Outputs the times for one group of values
+static void outputTimes(const string& name, const SampleStats& times, bool wantJson, bool firstOutput)
+{
+    if (wantJson) {
+        if (!firstOutput)
+            cout << ",";
+        cout << "\"" << name << "\":{";
+        times.outputJson(cout);
+        cout << "}";
+        return;
+    }
+    cout.width(12);
+    cout << std::left << name << std::right;
+    cout.width(8);
+    cout << times.getCount();
+    cout.width(12);
+    cout << times.getMin();
+    cout.width(12);
+    cout << times.getMedian();
+    cout.width(12);
+    cout << times.getPercentile(90.0);
+    cout.width(12);
+    cout << times.getMax() << endl;
+}
+
+int main(int argc, char **argv)
+{
+    vector<string> args;
+    bool wantJson = false;
+    unsigned short firstSeason = 0;
+    unsigned short lastSeason = 0;
+    int argIndex;
+    for (argIndex = 1; argIndex < argc; argIndex++) {
+        string arg(argv[argIndex]);
+        if (arg == string("--json"))
+            wantJson = true;
+        else if ((arg == string("--seasons")) && (argIndex + 2 < argc)) {
+            firstSeason = (unsigned short)atoi(argv[argIndex + 1]);
+            lastSeason = (unsigned short)atoi(argv[argIndex + 2]);
+            argIndex += 2;
+        }
+        else
+            args.push_back(arg);
+    } // Loop through arguments
+    if ((args.size() < 1) || (args.size() > 2)) {
+        cout << "Invalid arguments. DATA_DIRECTORY [BUILDERS] [--seasons FIRST LAST] [--json]" << endl;
+        exit(1);
+    }
+    unsigned int builderCount = (args.size() >= 2) ? (unsigned int)atoi(args[1].c_str()) : 2;
+    if (!firstSeason)
+        PlayLoader::getRecentSeasons(3, firstSeason, lastSeason);
+    if ((builderCount == 0) || (firstSeason > lastSeason)) {
+        cout << "Builders must be at least 1, and the first season can't be after the last" << endl;
+        exit(1);
+    }
+
+    try {
+        string thisTeam("NE");
+        string otherTeam("NYJ");
+        vector<string> thisSimiliar;
+        vector<string> otherSimiliar;
+        otherSimiliar.push_back(string("MIA"));
+        otherSimiliar.push_back(string("BUF"));
+        PlayLoader loader(args[0]);
+
+        /* Read the seasons before starting, so the timed ingest is only inserting and
+            publishing, not reading files */
+        vector<PlayBatch*> seasons;
+        unsigned short season;
+        for (season = lastSeason; season >= firstSeason; season--) {
+            seasons.push_back(new PlayBatch());
+            loader.loadSeason(thisTeam, otherTeam, thisSimiliar, otherSimiliar, season, *seasons.back());
+        }
+
+        VersionedStore store;
+        atomic<unsigned long long> lastVersion(0);
+        vector<BuilderWork> work(builderCount);
+        vector<thread> builders;
+        unsigned int builderIndex;
+        for (builderIndex = 0; builderIndex < builderCount; builderIndex++) {
+            work[builderIndex].store = &store;
+            work[builderIndex].lastVersion = &lastVersion;
+        }
+        for (builderIndex = 0; builderIndex < builderCount; builderIndex++)
+            builders.push_back(thread(runBuilder, &work[builderIndex]));
+
+        // Ingest a season at a time, resting between them so builds run on each version
+        SampleStats insertTimes;
+        SampleStats publishTimes;
+        vector<PlayBatch*>::const_iterator batch;
+        unsigned long long version = 0;
+        for (batch = seasons.begin(); batch != seasons.end(); batch++) {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            store.insertPlays(**batch);
+            std::chrono::steady_clock::time_point inserted = std::chrono::steady_clock::now();
+            version = store.publish();
+            std::chrono::steady_clock::time_point published = std::chrono::steady_clock::now();
+            insertTimes.add(std::chrono::duration<double, std::micro>(inserted - start).count());
+            publishTimes.add(std::chrono::duration<double, std::micro>(published - inserted).count());
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        } // Loop through seasons
+        lastVersion.store(version);
+        vector<thread>::iterator builderPtr;
+        for (builderPtr = builders.begin(); builderPtr != builders.end(); builderPtr++)
+            builderPtr->join();
+        unsigned int retiredCount = store.getRetiredCount();
+
+        /* Build the expected tree of each version from a data store. Version N holds the
+            first N seasons loaded */
+        map<unsigned long long, string> expectedTrees;
+        for (version = 1; version <= seasons.size(); version++) {
+            DataStore data;
+            unsigned long playCount = 0;
+            unsigned long long seasonIndex;
+            for (seasonIndex = 0; seasonIndex < version; seasonIndex++) {
+                data.insertPlays(*seasons[seasonIndex]);
+                playCount += seasons[seasonIndex]->size();
+            }
+            if (!playCount)
+                continue; // Builders never build from a version without plays
+            data.buildIndexes();
+            PlayIndexSet indexes(data.getIndexes());
+            expectedTrees[version] = buildTreeText(indexes, data.getPlaySummaryStats());
+        } // Loop through versions
+
+        SampleStats currentTimes;
+        SampleStats replacedTimes;
+        unsigned int treeCount = 0;
+        unsigned int mismatchCount = 0;
+        vector<BuiltTree>::const_iterator built;
+        for (builderIndex = 0; builderIndex < builderCount; builderIndex++)
+            for (built = work[builderIndex].trees.begin(); built != work[builderIndex].trees.end(); built++) {
+                treeCount++;
+                if (built->treeText != expectedTrees[built->version])
+                    mismatchCount++;
+                if (built->replaced)
+                    replacedTimes.add(built->buildTime);
+                else
+                    currentTimes.add(built->buildTime);
+            } // Loop through trees built
+        for (batch = seasons.begin(); batch != seasons.end(); batch++)
+            delete *batch;
+
+        cout.setf(std::ios::fixed);
+        cout.precision(1);
+        if (wantJson) {
+            cout << "{\"builders\":" << builderCount << ",\"seasons\":" << seasons.size()
+                 << ",\"plays\":" << store.getInsertedCount() << ",\"trees\":" << treeCount
+                 << ",\"mismatches\":" << mismatchCount << ",\"retired_after_run\":" << retiredCount
+                 << ",\"us\":{";
+            outputTimes(string("insert"), insertTimes, true, true);
+            outputTimes(string("publish"), publishTimes, true, false);
+            outputTimes(string("build"), currentTimes, true, false);
+            outputTimes(string("build_old"), replacedTimes, true, false);
+            cout << "}}" << endl;
+        }
+        else {
+            cout << builderCount << " builders, " << seasons.size() << " seasons of "
+                 << store.getInsertedCount() << " plays, " << treeCount << " trees built, "
+                 << mismatchCount << " not matching a data store, " << retiredCount
+                 << " versions left unreclaimed" << endl;
+            cout << "Microseconds per operation. build_old is builds whose version was replaced before they finished" << endl;
+            cout << "Operation    Count         Min      Median         p90         Max" << endl;
+            outputTimes(string("insert"), insertTimes, false, true);
+            outputTimes(string("publish"), publishTimes, false, false);
+            outputTimes(string("build"), currentTimes, false, false);
+            outputTimes(string("build_old"), replacedTimes, false, false);
+        }
+        if (mismatchCount)
+            exit(2);
+    }
+    catch (exception& e) { // Catch by reference so virtual methods work properly
+        cout << "Exception: " << e.what() << " thrown" << endl;
+        exit(1);
+    }
+    return 0;
+}
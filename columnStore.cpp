@@ -0,0 +1,403 @@
+/* This file is part of NFLdecisionTree. It creates decision trees to classify
+    situations within NFL football games, and displays the plays historically
+    called in those situations given a set of opponents.
+
+    Copyright (C) 2013   Ezra Erb
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 3 as published
+    by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    I'd appreciate a note if you find this program useful or make
+    updates. Please contact me through LinkedIn (my profile also has
+    a link to the code depository)
+*/
+#include<string>
+#include<vector>
+#include<fstream>
+#include<sstream>
+#include<cstring>
+#include<cerrno>
+
+#include"singlePlay.h" // Needed by playIndexSet.h
+#include"playIndexSet.h" // Needed by dataStore.h
+#include"playStats.h" // Needed by columnStore.h
+#include"allocTracker.h" // Needed by dataStore.h
+#include"dataStore.h"
+#include"columnStore.h"
+#include"playLoader.h"
+#include"baseException.h"
+
+#ifndef _WIN32
+#include<sys/mman.h>
+#include<sys/stat.h>
+#include<fcntl.h>
+#include<unistd.h>
+#endif
+
+using std::string;
+using std::vector;
+using std::ifstream;
+using std::stringstream;
+
+// Identifies a column file
+static const char FileMagic[8] = { 'N', 'F', 'L', 'C', 'O', 'L', 'M', 'N' };
+
+// Columns start on this boundary, so they can be read in place
+static const unsigned long long ColumnAlignment = 8;
+
+// Space for each team code
+static const unsigned int TeamCodeSize = 8;
+
+// Plays copied from the spool to the columns at a time
+static const unsigned int SpoolBlockSize = 65536;
+
+// Rounds a file offset up to the next column boundary
+static unsigned long long alignOffset(unsigned long long offset)
+{
+    return (offset + ColumnAlignment - 1) & ~(ColumnAlignment - 1);
+}
+
+// Reads a team code, which is padded with nulls
+static string readTeamCode(const char* code)
+{
+    return string(code, strnlen(code, TeamCodeSize));
+}
+
+// Throws an error about a column file, including the system error if there is one
+static void throwFileError(const char* file, int line, const char* action, const string& name)
+{
+    stringstream errorMessage;
+    errorMessage << "Could not " << action << " column file " << name;
+    if (errno != 0)
+        errorMessage << ": " << strerror(errno);
+    throw BaseException(file, line, errorMessage.str().c_str());
+}
+
+// Creates an empty store
+ColumnStore::ColumnStore()
+    : _file(NULL), _fileSize(0)
+{
+    // All in the initialization list
+}
+
+// Destructor. Unmaps any open file
+ColumnStore::~ColumnStore()
+{
+    clear();
+}
+
+// Releases any mapped file
+void ColumnStore::clear()
+{
+#ifndef _WIN32
+    if (_file != NULL)
+        munmap((void*)_file, _fileSize);
+#endif
+    _file = NULL;
+    _fileSize = 0;
+}
+
+/* Starts a column file for the plays of a matchup. Nothing is written to the file
+    itself until finish() is called. Throws if the teams can't be stored */
+ColumnWriter::ColumnWriter(const string& fileName, const string& thisTeam, const string& otherTeam,
+                           const vector<string>& thisSimiliar, const vector<string>& otherSimiliar)
+    : _fileName(fileName), _spoolName(fileName + string(".spool")), _spool(), _teams(),
+      _thisSimiliarCount((unsigned int)thisSimiliar.size()), _otherSimiliarCount((unsigned int)otherSimiliar.size()),
+      _playCount(0), _typeCounts(SinglePlay::getPlayTypeCount(), 0),
+      _distanceSums(SinglePlay::getPlayTypeCount(), 0), _distanceSquares(SinglePlay::getPlayTypeCount(), 0),
+      _turnoverCounts(SinglePlay::getPlayTypeCount(), 0)
+{
+#ifdef _WIN32
+    throw BaseException(__FILE__, __LINE__, "Column files need a POSIX system");
+#else
+    _teams.push_back(thisTeam);
+    _teams.push_back(otherTeam);
+    _teams.insert(_teams.end(), thisSimiliar.begin(), thisSimiliar.end());
+    _teams.insert(_teams.end(), otherSimiliar.begin(), otherSimiliar.end());
+    vector<string>::const_iterator teamPtr;
+    for (teamPtr = _teams.begin(); teamPtr != _teams.end(); teamPtr++)
+        if (teamPtr->size() >= TeamCodeSize) {
+            stringstream errorMessage;
+            errorMessage << "Column file can't hold team " << *teamPtr;
+            throw BaseException(__FILE__, __LINE__, errorMessage.str().c_str());
+        }
+    errno = 0;
+    _spool.open(_spoolName.c_str(), std::ios::binary | std::ios::trunc);
+    if (!_spool.is_open())
+        throwFileError(__FILE__, __LINE__, "create the spool for", _fileName);
+#endif
+}
+
+// Destructor. Deletes the spool file
+ColumnWriter::~ColumnWriter()
+{
+#ifndef _WIN32
+    if (_spool.is_open())
+        _spool.close();
+    unlink(_spoolName.c_str());
+#endif
+}
+
+// Adds a play to the end of the file
+void ColumnWriter::addPlay(const SinglePlay& play)
+{
+    SpoolRecord record;
+    unsigned short characteristic;
+    for (characteristic = 0; characteristic <= (unsigned short)SinglePlay::score_differential; characteristic++)
+        record.categories[characteristic] = (unsigned char)play.getValue((SinglePlay::PlayCharacteristic)characteristic);
+    record.playType = (unsigned char)play.getPlayType();
+    record.turnedOver = play.getTurnedOver() ? 1 : 0;
+    record.distanceGained = play.getDistanceGained();
+    if (_playCount == 0xFFFFFFFFU)
+        throw BaseException(__FILE__, __LINE__, "Column file can't hold more plays");
+    _spool.write((const char*)&record, sizeof(record));
+    _playCount++;
+
+    long distance = record.distanceGained;
+    _typeCounts[record.playType]++;
+    _distanceSums[record.playType] += distance;
+    _distanceSquares[record.playType] += distance * distance;
+    _turnoverCounts[record.playType] += record.turnedOver;
+}
+
+// Adds every play of a batch, in order, to the end of the file
+void ColumnWriter::addPlays(const PlayBatch& batch)
+{
+    // The batch converts the situations to categories, so its plays are used as they are
+    PlayVector plays;
+    plays.reserve(batch.size());
+    batch.appendPlays(0, batch.size(), 0, plays);
+    PlayVector::const_iterator playPtr;
+    for (playPtr = plays.begin(); playPtr != plays.end(); playPtr++)
+        addPlay(*playPtr);
+}
+
+/* Loads the plays of the matchup for a range of seasons, [first...last], and adds them
+    in the order PlayLoader::loadPlays would. Only one season is held in memory at a time */
+void ColumnWriter::addSeasons(PlayLoader& loader, unsigned short firstYear, unsigned short lastYear)
+{
+    vector<string> thisSimiliar(_teams.begin() + 2, _teams.begin() + 2 + _thisSimiliarCount);
+    vector<string> otherSimiliar(_teams.begin() + 2 + _thisSimiliarCount, _teams.end());
+    // Seasons go in the same order as loading into a data store
+    PlayBatch batch;
+    unsigned short yearCounter;
+    for (yearCounter = lastYear; yearCounter >= firstYear; yearCounter--) {
+        batch.clear();
+        loader.loadSeason(_teams[0], _teams[1], thisSimiliar, otherSimiliar, yearCounter, batch);
+        addPlays(batch);
+    }
+}
+
+/* Writes the column file, along with the summary data for all of the plays added and
+    the teams of the matchup. Replaces any existing file */
+void ColumnWriter::finish()
+{
+#ifndef _WIN32
+    typedef ColumnStore::FileHeader FileHeader;
+    typedef ColumnStore::StoredSummary StoredSummary;
+
+    errno = 0;
+    _spool.close();
+    if (_spool.fail())
+        throwFileError(__FILE__, __LINE__, "write the spool for", _fileName);
+
+    // Lay out the file
+    FileHeader header;
+    memset(&header, 0, sizeof(header));
+    header.version = ColumnStore::FileVersion;
+    header.playCount = _playCount;
+    header.playTypeCount = SinglePlay::getPlayTypeCount();
+    header.thisSimiliarCount = _thisSimiliarCount;
+    header.otherSimiliarCount = _otherSimiliarCount;
+    header.summaryOffset = alignOffset(sizeof(FileHeader));
+    header.teamOffset = alignOffset(header.summaryOffset + (header.playTypeCount * sizeof(StoredSummary)));
+    unsigned long long nextOffset = alignOffset(header.teamOffset + (_teams.size() * TeamCodeSize));
+    unsigned short characteristic;
+    for (characteristic = 0; characteristic <= (unsigned short)SinglePlay::score_differential; characteristic++) {
+        header.categoryOffset[characteristic] = nextOffset;
+        nextOffset = alignOffset(nextOffset + header.playCount);
+    }
+    header.playTypeOffset = nextOffset;
+    header.distanceOffset = alignOffset(header.playTypeOffset + header.playCount);
+    header.turnoverOffset = alignOffset(header.distanceOffset + (header.playCount * sizeof(short)));
+    header.fileSize = header.turnoverOffset + header.playCount;
+
+    OverallSummaryData summaryData;
+    PlaySummaryFactory::buildSummaryData(_typeCounts, _distanceSums, _distanceSquares, _turnoverCounts,
+                                         summaryData);
+
+    errno = 0;
+    ifstream spool(_spoolName.c_str(), std::ios::binary);
+    if (!spool.is_open())
+        throwFileError(__FILE__, __LINE__, "read the spool for", _fileName);
+    unlink(_fileName.c_str());
+    int fileHandle = ::open(_fileName.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fileHandle < 0)
+        throwFileError(__FILE__, __LINE__, "create", _fileName);
+    if (ftruncate(fileHandle, (off_t)header.fileSize) != 0) {
+        close(fileHandle);
+        throwFileError(__FILE__, __LINE__, "size", _fileName);
+    }
+    void* mapping = mmap(NULL, header.fileSize, PROT_READ | PROT_WRITE, MAP_SHARED, fileHandle, 0);
+    close(fileHandle);
+    if (mapping == MAP_FAILED)
+        throwFileError(__FILE__, __LINE__, "map", _fileName);
+    char* file = (char*)mapping;
+
+    StoredSummary* summaries = (StoredSummary*)(file + header.summaryOffset);
+    unsigned int playType;
+    for (playType = 0; playType < header.playTypeCount; playType++) {
+        summaries[playType].averageDistance = summaryData[playType].getAverageDistance();
+        summaries[playType].distanceVariance = summaryData[playType].getDistanceVariance();
+        summaries[playType].turnoverPercentage = summaryData[playType].getTurnoverPercentage();
+        summaries[playType].totalCount = summaryData[playType].getTotalCount();
+    }
+    unsigned int teamIndex;
+    for (teamIndex = 0; teamIndex < _teams.size(); teamIndex++)
+        strncpy(file + header.teamOffset + (teamIndex * TeamCodeSize), _teams[teamIndex].c_str(), TeamCodeSize - 1);
+
+    /* Copy the spooled plays into their columns, a block at a time. Every column is
+        written front to back, so the system can write pages out as they fill */
+    unsigned char* categories[SinglePlay::score_differential + 1];
+    for (characteristic = 0; characteristic <= (unsigned short)SinglePlay::score_differential; characteristic++)
+        categories[characteristic] = (unsigned char*)(file + header.categoryOffset[characteristic]);
+    unsigned char* playTypes = (unsigned char*)(file + header.playTypeOffset);
+    short* distances = (short*)(file + header.distanceOffset);
+    unsigned char* turnovers = (unsigned char*)(file + header.turnoverOffset);
+    vector<SpoolRecord> records(SpoolBlockSize);
+    unsigned int playNumber = 0;
+    while (playNumber < header.playCount) {
+        unsigned int blockSize = header.playCount - playNumber;
+        if (blockSize > SpoolBlockSize)
+            blockSize = SpoolBlockSize;
+        if (!spool.read((char*)&records[0], blockSize * sizeof(SpoolRecord))) {
+            munmap(mapping, header.fileSize);
+            unlink(_fileName.c_str());
+            errno = 0;
+            throwFileError(__FILE__, __LINE__, "read the spool for", _fileName);
+        }
+        unsigned int recordIndex;
+        for (recordIndex = 0; recordIndex < blockSize; recordIndex++, playNumber++) {
+            const SpoolRecord& record = records[recordIndex];
+            for (characteristic = 0; characteristic <= (unsigned short)SinglePlay::score_differential;
+                 characteristic++)
+                categories[characteristic][playNumber] = record.categories[characteristic];
+            playTypes[playNumber] = record.playType;
+            distances[playNumber] = record.distanceGained;
+            turnovers[playNumber] = record.turnedOver;
+        } // For each play of the block
+    } // For each block
+    spool.close();
+    unlink(_spoolName.c_str());
+
+    memcpy(file, &header, sizeof(header));
+    // The magic goes in last, so a file left partly written by a failure can't be opened
+    memcpy(file, FileMagic, sizeof(FileMagic));
+    if (msync(mapping, header.fileSize, MS_SYNC) != 0) {
+        munmap(mapping, header.fileSize);
+        throwFileError(__FILE__, __LINE__, "write", _fileName);
+    }
+    munmap(mapping, header.fileSize);
+#endif
+}
+
+// Maps a column file read only. Replaces anything opened before
+void ColumnStore::open(const string& fileName)
+{
+    clear();
+#ifdef _WIN32
+    throw BaseException(__FILE__, __LINE__, "Column files need a POSIX system");
+#else
+    errno = 0;
+    int fileHandle = ::open(fileName.c_str(), O_RDONLY);
+    if (fileHandle < 0)
+        throwFileError(__FILE__, __LINE__, "open", fileName);
+    struct stat fileStatus;
+    if (fstat(fileHandle, &fileStatus) != 0) {
+        close(fileHandle);
+        throwFileError(__FILE__, __LINE__, "read the size of", fileName);
+    }
+    unsigned long long fileSize = (unsigned long long)fileStatus.st_size;
+    if (fileSize < sizeof(FileHeader)) {
+        close(fileHandle);
+        errno = 0;
+        throwFileError(__FILE__, __LINE__, "use incomplete", fileName);
+    }
+    void* mapping = mmap(NULL, fileSize, PROT_READ, MAP_SHARED, fileHandle, 0);
+    close(fileHandle);
+    if (mapping == MAP_FAILED)
+        throwFileError(__FILE__, __LINE__, "map", fileName);
+    _file = (const char*)mapping;
+    _fileSize = fileSize;
+
+    // Check it before trusting any of the offsets
+    const FileHeader& header = getHeader();
+    errno = 0;
+    if (memcmp(header.magic, FileMagic, sizeof(FileMagic)) != 0) {
+        clear();
+        throwFileError(__FILE__, __LINE__, "use incomplete", fileName);
+    }
+    bool validLayout = ((header.version == FileVersion) && (header.fileSize == fileSize) &&
+                        (header.playTypeCount == SinglePlay::getPlayTypeCount()) &&
+                        (header.summaryOffset + (header.playTypeCount * sizeof(StoredSummary)) <= header.teamOffset) &&
+                        (header.teamOffset + ((2ULL + header.thisSimiliarCount + header.otherSimiliarCount) *
+                                              TeamCodeSize) <= header.categoryOffset[0]));
+    unsigned short characteristic;
+    for (characteristic = 0; characteristic <= (unsigned short)SinglePlay::score_differential; characteristic++)
+        validLayout = validLayout && (header.categoryOffset[characteristic] + header.playCount <= fileSize);
+    validLayout = validLayout && (header.playTypeOffset + header.playCount <= fileSize) &&
+                  (header.distanceOffset + (header.playCount * sizeof(short)) <= fileSize) &&
+                  (header.turnoverOffset + header.playCount <= fileSize);
+    if (!validLayout) {
+        clear();
+        throwFileError(__FILE__, __LINE__, "use incompatible", fileName);
+    }
+
+    /* The tree builder reads the columns front to back, over and over. Tell the system, so
+        it reads ahead and drops pages behind. Its only advice, so failure doesn't matter */
+    madvise(mapping, fileSize, MADV_SEQUENTIAL);
+#endif
+}
+
+// Summary data of all of the plays, as written
+void ColumnStore::getSummaryData(OverallSummaryData& summaryData) const
+{
+    summaryData.clear();
+    if (_file == NULL)
+        return;
+    const StoredSummary* summaries = (const StoredSummary*)(_file + getHeader().summaryOffset);
+    unsigned int playType;
+    for (playType = 0; playType < getHeader().playTypeCount; playType++)
+        summaryData.push_back(OverallPlaySummary(summaries[playType].averageDistance,
+                                                 summaries[playType].distanceVariance,
+                                                 summaries[playType].turnoverPercentage,
+                                                 summaries[playType].totalCount));
+}
+
+// Teams of the matchup, as written
+void ColumnStore::getTeams(string& thisTeam, string& otherTeam,
+                           vector<string>& thisSimiliar, vector<string>& otherSimiliar) const
+{
+    thisSimiliar.clear();
+    otherSimiliar.clear();
+    if (_file == NULL)
+        return;
+    const char* teams = _file + getHeader().teamOffset;
+    thisTeam = readTeamCode(teams);
+    otherTeam = readTeamCode(teams + TeamCodeSize);
+    unsigned int teamIndex = 2;
+    unsigned int counter;
+    for (counter = 0; counter < getHeader().thisSimiliarCount; counter++, teamIndex++)
+        thisSimiliar.push_back(readTeamCode(teams + (teamIndex * TeamCodeSize)));
+    for (counter = 0; counter < getHeader().otherSimiliarCount; counter++, teamIndex++)
+        otherSimiliar.push_back(readTeamCode(teams + (teamIndex * TeamCodeSize)));
+}
@@ -0,0 +1,245 @@
+/* This file is part of NFLdecisionTree. It creates decision trees to classify
+    situations within NFL football games, and displays the plays historically
+    called in those situations given a set of opponents.
+
+    Copyright (C) 2013   Ezra Erb
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 3 as published
+    by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    I'd appreciate a note if you find this program useful or make
+    updates. Please contact me through LinkedIn (my profile also has
+    a link to the code depository)
+*/
+#include<fstream>
+
+/* This class holds the plays for a matchup as columns in a file, for building the
+    decision tree without holding the plays in memory. The data store keeps every play as
+    an object with all of its fields, plus five indexes of pointers to them, and every
+    node of the tree copies the indexes of its parent. For a large enough set of plays,
+    such as league wide data over many seasons, that no longer fits.
+
+    The file holds one column per field the tree builder reads: the category of each
+    characteristic, the play type, the distance gained and whether the play turned over.
+    A pass over the plays reads only the columns it needs, one byte or two per play. The
+    file is mapped read only, so the operating system pages the columns in as they are
+    read and drops them again under memory pressure. The summary data for all the plays
+    and the teams of the matchup are stored with the columns, so a file is complete on
+    its own.
+
+    Plays are numbered by their position in the columns. The tree builder keeps only a
+    list of play numbers, divided into a range for each node (see DecisionNode).
+
+    Files are written by ColumnWriter, below, without holding the plays in memory either. */
+using std::string; // Header deliberately not included, clients should already have it
+using std::vector;
+using std::ofstream;
+
+class PlayBatch; // Only used by reference here
+class PlayLoader; // Only used by reference here
+
+class ColumnStore {
+public:
+    // Creates an empty store
+    ColumnStore();
+
+    // Destructor. Unmaps any open file
+    ~ColumnStore();
+
+    // Maps a column file read only. Replaces anything opened before
+    void open(const string& fileName);
+
+    /* Column types. The tree builder reads league stores the same way (see LeagueColumns),
+        with its own types */
+    typedef const unsigned char* CategoryColumn;
+    typedef const unsigned char* PlayTypeColumn;
+    typedef const short* DistanceColumn;
+    typedef const unsigned char* TurnoverColumn;
+
+    // Number of plays held
+    unsigned int getPlayCount() const;
+
+    // Category of every play for a characteristic
+    CategoryColumn getCategories(SinglePlay::PlayCharacteristic characteristic) const;
+
+    // Column of play types
+    PlayTypeColumn getPlayTypes() const;
+
+    // Column of distances gained
+    DistanceColumn getDistances() const;
+
+    // Column of flags for plays that turned over, one for turnovers and zero otherwise
+    TurnoverColumn getTurnovers() const;
+
+    // Summary data of all of the plays, as written
+    void getSummaryData(OverallSummaryData& summaryData) const;
+
+    // Teams of the matchup, as written
+    void getTeams(string& thisTeam, string& otherTeam,
+                  vector<string>& thisSimiliar, vector<string>& otherSimiliar) const;
+
+private:
+    // The writer lays out files, so it shares the layout below
+    friend class ColumnWriter;
+
+    /* File layout. WARNING: Increase FileVersion whenever any of these change, so
+        programs built with the old layout refuse to open the file */
+    static const unsigned int FileVersion = 2;
+
+    // Summary data for one play type
+    struct StoredSummary {
+        short averageDistance;
+        short distanceVariance;
+        short turnoverPercentage;
+        short padding;
+        unsigned int totalCount;
+    };
+
+    struct FileHeader {
+        char magic[8]; // Written last, so a partly written file can't be opened
+        unsigned int version;
+        unsigned int playCount;
+        unsigned int playTypeCount;
+        unsigned int thisSimiliarCount;
+        unsigned int otherSimiliarCount;
+        unsigned int padding;
+        /* Offsets from the start of the file. Teams are eight characters each: this team,
+            the other team, then the similiar teams to each */
+        unsigned long long summaryOffset;
+        unsigned long long teamOffset;
+        unsigned long long categoryOffset[SinglePlay::score_differential + 1];
+        unsigned long long playTypeOffset;
+        unsigned long long distanceOffset;
+        unsigned long long turnoverOffset;
+        unsigned long long fileSize;
+    };
+
+    // Mapped file, if any. NULL otherwise
+    const char* _file;
+    unsigned long long _fileSize;
+
+    // Returns the header of the mapped file
+    const FileHeader& getHeader() const;
+
+    // Releases any mapped file
+    void clear();
+
+    // Prohibit copying, which would unmap the file twice
+    ColumnStore(const ColumnStore& other);
+    ColumnStore& operator=(const ColumnStore& other);
+};
+
+/* This class writes a column file a few plays at a time, so a file can be made for more
+    plays than fit in memory. Loaders add plays as they read them, typically a season at a
+    time, and the writer keeps only the running totals needed for the summary data.
+
+    The size of each column depends on the number of plays, which isn't known until the
+    last one is added, so plays go to a spool file next to the column file first, one
+    fixed size record each. finish() lays out the column file and copies each record into
+    place in a single pass over the spool, which is then deleted. A writer that is never
+    finished deletes its spool and leaves no column file behind */
+class ColumnWriter {
+public:
+    /* Starts a column file for the plays of a matchup. Nothing is written to the file
+        itself until finish() is called. Throws if the teams can't be stored */
+    ColumnWriter(const string& fileName, const string& thisTeam, const string& otherTeam,
+                 const vector<string>& thisSimiliar, const vector<string>& otherSimiliar);
+
+    // Destructor. Deletes the spool file
+    ~ColumnWriter();
+
+    // Adds a play to the end of the file
+    void addPlay(const SinglePlay& play);
+
+    // Adds every play of a batch, in order, to the end of the file
+    void addPlays(const PlayBatch& batch);
+
+    /* Loads the plays of the matchup for a range of seasons, [first...last], and adds them
+        in the order PlayLoader::loadPlays would. Only one season is held in memory at a time */
+    void addSeasons(PlayLoader& loader, unsigned short firstYear, unsigned short lastYear);
+
+    /* Writes the column file, along with the summary data for all of the plays added and
+        the teams of the matchup. Replaces any existing file */
+    void finish();
+
+    // Number of plays added
+    unsigned int getPlayCount() const;
+
+private:
+    // A play as spooled. The same fields, in the same types, as the columns
+    struct SpoolRecord {
+        unsigned char categories[SinglePlay::score_differential + 1];
+        unsigned char playType;
+        unsigned char turnedOver;
+        short distanceGained;
+    };
+
+    string _fileName;
+    string _spoolName;
+    ofstream _spool;
+    vector<string> _teams; // This team, the other team, then the similiar teams to each
+    unsigned int _thisSimiliarCount;
+    unsigned int _otherSimiliarCount;
+    unsigned int _playCount;
+
+    // Running totals by play type, for the summary data
+    vector<long> _typeCounts;
+    vector<long> _distanceSums;
+    vector<long long> _distanceSquares;
+    vector<long> _turnoverCounts;
+
+    // Prohibit copying, which would delete the spool twice
+    ColumnWriter(const ColumnWriter& other);
+    ColumnWriter& operator=(const ColumnWriter& other);
+};
+
+// Number of plays added
+inline unsigned int ColumnWriter::getPlayCount() const
+{
+    return _playCount;
+}
+
+// Returns the header of the mapped file
+inline const ColumnStore::FileHeader& ColumnStore::getHeader() const
+{
+    return *((const FileHeader*)_file);
+}
+
+// Number of plays held
+inline unsigned int ColumnStore::getPlayCount() const
+{
+    return (_file != NULL) ? getHeader().playCount : 0;
+}
+
+// Category of every play for a characteristic
+inline const unsigned char* ColumnStore::getCategories(SinglePlay::PlayCharacteristic characteristic) const
+{
+    return (const unsigned char*)(_file + getHeader().categoryOffset[characteristic]);
+}
+
+// Column of play types
+inline const unsigned char* ColumnStore::getPlayTypes() const
+{
+    return (const unsigned char*)(_file + getHeader().playTypeOffset);
+}
+
+// Column of distances gained
+inline const short* ColumnStore::getDistances() const
+{
+    return (const short*)(_file + getHeader().distanceOffset);
+}
+
+// Column of flags for plays that turned over, one for turnovers and zero otherwise
+inline const unsigned char* ColumnStore::getTurnovers() const
+{
+    return (const unsigned char*)(_file + getHeader().turnoverOffset);
+}
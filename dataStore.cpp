@@ -27,12 +27,113 @@
 #include"singlePlay.h"
 #include"playIndexSet.h"
 #include"playStats.h"
+#include"allocTracker.h"
 #include"dataStore.h"
+#include"parallelSettings.h"
+#include"parallelTasks.h"
+#include"runStats.h"
+#include"traceLog.h"
 
 #include<iostream>
 using std::cerr;
 using std::endl;
 
+/* Indexes are built in parallel once there are this many plays. Below it, starting
+    threads costs more than it saves */
+static const unsigned long ParallelIndexPlays = 65536;
+
+// Number of characteristics indexed. Indexes are kept in the order of the enum
+static const unsigned short IndexCount = (unsigned short)SinglePlay::score_differential + 1;
+
+// Indexes plays [first...last) by every characteristic, adding them to the indexes
+static void indexPlays(PlayIterator first, PlayIterator last, vector<CategoryIndex>& indexes)
+{
+    unsigned short characteristic;
+    indexes.resize(IndexCount);
+    for (characteristic = 0; characteristic < IndexCount; characteristic++)
+        indexes[characteristic].resize(SinglePlay::getCategoryCount((SinglePlay::PlayCharacteristic)characteristic));
+    CategoryIndex& downIndex = indexes[SinglePlay::down_number];
+    CategoryIndex& distanceNeededIndex = indexes[SinglePlay::distance_needed];
+    CategoryIndex& fieldLocationIndex = indexes[SinglePlay::field_location];
+    CategoryIndex& timeRemainingIndex = indexes[SinglePlay::time_remaining];
+    CategoryIndex& scoreDifferentialIndex = indexes[SinglePlay::score_differential];
+    PlayIterator indexValue;
+    for (indexValue = first; indexValue != last; indexValue++) {
+        downIndex[(unsigned short)indexValue->getDown()].push_back(indexValue);
+        distanceNeededIndex[(unsigned short)indexValue->getDistanceNeeded()].push_back(indexValue);
+        fieldLocationIndex[(unsigned short)indexValue->getFieldLocation()].push_back(indexValue);
+        timeRemainingIndex[(unsigned short)indexValue->getTimeRemaining()].push_back(indexValue);
+        scoreDifferentialIndex[(unsigned short)indexValue->getScoreDifferential()].push_back(indexValue);
+    }
+}
+
+/* Builds indexes in parallel. First each task indexes its own range of the plays. Then
+    each task merges the ranges for one characteristic, in play order, so the indexes are
+    exactly those a single loop over the plays builds */
+class IndexBuildTasks : public ParallelTasks {
+public:
+    // Splits the plays into ranges, one per task
+    IndexBuildTasks(const PlayVector& plays, unsigned int rangeCount);
+
+    // Builds the indexes. They are in the order of the characteristic enum
+    void buildIndexes(vector<CategoryIndex>& indexes);
+
+protected:
+    virtual void runTask(unsigned int taskNumber);
+
+private:
+    const PlayVector& _plays;
+    unsigned int _rangeCount;
+    vector<vector<CategoryIndex> > _rangeIndexes; // By range, then characteristic
+    vector<CategoryIndex>* _indexes; // Merge results. NULL while indexing ranges
+};
+
+// Splits the plays into ranges, one per task
+IndexBuildTasks::IndexBuildTasks(const PlayVector& plays, unsigned int rangeCount)
+    : _plays(plays), _rangeCount(rangeCount), _rangeIndexes(rangeCount), _indexes(NULL)
+{
+    // All in the initialization list
+}
+
+// Builds the indexes. They are in the order of the characteristic enum
+void IndexBuildTasks::buildIndexes(vector<CategoryIndex>& indexes)
+{
+    _indexes = NULL;
+    run(_rangeCount);
+    indexes.assign(IndexCount, CategoryIndex());
+    _indexes = &indexes;
+    run(IndexCount);
+}
+
+void IndexBuildTasks::runTask(unsigned int taskNumber)
+{
+    ALLOC_SCOPE(index_memory);
+    if (_indexes == NULL) {
+        // Index one range of the plays
+        PlayIterator first = _plays.begin() + ((_plays.size() * taskNumber) / _rangeCount);
+        PlayIterator last = _plays.begin() + ((_plays.size() * (taskNumber + 1)) / _rangeCount);
+        indexPlays(first, last, _rangeIndexes[taskNumber]);
+        return;
+    }
+
+    // Merge the ranges for one characteristic, freeing each once it is merged
+    CategoryIndex& result = (*_indexes)[taskNumber];
+    result.resize(SinglePlay::getCategoryCount((SinglePlay::PlayCharacteristic)taskNumber));
+    unsigned short category;
+    unsigned int range;
+    for (category = 0; category < result.size(); category++) {
+        unsigned long playCount = 0;
+        for (range = 0; range < _rangeCount; range++)
+            playCount += _rangeIndexes[range][taskNumber][category].size();
+        result[category].reserve(playCount);
+        for (range = 0; range < _rangeCount; range++) {
+            PlayIndex& rangeIndex = _rangeIndexes[range][taskNumber][category];
+            result[category].insert(result[category].end(), rangeIndex.begin(), rangeIndex.end());
+            PlayIndex().swap(rangeIndex);
+        }
+    } // Loop through categories
+}
+
 // Creates an empty data store
 DataStore::DataStore()
     : _data(), _indexes()
@@ -40,32 +141,112 @@ DataStore::DataStore()
     // All in the initialization list
 }
 
+// Creates an empty batch
+PlayBatch::PlayBatch()
+    : _playTypes(), _downs(), _distancesNeeded(), _yardLines(), _minutes(), _ownScores(),
+      _oppScores(), _distancesGained(), _turnedOver()
+{
+    // All in the initialization list
+}
+
+// Makes room for a number of plays, for callers that know how many are coming
+void PlayBatch::reserve(unsigned long playCount)
+{
+    _playTypes.reserve(playCount);
+    _downs.reserve(playCount);
+    _distancesNeeded.reserve(playCount);
+    _yardLines.reserve(playCount);
+    _minutes.reserve(playCount);
+    _ownScores.reserve(playCount);
+    _oppScores.reserve(playCount);
+    _distancesGained.reserve(playCount);
+    _turnedOver.reserve(playCount);
+}
+
+// Removes all plays, keeping the memory for reuse
+void PlayBatch::clear()
+{
+    _playTypes.clear();
+    _downs.clear();
+    _distancesNeeded.clear();
+    _yardLines.clear();
+    _minutes.clear();
+    _ownScores.clear();
+    _oppScores.clear();
+    _distancesGained.clear();
+    _turnedOver.clear();
+}
+
+/* Converts a range of the plays, [first...first + count), to plays and adds them to the
+    end of a list. Reference IDs start at the one given */
+void PlayBatch::appendPlays(unsigned long first, unsigned long count, unsigned int firstRefId,
+                            PlayVector& plays) const
+{
+    if (!count)
+        return;
+
+    // Convert the situations a column at a time, then build the plays in one pass
+    vector<unsigned char> categories(count * 4);
+    unsigned char* distanceNeeded = &categories[0];
+    unsigned char* fieldLocation = distanceNeeded + count;
+    unsigned char* timeRemaining = fieldLocation + count;
+    unsigned char* scoreDifferential = timeRemaining + count;
+    SinglePlay::categorizeDistances(&_distancesNeeded[first], count, distanceNeeded);
+    SinglePlay::categorizeYardLines(&_yardLines[first], count, fieldLocation);
+    SinglePlay::categorizeMinutes(&_minutes[first], count, timeRemaining);
+    SinglePlay::categorizeScores(&_ownScores[first], &_oppScores[first], count, scoreDifferential);
+
+    unsigned long index;
+    for (index = 0; index < count; index++)
+        plays.push_back(SinglePlay(firstRefId + index, (SinglePlay::PlayType)_playTypes[first + index],
+                                   _downs[first + index],
+                                   (SinglePlay::DistanceNeeded)distanceNeeded[index],
+                                   (SinglePlay::FieldLocation)fieldLocation[index],
+                                   (SinglePlay::TimeRemaining)timeRemaining[index],
+                                   (SinglePlay::ScoreDifferential)scoreDifferential[index],
+                                   _distancesGained[first + index], _turnedOver[first + index] != 0));
+}
+
+/* Inserts every play of a batch, in order, as though each had been inserted with
+    insertPlay(). The batch is unchanged */
+void DataStore::insertPlays(const PlayBatch& batch)
+{
+    ALLOC_SCOPE(data_store_memory);
+    /* Grow once for the batch. Growth stays geometric, so inserting many small batches
+        doesn't copy the store for each one. Reference IDs continue from the plays already
+        inserted, as insertPlay() assigns them */
+    unsigned long wantedSize = _data.size() + batch.size();
+    if (_data.capacity() < wantedSize)
+        _data.reserve((wantedSize > _data.capacity() * 2) ? wantedSize : _data.capacity() * 2);
+    batch.appendPlays(0, batch.size(), _data.size(), _data);
+}
+
 /* Build indexes and derive collective play data. Indicates insertion is done. Data inserted
     after calling this method will be ignored */
 void DataStore::buildIndexes()
 {
+    STATS_PHASE(build_indexes);
+    ALLOC_SCOPE(index_memory);
+    TRACE_SCOPE("build_indexes", "plays", _data.size());
     // If the method is called with the data store empty, do nothing. In practice this indicates an error
     if (_data.empty())
         return;
 
-    // Iterate through the data and build the indexes
-    CategoryIndex downIndex(SinglePlay::getCategoryCount(SinglePlay::down_number));
-    CategoryIndex distanceNeededIndex(SinglePlay::getCategoryCount(SinglePlay::distance_needed));
-    CategoryIndex fieldLocationIndex(SinglePlay::getCategoryCount(SinglePlay::field_location));
-    CategoryIndex timeRemainingIndex(SinglePlay::getCategoryCount(SinglePlay::time_remaining));
-    CategoryIndex scoreDifferentialIndex(SinglePlay::getCategoryCount(SinglePlay::score_differential));
-
-    PlayIterator indexValue;
-    for (indexValue = _data.begin(); indexValue != _data.end(); indexValue++) {
-        downIndex[(unsigned short)indexValue->getDown()].push_back(indexValue);
-        distanceNeededIndex[(unsigned short)indexValue->getDistanceNeeded()].push_back(indexValue);
-        fieldLocationIndex[(unsigned short)indexValue->getFieldLocation()].push_back(indexValue);
-        timeRemainingIndex[(unsigned short)indexValue->getTimeRemaining()].push_back(indexValue);
-        scoreDifferentialIndex[(unsigned short)indexValue->getScoreDifferential()].push_back(indexValue);
+    /* Iterate through the data and build the indexes. Large stores are split into
+        ranges, one per worker thread */
+    vector<CategoryIndex> indexes;
+    unsigned short workerCount = ParallelSettings::getWorkerCount();
+    if ((workerCount > 1) && (_data.size() >= ParallelIndexPlays)) {
+        IndexBuildTasks tasks(_data, workerCount);
+        tasks.buildIndexes(indexes);
     }
+    else
+        indexPlays(_data.begin(), _data.end(), indexes);
     // Copy into the object
-    _indexes.setIndexes(downIndex, distanceNeededIndex, fieldLocationIndex, timeRemainingIndex,
-                        scoreDifferentialIndex);
+    _indexes.setIndexes(indexes[SinglePlay::down_number], indexes[SinglePlay::distance_needed],
+                        indexes[SinglePlay::field_location], indexes[SinglePlay::time_remaining],
+                        indexes[SinglePlay::score_differential]);
     // Find overall plays statistics
+    ALLOC_SCOPE(data_store_memory);
     PlaySummaryFactory::buildSummaryData(_indexes, _playSummaryStats);
 }
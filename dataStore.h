@@ -59,9 +59,52 @@
     be called in one class, so finding misuse is easy. 2. All data read out of the
     object will be done by index, which is derived. As long as the internal data stays
     consistent on insert, index methods will still be valid even after more inserts.
-    The inserted data will be ignored, but this is acceptable */
+    The inserted data will be ignored, but this is acceptable. Stores that must keep taking
+    plays while trees are built from them use VersionedStore instead */
 using std::vector;
 
+/* Plays waiting to be inserted into a data store together, held as one column per
+    field. Loaders add each play they want as they parse it, and insert the whole batch
+    at once, so the store grows once per batch and the situations are converted to
+    categories a column at a time. Batches built separately, by different threads for
+    example, are each inserted with a single call */
+class PlayBatch {
+    public:
+        // Creates an empty batch
+        PlayBatch();
+
+        // Use the default copy constructor, assignment operator and destructor
+
+        // Adds a play. Takes the same data as DataStore::insertPlay()
+        void addPlay(SinglePlay::PlayType playType, short down, short distanceNeeded,
+                     short yardLine, short minutes, short ownScore, short oppScore,
+                     short distanceGained, bool turnedOver);
+
+        // Makes room for a number of plays, for callers that know how many are coming
+        void reserve(unsigned long playCount);
+
+        // Removes all plays, keeping the memory for reuse
+        void clear();
+
+        unsigned long size() const;
+
+        /* Converts a range of the plays, [first...first + count), to plays and adds them to
+            the end of a list. Reference IDs start at the one given */
+        void appendPlays(unsigned long first, unsigned long count, unsigned int firstRefId,
+                         PlayVector& plays) const;
+
+    private:
+        vector<unsigned char> _playTypes;
+        vector<short> _downs;
+        vector<short> _distancesNeeded;
+        vector<short> _yardLines;
+        vector<short> _minutes;
+        vector<short> _ownScores;
+        vector<short> _oppScores;
+        vector<short> _distancesGained;
+        vector<unsigned char> _turnedOver;
+};
+
 class DataStore {
     public:
         // Creates an empty data store
@@ -74,6 +117,19 @@ class DataStore {
                         short yardLine, short minutes, short ownScore, short oppScore,
                         short distanceGained, bool turnedOver);
 
+        /* Inserts a single play whose situation is already converted to categories, like
+            those from a league store */
+        void insertPlay(SinglePlay::PlayType playType, short down, SinglePlay::DistanceNeeded distanceNeeded,
+                        SinglePlay::FieldLocation fieldLocation, SinglePlay::TimeRemaining timeRemaining,
+                        SinglePlay::ScoreDifferential scoreDifferential, short distanceGained, bool turnedOver);
+
+        // Makes room for a number of plays, for callers that know how many are coming
+        void reserve(unsigned long playCount);
+
+        /* Inserts every play of a batch, in order, as though each had been inserted with
+            insertPlay(). The batch is unchanged */
+        void insertPlays(const PlayBatch& batch);
+
         /* Build indexes and derive collective play data. Indicates insertion is done. Data inserted
             after calling this method will be ignored */
         void buildIndexes();
@@ -99,22 +155,65 @@ class DataStore {
         DataStore& operator=(const DataStore& other);
 };
 
+// Adds a play. Takes the same data as DataStore::insertPlay()
+inline void PlayBatch::addPlay(SinglePlay::PlayType playType, short down, short distanceNeeded,
+                               short yardLine, short minutes, short ownScore, short oppScore,
+                               short distanceGained, bool turnedOver)
+{
+    _playTypes.push_back((unsigned char)playType);
+    _downs.push_back(down);
+    _distancesNeeded.push_back(distanceNeeded);
+    _yardLines.push_back(yardLine);
+    _minutes.push_back(minutes);
+    _ownScores.push_back(ownScore);
+    _oppScores.push_back(oppScore);
+    _distancesGained.push_back(distanceGained);
+    _turnedOver.push_back(turnedOver ? 1 : 0);
+}
+
+inline unsigned long PlayBatch::size() const
+{
+    return _playTypes.size();
+}
+
 // Inserts a single play. It takes the data to avoid excess object copies
 inline void DataStore::insertPlay(SinglePlay::PlayType playType, short down, short distanceNeeded,
                                   short yardLine, short minutes, short ownScore, short oppScore,
                                   short distanceGained, bool turnedOver)
 {
+    ALLOC_SCOPE(data_store_memory);
     // Play data goes into the data list, accumulation data goes into total for play type
     // Use the current size of the store as the reference ID, should ensure uniqueness
     _data.push_back(SinglePlay(_data.size(), playType, down, distanceNeeded, yardLine,
                                minutes, ownScore, oppScore, distanceGained, turnedOver));
 }
 
+/* Inserts a single play whose situation is already converted to categories, like
+    those from a league store */
+inline void DataStore::insertPlay(SinglePlay::PlayType playType, short down, SinglePlay::DistanceNeeded distanceNeeded,
+                                  SinglePlay::FieldLocation fieldLocation, SinglePlay::TimeRemaining timeRemaining,
+                                  SinglePlay::ScoreDifferential scoreDifferential, short distanceGained,
+                                  bool turnedOver)
+{
+    ALLOC_SCOPE(data_store_memory);
+    _data.push_back(SinglePlay(_data.size(), playType, down, distanceNeeded, fieldLocation,
+                               timeRemaining, scoreDifferential, distanceGained, turnedOver));
+}
+
+// Makes room for a number of plays, for callers that know how many are coming
+inline void DataStore::reserve(unsigned long playCount)
+{
+    ALLOC_SCOPE(data_store_memory);
+    if (_data.capacity() < _data.size() + playCount)
+        _data.reserve(_data.size() + playCount);
+}
+
 
 /* Returns index data for this data store. A COPY is returned so the client can manipulate
     it as plays are divided up */
 inline PlayIndexSet DataStore::getIndexes() const
 {
+    ALLOC_SCOPE(index_memory);
     return _indexes;
 }
 
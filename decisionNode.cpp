@@ -25,36 +25,113 @@
 #include<iostream>
 #include<cstdlib>
 #include<bitset>
+#include<string>
+#include<algorithm>
+#include<cmath>
+#include<cstring>
 #include"singlePlay.h"
 #include"playIndexSet.h"
 #include"playStats.h"
+#include"playHistogram.h"
+#include"columnStore.h"
 #include"decisionNode.h"
+#include"splitCriteria.h"
 #include"baseException.h"
+#include"runStats.h"
+#include"allocTracker.h"
+#include"dataStore.h" // Needed by leagueStore.h
+#include"playLoader.h" // Needed by leagueStore.h
+#include"leagueStore.h"
+#include"traceLog.h"
 
 using std::vector;
 using std::map;
 using std::ostream;
 using std::make_pair;
 using std::bitset;
+using std::copy;
 
 using std::cerr;
 using std::endl;
 
 // Lower limit of information gain ratio where a split is valuable
-const double DecisionNode::MinInformationGain = 0.02;
+const double DecisionNode::MinInformationGain = GainRatioCriterion::getMinimumScore();
+
+// Split mode, selection and criterion for trees being built
+DecisionNode::SplitMode DecisionNode::_splitMode = DecisionNode::category_split;
+DecisionNode::SplitSelection DecisionNode::_splitSelection = DecisionNode::exact_selection;
+DecisionNode::SplitCriterion DecisionNode::_splitCriterion = DecisionNode::gain_ratio_criterion;
+DecisionNode::SplitTarget DecisionNode::_splitTarget = DecisionNode::play_type_target;
+short DecisionNode::_yardagePlayType = PlayHistogram::all_play_types;
+
+/* Yardage split limits. Situations explain only a little of the variance of a play's
+    distance, most of it being the play itself, so the share wanted is small */
+const double DecisionNode::MinVarianceReduction = 0.01;
+const short DecisionNode::MinYardagePlays = 10;
+
+/* Sampling parameters. The first sample is big enough that the bound could possibly be
+    met, and the confidence makes a wrong decision about as rare as one in a thousand nodes */
+const unsigned long DecisionNode::SampleStart = 4096;
+const double DecisionNode::SampleConfidence = 0.001;
+
+/* Returns the next value from a simple random number generator (xorshift). Sampling
+    needs speed and repeatable trees far more than it needs high quality numbers.
+    WARNING: The state must never be zero */
+static unsigned long long nextRandom(unsigned long long& state)
+{
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 2685821657736338717ULL;
+}
 
 /* Constructor. Requires a set of indexes into the play store.
     WARNING: Indexes are modified thanks to the splitting proecess */
 DecisionNode::DecisionNode(PlayIndexSet& indexes, const OverallSummaryData& summaryData)
-    : _childNodes(), _categoryChildMapping(), _playData()
+    : _childNodes(), _categoryChildMapping(), _playData(), _ownDistancePool(NULL), _distancePool(NULL)
 {
-    /* First, assemble data about the plays in the index. Need the number of play types and
-        the number of plays per type. A map handles this nicely */
-    PlayCountMap playTypeCounts;
-    indexesToPlayCounts(indexes, playTypeCounts);
+    {
+        ALLOC_SCOPE(tree_memory);
+        _ownDistancePool = new DistancePool();
+    }
+    _distancePool = _ownDistancePool;
+    // The destructor is not called if construction fails, so release the pool here
+    try {
+        // The root counts its plays itself. Nodes below usually get their counts from their parent
+        buildNode(indexes, summaryData, NULL, 0);
+    } // Try block
+    catch (...) {
+        delete _ownDistancePool;
+        throw;
+    } // Catch any exception
+}
 
-    // If the play data is empty, so are the indexes. This indicates a serious problem
-    if (playTypeCounts.empty())
+/* Constructor for nodes below the root. The histogram holds the counts of the plays
+    in the indexes, or is NULL if the parent did not count them. The pool is the one
+    owned by the root. Depth is the distance from the root, which is only used for
+    statistics */
+DecisionNode::DecisionNode(PlayIndexSet& indexes, const OverallSummaryData& summaryData,
+                           const PlayHistogram* histogram, DistancePool& distancePool,
+                           unsigned short depth)
+    : _childNodes(), _categoryChildMapping(), _playData(), _ownDistancePool(NULL),
+      _distancePool(&distancePool)
+{
+    buildNode(indexes, summaryData, histogram, depth);
+}
+
+// Builds this node and all nodes underneath it. Called by the constructors
+void DecisionNode::buildNode(PlayIndexSet& indexes, const OverallSummaryData& summaryData,
+                             const PlayHistogram* histogram, unsigned short depth)
+{
+    ALLOC_SCOPE(tree_memory);
+    STATS_COUNT(nodes_created, 1);
+    // Statistics for the tree level cover this node only, not the ones below it
+    STATS_LEVEL_TIMER(levelTimer);
+    unsigned long playCount = indexes.getPlayCount();
+    TRACE_SCOPE("build_node", "depth", depth, "plays", playCount);
+
+    // If the indexes are empty, this indicates a serious problem
+    if (playCount == 0)
         throw BaseException(__FILE__, __LINE__, "DecisionNode create failed, passed play store empty");
 
     /* At this point, need to find the characteristic split that will best divide
@@ -63,77 +140,60 @@ DecisionNode::DecisionNode(PlayIndexSet& indexes, const OverallSummaryData& summ
         stopping value, this node should be created as a leaf. Otherwise it becomes
         a decision node */
     double maxInfoRatio = 0.0;
-
-    /* If the play data has only one play type, no further splitting is possible.
-        Information gain ratio is zero */
-    if (playTypeCounts.size() > 1) {
-        PlayCharacteristicSet::const_iterator testIndex;
-
-        // Default vector of counts per play type
-        vector<short> defaultPlayCounts(SinglePlay::getPlayTypeCount(), 0);
-
-        /* Indexes found to be redundant are dropped. Make a copy of the available set
-            here, to ensure iterators are stable */
+    // Groups of categories for each child, for binary splits. Empty means one child per category
+    vector<short> bestGroups;
+
+    // Large nodes the parent did not count try a sample first, if wanted
+    bool haveSplit = false;
+    if ((histogram == NULL) && (_splitSelection == sampled_selection) && (_splitTarget == play_type_target))
+        haveSplit = chooseSplitFromSample(indexes, playCount, depth, maxInfoRatio, bestGroups);
+    PlayHistogram countedHistogram(getHistogramDistances());
+    if (!haveSplit) {
+        if (histogram == NULL) {
+            countedHistogram.addPlays(indexes);
+            histogram = &countedHistogram;
+        } // Parent did not count the plays
+        PlayCharacteristicSet available(indexes.getIndexesAvailable());
+        chooseSplit(*histogram, available, maxInfoRatio, bestGroups);
+        // Characteristics that can't split the plays are dropped from the indexes as well
         PlayCharacteristicSet testCharacteristics(indexes.getIndexesAvailable());
-        for (testIndex = testCharacteristics.begin(); testIndex != testCharacteristics.end();
-             testIndex++) {
-            double infoRatio = 0.0; // Informaion gain ratio for this index
-
-            /* Using constant references is normally bad, but the routine
-                has considerably logic and copying an index is expensive */
-            const CategoryIndex& splitIndex = indexes.getIndex(*testIndex);
-
-            /* Category indexes split by category type. Find the play counts for each
-                and use them to find the information gain */
-            vector<vector<short> > splitPlayCounts;
-            vector<short> splitPlayTotals;
-            short playTotals = 0;
-
-            CategoryIndex::const_iterator catIndex;
-            PlayIndex::const_iterator playIndex;
-            for (catIndex = splitIndex.begin(); catIndex != splitIndex.end(); catIndex++)
-                if (!catIndex->empty()) {
-                    splitPlayCounts.push_back(defaultPlayCounts);
-                    for (playIndex = catIndex->begin(); playIndex != catIndex->end(); playIndex++)
-                        splitPlayCounts.back().at((unsigned short)((*playIndex)->getPlayType()))++;
-                    splitPlayTotals.push_back(catIndex->size());
-                    playTotals += catIndex->size();
-                } // Category has plays
-
-            // If all plays are in one category, the information gain by definition is zero
-            if (splitPlayTotals.size() <= 1)
-                infoRatio = 0.0;
-            else
-                infoRatio = getInfoGainRatio(playTypeCounts, playTotals, splitPlayCounts, splitPlayTotals);
-
-            if (infoRatio < MinInformationGain)
-            // Index can't be used for splitting, so its redundant
+        PlayCharacteristicSet::const_iterator testIndex;
+        for (testIndex = testCharacteristics.begin(); testIndex != testCharacteristics.end(); testIndex++)
+            if (available.find(*testIndex) == available.end())
                 indexes.dropIndex(*testIndex);
-
-            else {
-                _decisionValue = *testIndex;
-                maxInfoRatio = infoRatio;
-            } // Characteristic is best split found so far
-        } // For each characteristic with an index defined
-    } // Multiple play types within the indexes
+    } // Split not chosen from a sample
 
     /* If information gain is greater than the minimum for a split, create a decision
         node, otherwise create a leaf */
-    if (maxInfoRatio >= MinInformationGain) {
+    if (maxInfoRatio >= getMinimumScore()) {
         /* Children will only be created for values with plays. The order will be the same
             as the order of the categories. Use this to create the mapping from categories
             to children. It needs to be done here because the split below will change the index */
-        const CategoryIndex& splitIndex = indexes.getIndex(_decisionValue);
-        _categoryChildMapping.assign(splitIndex.size(), -1); // 0 is a valid value!
-        short valueCount = 0;
-        unsigned short catIndex;
-        for (catIndex = 0; catIndex < splitIndex.size(); catIndex++)
-            if (splitIndex[catIndex].size() > 0) {
-                _categoryChildMapping.at(catIndex) = valueCount;
-                valueCount++;
-            } // Category with values
-
-        vector<PlayIndexSet> newIndexes(indexes.splitIndexByCharacteristic(_decisionValue));
+        vector<PlayIndexSet> newIndexes;
+        if (!bestGroups.empty()) {
+            /* Binary split. The groups already map categories to children. A sample can miss
+                categories with few plays; put them in the second group */
+            const CategoryIndex& splitIndex = indexes.getIndex(_decisionValue);
+            unsigned short catIndex;
+            for (catIndex = 0; catIndex < splitIndex.size(); catIndex++)
+                if ((bestGroups[catIndex] < 0) && (!splitIndex[catIndex].empty()))
+                    bestGroups[catIndex] = 1;
+            _categoryChildMapping = bestGroups;
+            indexes.splitIndexByGroups(_decisionValue, bestGroups).swap(newIndexes);
+        }
+        else {
+            const CategoryIndex& splitIndex = indexes.getIndex(_decisionValue);
+            _categoryChildMapping.assign(splitIndex.size(), -1); // 0 is a valid value!
+            short valueCount = 0;
+            unsigned short catIndex;
+            for (catIndex = 0; catIndex < splitIndex.size(); catIndex++)
+                if (splitIndex[catIndex].size() > 0) {
+                    _categoryChildMapping.at(catIndex) = valueCount;
+                    valueCount++;
+                } // Category with values
+
+            indexes.splitIndexByCharacteristic(_decisionValue).swap(newIndexes);
+        } // Split by category
 
         /* If the new indexes are empty, something went seriously wrong. About to start an infinite loop
             (because the indxes just attempt to be split will be pasesed to a new node, which won't be
@@ -141,13 +201,40 @@ DecisionNode::DecisionNode(PlayIndexSet& indexes, const OverallSummaryData& summ
         if (newIndexes.empty())
             throw BaseException(__FILE__, __LINE__, "DecisionNode create failed, split of play store data failed");
 
+        /* Count the plays of every child but the largest directly. The largest gets the
+            counts of this node minus those of the others, which is much cheaper than counting
+            it. If this node was chosen from a sample, it has no counts to subtract from, so
+            the children count or sample their own plays.
+            NOTE: The first child is the remains of the indexes for this node */
+        vector<PlayIndexSet*> childIndexes;
+        childIndexes.push_back(&indexes);
+        vector<PlayIndexSet>::iterator newIndexesPtr;
+        for (newIndexesPtr = newIndexes.begin(); newIndexesPtr != newIndexes.end(); newIndexesPtr++)
+            childIndexes.push_back(&(*newIndexesPtr));
+        vector<PlayHistogram> childHistograms;
+        unsigned short childIndex;
+        if (histogram != NULL) {
+            unsigned short largestChild = 0;
+            for (childIndex = 1; childIndex < childIndexes.size(); childIndex++)
+                if (childIndexes[childIndex]->getPlayCount() > childIndexes[largestChild]->getPlayCount())
+                    largestChild = childIndex;
+            childHistograms.assign(childIndexes.size(), PlayHistogram(getHistogramDistances()));
+            childHistograms[largestChild] = *histogram;
+            for (childIndex = 0; childIndex < childIndexes.size(); childIndex++)
+                if (childIndex != largestChild) {
+                    childHistograms[childIndex].addPlays(*childIndexes[childIndex]);
+                    childHistograms[largestChild].subtract(childHistograms[childIndex]);
+                } // Not the largest child
+        } // Have counts for this node
+
+        STATS_LEVEL_STOP(levelTimer, depth, playCount);
+
         // Partially constructed objects are NOT deallocated on exception. Need to handle explictly
         try {
-            _childNodes.push_back(new DecisionNode(indexes, summaryData));
-            vector<PlayIndexSet>::iterator newIndexesPtr;
-            for (newIndexesPtr = newIndexes.begin(); newIndexesPtr != newIndexes.end();
-                 newIndexesPtr++)
-                _childNodes.push_back(new DecisionNode(*newIndexesPtr, summaryData));
+            for (childIndex = 0; childIndex < childIndexes.size(); childIndex++)
+                _childNodes.push_back(new DecisionNode(*childIndexes[childIndex], summaryData,
+                                                       childHistograms.empty() ? NULL : &childHistograms[childIndex],
+                                                       *_distancePool, depth + 1));
         } // Try block
         catch (...) {
             vector<DecisionNode*>::iterator index;
@@ -156,9 +243,547 @@ DecisionNode::DecisionNode(PlayIndexSet& indexes, const OverallSummaryData& summ
             throw;
         } // Catch any exception
     } // High enough information gain for a decision node
-    else
+    else {
         // Convert the indexes into statistics
-        PlaySummaryFactory::buildDetailedData(indexes, summaryData, _playData);
+        PlaySummaryFactory::buildDetailedData(indexes, summaryData, *_distancePool, _playData);
+        STATS_LEVEL_STOP(levelTimer, depth, playCount);
+    } // Leaf node
+}
+
+/* Constructor for plays held in a column store instead of a data store. Only a list of
+    play numbers is held in memory, along with counts of the plays */
+DecisionNode::DecisionNode(const ColumnStore& columns, const OverallSummaryData& summaryData)
+    : _childNodes(), _categoryChildMapping(), _playData(), _ownDistancePool(NULL), _distancePool(NULL)
+{
+    buildRoot(columns, summaryData);
+}
+
+/* Constructor for plays selected from a league store, read in place from its segment.
+    The tree is built exactly as for a column store, above */
+DecisionNode::DecisionNode(const LeagueColumns& columns, const OverallSummaryData& summaryData)
+    : _childNodes(), _categoryChildMapping(), _playData(), _ownDistancePool(NULL), _distancePool(NULL)
+{
+    buildRoot(columns, summaryData);
+}
+
+/* Builds the root of a tree from a column store or a league selection, and every node
+    underneath it. Called by the constructors */
+template<class Columns>
+void DecisionNode::buildRoot(const Columns& columns, const OverallSummaryData& summaryData)
+{
+    /* Every node owns a range of one list of play numbers. It starts in file order, and
+        splits keep the order within each child, so every pass over the plays of a node reads
+        the columns from front to back. Nodes far down the tree skip most of the file, but
+        never go back */
+    vector<unsigned int> rows;
+    {
+        ALLOC_SCOPE(tree_memory);
+        rows.resize(columns.getPlayCount());
+    }
+    unsigned int row;
+    for (row = 0; row < rows.size(); row++)
+        rows[row] = row;
+    PlayCharacteristicSet available;
+    unsigned short characteristic;
+    for (characteristic = 0; characteristic <= (unsigned short)SinglePlay::score_differential; characteristic++)
+        available.insert((SinglePlay::PlayCharacteristic)characteristic);
+    {
+        ALLOC_SCOPE(tree_memory);
+        _ownDistancePool = new DistancePool();
+    }
+    _distancePool = _ownDistancePool;
+    // The destructor is not called if construction fails, so release the pool here
+    try {
+        buildNode(columns, rows, 0, rows.size(), available, summaryData, NULL, 0);
+    } // Try block
+    catch (...) {
+        delete _ownDistancePool;
+        throw;
+    } // Catch any exception
+}
+
+/* Constructor for nodes below the root, for a column store or a league selection. The
+    plays of the node are the range [firstRow, lastRow) of the play numbers, and the
+    characteristics available are those the node could still split on */
+template<class Columns>
+DecisionNode::DecisionNode(const Columns& columns, vector<unsigned int>& rows, unsigned long firstRow,
+                           unsigned long lastRow, const PlayCharacteristicSet& available,
+                           const OverallSummaryData& summaryData, const PlayHistogram* histogram,
+                           DistancePool& distancePool, unsigned short depth)
+    : _childNodes(), _categoryChildMapping(), _playData(), _ownDistancePool(NULL),
+      _distancePool(&distancePool)
+{
+    PlayCharacteristicSet nodeAvailable(available);
+    buildNode(columns, rows, firstRow, lastRow, nodeAvailable, summaryData, histogram, depth);
+}
+
+/* Builds this node and all nodes underneath it from a column store or a league selection.
+    Every step matches the build from indexes above, so the trees are identical */
+template<class Columns>
+void DecisionNode::buildNode(const Columns& columns, vector<unsigned int>& rows, unsigned long firstRow,
+                             unsigned long lastRow, PlayCharacteristicSet& available,
+                             const OverallSummaryData& summaryData, const PlayHistogram* histogram,
+                             unsigned short depth)
+{
+    ALLOC_SCOPE(tree_memory);
+    STATS_COUNT(nodes_created, 1);
+    // Statistics for the tree level cover this node only, not the ones below it
+    STATS_LEVEL_TIMER(levelTimer);
+    unsigned long playCount = lastRow - firstRow;
+    TRACE_SCOPE("build_node", "depth", depth, "plays", playCount);
+
+    // If the node has no plays, this indicates a serious problem
+    if (playCount == 0)
+        throw BaseException(__FILE__, __LINE__, "DecisionNode create failed, passed play store empty");
+
+    double maxInfoRatio = 0.0;
+    vector<short> bestGroups;
+    PlayHistogram countedHistogram(getHistogramDistances());
+    if (histogram == NULL) {
+        countedHistogram.addRows(columns, &rows[firstRow], playCount);
+        histogram = &countedHistogram;
+    } // Parent did not count the plays
+    chooseSplit(*histogram, available, maxInfoRatio, bestGroups);
+
+    if (maxInfoRatio >= getMinimumScore()) {
+        /* Map categories to children exactly as the split of indexes does: in category
+            order for category splits, by group for binary splits. A category split can't
+            happen again below, so the characteristic is dropped unless its the last one */
+        unsigned short catIndex;
+        short childCount = 0;
+        if (!bestGroups.empty()) {
+            _categoryChildMapping = bestGroups;
+            for (catIndex = 0; catIndex < _categoryChildMapping.size(); catIndex++)
+                if (_categoryChildMapping[catIndex] >= childCount)
+                    childCount = _categoryChildMapping[catIndex] + 1;
+        } // Binary split
+        else {
+            _categoryChildMapping.assign(SinglePlay::getCategoryCount(_decisionValue), -1); // 0 is a valid value!
+            for (catIndex = 0; catIndex < _categoryChildMapping.size(); catIndex++)
+                if (histogram->getCategoryTotal(_decisionValue, catIndex) != 0) {
+                    _categoryChildMapping[catIndex] = childCount;
+                    childCount++;
+                } // Category with values
+            if (available.size() > 1)
+                available.erase(_decisionValue);
+        } // Split by category
+        if (childCount <= 1)
+            throw BaseException(__FILE__, __LINE__, "DecisionNode create failed, split of play store data failed");
+
+        /* Move the play numbers of each child together, keeping their order. This is a
+            counting sort on one column: count the plays for each child to find where its
+            range starts, then copy each play number to the next place in its range */
+        typename Columns::CategoryColumn splitCategories = columns.getCategories(_decisionValue);
+        vector<unsigned long> childStarts(childCount + 1, 0);
+        unsigned long rowIndex;
+        for (rowIndex = firstRow; rowIndex < lastRow; rowIndex++)
+            childStarts[_categoryChildMapping[splitCategories[rows[rowIndex]]] + 1]++;
+        short childIndex;
+        childStarts[0] = firstRow;
+        for (childIndex = 1; childIndex <= childCount; childIndex++)
+            childStarts[childIndex] += childStarts[childIndex - 1];
+        {
+            vector<unsigned int> splitRows(playCount);
+            vector<unsigned long> nextRow(childStarts.begin(), childStarts.end() - 1);
+            for (rowIndex = firstRow; rowIndex < lastRow; rowIndex++) {
+                unsigned int row = rows[rowIndex];
+                splitRows[nextRow[_categoryChildMapping[splitCategories[row]]]++ - firstRow] = row;
+            }
+            copy(splitRows.begin(), splitRows.end(), rows.begin() + firstRow);
+        }
+
+        // Count every child but the largest, and get the largest by subtraction
+        short largestChild = 0;
+        for (childIndex = 1; childIndex < childCount; childIndex++)
+            if (childStarts[childIndex + 1] - childStarts[childIndex] >
+                childStarts[largestChild + 1] - childStarts[largestChild])
+                largestChild = childIndex;
+        vector<PlayHistogram> childHistograms(childCount, PlayHistogram(getHistogramDistances()));
+        childHistograms[largestChild] = *histogram;
+        for (childIndex = 0; childIndex < childCount; childIndex++)
+            if (childIndex != largestChild) {
+                childHistograms[childIndex].addRows(columns, &rows[childStarts[childIndex]],
+                                                    childStarts[childIndex + 1] - childStarts[childIndex]);
+                childHistograms[largestChild].subtract(childHistograms[childIndex]);
+            } // Not the largest child
+
+        STATS_LEVEL_STOP(levelTimer, depth, playCount);
+
+        // Partially constructed objects are NOT deallocated on exception. Need to handle explictly
+        try {
+            for (childIndex = 0; childIndex < childCount; childIndex++)
+                _childNodes.push_back(new DecisionNode(columns, rows, childStarts[childIndex],
+                                                       childStarts[childIndex + 1], available, summaryData,
+                                                       &childHistograms[childIndex], *_distancePool, depth + 1));
+        } // Try block
+        catch (...) {
+            vector<DecisionNode*>::iterator index;
+            for (index = _childNodes.begin(); index != _childNodes.end(); index++)
+                delete *index;
+            throw;
+        } // Catch any exception
+    } // High enough information gain for a decision node
+    else {
+        // Convert the plays into statistics
+        vector<DistanceVector> distances(SinglePlay::getPlayTypeCount());
+        vector<long> turnoverCounts(SinglePlay::getPlayTypeCount());
+        typename Columns::PlayTypeColumn playTypes = columns.getPlayTypes();
+        typename Columns::DistanceColumn playDistances = columns.getDistances();
+        typename Columns::TurnoverColumn turnovers = columns.getTurnovers();
+        unsigned long rowIndex;
+        for (rowIndex = firstRow; rowIndex < lastRow; rowIndex++) {
+            unsigned int row = rows[rowIndex];
+            distances[playTypes[row]].push_back(playDistances[row]);
+            turnoverCounts[playTypes[row]] += turnovers[row];
+        } // For each play
+        PlaySummaryFactory::buildDetailedData(distances, turnoverCounts, summaryData, *_distancePool, _playData);
+        STATS_LEVEL_STOP(levelTimer, depth, playCount);
+    } // Leaf node
+}
+
+/* Chooses the characteristic to split on from counts of the plays. Characteristics that
+    can't split the plays are dropped from the available set, except the last one, as
+    PlayIndexSet::dropIndex does. Sets the ratio to zero if there is no useful split. For
+    binary splits, the group for each category is set as well */
+void DecisionNode::chooseSplit(const PlayHistogram& counts, PlayCharacteristicSet& available,
+                               double& maxInfoRatio, vector<short>& bestGroups)
+{
+    if (_splitTarget == yardage_target) {
+        chooseYardageSplit(counts, available, maxInfoRatio, bestGroups);
+        return;
+    }
+    maxInfoRatio = 0.0;
+    bestGroups.clear();
+    /* First, assemble data about the plays. Need the number of play types and the number
+        of plays per type. A map handles this nicely */
+    PlayCountMap playTypeCounts;
+    getPlayTypeCounts(counts, playTypeCounts);
+
+    /* If the play data has only one play type, no further splitting is possible.
+        Information gain ratio is zero */
+    if (playTypeCounts.size() <= 1)
+        return;
+
+    /* Characteristics found to be redundant are dropped. Make a copy of the available set
+        here, to ensure iterators are stable */
+    PlayCharacteristicSet testCharacteristics(available);
+    PlayCharacteristicSet::const_iterator testIndex;
+    for (testIndex = testCharacteristics.begin(); testIndex != testCharacteristics.end();
+         testIndex++) {
+        vector<short> groups;
+        double infoRatio = getSplitInfoRatio(counts, playTypeCounts, *testIndex, groups);
+        if (infoRatio < getMinimumScore()) {
+            // Characteristic can't be used for splitting, so its redundant. Always keep one
+            if (available.size() > 1)
+                available.erase(*testIndex);
+        }
+
+        else {
+            _decisionValue = *testIndex;
+            maxInfoRatio = infoRatio;
+            bestGroups.swap(groups);
+        } // Characteristic is best split found so far
+    } // For each characteristic with an index defined
+}
+
+/* Chooses the characteristic for a yardage split, the one removing the largest share
+    of the variance of distance. Otherwise the same as chooseSplit() */
+void DecisionNode::chooseYardageSplit(const PlayHistogram& counts, PlayCharacteristicSet& available,
+                                      double& maxReduction, vector<short>& bestGroups)
+{
+    /* Unlike play type splits, the best characteristic is chosen rather than the last one
+        good enough. There is no older tree to match, and the best is what regression trees
+        normally use */
+    maxReduction = 0.0;
+    bestGroups.clear();
+    PlayCharacteristicSet testCharacteristics(available);
+    PlayCharacteristicSet::const_iterator testIndex;
+    for (testIndex = testCharacteristics.begin(); testIndex != testCharacteristics.end();
+         testIndex++) {
+        vector<short> groups;
+        double reduction = getYardageReduction(counts, *testIndex, groups);
+        if (reduction < MinVarianceReduction) {
+            // Characteristic can't be used for splitting, so its redundant. Always keep one
+            if (available.size() > 1)
+                available.erase(*testIndex);
+        }
+        else if (reduction > maxReduction) {
+            _decisionValue = *testIndex;
+            maxReduction = reduction;
+            bestGroups.swap(groups);
+        } // Characteristic is best split found so far
+    } // For each characteristic with an index defined
+}
+
+/* Returns the share of the variance of distance removed by splitting plays on a
+    characteristic. For binary splits, the group for each category is returned as
+    well, with -1 for categories without yardage wanted */
+double DecisionNode::getYardageReduction(const PlayHistogram& counts,
+                                         SinglePlay::PlayCharacteristic characteristic, vector<short>& groups)
+{
+    /* The squared error of a group of n distances with sum S and sum of squares Q is
+        Q - S^2/n, which is n times their variance. A split removes the squared error of the
+        whole group minus that of each child. The share removed is the score, so it can be
+        compared to a fixed minimum at any node. Every value comes from the category sums,
+        so a characteristic is scored in time proportional to its categories */
+    groups.clear();
+    unsigned short categoryCount = SinglePlay::getCategoryCount(characteristic);
+    long playCount = 0;
+    double distanceSum = 0.0;
+    double distanceSquares = 0.0;
+    unsigned short categoriesWithPlays = 0;
+    unsigned short category;
+    for (category = 0; category < categoryCount; category++) {
+        if (counts.getCategoryTotal(characteristic, category) != 0)
+            categoriesWithPlays++;
+        playCount += counts.getDistanceCount(characteristic, category);
+        distanceSum += (double)counts.getDistanceSum(characteristic, category);
+        distanceSquares += (double)counts.getDistanceSquares(characteristic, category);
+    } // Loop through categories
+    // Both children of the smallest useful split need enough plays
+    if ((categoriesWithPlays <= 1) || (playCount < 2 * MinYardagePlays))
+        return 0.0;
+    double totalError = distanceSquares - ((distanceSum * distanceSum) / (double)playCount);
+    if (totalError <= 0.0)
+        return 0.0; // Every play gained the same, so nothing to explain
+    STATS_COUNT(splits_evaluated, 1);
+
+    if ((_splitMode != binary_split) || (categoriesWithPlays <= 2)) {
+        double splitError = 0.0;
+        for (category = 0; category < categoryCount; category++) {
+            long categoryPlays = counts.getDistanceCount(characteristic, category);
+            if (categoryPlays == 0)
+                continue;
+            double categorySum = (double)counts.getDistanceSum(characteristic, category);
+            splitError += (double)counts.getDistanceSquares(characteristic, category) -
+                          ((categorySum * categorySum) / (double)categoryPlays);
+        } // Loop through categories
+        return (totalError - splitError) / totalError;
+    } // Category split
+
+    /* For squared error, ordering the categories by their mean distance and trying each cut
+        point of the ordering is guarenteed to find the best grouping (Breiman et. al.,
+        Classification and Regression Trees), so this is exact, unlike the play type version.
+        Sets are only a handful of entries, so an insertion sort is fine */
+    vector<unsigned short> order;
+    for (category = 0; category < categoryCount; category++) {
+        long categoryPlays = counts.getDistanceCount(characteristic, category);
+        if (categoryPlays == 0)
+            continue;
+        double mean = (double)counts.getDistanceSum(characteristic, category) / (double)categoryPlays;
+        vector<unsigned short>::iterator position = order.end();
+        while ((position != order.begin()) &&
+               ((double)counts.getDistanceSum(characteristic, *(position - 1)) /
+                (double)counts.getDistanceCount(characteristic, *(position - 1)) > mean))
+            position--;
+        order.insert(position, category);
+    } // Loop through categories
+    if (order.size() <= 1)
+        return 0.0;
+
+    // Move categories from the second group to the first one at a time, keeping running sums
+    double firstPlays = 0.0;
+    double firstSum = 0.0;
+    double firstSquares = 0.0;
+    double bestReduction = 0.0;
+    unsigned short bestCut = 1;
+    unsigned short cut;
+    for (cut = 1; cut < order.size(); cut++) {
+        firstPlays += (double)counts.getDistanceCount(characteristic, order[cut - 1]);
+        firstSum += (double)counts.getDistanceSum(characteristic, order[cut - 1]);
+        firstSquares += (double)counts.getDistanceSquares(characteristic, order[cut - 1]);
+        double secondPlays = (double)playCount - firstPlays;
+        double secondSum = distanceSum - firstSum;
+        double splitError = (firstSquares - ((firstSum * firstSum) / firstPlays)) +
+                            ((distanceSquares - firstSquares) - ((secondSum * secondSum) / secondPlays));
+        double reduction = (totalError - splitError) / totalError;
+        if (reduction > bestReduction) {
+            bestReduction = reduction;
+            bestCut = cut;
+        }
+    } // Loop through cut points
+
+    groups.assign(categoryCount, -1);
+    for (cut = 0; cut < order.size(); cut++)
+        groups[order[cut]] = (cut < bestCut) ? 0 : 1;
+    return bestReduction;
+}
+
+// Returns the plays whose distances histograms must sum for the split target
+short DecisionNode::getHistogramDistances()
+{
+    if (_splitTarget == yardage_target)
+        return _yardagePlayType;
+    else
+        return PlayHistogram::no_distances;
+}
+
+/* Chooses the characteristic to split on from random samples of the plays, the same
+    way as above. Returns false if no sample small enough to be worthwhile gives a
+    confident result, in which case the plays must be counted */
+bool DecisionNode::chooseSplitFromSample(PlayIndexSet& indexes, unsigned long playCount, unsigned short depth,
+                                         double& maxInfoRatio, vector<short>& bestGroups)
+{
+    /* The information gain ratio of a sample is an estimate of the ratio for all of the
+        plays. The Hoeffding bound gives how far off it can be: for a value with range R
+        estimated from n independent samples, the true value is within
+        sqrt(R^2 * ln(1/delta) / 2n) of the estimate with probability 1 - delta. The range
+        depends on the split criterion; the gain ratio ranges from 0 to 1. Strictly, the
+        bound applies to averages, which the scores are not, but it works well in practice for decision trees (Domingos and Hulten,
+        Mining High-Speed Data Streams).
+
+        This builder splits on the last characteristic whose ratio reaches the minimum,
+        so that is the decision that needs confidence. The sample is big enough when the
+        chosen characteristic clears the minimum by more than the bound and every one
+        after it falls short by more than the bound. Characteristics before it that fall
+        short by more than the bound are dropped, as counting would do. Ones too close
+        to call are kept, which costs a little time further down but changes nothing.
+
+        Samples start at SampleStart plays and double each time, drawn with replacement
+        so they are independent. Once a sample would be more than half the node, counting
+        is cheaper, so the caller counts instead */
+    if (indexes.getIndexesAvailable().empty())
+        return false;
+    const CategoryIndex& sampleIndex = indexes.getIndex(*(indexes.getIndexesAvailable().begin()));
+    // Seeded from the node, so the same data always builds the same tree
+    unsigned long long randomState = ((unsigned long long)playCount << 16) + depth + 1;
+
+    PlayHistogram sample;
+    unsigned long sampleSize = 0;
+    unsigned long targetSize;
+    for (targetSize = SampleStart; targetSize <= playCount / 2; targetSize *= 2) {
+        for (; sampleSize < targetSize; sampleSize++) {
+            // Find the play by walking the categories. There are only a handful of them
+            unsigned long position = (unsigned long)(nextRandom(randomState) % playCount);
+            CategoryIndex::const_iterator category = sampleIndex.begin();
+            while (position >= category->size()) {
+                position -= category->size();
+                category++;
+            }
+            sample.addPlay(*((*category)[position]));
+        } // Grow the sample
+        STATS_COUNT(plays_sampled, targetSize);
+
+        PlayCountMap playTypeCounts;
+        getPlayTypeCounts(sample, playTypeCounts);
+        double bound = getScoreRange() * sqrt(log(1.0 / SampleConfidence) / (2.0 * (double)sampleSize));
+
+        // Find the last characteristic that might reach the minimum, and whether it surely does
+        PlayCharacteristicSet testCharacteristics(indexes.getIndexesAvailable());
+        PlayCharacteristicSet::const_iterator testIndex;
+        vector<double> infoRatios;
+        vector<vector<short> > groups(testCharacteristics.size());
+        bool haveCandidate = false;
+        bool confident = true;
+        unsigned short candidate = 0;
+        unsigned short testCounter = 0;
+        for (testIndex = testCharacteristics.begin(); testIndex != testCharacteristics.end();
+             testIndex++, testCounter++) {
+            double infoRatio = 0.0;
+            if (playTypeCounts.size() > 1)
+                infoRatio = getSplitInfoRatio(sample, playTypeCounts, *testIndex, groups[testCounter]);
+            infoRatios.push_back(infoRatio);
+            if (infoRatio > getMinimumScore() - bound) {
+                haveCandidate = true;
+                candidate = testCounter;
+                confident = (infoRatio >= getMinimumScore() + bound);
+            } // Might reach the minimum
+        } // For each characteristic with an index defined
+        if (!confident)
+            continue; // Need a bigger sample
+
+        // Confident of the result. Drop the characteristics that surely can't be used
+        STATS_COUNT(splits_sampled, 1);
+        maxInfoRatio = 0.0;
+        bestGroups.clear();
+        for (testIndex = testCharacteristics.begin(), testCounter = 0; testIndex != testCharacteristics.end();
+             testIndex++, testCounter++)
+            if (infoRatios[testCounter] <= getMinimumScore() - bound)
+                indexes.dropIndex(*testIndex);
+            else if (haveCandidate && (testCounter == candidate)) {
+                _decisionValue = *testIndex;
+                maxInfoRatio = infoRatios[testCounter];
+                bestGroups.swap(groups[testCounter]);
+            } // Chosen characteristic
+        return true;
+    } // Loop through sample sizes
+    return false;
+}
+
+/* Returns the score from splitting plays on a characteristic, given counts of the plays,
+    using the current criterion. For binary splits, the group for each category is
+    returned as well, with -1 for categories without plays */
+double DecisionNode::getSplitInfoRatio(const PlayHistogram& counts, const PlayCountMap& playTypeCounts,
+                                       SinglePlay::PlayCharacteristic characteristic, vector<short>& groups)
+{
+    // The criterion is chosen here, once per split, so the kernels below have it built in
+    switch (_splitCriterion) {
+    case entropy_criterion:
+        return getCriterionSplit<EntropyCriterion>(counts, playTypeCounts, characteristic, groups);
+    case gini_criterion:
+        return getCriterionSplit<GiniCriterion>(counts, playTypeCounts, characteristic, groups);
+    default:
+        return getCriterionSplit<GainRatioCriterion>(counts, playTypeCounts, characteristic, groups);
+    }
+}
+
+// Same as above, for one criterion
+template<class Criterion>
+double DecisionNode::getCriterionSplit(const PlayHistogram& counts, const PlayCountMap& playTypeCounts,
+                                       SinglePlay::PlayCharacteristic characteristic, vector<short>& groups)
+{
+    groups.clear();
+    /* Category indexes split by category type. Find the play counts for each
+        and use them to find the information gain */
+    vector<vector<long> > splitPlayCounts;
+    vector<long> splitPlayTotals;
+    long playTotals = 0;
+    // Default vector of counts per play type
+    vector<long> defaultPlayCounts(SinglePlay::getPlayTypeCount(), 0);
+
+    unsigned short category;
+    unsigned short playType;
+    for (category = 0; category < SinglePlay::getCategoryCount(characteristic); category++)
+        if (counts.getCategoryTotal(characteristic, category) != 0) {
+            splitPlayCounts.push_back(defaultPlayCounts);
+            for (playType = 0; playType < SinglePlay::getPlayTypeCount(); playType++)
+                splitPlayCounts.back()[playType] =
+                    counts.getCount(characteristic, category, (SinglePlay::PlayType)playType);
+            splitPlayTotals.push_back(counts.getCategoryTotal(characteristic, category));
+            playTotals += counts.getCategoryTotal(characteristic, category);
+        } // Category has plays
+
+    // If all plays are in one category, the information gain by definition is zero
+    if (splitPlayTotals.size() <= 1)
+        return 0.0;
+    STATS_COUNT(splits_evaluated, 1);
+    if ((_splitMode != binary_split) || (splitPlayTotals.size() <= 2))
+        return getSplitScore<Criterion>(playTypeCounts, playTotals, splitPlayCounts, splitPlayTotals);
+
+    /* Groups are found for categories with plays only. Convert them to a group for
+        every category */
+    vector<short> splitGroups;
+    double infoRatio = getBinaryGrouping<Criterion>(playTypeCounts, playTotals, splitPlayCounts,
+                                                    splitPlayTotals, splitGroups);
+    groups.assign(SinglePlay::getCategoryCount(characteristic), -1);
+    unsigned short groupIndex = 0;
+    for (category = 0; category < SinglePlay::getCategoryCount(characteristic); category++)
+        if (counts.getCategoryTotal(characteristic, category) != 0) {
+            groups[category] = splitGroups[groupIndex];
+            groupIndex++;
+        } // Category has plays
+    return infoRatio;
+}
+
+// Extracts the number of plays of each type, for the types with plays
+void DecisionNode::getPlayTypeCounts(const PlayHistogram& counts, PlayCountMap& playTypeCounts)
+{
+    playTypeCounts.clear();
+    unsigned short playType;
+    for (playType = 0; playType < SinglePlay::getPlayTypeCount(); playType++)
+        if (counts.getPlayTypeCount((SinglePlay::PlayType)playType) != 0)
+            playTypeCounts.insert(make_pair((SinglePlay::PlayType)playType,
+                                            counts.getPlayTypeCount((SinglePlay::PlayType)playType)));
 }
 
 // Destructor
@@ -167,27 +792,57 @@ DecisionNode::~DecisionNode()
     vector<DecisionNode*>::iterator index;
     for (index = _childNodes.begin(); index != _childNodes.end(); index++)
         delete *index;
+    // Only the root owns the pool, and the nodes using it are gone
+    delete _ownDistancePool;
 }
 
-// Converts an indexes into data about the plays in the data store
-void DecisionNode::indexesToPlayCounts(const PlayIndexSet& indexes, PlayCountMap& playData)
+// Prune the decision tree at this node and below
+void DecisionNode::pruneTree()
 {
-    playData.clear();
-    // Extract the characteristics with indexes. If empty, have nothing to do
-    if (indexes.getIndexesAvailable().empty())
-        return;
+    pruneNode();
+
+    /* Merging leaves left the distances they used to have in the pool. Once pruning is
+        done, copy the ones still used to a new pool, in tree order, and replace the old one.
+        The nodes keep pointing to the same pool object, so only the starts change */
+    if (_ownDistancePool != NULL) {
+        ALLOC_SCOPE(tree_memory);
+        DistancePool newPool;
+        compactDistances(newPool);
+        _ownDistancePool->swap(newPool);
+    } // This node owns the pool
+}
 
-    SinglePlay::PlayCharacteristic indexType = *(indexes.getIndexesAvailable().begin());
-    /* NOTE: Using constant references is normally bad, but in this case the routine
-        does complex logic and copying the index will be expensive */
-    const CategoryIndex& catIndex = indexes.getIndex(indexType);
-    CategoryIndex::const_iterator tempPtr;
-    for (tempPtr = catIndex.begin(); tempPtr != catIndex.end(); tempPtr++)
-        indexesToPlayCounts(*tempPtr, playData);
+// Number of children with enough plays with yardage wanted to stand on their own
+unsigned short DecisionNode::getYardageSupport() const
+{
+    unsigned short supportedCount = 0;
+    vector<DecisionNode*>::const_iterator nodeIndex;
+    for (nodeIndex = _childNodes.begin(); nodeIndex != _childNodes.end(); nodeIndex++) {
+        long yardagePlays = 0;
+        DetailedPlayData::const_iterator playIndex;
+        for (playIndex = (*nodeIndex)->_playData.begin(); playIndex != (*nodeIndex)->_playData.end(); playIndex++)
+            if ((_yardagePlayType == PlayHistogram::all_play_types) || (_yardagePlayType == (short)playIndex->first))
+                yardagePlays += playIndex->second.getPlayCount();
+        if (yardagePlays >= MinYardagePlays)
+            supportedCount++;
+    } // Loop through children
+    return supportedCount;
 }
 
-// Prune the decision tree at this node and below
-void DecisionNode::pruneTree()
+// Copies the distances of this node and all nodes underneath it to a new pool, in tree order
+void DecisionNode::compactDistances(DistancePool& newPool)
+{
+    DetailedPlayData::iterator playIndex;
+    for (playIndex = _playData.begin(); playIndex != _playData.end(); playIndex++)
+        playIndex->second.relocateDistances(newPool.add(playIndex->second.getPlayDistances(),
+                                                        playIndex->second.getPlayCount()));
+    vector<DecisionNode*>::iterator nodeIndex;
+    for (nodeIndex = _childNodes.begin(); nodeIndex != _childNodes.end(); nodeIndex++)
+        (*nodeIndex)->compactDistances(newPool);
+}
+
+// Prunes this node and all nodes underneath it. Called by pruneTree()
+void DecisionNode::pruneNode()
 {
     /* NFL play calling is probablity based, not exact. That causes big problems for
         information gain based splitting, because it will split plays long after
@@ -197,6 +852,7 @@ void DecisionNode::pruneTree()
     if (isLeaf())
         // Leaf node, nothing to do!
         return;
+    ALLOC_SCOPE(tree_memory);
 
     /* Scan through the child nodes. For each one that is not already a leaf, try to prune the nodes
         below that node. If the pruning fails and it remains a decision node, can stop afterwards
@@ -206,14 +862,16 @@ void DecisionNode::pruneTree()
     vector<DecisionNode*>::iterator nodeIndex;
     for (nodeIndex = _childNodes.begin(); nodeIndex != _childNodes.end(); nodeIndex++) {
         if (!((*nodeIndex)->isLeaf())) {
-            (*nodeIndex)->pruneTree();
+            (*nodeIndex)->pruneNode();
             haveLeaves = haveLeaves && (*nodeIndex)->isLeaf();
         } // Not a leaf node
     } // While nodes to test and reason to do so
 
-    if (!haveLeaves)
+    if (!haveLeaves) {
         // Have decison nodes below this one, can't prune
+        TRACE_INSTANT("prune_blocked", "children", _childNodes.size());
         return;
+    }
 
     /* Every NFL play occurs often enough that a leaf containing a single play almost
         certainly the result of splitting a probability based entry. If all leaves, or
@@ -224,7 +882,12 @@ void DecisionNode::pruneTree()
             if ((*nodeIndex)->_playData.begin()->second.getPlayCount() == 1) // Play type has only one play
                 singlePlayLeafCount++;
     bool pruneTree = (singlePlayLeafCount >= _childNodes.size() - 1);
-    if (!pruneTree) {
+    /* A yardage split is only worth keeping if it divides plays into at least two groups
+        big enough for their average distances to mean something. The play types called
+        don't matter, so the tests below don't apply */
+    if ((!pruneTree) && (_splitTarget == yardage_target))
+        pruneTree = (getYardageSupport() < 2);
+    else if (!pruneTree) {
         /* Error rate algorithms treat the ideal tree layout as every node having only one
             type of play. This normally doesn't happen in practice. Consider the play type
             with the highest count the 'intended' play type for the node, and the remainder as
@@ -248,7 +911,7 @@ void DecisionNode::pruneTree()
             the number of play types changes, this must be updated to match or bad things will happen! */
         typedef bitset<11> PlayTypeBitSet; // Use typedef so size is in only one place
 
-        unsigned short totalPlayCount;
+        unsigned long totalPlayCount = 0;
         PlayTypeBitSet singlePlays; // Only one play in at least one child
         PlayTypeBitSet multiPlays; // More than one play in at least one child
 
@@ -260,7 +923,7 @@ void DecisionNode::pruneTree()
         DetailedPlayData::iterator playIndex;
         for (nodeIndex = _childNodes.begin(); nodeIndex != _childNodes.end(); nodeIndex++) {
             // Accumulate single plays and multiple plays, and find the most frequent play
-            short mostFrequentPlay = 0;
+            long mostFrequentPlay = 0;
             for (playIndex = (*nodeIndex)->_playData.begin(); playIndex != (*nodeIndex)->_playData.end();
                  playIndex++) {
                 // Accumulate to combined play total for nodes, needed below
@@ -327,6 +990,7 @@ void DecisionNode::pruneTree()
                 pruneTree = true;
         } // Some significant play types are not in all children
     } // Tests so far did not result in a prune
+    TRACE_INSTANT("prune_decision", "children", _childNodes.size(), "pruned", pruneTree ? 1 : 0);
 
     if (pruneTree) {
         // Combine their statistics
@@ -335,6 +999,7 @@ void DecisionNode::pruneTree()
             PlaySummaryFactory::mergeData(_playData, (*nodeIndex)->_playData);
 
         // Remove children
+        STATS_COUNT(nodes_pruned, _childNodes.size());
         for (nodeIndex = _childNodes.begin(); nodeIndex != _childNodes.end(); nodeIndex++)
             delete *nodeIndex;
         _childNodes.clear();
@@ -342,24 +1007,11 @@ void DecisionNode::pruneTree()
     return;
 }
 
-// Converts an index into data about the plays in the index
-void DecisionNode::indexesToPlayCounts(const PlayIndex& index, PlayCountMap& data)
-{
-    PlayIndex::const_iterator indexPtr;
-    PlayCountMap::iterator dataPtr;
-    for (indexPtr = index.begin(); indexPtr != index.end(); indexPtr++) {
-        dataPtr = data.find((*indexPtr)->getPlayType());
-        if (dataPtr != data.end())
-            dataPtr->second++;
-        else
-            data.insert(make_pair((*indexPtr)->getPlayType(), 1));
-    } // For every play in the index
-}
-
-// Returns the information gain ratio for a given split of plays
-double DecisionNode::getInfoGainRatio(const PlayCountMap& plays, short playTotal,
-                                      vector<vector<short> >& splitPlayCounts,
-                                      vector<short> splitPlayTotals)
+// Returns the score for a given split of plays with a criterion
+template<class Criterion>
+double DecisionNode::getSplitScore(const PlayCountMap& plays, long playTotal,
+                                   const vector<vector<long> >& splitPlayCounts,
+                                   const vector<long>& splitPlayTotals)
 {
     /* Partition tests are based on information gain theory. The test is
         derived as follows:
@@ -425,6 +1077,14 @@ double DecisionNode::getInfoGainRatio(const PlayCountMap& plays, short playTotal
         subset in this case contains plays of a single type.
 
         The information gain ratio is IG(D,k) / IIV(D,k).
+
+        The other criteria follow the same steps with a different measure. Plain
+        information gain (the entropy criterion) stops at IG(D,k), accepting the bias.
+        Gini impurity replaces I(D) with G(D) = sum[1..c]((p[i]/d)(1 - p[i]/d)), the
+        chance a play is mislabeled if labels are drawn at random from D, and the gain is
+        G(D) - sum[1..k]((d[k]/d)G(D(k))). It behaves much like information but needs no
+        logarithms. The criterion supplies the term for one play type and the final score,
+        so the loops below are written once.
     */
     unsigned short counter, counter2;
 
@@ -432,22 +1092,145 @@ double DecisionNode::getInfoGainRatio(const PlayCountMap& plays, short playTotal
     double groupInformation = 0.0;
     PlayCountMap::const_iterator mapCounter;
     for (mapCounter = plays.begin(); mapCounter != plays.end(); mapCounter++)
-        groupInformation += getInformation(mapCounter->second, playTotal);
+        groupInformation += Criterion::getImpurity(mapCounter->second, playTotal);
 
     // Now, SUBTRACT the information for each split subset
     for (counter = 0; counter < splitPlayCounts.size(); counter++) {
         double splitInformation = 0.0;
         for (counter2 = 0; counter2 < splitPlayCounts[counter].size(); counter2++)
             if (splitPlayCounts[counter][counter2] != 0) // This is indexed by play type, so some may have no count
-                splitInformation += getInformation(splitPlayCounts[counter][counter2], splitPlayTotals[counter]);
+                splitInformation += Criterion::getImpurity(splitPlayCounts[counter][counter2], splitPlayTotals[counter]);
         groupInformation -= ((splitInformation * (double)splitPlayTotals[counter]) / (double)playTotal);
     } // Loop through splits
 
-    // Find the intrinsic information value of the original group
-    double intrinsicValue = 0.0;
-    for (counter = 0; counter < splitPlayTotals.size(); counter++)
-        intrinsicValue += getInformation(splitPlayTotals[counter], playTotal);
-    return groupInformation / intrinsicValue;
+    // Gain ratio divides by the intrinsic information value of the original group here
+    return Criterion::getScore(groupInformation, playTotal, splitPlayTotals);
+}
+
+// Same as above, with the criterion given at run time. Used to time the criteria
+double DecisionNode::getSplitScore(SplitCriterion splitCriterion, const PlayCountMap& plays, long playTotal,
+                                   const vector<vector<long> >& splitPlayCounts,
+                                   const vector<long>& splitPlayTotals)
+{
+    switch (splitCriterion) {
+    case entropy_criterion:
+        return getSplitScore<EntropyCriterion>(plays, playTotal, splitPlayCounts, splitPlayTotals);
+    case gini_criterion:
+        return getSplitScore<GiniCriterion>(plays, playTotal, splitPlayCounts, splitPlayTotals);
+    default:
+        return getSplitScore<GainRatioCriterion>(plays, playTotal, splitPlayCounts, splitPlayTotals);
+    }
+}
+
+// Lowest score where a split is valuable for the current criterion
+double DecisionNode::getMinimumScore()
+{
+    // Yardage splits are scored by the variance they remove, whatever the criterion
+    if (_splitTarget == yardage_target)
+        return MinVarianceReduction;
+    switch (_splitCriterion) {
+    case entropy_criterion:
+        return EntropyCriterion::getMinimumScore();
+    case gini_criterion:
+        return GiniCriterion::getMinimumScore();
+    default:
+        return GainRatioCriterion::getMinimumScore();
+    }
+}
+
+// Largest difference between two scores for the current criterion, for sampling bounds
+double DecisionNode::getScoreRange()
+{
+    switch (_splitCriterion) {
+    case entropy_criterion:
+        return EntropyCriterion::getScoreRange();
+    case gini_criterion:
+        return GiniCriterion::getScoreRange();
+    default:
+        return GainRatioCriterion::getScoreRange();
+    }
+}
+
+// Returns the name of a split criterion, as given on the command line
+const char* DecisionNode::getCriterionName(SplitCriterion splitCriterion)
+{
+    switch (splitCriterion) {
+    case entropy_criterion:
+        return "entropy";
+    case gini_criterion:
+        return "gini";
+    default:
+        return "gain-ratio";
+    }
+}
+
+/* Finds the best division of the categories of a split into two groups, and returns its
+    score. The group for each entry of the split counts is returned */
+template<class Criterion>
+double DecisionNode::getBinaryGrouping(const PlayCountMap& plays, long playTotal,
+                                       const vector<vector<long> >& splitPlayCounts,
+                                       const vector<long>& splitPlayTotals, vector<short>& groups)
+{
+    /* There are 2^(k-1)-1 ways to divide k categories into two groups, too many to try
+        every one for large k. When there are only two play types, ordering the categories
+        by the share of one type and trying each cut point of the ordering is guarenteed to
+        find the best grouping (Breiman et. al., Classification and Regression Trees).
+        With more play types no such guarentee exists, but ordering by the share of the
+        most common play type in the node works well in practice. Its the play type most
+        likely to be called, so separating the situations where it is and isn't called is
+        what a coach would look for. This tries k-1 groupings instead of 2^(k-1)-1 */
+    SinglePlay::PlayType dominantType = plays.begin()->first;
+    PlayCountMap::const_iterator mapCounter;
+    for (mapCounter = plays.begin(); mapCounter != plays.end(); mapCounter++)
+        if (mapCounter->second > plays.find(dominantType)->second)
+            dominantType = mapCounter->first;
+
+    /* Sort the categories by share of the dominant type. Sets are only a handful of
+        entries, so an insertion sort is fine. It is stable, so ties stay in category order */
+    vector<unsigned short> order;
+    unsigned short counter, counter2;
+    for (counter = 0; counter < splitPlayCounts.size(); counter++) {
+        double share = (double)splitPlayCounts[counter][(unsigned short)dominantType] /
+                       (double)splitPlayTotals[counter];
+        vector<unsigned short>::iterator position = order.end();
+        while ((position != order.begin()) &&
+               ((double)splitPlayCounts[*(position - 1)][(unsigned short)dominantType] /
+                (double)splitPlayTotals[*(position - 1)] > share))
+            position--;
+        order.insert(position, counter);
+    } // Loop through categories
+
+    /* Try each cut point. Everything before the cut goes in group zero. Counts for the
+        two groups are updated as the cut moves, rather than recounted */
+    vector<vector<long> > groupPlayCounts(2, vector<long>(splitPlayCounts[0].size(), 0));
+    vector<long> groupPlayTotals(2, 0);
+    for (counter = 0; counter < order.size(); counter++) {
+        for (counter2 = 0; counter2 < splitPlayCounts[order[counter]].size(); counter2++)
+            groupPlayCounts[1][counter2] += splitPlayCounts[order[counter]][counter2];
+        groupPlayTotals[1] += splitPlayTotals[order[counter]];
+    } // Everything starts in group one
+
+    double bestInfoRatio = 0.0;
+    unsigned short bestCut = 1;
+    for (counter = 1; counter < order.size(); counter++) {
+        unsigned short moved = order[counter - 1];
+        for (counter2 = 0; counter2 < splitPlayCounts[moved].size(); counter2++) {
+            groupPlayCounts[0][counter2] += splitPlayCounts[moved][counter2];
+            groupPlayCounts[1][counter2] -= splitPlayCounts[moved][counter2];
+        }
+        groupPlayTotals[0] += splitPlayTotals[moved];
+        groupPlayTotals[1] -= splitPlayTotals[moved];
+        double infoRatio = getSplitScore<Criterion>(plays, playTotal, groupPlayCounts, groupPlayTotals);
+        if (infoRatio > bestInfoRatio) {
+            bestInfoRatio = infoRatio;
+            bestCut = counter;
+        }
+    } // Loop through cut points
+
+    groups.assign(splitPlayCounts.size(), 1);
+    for (counter = 0; counter < bestCut; counter++)
+        groups[order[counter]] = 0;
+    return bestInfoRatio;
 }
 
 /* Get the set of plays used in the past given situation characteristics.
@@ -507,38 +1290,47 @@ void DecisionNode::debugOutputData(ostream& stream, short level, vector<bool>& l
     if (!isLeaf()) {
         lastNode.push_back(false); // Extend list for children about to process
         stream << "Split: " << _decisionValue << endl;
+        /* Children are output in order, listing the values that lead to each. Binary splits
+            can send several values to the same child */
+        short childIndex;
         short index;
-        for (index = 0; index < (short)_categoryChildMapping.size(); index++)
-            if (_categoryChildMapping[index] >= 0) {
-                // Flag the last child
-                if (_categoryChildMapping[index] == (short)_childNodes.size() - 1)
-                    lastNode.back() = true;
-                debugOutputLeader(stream, level, lastNode);
-                stream << "Value:";
-                // Output the value based on the split characteristic
-                switch (_decisionValue) {
-                    case SinglePlay::distance_needed:
-                        stream << (SinglePlay::DistanceNeeded)index;
-                        break;
-
-                    case SinglePlay::field_location:
-                        stream << (SinglePlay::FieldLocation)index;
-                        break;
-
-                    case SinglePlay::time_remaining:
-                        stream << (SinglePlay::TimeRemaining)index;
-                        break;
-
-                    case SinglePlay::score_differential:
-                        stream << (SinglePlay::ScoreDifferential)index;
-                        break;
-
-                    default:
-                        stream << index;
-                } // Switch on split characteristic
-                stream << endl;
-                _childNodes[_categoryChildMapping[index]]->debugOutputData(stream, level + 1, lastNode);
-            } // This category has a child node
+        for (childIndex = 0; childIndex < (short)_childNodes.size(); childIndex++) {
+            // Flag the last child
+            if (childIndex == (short)_childNodes.size() - 1)
+                lastNode.back() = true;
+            debugOutputLeader(stream, level, lastNode);
+            stream << "Value:";
+            bool firstValue = true;
+            for (index = 0; index < (short)_categoryChildMapping.size(); index++)
+                if (_categoryChildMapping[index] == childIndex) {
+                    if (!firstValue)
+                        stream << " or ";
+                    firstValue = false;
+                    // Output the value based on the split characteristic
+                    switch (_decisionValue) {
+                        case SinglePlay::distance_needed:
+                            stream << (SinglePlay::DistanceNeeded)index;
+                            break;
+
+                        case SinglePlay::field_location:
+                            stream << (SinglePlay::FieldLocation)index;
+                            break;
+
+                        case SinglePlay::time_remaining:
+                            stream << (SinglePlay::TimeRemaining)index;
+                            break;
+
+                        case SinglePlay::score_differential:
+                            stream << (SinglePlay::ScoreDifferential)index;
+                            break;
+
+                        default:
+                            stream << index;
+                    } // Switch on split characteristic
+                } // Value leads to this child
+            stream << endl;
+            _childNodes[childIndex]->debugOutputData(stream, level + 1, lastNode);
+        } // Loop through children
         lastNode.pop_back(); // Remove bit inserted above so doesn't carry over
     } // Decision node
     else {
@@ -21,7 +21,6 @@
     a link to the code depository)
 */
 #include<map>
-#include<cmath> // Needed for inline methods
 
 /* These classes represent nodes within the decision tree. The class
     can represent either a decision node or a leaf depending on which
@@ -49,18 +48,80 @@ using std::vector; // Header not included, since all callers also use vectors
 using std::ostream;
 using std::map;
 
-typedef map<SinglePlay::PlayType, unsigned short> PlayCountMap;
+class PlayHistogram; // Only used by reference here
+class ColumnStore; // Ditto
+class LeagueColumns; // Ditto
+
+typedef map<SinglePlay::PlayType, long> PlayCountMap;
 
 class DecisionNode {
 public:
-    // Lower limit of information gain ratio where a split is valuable
+    /* Lower limit of information gain ratio where a split is valuable. Other criteria have
+        their own limits, in splitCriteria.h */
     static const double MinInformationGain;
 
+    /* How a split divides plays between children. Category splits create one child per
+        category with plays. Binary splits create two children, each holding a group of
+        categories, which gives fewer, better populated nodes for characteristics with many
+        categories. A group with several categories can be split on the same characteristic
+        again further down */
+    enum SplitMode { category_split, binary_split };
+
+    // Sets the split mode used by trees built afterward. The default is category splits
+    static void setSplitMode(SplitMode splitMode);
+    static SplitMode getSplitMode();
+
+    /* How the characteristic to split on is chosen. Exact selection counts every play in
+        a node. Sampled selection estimates the information gain ratios from a growing random
+        sample of the plays in large nodes, stopping as soon as the sample is big enough to
+        be confident of the result. Nodes too small to gain from it are counted exactly */
+    enum SplitSelection { exact_selection, sampled_selection };
+
+    // Sets the split selection used by trees built afterward. The default is exact selection
+    static void setSplitSelection(SplitSelection splitSelection);
+    static SplitSelection getSplitSelection();
+
+    /* How a split is scored (see splitCriteria.h). Gain ratio is the classic C4.5 criterion.
+        Entropy is information gain without the correction for many categories, and Gini
+        scores splits by the drop in Gini impurity, which needs no logarithms */
+    enum SplitCriterion { gain_ratio_criterion, entropy_criterion, gini_criterion };
+
+    // Sets the split criterion used by trees built afterward. The default is gain ratio
+    static void setSplitCriterion(SplitCriterion splitCriterion);
+    static SplitCriterion getSplitCriterion();
+
+    // Returns the name of a split criterion, as given on the command line
+    static const char* getCriterionName(SplitCriterion splitCriterion);
+
+    /* What splits separate. Play type splits separate the types of play called, which is
+        what the tree is for. Yardage splits make a regression tree instead: each split
+        divides the plays so the distances gained vary as little as possible within each
+        child, so the leaves show where plays gain the most and least. Yardage can be for
+        plays of one type only, with the others still shown in the leaves */
+    enum SplitTarget { play_type_target, yardage_target };
+
+    /* Sets the split target used by trees built afterward. The play type is the one whose
+        yardage is wanted, or PlayHistogram::all_play_types. The default is play type splits */
+    static void setSplitTarget(SplitTarget splitTarget, short yardagePlayType);
+    static SplitTarget getSplitTarget();
+    static short getYardagePlayType();
+
     /* Constructor. Requires a set of indexes into the play store, and summary data
         about all plays (not just those in this particular index set
         WARNING: Indexes are modified thanks to the splitting proecess */
     DecisionNode(PlayIndexSet& indexes, const OverallSummaryData& summaryData);
 
+    /* Constructor for plays held in a column store instead of a data store. Only a list of
+        play numbers is held in memory, along with counts of the plays; the plays themselves
+        are read from the store in passes from front to back. The tree is identical to one
+        built from a data store holding the same plays. Splits are always chosen by counting,
+        since sampling depends on how a data store orders its plays */
+    DecisionNode(const ColumnStore& columns, const OverallSummaryData& summaryData);
+
+    /* Constructor for plays selected from a league store, read in place from its segment.
+        The tree is built exactly as for a column store, above */
+    DecisionNode(const LeagueColumns& columns, const OverallSummaryData& summaryData);
+
     // Destructor
     ~DecisionNode();
 
@@ -77,6 +138,11 @@ public:
     void debugOutputData(ostream& stream) const;
 
  private:
+    // The kernel benchmark times the split calculation directly
+    friend class KernelAccess;
+    // The exporter walks the finished tree to write it as C++ source
+    friend class TreeExporter;
+
     // List of child nodes. Any node missing this is a leaf
     vector<DecisionNode*> _childNodes;
     // Atribute to use to choose a child. Applies to non-leaves only
@@ -89,6 +155,115 @@ public:
     // Data about plays in this branch. Should be set for leaves only
     DetailedPlayData _playData;
 
+    /* Distances of the plays in every leaf of the tree are held in one pool. The root
+        allocates and owns it, and every node points to it. NULL except at the root */
+    DistancePool* _ownDistancePool;
+    DistancePool* _distancePool;
+
+    // Split mode, selection, criterion and target for trees being built
+    static SplitMode _splitMode;
+    static SplitSelection _splitSelection;
+    static SplitCriterion _splitCriterion;
+    static SplitTarget _splitTarget;
+    static short _yardagePlayType;
+
+    // Lowest share of the variance of distance a yardage split must remove to be valuable
+    static const double MinVarianceReduction;
+
+    /* Fewest plays with yardage wanted a child must have to be worth splitting off. Yardage
+        is very noisy, so smaller groups mostly show chance */
+    static const short MinYardagePlays;
+
+    // Size of the first sample for sampled selection. Each sample after doubles
+    static const unsigned long SampleStart;
+
+    // Chance that a decision made from a sample differs from the one counting would make
+    static const double SampleConfidence;
+
+    /* Constructor for nodes below the root. The histogram holds the counts of the plays
+        in the indexes, or is NULL if the parent did not count them. The pool is the one
+        owned by the root. Depth is the distance from the root, which is only used for
+        statistics */
+    DecisionNode(PlayIndexSet& indexes, const OverallSummaryData& summaryData,
+                 const PlayHistogram* histogram, DistancePool& distancePool, unsigned short depth);
+
+    /* Constructor for nodes below the root, for a column store or a league selection. The
+        plays of the node are the range [firstRow, lastRow) of the play numbers, and the
+        characteristics available are those the node could still split on. Play numbers
+        within the range are in increasing order */
+    template<class Columns>
+    DecisionNode(const Columns& columns, vector<unsigned int>& rows, unsigned long firstRow,
+                 unsigned long lastRow, const PlayCharacteristicSet& available,
+                 const OverallSummaryData& summaryData, const PlayHistogram* histogram,
+                 DistancePool& distancePool, unsigned short depth);
+
+    // Builds this node and all nodes underneath it. Called by the constructors
+    void buildNode(PlayIndexSet& indexes, const OverallSummaryData& summaryData,
+                   const PlayHistogram* histogram, unsigned short depth);
+
+    /* Builds the root of a tree from a column store or a league selection, and every node
+        underneath it. Called by the constructors */
+    template<class Columns>
+    void buildRoot(const Columns& columns, const OverallSummaryData& summaryData);
+
+    /* Same as buildNode above, for a column store or a league selection. Splitting a node
+        moves the play numbers of each child together, keeping their order, so the children
+        get ranges within this node's range.
+        WARNING: Available characteristics are modified the same way as the indexes above */
+    template<class Columns>
+    void buildNode(const Columns& columns, vector<unsigned int>& rows, unsigned long firstRow,
+                   unsigned long lastRow, PlayCharacteristicSet& available,
+                   const OverallSummaryData& summaryData, const PlayHistogram* histogram,
+                   unsigned short depth);
+
+    /* Chooses the characteristic to split on from counts of the plays. Characteristics that
+        can't split the plays are dropped from the available set, except the last one, as
+        PlayIndexSet::dropIndex does. Sets the ratio to zero if there is no useful split. For
+        binary splits, the group for each category is set as well */
+    void chooseSplit(const PlayHistogram& counts, PlayCharacteristicSet& available, double& maxInfoRatio,
+                     vector<short>& bestGroups);
+
+    /* Chooses the characteristic to split on from random samples of the plays, the same
+        way as above. Returns false if no sample small enough to be worthwhile gives a
+        confident result, in which case the plays must be counted */
+    bool chooseSplitFromSample(PlayIndexSet& indexes, unsigned long playCount, unsigned short depth,
+                               double& maxInfoRatio, vector<short>& bestGroups);
+
+    /* Returns the score from splitting plays on a characteristic, given counts of the plays,
+        using the current criterion. For binary splits, the group for each category is
+        returned as well, with -1 for categories without plays */
+    double getSplitInfoRatio(const PlayHistogram& counts, const PlayCountMap& playTypeCounts,
+                             SinglePlay::PlayCharacteristic characteristic, vector<short>& groups);
+
+    // Same as above, for one criterion
+    template<class Criterion>
+    double getCriterionSplit(const PlayHistogram& counts, const PlayCountMap& playTypeCounts,
+                             SinglePlay::PlayCharacteristic characteristic, vector<short>& groups);
+
+    /* Chooses the characteristic for a yardage split, the one removing the largest share
+        of the variance of distance. Otherwise the same as chooseSplit() */
+    void chooseYardageSplit(const PlayHistogram& counts, PlayCharacteristicSet& available,
+                            double& maxReduction, vector<short>& bestGroups);
+
+    /* Returns the share of the variance of distance removed by splitting plays on a
+        characteristic. For binary splits, the group for each category is returned as
+        well, with -1 for categories without yardage wanted */
+    double getYardageReduction(const PlayHistogram& counts, SinglePlay::PlayCharacteristic characteristic,
+                               vector<short>& groups);
+
+    // Returns the plays whose distances histograms must sum for the split target
+    static short getHistogramDistances();
+
+    // Number of children with enough plays with yardage wanted to stand on their own
+    unsigned short getYardageSupport() const;
+
+    // Lowest score where a split is valuable, and largest difference between scores, for the current criterion
+    static double getMinimumScore();
+    static double getScoreRange();
+
+    // Extracts the number of plays of each type, for the types with plays
+    static void getPlayTypeCounts(const PlayHistogram& counts, PlayCountMap& playTypeCounts);
+
     /* Get the set of plays used in the past given situation characteristics.
         This version takes category values */
     const DetailedPlayData& findPlays(short down, short distanceNeeded,
@@ -96,18 +271,30 @@ public:
                                       SinglePlay::TimeRemaining timeRemaining,
                                       SinglePlay::ScoreDifferential scoreDifferential) const;
 
-    // Converts a set of indexes into data about the plays in the data store
-    void indexesToPlayCounts(const PlayIndexSet& indexes, PlayCountMap& playData);
+    // Returns the score for a given split of plays with a criterion
+    template<class Criterion>
+    static double getSplitScore(const PlayCountMap& plays, long playTotal,
+                                const vector<vector<long> >& splitPlayCounts, const vector<long>& splitPlayTotals);
+
+    // Same as above, with the criterion given at run time. Used to time the criteria
+    static double getSplitScore(SplitCriterion splitCriterion, const PlayCountMap& plays, long playTotal,
+                                const vector<vector<long> >& splitPlayCounts, const vector<long>& splitPlayTotals);
 
-    // Converts an index into data about the plays in the index
-    void indexesToPlayCounts(const PlayIndex& index, PlayCountMap& data);
+    /* Finds the best division of the categories of a split into two groups, and returns its
+        score. The group for each entry of the split counts is returned */
+    template<class Criterion>
+    static double getBinaryGrouping(const PlayCountMap& plays, long playTotal,
+                                    const vector<vector<long> >& splitPlayCounts,
+                                    const vector<long>& splitPlayTotals, vector<short>& groups);
 
-    // Returns the information gain ratio for a given split of plays
-    double getInfoGainRatio(const PlayCountMap& plays, short playTotal,
-                            vector<vector<short> >& splitPlayCounts, vector<short> splitPlayTotals);
+    // Returns the total number of plays in a set of play counts
+    static long getPlayTotal(const PlayCountMap& playData);
 
-    // Returns the information of a group of plays of one type
-    double getInformation(short playCount, short groupCount);
+    // Prunes this node and all nodes underneath it. Called by pruneTree()
+    void pruneNode();
+
+    // Copies the distances of this node and all nodes underneath it to a new pool, in tree order
+    void compactDistances(DistancePool& newPool);
 
     // Returns whether this node is a leaf. Deliberately private
     bool isLeaf() const;
@@ -133,16 +320,73 @@ ostream& operator<<(ostream& stream, const DecisionNode& node);
 inline const DetailedPlayData& DecisionNode::findPlays(short down, short distanceNeeded, short yardLine,
                                                        short minutes, short ownScore, short oppScore) const
 {
-    // Convert values to category values and call
-    return findPlays(down, distanceNeeded, SinglePlay::yardsToFieldLocation(yardLine),
+    /* Convert values to category values and call. The distance category is passed as a
+        short, since the other version also takes it that way */
+    return findPlays(down, (short)SinglePlay::distanceToDistanceNeeded(distanceNeeded),
+                     SinglePlay::yardsToFieldLocation(yardLine),
                      SinglePlay::minutesToTimeRemaining(minutes),
                      SinglePlay::scoreToScoreDifferential(ownScore, oppScore));
 }
 
-inline double DecisionNode::getInformation(short playCount, short groupCount)
+// Sets the split mode used by trees built afterward. The default is category splits
+inline void DecisionNode::setSplitMode(SplitMode splitMode)
+{
+    _splitMode = splitMode;
+}
+
+inline DecisionNode::SplitMode DecisionNode::getSplitMode()
+{
+    return _splitMode;
+}
+
+// Sets the split selection used by trees built afterward. The default is exact selection
+inline void DecisionNode::setSplitSelection(SplitSelection splitSelection)
+{
+    _splitSelection = splitSelection;
+}
+
+inline DecisionNode::SplitSelection DecisionNode::getSplitSelection()
+{
+    return _splitSelection;
+}
+
+// Sets the split criterion used by trees built afterward. The default is gain ratio
+inline void DecisionNode::setSplitCriterion(SplitCriterion splitCriterion)
+{
+    _splitCriterion = splitCriterion;
+}
+
+inline DecisionNode::SplitCriterion DecisionNode::getSplitCriterion()
+{
+    return _splitCriterion;
+}
+
+/* Sets the split target used by trees built afterward. The play type is the one whose
+    yardage is wanted, or PlayHistogram::all_play_types. The default is play type splits */
+inline void DecisionNode::setSplitTarget(SplitTarget splitTarget, short yardagePlayType)
+{
+    _splitTarget = splitTarget;
+    _yardagePlayType = yardagePlayType;
+}
+
+inline DecisionNode::SplitTarget DecisionNode::getSplitTarget()
+{
+    return _splitTarget;
+}
+
+inline short DecisionNode::getYardagePlayType()
+{
+    return _yardagePlayType;
+}
+
+// Returns the total number of plays in a set of play counts
+inline long DecisionNode::getPlayTotal(const PlayCountMap& playData)
 {
-    double ratio = (double)playCount / (double)groupCount;
-    return -ratio * log2(ratio);
+    long playTotal = 0;
+    PlayCountMap::const_iterator index;
+    for (index = playData.begin(); index != playData.end(); index++)
+        playTotal += index->second;
+    return playTotal;
 }
 
 // Returns whether this node is a leaf. Deliberately private
@@ -0,0 +1,875 @@
+/* This file is part of NFLdecisionTree. It creates decision trees to classify
+    situations within NFL football games, and displays the plays historically
+    called in those situations given a set of opponents.
+
+    Copyright (C) 2013   Ezra Erb
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 3 as published
+    by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    I'd appreciate a note if you find this program useful or make
+    updates. Please contact me through LinkedIn (my profile also has
+    a link to the code depository)
+*/
+#include<string>
+#include<vector>
+#include<fstream>
+#include<iostream>
+#include<sstream>
+#include<algorithm>
+#include<cstring>
+#include<cerrno>
+
+#include"singlePlay.h" // Needed by playIndexSet.h
+#include"playIndexSet.h" // Needed by dataStore.h
+#include"playStats.h" // Needed by dataStore.h
+#include"allocTracker.h" // Needed by dataStore.h
+#include"dataStore.h"
+#include"columnStore.h"
+#include"playLoader.h"
+#include"leagueStore.h"
+#include"baseException.h"
+#include"runStats.h"
+#include"traceLog.h"
+
+#ifndef _WIN32
+#include<sys/mman.h>
+#include<time.h>
+#include<sys/stat.h>
+#include<fcntl.h>
+#include<unistd.h>
+#endif
+
+using std::string;
+using std::vector;
+using std::stringstream;
+using std::merge;
+using std::find;
+using std::back_inserter;
+
+// Identifies a published segment
+static const char SegmentMagic[8] = { 'N', 'F', 'L', 'P', 'L', 'A', 'Y', 'S' };
+
+// Sections of the segment start on this boundary, so they can be read in place
+static const unsigned long long SegmentAlignment = 8;
+
+// Rounds a segment offset up to the next section boundary
+static unsigned long long alignOffset(unsigned long long offset)
+{
+    return (offset + SegmentAlignment - 1) & ~(SegmentAlignment - 1);
+}
+
+#ifndef _WIN32
+/* Returns a new generation stamp for a segment. The time in nanoseconds differs for
+    every publication on the machine, which is all that ever shares a segment name */
+static unsigned long long newGeneration()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return ((unsigned long long)now.tv_sec * 1000000000ULL) + (unsigned long long)now.tv_nsec;
+}
+#endif
+
+/* Bytes taken by a packed column. The eight bytes after the last value are padding, so
+    reading any value can always load eight bytes at once */
+static unsigned long long packedColumnSize(unsigned int valueCount, unsigned short width)
+{
+    return ((((unsigned long long)valueCount * width) + 7) / 8) + sizeof(unsigned long long);
+}
+
+// Stores value N of a packed column. The column must start zeroed
+static void packValue(char* column, unsigned short width, unsigned int index, unsigned int value)
+{
+    unsigned long long bitPosition = (unsigned long long)index * width;
+    unsigned long long bits;
+    memcpy(&bits, column + (bitPosition >> 3), sizeof(bits));
+    bits |= ((unsigned long long)value << (bitPosition & 7));
+    memcpy(column + (bitPosition >> 3), &bits, sizeof(bits));
+}
+
+// Names without a '/' are shared memory objects, everything else is a file path
+static bool isSharedMemoryName(const string& name)
+{
+    return (name.find('/') == string::npos);
+}
+
+// Throws an error about a segment, including the system error if there is one
+static void throwSegmentError(const char* file, int line, const char* action, const string& name)
+{
+    stringstream errorMessage;
+    errorMessage << "Could not " << action << " league store " << name;
+    if (errno != 0)
+        errorMessage << ": " << strerror(errno);
+    throw BaseException(file, line, errorMessage.str().c_str());
+}
+
+// Creates an empty store
+LeagueStore::LeagueStore()
+    : _plays(), _teams(), _firstSeason(0), _lastSeason(0), _segment(NULL), _segmentSize(0)
+{
+    // All in the initialization list
+}
+
+// Destructor. Unmaps any attached segment
+LeagueStore::~LeagueStore()
+{
+    clear();
+}
+
+// Releases anything loaded or attached
+void LeagueStore::clear()
+{
+#ifndef _WIN32
+    if (_segment != NULL)
+        munmap((void*)_segment, _segmentSize);
+#endif
+    _segment = NULL;
+    _segmentSize = 0;
+    _plays.clear();
+    _teams.clear();
+    _firstSeason = 0;
+    _lastSeason = 0;
+}
+
+/* Loads every down play for a range of seasons, [first...last], for publishing.
+    Replaces anything loaded or attached before */
+void LeagueStore::loadSeasons(PlayLoader& loader, unsigned short firstYear, unsigned short lastYear)
+{
+    clear();
+    // Most recent seasons are loaded first, matching the order PlayLoader uses
+    unsigned short yearCounter;
+    for (yearCounter = lastYear; yearCounter >= firstYear; yearCounter--)
+        loadSingleSeason(loader, yearCounter);
+    _firstSeason = firstYear;
+    _lastSeason = lastYear;
+}
+
+// Loads every down play for one season
+void LeagueStore::loadSingleSeason(PlayLoader& loader, unsigned short seasonYear)
+{
+    STATS_PHASE(season_load);
+    ALLOC_SCOPE(loader_memory);
+    TRACE_SCOPE("season_load", "season", seasonYear);
+    loader.openSeasonFile(seasonYear);
+
+    string playText;
+    // First line is a header. Read it to burn it
+    getline(loader._playFile, playText);
+    PlayLoader::PlayFields fields;
+    while (!loader._playFile.eof()) {
+        {
+            STATS_TIMER(readTimer, file_read);
+            getline(loader._playFile, playText);
+        }
+        // The file normally ends with a line break, which produces an empty final line
+        if (playText.empty())
+            continue;
+        STATS_COUNT(lines_scanned, 1);
+        STATS_TIMER(lineTimer, line_parse);
+        // Every down play is wanted, so there is no filter step
+        string::size_type pos;
+        if (!loader.extractLeadingFields(playText, fields, pos))
+            continue;
+        if (!loader.extractTrailingFields(playText, pos, fields))
+            continue;
+
+        /* The pass type of a busted pass play depends on how many were wanted before it
+            in the season, so a count of zero is passed and the play is flagged if the
+            count changed. The type is assigned when plays are selected */
+        STATS_SWITCH(lineTimer, classification);
+        SinglePlay::PlayType playType = SinglePlay::punt;
+        short distanceGained = 0;
+        bool turnedOver = false;
+        unsigned short sackCount = 0;
+        if (!loader.classifyDescription(fields.description, sackCount, playType, distanceGained, turnedOver)) {
+            loader.reportUnknownPlay(playText, fields.description);
+            continue;
+        }
+        STATS_COUNT(plays_kept, 1);
+        // The tree only uses the categories of the situation, so they are all that is kept
+        StoredPlay newPlay;
+        newPlay.season = seasonYear;
+        newPlay.categories[SinglePlay::down_number] = (unsigned char)fields.down;
+        newPlay.categories[SinglePlay::distance_needed] =
+            (unsigned char)SinglePlay::distanceToDistanceNeeded(fields.distanceNeeded);
+        newPlay.categories[SinglePlay::field_location] = (unsigned char)SinglePlay::yardsToFieldLocation(fields.yardLine);
+        newPlay.categories[SinglePlay::time_remaining] = (unsigned char)SinglePlay::minutesToTimeRemaining(fields.minutes);
+        newPlay.categories[SinglePlay::score_differential] =
+            (unsigned char)SinglePlay::scoreToScoreDifferential(fields.ownScore, fields.oppScore);
+        newPlay.distanceGained = distanceGained;
+        newPlay.offense = findTeam(fields.offense);
+        newPlay.defense = findTeam(fields.defense);
+        newPlay.playType = (unsigned char)playType;
+        newPlay.turnedOver = turnedOver ? 1 : 0;
+        newPlay.rotatedPass = (sackCount != 0) ? 1 : 0;
+        _plays.push_back(newPlay);
+    } // Loop through lines of the file
+    loader._playFile.close();
+}
+
+// Returns the team number for a team code, adding it if needed
+unsigned char LeagueStore::findTeam(const string& team)
+{
+    // There are only a few dozen teams, so a linear search is fastest
+    unsigned short index;
+    for (index = 0; index < _teams.size(); index++)
+        if (_teams[index] == team)
+            return (unsigned char)index;
+    if ((_teams.size() > 255) || (team.size() >= sizeof(((TeamEntry*)0)->code))) {
+        stringstream errorMessage;
+        errorMessage << "League store can't hold team " << team;
+        throw BaseException(__FILE__, __LINE__, errorMessage.str().c_str());
+    }
+    _teams.push_back(team);
+    return (unsigned char)(_teams.size() - 1);
+}
+
+// Returns the value of a loaded play for a packed column
+short LeagueStore::getColumnValue(const StoredPlay& play, PackedColumn column)
+{
+    switch (column) {
+    case down_column:
+    case distance_needed_column:
+    case field_location_column:
+    case time_remaining_column:
+    case score_differential_column:
+        return (short)play.categories[column];
+    case distance_gained_column:
+        return play.distanceGained;
+    case play_type_column:
+        return (short)play.playType;
+    case turnover_column:
+        return (short)play.turnedOver;
+    case rotated_pass_column:
+        return (short)play.rotatedPass;
+    default: // Keep the compiler happy
+        return 0;
+    }
+}
+
+/* Lays out the loaded plays as a segment. The runs, team entries and run numbers for
+    each team are built as well */
+void LeagueStore::layoutSegment(SegmentLayout& layout) const
+{
+    SegmentHeader& header = layout.header;
+    memset(&header, 0, sizeof(header));
+    header.version = SegmentVersion;
+    header.playCount = (unsigned int)_plays.size();
+    header.teamCount = (unsigned int)_teams.size();
+    header.firstSeason = _firstSeason;
+    header.lastSeason = _lastSeason;
+
+    // Find the runs of plays with the same teams, and of each season
+    layout.playRuns.clear();
+    layout.seasonRuns.clear();
+    unsigned int playIndex;
+    for (playIndex = 0; playIndex < _plays.size(); playIndex++) {
+        const StoredPlay& play = _plays[playIndex];
+        if (layout.playRuns.empty() || (play.offense != layout.playRuns.back().offense) ||
+            (play.defense != layout.playRuns.back().defense)) {
+            PlayRun newRun;
+            memset(&newRun, 0, sizeof(newRun)); // Padding goes into the segment too
+            newRun.firstPlay = playIndex;
+            newRun.offense = play.offense;
+            newRun.defense = play.defense;
+            layout.playRuns.push_back(newRun);
+        }
+        if (layout.seasonRuns.empty() || (play.season != layout.seasonRuns.back().season)) {
+            SeasonRun newSeason;
+            newSeason.firstPlay = playIndex;
+            newSeason.season = play.season;
+            layout.seasonRuns.push_back(newSeason);
+        }
+    } // Loop through plays
+    header.runCount = (unsigned int)layout.playRuns.size();
+    header.seasonCount = (unsigned int)layout.seasonRuns.size();
+    PlayRun endRun;
+    memset(&endRun, 0, sizeof(endRun));
+    endRun.firstPlay = header.playCount;
+    layout.playRuns.push_back(endRun);
+
+    /* Build the team lists. Count the runs for each team, then place run numbers in
+        increasing order, which is the order selection wants them */
+    layout.teamEntries.assign(_teams.size(), TeamEntry());
+    unsigned int teamIndex;
+    for (teamIndex = 0; teamIndex < layout.teamEntries.size(); teamIndex++) {
+        TeamEntry& entry = layout.teamEntries[teamIndex];
+        memset(&entry, 0, sizeof(TeamEntry));
+        strncpy(entry.code, _teams[teamIndex].c_str(), sizeof(entry.code) - 1);
+    }
+    unsigned int runIndex;
+    for (runIndex = 0; runIndex < header.runCount; runIndex++) {
+        layout.teamEntries[layout.playRuns[runIndex].offense].offenseCount++;
+        layout.teamEntries[layout.playRuns[runIndex].defense].defenseCount++;
+    }
+    unsigned int nextStart = 0;
+    for (teamIndex = 0; teamIndex < layout.teamEntries.size(); teamIndex++) {
+        layout.teamEntries[teamIndex].offenseStart = nextStart;
+        nextStart += layout.teamEntries[teamIndex].offenseCount;
+    }
+    for (teamIndex = 0; teamIndex < layout.teamEntries.size(); teamIndex++) {
+        layout.teamEntries[teamIndex].defenseStart = nextStart;
+        nextStart += layout.teamEntries[teamIndex].defenseCount;
+    }
+    layout.runNumbers.assign(2 * header.runCount, 0);
+    vector<unsigned int> offenseFill(layout.teamEntries.size(), 0);
+    vector<unsigned int> defenseFill(layout.teamEntries.size(), 0);
+    for (runIndex = 0; runIndex < header.runCount; runIndex++) {
+        unsigned char offense = layout.playRuns[runIndex].offense;
+        unsigned char defense = layout.playRuns[runIndex].defense;
+        layout.runNumbers[layout.teamEntries[offense].offenseStart + offenseFill[offense]++] = runIndex;
+        layout.runNumbers[layout.teamEntries[defense].defenseStart + defenseFill[defense]++] = runIndex;
+    }
+
+    header.teamOffset = alignOffset(sizeof(SegmentHeader));
+    header.runOffset = alignOffset(header.teamOffset + (header.teamCount * sizeof(TeamEntry)));
+    header.seasonOffset = alignOffset(header.runOffset + ((header.runCount + 1ULL) * sizeof(PlayRun)));
+    header.indexOffset = alignOffset(header.seasonOffset + (header.seasonCount * sizeof(SeasonRun)));
+    unsigned long long nextOffset = alignOffset(header.indexOffset +
+                                                (2ULL * header.runCount * sizeof(unsigned int)));
+
+    /* Each column is packed in just enough bits for the range of its values. Category
+        columns hold codes instead, the positions of their categories in a dictionary of the
+        categories found, so they need just enough bits for the number of categories */
+    unsigned int column;
+    for (column = 0; column < column_count; column++) {
+        ColumnEntry& entry = header.columns[column];
+        short minValue = 0;
+        short maxValue = 0;
+        vector<bool> categoryFound;
+        for (playIndex = 0; playIndex < _plays.size(); playIndex++) {
+            short value = getColumnValue(_plays[playIndex], (PackedColumn)column);
+            if ((playIndex == 0) || (value < minValue))
+                minValue = value;
+            if ((playIndex == 0) || (value > maxValue))
+                maxValue = value;
+            if (isCategoryColumn((PackedColumn)column)) {
+                if ((unsigned short)value >= categoryFound.size())
+                    categoryFound.resize(value + 1, false);
+                categoryFound[value] = true;
+            }
+        }
+        unsigned int valueRange = (unsigned int)((int)maxValue - (int)minValue);
+        if (isCategoryColumn((PackedColumn)column)) {
+            unsigned int codeCount = 0;
+            unsigned short category;
+            for (category = 0; category < categoryFound.size(); category++)
+                if (categoryFound[category]) {
+                    if (codeCount >= DictionarySize)
+                        throw BaseException(__FILE__, __LINE__, "League store can't hold the categories of a characteristic");
+                    entry.dictionary[codeCount] = (unsigned char)category;
+                    codeCount++;
+                }
+            valueRange = (codeCount > 1) ? codeCount - 1 : 0;
+        } // Category column
+        else
+            entry.base = minValue;
+        entry.width = 0;
+        while ((1U << entry.width) <= valueRange)
+            entry.width++;
+        entry.offset = nextOffset;
+        nextOffset = alignOffset(nextOffset + packedColumnSize(header.playCount, entry.width));
+    } // Loop through columns
+    header.segmentSize = nextOffset;
+}
+
+/* Packs the loaded plays into memory laid out by layoutSegment(). The memory must
+    start zeroed. The magic goes in last, after everything else is visible, so another
+    process attaching at the wrong moment sees an incomplete segment instead of bad data */
+void LeagueStore::writeSegment(char* segment, const SegmentLayout& layout) const
+{
+    const SegmentHeader& header = layout.header;
+    if (!layout.teamEntries.empty())
+        memcpy(segment + header.teamOffset, &layout.teamEntries[0], layout.teamEntries.size() * sizeof(TeamEntry));
+    memcpy(segment + header.runOffset, &layout.playRuns[0], layout.playRuns.size() * sizeof(PlayRun));
+    if (!_plays.empty()) {
+        memcpy(segment + header.seasonOffset, &layout.seasonRuns[0], layout.seasonRuns.size() * sizeof(SeasonRun));
+        memcpy(segment + header.indexOffset, &layout.runNumbers[0], layout.runNumbers.size() * sizeof(unsigned int));
+    }
+    unsigned int column;
+    for (column = 0; column < column_count; column++) {
+        const ColumnEntry& entry = header.columns[column];
+        if (!entry.width)
+            continue; // Every value is the base, or the only category
+        /* Codes for category columns are looked up by category. Unused dictionary entries
+            are zero, so going backward leaves the lowest code for each category */
+        unsigned char categoryCodes[256];
+        int code;
+        for (code = DictionarySize - 1; code >= 0; code--)
+            categoryCodes[entry.dictionary[code]] = (unsigned char)code;
+        unsigned int playIndex;
+        for (playIndex = 0; playIndex < _plays.size(); playIndex++) {
+            short value = getColumnValue(_plays[playIndex], (PackedColumn)column);
+            if (isCategoryColumn((PackedColumn)column))
+                packValue(segment + entry.offset, entry.width, playIndex, categoryCodes[value]);
+            else
+                packValue(segment + entry.offset, entry.width, playIndex, (unsigned int)((int)value - (int)entry.base));
+        }
+    } // Loop through columns
+    memcpy(segment, &header, sizeof(header));
+    __sync_synchronize();
+    memcpy(segment, SegmentMagic, sizeof(SegmentMagic));
+}
+
+// Publishes the loaded plays to a named segment
+void LeagueStore::publish(const string& name) const
+{
+#ifdef _WIN32
+    throw BaseException(__FILE__, __LINE__, "League stores need a POSIX system");
+#else
+    SegmentLayout layout;
+    layoutSegment(layout);
+    layout.header.generation = newGeneration();
+    const SegmentHeader& header = layout.header;
+
+    /* Remove any existing segment first. Processes attached to it keep their mapping,
+        and nothing can attach to the new one until it is complete */
+    errno = 0;
+    int fileHandle;
+    if (isSharedMemoryName(name)) {
+        string objectName(string("/") + name);
+        shm_unlink(objectName.c_str());
+        fileHandle = shm_open(objectName.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    }
+    else {
+        unlink(name.c_str());
+        fileHandle = open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    }
+    if (fileHandle < 0)
+        throwSegmentError(__FILE__, __LINE__, "create", name);
+    if (ftruncate(fileHandle, (off_t)header.segmentSize) != 0) {
+        close(fileHandle);
+        throwSegmentError(__FILE__, __LINE__, "size", name);
+    }
+    void* mapping = mmap(NULL, header.segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, fileHandle, 0);
+    close(fileHandle);
+    if (mapping == MAP_FAILED)
+        throwSegmentError(__FILE__, __LINE__, "map", name);
+
+    writeSegment((char*)mapping, layout);
+    msync(mapping, header.segmentSize, MS_SYNC);
+    munmap(mapping, header.segmentSize);
+#endif
+}
+
+/* Attaches to the loaded plays without publishing them, so only this process can select
+    from them. The loaded copy is released, so the plays are held once */
+void LeagueStore::attachLoaded()
+{
+#ifdef _WIN32
+    throw BaseException(__FILE__, __LINE__, "League stores need a POSIX system");
+#else
+    SegmentLayout layout;
+    layoutSegment(layout);
+    layout.header.generation = newGeneration();
+    const SegmentHeader& header = layout.header;
+    errno = 0;
+    void* mapping = mmap(NULL, header.segmentSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED)
+        throwSegmentError(__FILE__, __LINE__, "map", string("in memory"));
+    writeSegment((char*)mapping, layout);
+    mprotect(mapping, header.segmentSize, PROT_READ);
+
+    // Keep the seasons, since clear() resets them
+    unsigned short firstSeason = _firstSeason;
+    unsigned short lastSeason = _lastSeason;
+    clear();
+    _segment = (const char*)mapping;
+    _segmentSize = header.segmentSize;
+    _firstSeason = firstSeason;
+    _lastSeason = lastSeason;
+#endif
+}
+
+// Attaches to a published segment, read only. Replaces anything loaded or attached before
+void LeagueStore::attach(const string& name)
+{
+    clear();
+#ifdef _WIN32
+    throw BaseException(__FILE__, __LINE__, "League stores need a POSIX system");
+#else
+    errno = 0;
+    int fileHandle;
+    if (isSharedMemoryName(name))
+        fileHandle = shm_open((string("/") + name).c_str(), O_RDONLY, 0);
+    else
+        fileHandle = open(name.c_str(), O_RDONLY);
+    if (fileHandle < 0)
+        throwSegmentError(__FILE__, __LINE__, "open", name);
+    struct stat fileStatus;
+    if (fstat(fileHandle, &fileStatus) != 0) {
+        close(fileHandle);
+        throwSegmentError(__FILE__, __LINE__, "read the size of", name);
+    }
+    unsigned long long segmentSize = (unsigned long long)fileStatus.st_size;
+    if (segmentSize < sizeof(SegmentHeader)) {
+        close(fileHandle);
+        errno = 0;
+        throwSegmentError(__FILE__, __LINE__, "use incomplete", name);
+    }
+    void* mapping = mmap(NULL, segmentSize, PROT_READ, MAP_SHARED, fileHandle, 0);
+    close(fileHandle);
+    if (mapping == MAP_FAILED)
+        throwSegmentError(__FILE__, __LINE__, "map", name);
+    _segment = (const char*)mapping;
+    _segmentSize = segmentSize;
+
+    // Check it before trusting any of the offsets
+    const SegmentHeader* header = (const SegmentHeader*)_segment;
+    errno = 0;
+    if (memcmp(header->magic, SegmentMagic, sizeof(SegmentMagic)) != 0) {
+        clear();
+        throwSegmentError(__FILE__, __LINE__, "use incomplete", name);
+    }
+    bool compatible = ((header->version == SegmentVersion) && (header->segmentSize == segmentSize) &&
+                       (header->teamOffset + (header->teamCount * sizeof(TeamEntry)) <= header->runOffset) &&
+                       (header->runOffset + ((header->runCount + 1ULL) * sizeof(PlayRun)) <= header->seasonOffset) &&
+                       (header->seasonOffset + (header->seasonCount * sizeof(SeasonRun)) <= header->indexOffset));
+    unsigned long long columnStart = header->indexOffset + (2ULL * header->runCount * sizeof(unsigned int));
+    unsigned int column;
+    for (column = 0; compatible && (column < column_count); column++) {
+        const ColumnEntry& entry = header->columns[column];
+        compatible = ((entry.width <= 16) && (entry.offset >= columnStart) &&
+                      (entry.offset + packedColumnSize(header->playCount, entry.width) <= segmentSize));
+        // Every code of a category column must be in its dictionary
+        if (isCategoryColumn((PackedColumn)column))
+            compatible = (compatible && ((1U << entry.width) <= DictionarySize));
+    }
+    if (!compatible) {
+        clear();
+        throwSegmentError(__FILE__, __LINE__, "use incompatible", name);
+    }
+    _firstSeason = header->firstSeason;
+    _lastSeason = header->lastSeason;
+#endif
+}
+
+/* Stamp of the attached segment, different every time plays are published or attached
+    from a load, so a segment replaced under the same name can be told apart. Zero if
+    not attached */
+unsigned long long LeagueStore::getGeneration() const
+{
+    if (_segment != NULL)
+        return ((const SegmentHeader*)_segment)->generation;
+    else
+        return 0;
+}
+
+// Number of plays held
+unsigned int LeagueStore::getPlayCount() const
+{
+    if (_segment != NULL)
+        return ((const SegmentHeader*)_segment)->playCount;
+    else
+        return (unsigned int)_plays.size();
+}
+
+/* Selects the plays for a matchup from the attached segment into a data store and
+    builds its indexes. The plays and their order are exactly what PlayLoader::loadPlays
+    would produce */
+void LeagueStore::selectPlays(const string& thisTeam, const string& otherTeam,
+                              const vector<string>& thisSimiliar, const vector<string>& otherSimiliar,
+                              DataStore& dataStore) const
+{
+    if (_segment == NULL)
+        throw BaseException(__FILE__, __LINE__, "League store is not attached");
+    STATS_PHASE(season_load);
+    ALLOC_SCOPE(loader_memory);
+    vector<unsigned int> wantedPlays;
+    findMatchupPlays(thisTeam, otherTeam, thisSimiliar, otherSimiliar, wantedPlays);
+    insertSelected(wantedPlays, dataStore);
+}
+
+/* Same as above, adding the plays to a column writer instead, in the same order, so
+    they are never all held in memory. The writer is not finished */
+void LeagueStore::selectPlays(const string& thisTeam, const string& otherTeam,
+                              const vector<string>& thisSimiliar, const vector<string>& otherSimiliar,
+                              ColumnWriter& writer) const
+{
+    if (_segment == NULL)
+        throw BaseException(__FILE__, __LINE__, "League store is not attached");
+    STATS_PHASE(season_load);
+    ALLOC_SCOPE(loader_memory);
+    vector<unsigned int> wantedPlays;
+    findMatchupPlays(thisTeam, otherTeam, thisSimiliar, otherSimiliar, wantedPlays);
+    vector<unsigned char> playTypes;
+    getPlayTypes(wantedPlays, playTypes);
+    unsigned int playIndex;
+    for (playIndex = 0; playIndex < wantedPlays.size(); playIndex++) {
+        unsigned int playNumber = wantedPlays[playIndex];
+        writer.addPlay(SinglePlay(playIndex, (SinglePlay::PlayType)playTypes[playIndex],
+                                  unpackValue(down_column, playNumber),
+                                  (SinglePlay::DistanceNeeded)unpackValue(distance_needed_column, playNumber),
+                                  (SinglePlay::FieldLocation)unpackValue(field_location_column, playNumber),
+                                  (SinglePlay::TimeRemaining)unpackValue(time_remaining_column, playNumber),
+                                  (SinglePlay::ScoreDifferential)unpackValue(score_differential_column, playNumber),
+                                  unpackValue(distance_gained_column, playNumber),
+                                  (unpackValue(turnover_column, playNumber) != 0)));
+    }
+    STATS_COUNT(plays_kept, wantedPlays.size());
+}
+
+/* Same as above, selecting the plays to be read in place from the attached segment,
+    for building a tree without a data store. The segment must stay attached while the
+    columns are used */
+void LeagueStore::selectPlays(const string& thisTeam, const string& otherTeam,
+                              const vector<string>& thisSimiliar, const vector<string>& otherSimiliar,
+                              LeagueColumns& columns) const
+{
+    if (_segment == NULL)
+        throw BaseException(__FILE__, __LINE__, "League store is not attached");
+    STATS_PHASE(season_load);
+    ALLOC_SCOPE(loader_memory);
+    findMatchupPlays(thisTeam, otherTeam, thisSimiliar, otherSimiliar, columns._playNumbers);
+    getPlayTypes(columns._playNumbers, columns._playTypes);
+
+    // Point the columns at the packed bits
+    const SegmentHeader* header = (const SegmentHeader*)_segment;
+    const unsigned int* playNumbers = columns._playNumbers.empty() ? NULL : &columns._playNumbers[0];
+    unsigned short characteristic;
+    for (characteristic = 0; characteristic <= (unsigned short)SinglePlay::score_differential; characteristic++) {
+        // Category columns are in characteristic order
+        const ColumnEntry& entry = header->columns[characteristic];
+        LeagueColumns::CategoryColumn& categories = columns._categories[characteristic];
+        categories._bits = _segment + entry.offset;
+        categories._dictionary = entry.dictionary;
+        categories._playNumbers = playNumbers;
+        categories._width = entry.width;
+    }
+    const ColumnEntry& distanceEntry = header->columns[distance_gained_column];
+    columns._distances._bits = _segment + distanceEntry.offset;
+    columns._distances._playNumbers = playNumbers;
+    columns._distances._base = distanceEntry.base;
+    columns._distances._width = distanceEntry.width;
+    const ColumnEntry& turnoverEntry = header->columns[turnover_column];
+    columns._turnovers._bits = _segment + turnoverEntry.offset;
+    columns._turnovers._playNumbers = playNumbers;
+    columns._turnovers._base = turnoverEntry.base;
+    columns._turnovers._width = turnoverEntry.width;
+
+    // Total the plays of each type for the summary data, as the data store does
+    unsigned short playTypeCount = SinglePlay::getPlayTypeCount();
+    vector<long> playCounts(playTypeCount, 0);
+    vector<long> distanceSums(playTypeCount, 0);
+    vector<long long> distanceSquares(playTypeCount, 0);
+    vector<long> turnoverCounts(playTypeCount, 0);
+    unsigned int row;
+    for (row = 0; row < columns._playNumbers.size(); row++) {
+        unsigned short playType = columns._playTypes[row];
+        long distance = columns._distances[row];
+        playCounts[playType]++;
+        distanceSums[playType] += distance;
+        distanceSquares[playType] += (long long)distance * distance;
+        turnoverCounts[playType] += columns._turnovers[row];
+    }
+    PlaySummaryFactory::buildSummaryData(playCounts, distanceSums, distanceSquares, turnoverCounts,
+                                         columns._summaryData);
+    STATS_COUNT(plays_kept, columns._playNumbers.size());
+}
+
+// Finds the numbers of the plays for a matchup, in load order, as selectPlays() wants them
+void LeagueStore::findMatchupPlays(const string& thisTeam, const string& otherTeam,
+                                   const vector<string>& thisSimiliar, const vector<string>& otherSimiliar,
+                                   vector<unsigned int>& wantedPlays) const
+{
+    const SegmentHeader* header = (const SegmentHeader*)_segment;
+    const TeamEntry* teams = (const TeamEntry*)(_segment + header->teamOffset);
+    TRACE_SCOPE("league_select", "plays", header->playCount);
+
+    /* Flag the teams wanted in each role. The rules are the same as PlayLoader::processPlay:
+        1. Offense is the wanted team, and defense is the opponent or similiar to it
+        2. Offense is similiar to the wanted team, and defense is the opponent */
+    vector<bool> similiarOffense(header->teamCount, false);
+    vector<bool> wantedDefense(header->teamCount, false);
+    const TeamEntry* thisEntry = NULL;
+    const TeamEntry* otherEntry = NULL;
+    unsigned int thisNumber = header->teamCount; // Team numbers; past the end if not found
+    unsigned int teamIndex;
+    for (teamIndex = 0; teamIndex < header->teamCount; teamIndex++) {
+        string code(teams[teamIndex].code);
+        if (code == thisTeam) {
+            thisEntry = teams + teamIndex;
+            thisNumber = teamIndex;
+        }
+        if (code == otherTeam) {
+            otherEntry = teams + teamIndex;
+            wantedDefense[teamIndex] = true;
+        }
+        if (find(thisSimiliar.begin(), thisSimiliar.end(), code) != thisSimiliar.end())
+            similiarOffense[teamIndex] = true;
+        if (find(otherSimiliar.begin(), otherSimiliar.end(), code) != otherSimiliar.end())
+            wantedDefense[teamIndex] = true;
+    }
+
+    // Plays with the wanted team on offense are handled by its own runs
+    if (thisNumber < header->teamCount)
+        similiarOffense[thisNumber] = false;
+
+    vector<unsigned int> ownOffense;
+    if (thisEntry != NULL)
+        selectRuns(*thisEntry, true, wantedDefense, ownOffense);
+    vector<unsigned int> similiarPlays;
+    if (otherEntry != NULL)
+        selectRuns(*otherEntry, false, similiarOffense, similiarPlays);
+    // Both lists are in load order, so merging them gives the order PlayLoader uses
+    wantedPlays.clear();
+    wantedPlays.reserve(ownOffense.size() + similiarPlays.size());
+    merge(ownOffense.begin(), ownOffense.end(), similiarPlays.begin(), similiarPlays.end(),
+          back_inserter(wantedPlays));
+}
+
+// Returns whether a team has any plays in the attached segment
+bool LeagueStore::hasTeam(const string& team) const
+{
+    return (findEntry(team) != NULL);
+}
+
+/* Finds the numbers of every play with one team on offense and another on defense, in
+    load order, and adds them to the end of the list */
+void LeagueStore::findPairPlays(const string& offense, const string& defense,
+                                vector<unsigned int>& playNumbers) const
+{
+    const TeamEntry* offenseEntry = findEntry(offense);
+    const TeamEntry* defenseEntry = findEntry(defense);
+    if ((offenseEntry == NULL) || (defenseEntry == NULL))
+        return;
+    const SegmentHeader* header = (const SegmentHeader*)_segment;
+    const TeamEntry* teams = (const TeamEntry*)(_segment + header->teamOffset);
+
+    // Walk whichever team has fewer runs in its role
+    vector<bool> wantedTeams(header->teamCount, false);
+    if (offenseEntry->offenseCount <= defenseEntry->defenseCount) {
+        wantedTeams[defenseEntry - teams] = true;
+        selectRuns(*offenseEntry, true, wantedTeams, playNumbers);
+    }
+    else {
+        wantedTeams[offenseEntry - teams] = true;
+        selectRuns(*defenseEntry, false, wantedTeams, playNumbers);
+    }
+}
+
+/* Adds the numbers of the plays of every run listed for a team whose other team is
+    wanted, in load order. The list is the team's offense runs when the other team is
+    the defense, and its defense runs otherwise */
+void LeagueStore::selectRuns(const TeamEntry& entry, bool onOffense, const vector<bool>& wantedTeams,
+                             vector<unsigned int>& playNumbers) const
+{
+    const SegmentHeader* header = (const SegmentHeader*)_segment;
+    const PlayRun* runs = (const PlayRun*)(_segment + header->runOffset);
+    const unsigned int* runNumber = (const unsigned int*)(_segment + header->indexOffset);
+    const unsigned int* lastNumber;
+    if (onOffense) {
+        runNumber += entry.offenseStart;
+        lastNumber = runNumber + entry.offenseCount;
+    }
+    else {
+        runNumber += entry.defenseStart;
+        lastNumber = runNumber + entry.defenseCount;
+    }
+    // The teams are the same for every play of a run, so they are only checked once
+    for (; runNumber != lastNumber; runNumber++) {
+        const PlayRun& run = runs[*runNumber];
+        if (!wantedTeams[onOffense ? run.defense : run.offense])
+            continue;
+        unsigned int playNumber;
+        for (playNumber = run.firstPlay; playNumber < runs[*runNumber + 1].firstPlay; playNumber++)
+            playNumbers.push_back(playNumber);
+    } // Loop through runs
+}
+
+/* Inserts plays, given their numbers in load order, into a data store and builds its
+    indexes. Pass types of busted pass plays are assigned as though these were the only
+    plays wanted, so the result matches selecting the same teams with selectPlays() */
+void LeagueStore::insertPlays(const vector<unsigned int>& playNumbers, DataStore& dataStore) const
+{
+    if (_segment == NULL)
+        throw BaseException(__FILE__, __LINE__, "League store is not attached");
+    STATS_PHASE(season_load);
+    ALLOC_SCOPE(loader_memory);
+    insertSelected(playNumbers, dataStore);
+}
+
+// Returns the value of an attached play for a packed column, looking up codes in the dictionary
+inline short LeagueStore::unpackValue(PackedColumn column, unsigned int playNumber) const
+{
+    const ColumnEntry& entry = ((const SegmentHeader*)_segment)->columns[column];
+    unsigned int bits = LeagueColumns::unpackBits(_segment + entry.offset, entry.width, playNumber);
+    if (isCategoryColumn(column))
+        return (short)entry.dictionary[bits];
+    else
+        return (short)(entry.base + (int)bits);
+}
+
+/* Finds the play type of each wanted play. Busted pass plays are assigned their types
+    as though these were the only plays wanted */
+void LeagueStore::getPlayTypes(const vector<unsigned int>& wantedPlays, vector<unsigned char>& playTypes) const
+{
+    const SegmentHeader* header = (const SegmentHeader*)_segment;
+    const SeasonRun* season = (const SeasonRun*)(_segment + header->seasonOffset);
+    const SeasonRun* lastSeason = season + header->seasonCount;
+    const SeasonRun* playSeason = NULL; // Season of the last play
+    unsigned short sackCount = 0; // Number of busted pass plays this season
+    playTypes.resize(wantedPlays.size());
+    unsigned int playIndex;
+    for (playIndex = 0; playIndex < wantedPlays.size(); playIndex++) {
+        unsigned int playNumber = wantedPlays[playIndex];
+        // Plays are in load order, so their seasons only move forward
+        while ((season + 1 != lastSeason) && (season[1].firstPlay <= playNumber))
+            season++;
+        if (season != playSeason) {
+            playSeason = season;
+            sackCount = 0;
+        }
+        if (unpackValue(rotated_pass_column, playNumber)) {
+            playTypes[playIndex] = (unsigned char)PlayLoader::rotatedPassType(sackCount);
+            sackCount++;
+        }
+        else
+            playTypes[playIndex] = (unsigned char)unpackValue(play_type_column, playNumber);
+    } // Loop through wanted plays
+}
+
+// Inserts the wanted plays into a data store, assigning rotated pass types, and builds its indexes
+void LeagueStore::insertSelected(const vector<unsigned int>& wantedPlays, DataStore& dataStore) const
+{
+    vector<unsigned char> playTypes;
+    getPlayTypes(wantedPlays, playTypes);
+    // The categories are stored, so they go into the store without converting the situation again
+    dataStore.reserve(wantedPlays.size());
+    unsigned int playIndex;
+    for (playIndex = 0; playIndex < wantedPlays.size(); playIndex++) {
+        unsigned int playNumber = wantedPlays[playIndex];
+        dataStore.insertPlay((SinglePlay::PlayType)playTypes[playIndex], unpackValue(down_column, playNumber),
+                             (SinglePlay::DistanceNeeded)unpackValue(distance_needed_column, playNumber),
+                             (SinglePlay::FieldLocation)unpackValue(field_location_column, playNumber),
+                             (SinglePlay::TimeRemaining)unpackValue(time_remaining_column, playNumber),
+                             (SinglePlay::ScoreDifferential)unpackValue(score_differential_column, playNumber),
+                             unpackValue(distance_gained_column, playNumber),
+                             (unpackValue(turnover_column, playNumber) != 0));
+    }
+    STATS_COUNT(plays_kept, wantedPlays.size());
+    dataStore.buildIndexes();
+}
+
+// Returns the entry for a team in the attached segment, or NULL if it has none
+const LeagueStore::TeamEntry* LeagueStore::findEntry(const string& team) const
+{
+    if (_segment == NULL)
+        throw BaseException(__FILE__, __LINE__, "League store is not attached");
+    const SegmentHeader* header = (const SegmentHeader*)_segment;
+    const TeamEntry* teams = (const TeamEntry*)(_segment + header->teamOffset);
+    unsigned int teamIndex;
+    for (teamIndex = 0; teamIndex < header->teamCount; teamIndex++)
+        if (team == teams[teamIndex].code)
+            return teams + teamIndex;
+    return NULL;
+}
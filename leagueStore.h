@@ -0,0 +1,468 @@
+/* This file is part of NFLdecisionTree. It creates decision trees to classify
+    situations within NFL football games, and displays the plays historically
+    called in those situations given a set of opponents.
+
+    Copyright (C) 2013   Ezra Erb
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 3 as published
+    by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    I'd appreciate a note if you find this program useful or make
+    updates. Please contact me through LinkedIn (my profile also has
+    a link to the code depository)
+*/
+
+/* This class holds every down play of a range of seasons, for all teams, in a form
+    that can be shared between processes. The play files take far longer to parse than
+    anything else the program does, and several people running the program on the same
+    machine would otherwise each parse and hold their own copy of the same seasons.
+
+    One process loads the seasons and publishes them to a named segment, either a POSIX
+    shared memory object or an ordinary file. Later processes attach to it read only,
+    which maps the segment instead of copying it, so the plays exist once on the machine
+    no matter how many processes use them. Each process then selects the plays for its
+    own matchup into a normal data store, exactly as PlayLoader would have loaded them.
+
+    The segment holds no pointers, only offsets from its start, since it is mapped at a
+    different address in every process. Plays are kept in the order PlayLoader would load
+    them, compressed, since a whole league over many seasons is a lot of plays:
+    1. Consecutive plays with the same teams on offense and defense, usually a drive, form
+       a run. Teams are stored once per run, not once per play, and each team has lists of
+       its runs on offense and on defense. Selecting a matchup checks the teams of each run
+       of the teams involved, never touching plays of runs that aren't wanted.
+    2. Seasons are stored as runs as well, one per season.
+    3. The situation is stored as the category of each characteristic, which is all the
+       tree uses, not the raw down, distance, yard line, time and scores. Each category
+       column holds a dictionary of the categories found in it, and each play holds the code
+       of its category in the dictionary.
+    4. Every column is packed into as few bits as its codes or its range of values need.
+       Values are read straight from the packed bits.
+    Selecting a matchup gives the numbers of its plays in the segment. A tree is built
+    from them in place, counting plays straight from the packed columns (see LeagueColumns,
+    below), so the plays are never copied out of the segment. Selecting into a data store,
+    which sessions need, copies the categories into SinglePlay objects as they are.
+
+    Sacks and aborted snaps are assigned a pass type based on how many of them were
+    loaded before in the season (see PlayLoader::rotatedPassType). That depends on which
+    plays are wanted, so the segment flags them and selection assigns the type.
+
+    Segment names without a '/' are shared memory objects; anything else is a file path.
+    Publishing replaces an existing segment with the same name. Processes already attached
+    to the old one keep using it until they exit. */
+using std::string; // Header deliberately not included, clients should already have it
+using std::vector;
+
+class ColumnWriter; // Only used by reference here
+class LeagueColumns; // Ditto
+
+class LeagueStore {
+public:
+    // Creates an empty store
+    LeagueStore();
+
+    // Destructor. Unmaps any attached segment
+    ~LeagueStore();
+
+    /* Loads every down play for a range of seasons, [first...last], for publishing.
+        Replaces anything loaded or attached before */
+    void loadSeasons(PlayLoader& loader, unsigned short firstYear, unsigned short lastYear);
+
+    // Publishes the loaded plays to a named segment
+    void publish(const string& name) const;
+
+    // Attaches to a published segment, read only. Replaces anything loaded or attached before
+    void attach(const string& name);
+
+    /* Attaches to the loaded plays without publishing them, so only this process can select
+        from them. The loaded copy is released, so the plays are held once */
+    void attachLoaded();
+
+    /* Selects the plays for a matchup from the attached segment into a data store and
+        builds its indexes. The plays and their order are exactly what PlayLoader::loadPlays
+        would produce */
+    void selectPlays(const string& thisTeam, const string& otherTeam,
+                     const vector<string>& thisSimiliar, const vector<string>& otherSimiliar,
+                     DataStore& dataStore) const;
+
+    /* Same as above, adding the plays to a column writer instead, in the same order, so
+        they are never all held in memory. The writer is not finished */
+    void selectPlays(const string& thisTeam, const string& otherTeam,
+                     const vector<string>& thisSimiliar, const vector<string>& otherSimiliar,
+                     ColumnWriter& writer) const;
+
+    /* Same as above, selecting the plays to be read in place from the attached segment,
+        for building a tree without a data store. The segment must stay attached while the
+        columns are used */
+    void selectPlays(const string& thisTeam, const string& otherTeam,
+                     const vector<string>& thisSimiliar, const vector<string>& otherSimiliar,
+                     LeagueColumns& columns) const;
+
+    /* Selection a piece at a time, for callers that change the teams of a matchup and
+        reselect often. Plays are given by their numbers, which are in load order */
+
+    // Returns whether a team has any plays in the attached segment
+    bool hasTeam(const string& team) const;
+
+    /* Finds the numbers of every play with one team on offense and another on defense, in
+        load order, and adds them to the end of the list */
+    void findPairPlays(const string& offense, const string& defense, vector<unsigned int>& playNumbers) const;
+
+    /* Inserts plays, given their numbers in load order, into a data store and builds its
+        indexes. Pass types of busted pass plays are assigned as though these were the only
+        plays wanted, so the result matches selecting the same teams with selectPlays() */
+    void insertPlays(const vector<unsigned int>& playNumbers, DataStore& dataStore) const;
+
+    // Seasons held, as loaded or attached
+    unsigned short getFirstSeason() const;
+    unsigned short getLastSeason() const;
+
+    // Number of plays held
+    unsigned int getPlayCount() const;
+
+    // Number of bytes in the attached segment, zero if not attached
+    unsigned long long getSegmentSize() const;
+
+    /* Stamp of the attached segment, different every time plays are published or attached
+        from a load, so a segment replaced under the same name can be told apart. Zero if
+        not attached */
+    unsigned long long getGeneration() const;
+
+private:
+    /* Segment layout. WARNING: Increase SegmentVersion whenever any of these change, so
+        programs built with the old layout refuse to attach */
+    static const unsigned int SegmentVersion = 4;
+
+    /* Values of a play stored as packed columns in the segment. The category columns come
+        first, in the order of SinglePlay::PlayCharacteristic */
+    enum PackedColumn { down_column, distance_needed_column, field_location_column, time_remaining_column,
+                        score_differential_column, distance_gained_column, play_type_column,
+                        turnover_column, rotated_pass_column, column_count };
+
+    // Number of categories a dictionary can hold, enough for any characteristic
+    static const unsigned int DictionarySize = 8;
+
+    // A single play, as loaded. The situation is already converted to categories
+    struct StoredPlay {
+        unsigned short season;
+        unsigned char categories[SinglePlay::score_differential + 1];
+        short distanceGained;
+        unsigned char offense; // Team numbers
+        unsigned char defense;
+        unsigned char playType;
+        unsigned char turnedOver;
+        unsigned char rotatedPass; // Busted pass plays, whose type is assigned when selected
+    };
+
+    /* Consecutive plays with the same teams. Runs are followed by one extra run starting
+        at the play count, so every run ends where the next starts */
+    struct PlayRun {
+        unsigned int firstPlay;
+        unsigned char offense; // Team numbers
+        unsigned char defense;
+    };
+
+    // Consecutive plays of one season. Seasons are stored the same way as play runs
+    struct SeasonRun {
+        unsigned int firstPlay;
+        unsigned int season;
+    };
+
+    /* A packed column. Value N is the width bits starting at bit N * width. For category
+        columns that is a code, and the category is the dictionary entry for it; for the others
+        the value is the bits plus the base. A column of one value has a width of zero */
+    struct ColumnEntry {
+        unsigned long long offset; // From the start of the segment
+        short base;
+        unsigned short width;
+        unsigned char dictionary[DictionarySize];
+    };
+
+    /* Runs for one team. The index array holds run numbers in increasing order, for
+        all teams on offense followed by all teams on defense */
+    struct TeamEntry {
+        char code[8];
+        unsigned int offenseStart;
+        unsigned int offenseCount;
+        unsigned int defenseStart;
+        unsigned int defenseCount;
+    };
+
+    struct SegmentHeader {
+        char magic[8]; // Written last, so a partly written segment can't be attached
+        unsigned int version;
+        unsigned int playCount;
+        unsigned int teamCount;
+        unsigned int runCount; // Without the extra run at the end
+        unsigned int seasonCount;
+        unsigned short firstSeason;
+        unsigned short lastSeason;
+        unsigned long long teamOffset; // Offsets from the start of the segment
+        unsigned long long runOffset;
+        unsigned long long seasonOffset;
+        unsigned long long indexOffset;
+        ColumnEntry columns[column_count];
+        unsigned long long segmentSize;
+        unsigned long long generation; // Set when published, see getGeneration()
+    };
+
+    // Everything needed to write a segment for the loaded plays, except the play values
+    struct SegmentLayout {
+        SegmentHeader header;
+        vector<TeamEntry> teamEntries;
+        vector<PlayRun> playRuns;
+        vector<SeasonRun> seasonRuns;
+        vector<unsigned int> runNumbers;
+    };
+
+    // Loaded plays, before publication
+    vector<StoredPlay> _plays;
+    vector<string> _teams;
+    unsigned short _firstSeason;
+    unsigned short _lastSeason;
+
+    // Attached segment, if any. NULL otherwise
+    const char* _segment;
+    unsigned long long _segmentSize;
+
+    // Returns the team number for a team code, adding it if needed
+    unsigned char findTeam(const string& team);
+
+    // Returns the entry for a team in the attached segment, or NULL if it has none
+    const TeamEntry* findEntry(const string& team) const;
+
+    /* Lays out the loaded plays as a segment. The runs, team entries and run numbers for
+        each team are built as well */
+    void layoutSegment(SegmentLayout& layout) const;
+
+    // Packs the loaded plays into memory laid out by layoutSegment(), magic last
+    void writeSegment(char* segment, const SegmentLayout& layout) const;
+
+    // Returns whether a packed column holds category codes
+    static bool isCategoryColumn(PackedColumn column);
+
+    // Returns the value of a loaded play for a packed column
+    static short getColumnValue(const StoredPlay& play, PackedColumn column);
+
+    // Returns the value of an attached play for a packed column, looking up codes in the dictionary
+    short unpackValue(PackedColumn column, unsigned int playNumber) const;
+
+    /* Adds the numbers of the plays of every run listed for a team whose other team is
+        wanted, in load order. The list is the team's offense runs when the other team is
+        the defense, and its defense runs otherwise */
+    void selectRuns(const TeamEntry& entry, bool onOffense, const vector<bool>& wantedTeams,
+                    vector<unsigned int>& playNumbers) const;
+
+    // Finds the numbers of the plays for a matchup, in load order, as selectPlays() wants them
+    void findMatchupPlays(const string& thisTeam, const string& otherTeam,
+                          const vector<string>& thisSimiliar, const vector<string>& otherSimiliar,
+                          vector<unsigned int>& wantedPlays) const;
+
+    /* Finds the play type of each wanted play. Busted pass plays are assigned their types
+        as though these were the only plays wanted */
+    void getPlayTypes(const vector<unsigned int>& wantedPlays, vector<unsigned char>& playTypes) const;
+
+    // Inserts the wanted plays into a data store, assigning rotated pass types, and builds its indexes
+    void insertSelected(const vector<unsigned int>& wantedPlays, DataStore& dataStore) const;
+
+    // Loads every down play for one season
+    void loadSingleSeason(PlayLoader& loader, unsigned short seasonYear);
+
+    // Releases anything loaded or attached
+    void clear();
+
+    // Prohibit copying, which would unmap the segment twice
+    LeagueStore(const LeagueStore& other);
+    LeagueStore& operator=(const LeagueStore& other);
+};
+
+// Seasons held, as loaded or attached
+inline unsigned short LeagueStore::getFirstSeason() const
+{
+    return _firstSeason;
+}
+
+inline unsigned short LeagueStore::getLastSeason() const
+{
+    return _lastSeason;
+}
+
+// Number of bytes in the attached segment, zero if not attached
+inline unsigned long long LeagueStore::getSegmentSize() const
+{
+    return _segmentSize;
+}
+
+// Returns whether a packed column holds category codes
+inline bool LeagueStore::isCategoryColumn(PackedColumn column)
+{
+    return (column <= score_differential_column);
+}
+
+/* This class holds the plays of a matchup selected from an attached league store, for
+    building the decision tree straight from the segment (see DecisionNode). It offers
+    the same columns as a column store, so the same tree builder reads both. Rows are the
+    positions of the plays in the selection, in load order, which is the order a data store
+    would hold them. Each column reads the packed bits of the segment for the play at a row,
+    translating category codes through the dictionary of the column. Only the play types
+    are held here, since the types of busted pass plays depend on which plays are selected */
+class LeagueColumns {
+public:
+    // Reads the category of each play from a dictionary coded column
+    class CategoryColumn {
+    public:
+        CategoryColumn();
+        unsigned char operator[](unsigned int row) const;
+    private:
+        friend class LeagueStore;
+        const char* _bits;
+        const unsigned char* _dictionary;
+        const unsigned int* _playNumbers;
+        unsigned short _width;
+    };
+
+    // Reads a value of each play from a packed column
+    class ValueColumn {
+    public:
+        ValueColumn();
+        short operator[](unsigned int row) const;
+    private:
+        friend class LeagueStore;
+        const char* _bits;
+        const unsigned int* _playNumbers;
+        short _base;
+        unsigned short _width;
+    };
+
+    // Column types, as a column store has them
+    typedef const unsigned char* PlayTypeColumn;
+    typedef ValueColumn DistanceColumn;
+    typedef ValueColumn TurnoverColumn;
+
+    // Creates an empty selection
+    LeagueColumns();
+
+    // Use the default destructor
+
+    // Number of plays selected
+    unsigned int getPlayCount() const;
+
+    // Category of every play for a characteristic
+    CategoryColumn getCategories(SinglePlay::PlayCharacteristic characteristic) const;
+
+    // Column of play types
+    PlayTypeColumn getPlayTypes() const;
+
+    // Column of distances gained
+    DistanceColumn getDistances() const;
+
+    // Column of flags for plays that turned over, one for turnovers and zero otherwise
+    TurnoverColumn getTurnovers() const;
+
+    // Summary data of all of the plays selected
+    void getSummaryData(OverallSummaryData& summaryData) const;
+
+private:
+    // The league store fills in the selection
+    friend class LeagueStore;
+
+    vector<unsigned int> _playNumbers; // In the segment, for each row
+    vector<unsigned char> _playTypes;
+    CategoryColumn _categories[SinglePlay::score_differential + 1];
+    ValueColumn _distances;
+    ValueColumn _turnovers;
+    OverallSummaryData _summaryData;
+
+    /* Returns the bits of value N of a packed column. The eight bytes holding the start of
+        the value are loaded and shifted down. Values are at most 16 bits, so they never run
+        past them */
+    static unsigned int unpackBits(const char* bits, unsigned short width, unsigned int index);
+
+    // Prohibit copying, since the columns point into the list of play numbers
+    LeagueColumns(const LeagueColumns& other);
+    LeagueColumns& operator=(const LeagueColumns& other);
+};
+
+/* Returns the bits of value N of a packed column. The eight bytes holding the start of
+    the value are loaded and shifted down. Values are at most 16 bits, so they never run
+    past them */
+inline unsigned int LeagueColumns::unpackBits(const char* bits, unsigned short width, unsigned int index)
+{
+    unsigned long long bitPosition = (unsigned long long)index * width;
+    unsigned long long value;
+    memcpy(&value, bits + (bitPosition >> 3), sizeof(value));
+    return (unsigned int)((value >> (bitPosition & 7)) & ((1ULL << width) - 1));
+}
+
+inline LeagueColumns::CategoryColumn::CategoryColumn()
+    : _bits(NULL), _dictionary(NULL), _playNumbers(NULL), _width(0)
+{
+    // All in the initialization list
+}
+
+inline unsigned char LeagueColumns::CategoryColumn::operator[](unsigned int row) const
+{
+    return _dictionary[unpackBits(_bits, _width, _playNumbers[row])];
+}
+
+inline LeagueColumns::ValueColumn::ValueColumn()
+    : _bits(NULL), _playNumbers(NULL), _base(0), _width(0)
+{
+    // All in the initialization list
+}
+
+inline short LeagueColumns::ValueColumn::operator[](unsigned int row) const
+{
+    return (short)(_base + (int)unpackBits(_bits, _width, _playNumbers[row]));
+}
+
+// Creates an empty selection
+inline LeagueColumns::LeagueColumns()
+    : _playNumbers(), _playTypes(), _distances(), _turnovers(), _summaryData()
+{
+    // All in the initialization list
+}
+
+// Number of plays selected
+inline unsigned int LeagueColumns::getPlayCount() const
+{
+    return (unsigned int)_playNumbers.size();
+}
+
+// Category of every play for a characteristic
+inline LeagueColumns::CategoryColumn LeagueColumns::getCategories(SinglePlay::PlayCharacteristic characteristic) const
+{
+    return _categories[characteristic];
+}
+
+// Column of play types
+inline LeagueColumns::PlayTypeColumn LeagueColumns::getPlayTypes() const
+{
+    return _playTypes.empty() ? NULL : &_playTypes[0];
+}
+
+// Column of distances gained
+inline LeagueColumns::DistanceColumn LeagueColumns::getDistances() const
+{
+    return _distances;
+}
+
+// Column of flags for plays that turned over, one for turnovers and zero otherwise
+inline LeagueColumns::TurnoverColumn LeagueColumns::getTurnovers() const
+{
+    return _turnovers;
+}
+
+// Summary data of all of the plays selected
+inline void LeagueColumns::getSummaryData(OverallSummaryData& summaryData) const
+{
+    summaryData = _summaryData;
+}
@@ -25,36 +25,327 @@
 #include <vector>
 #include <string>
 #include <fstream>
+#include <cstdlib>
+#include <chrono>
+#include <sstream>
+#include <cstring>
 #include"baseException.h"
 #include"singlePlay.h"
 #include"playIndexSet.h"
 #include"playStats.h"
+#include"allocTracker.h"
 #include"dataStore.h"
 #include"playLoader.h"
+#include"leagueStore.h"
+#include"analysisSession.h"
+#include"columnStore.h"
+#include"playHistogram.h"
 #include"decisionNode.h"
+#include"resultWriter.h"
+#include"treeExporter.h"
+#include"treeCache.h"
+#include"precomputer.h"
+#include"runStats.h"
+#include"parallelSettings.h"
+#include"traceLog.h"
 
 using std::cout;
+using std::cin;
 using std::endl;
 using std::vector;
 using std::string;
 using std::ofstream;
+using std::stringstream;
+
+// Directory holding the play data files, relative to the directory the program runs in
+#ifdef _WIN32
+static const char* DefaultDataDirectory = "..\\Data";
+#else
+static const char* DefaultDataDirectory = "../Data";
+#endif
+
+// Owns a tree built on the heap, so it is deleted when the owner goes out of scope
+class TreeOwner {
+public:
+    explicit TreeOwner(DecisionNode* tree) : _tree(tree) {}
+    ~TreeOwner() { delete _tree; }
+private:
+    DecisionNode* _tree;
+
+    // Prohibit copying, which would delete the tree twice
+    TreeOwner(const TreeOwner& other);
+    TreeOwner& operator=(const TreeOwner& other);
+};
+
+/* Builds and prunes the tree for the plays of a session and writes it to result.txt.
+    Reports how long it took, since turnaround is what matters in a session */
+static void writeSessionTree(const AnalysisSession& session)
+{
+    // A tree needs plays, but the session can carry on until teams with some are added
+    if (session.getPlayCount() == 0) {
+        cout << "No plays for these teams, result.txt not changed" << endl;
+        return;
+    }
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    DataStore data;
+    session.selectPlays(data);
+    PlayIndexSet dataView(data.getIndexes());
+    DecisionNode* treeNode = new DecisionNode(dataView, data.getPlaySummaryStats());
+    TreeOwner treeOwner(treeNode);
+    treeNode->pruneTree();
+    ofstream resultFile("result.txt");
+    if (!resultFile.is_open())
+        throw BaseException(__FILE__, __LINE__, "Could not create result.txt");
+    ResultWriter::write(resultFile, session.getThisTeam(), session.getOtherTeam(), session.getThisSimiliar(),
+                        session.getOtherSimiliar(), *treeNode);
+    resultFile.close();
+    double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    cout << session.getPlayCount() << " plays, tree written to result.txt in " << elapsed << " ms" << endl;
+}
+
+// Names of play types for --yardage, in the order of SinglePlay::PlayType
+static const char* YardagePlayTypeNames[] = { "run-left", "run-middle", "run-right",
+                                              "short-right", "short-middle", "short-left",
+                                              "deep-right", "deep-middle", "deep-left",
+                                              "field-goal", "punt" };
+
+/* Returns the play type named for --yardage, PlayHistogram::all_play_types for "all",
+    or PlayHistogram::no_distances if the name is not known */
+static short getYardagePlayType(const string& typeName)
+{
+    if (typeName == string("all"))
+        return PlayHistogram::all_play_types;
+    for (unsigned short playType = 0; playType < SinglePlay::getPlayTypeCount(); playType++)
+        if (typeName == string(YardagePlayTypeNames[playType]))
+            return (short)playType;
+    return PlayHistogram::no_distances;
+}
+
+// Lists the teams of a session
+static void listSessionTeams(const AnalysisSession& session)
+{
+    cout << session.getThisTeam() << " vs " << session.getOtherTeam() << ". Similiar to us:";
+    vector<string>::const_iterator team;
+    for (team = session.getThisSimiliar().begin(); team != session.getThisSimiliar().end(); team++)
+        cout << " " << *team;
+    cout << ". Similiar to opponent:";
+    for (team = session.getOtherSimiliar().begin(); team != session.getOtherSimiliar().end(); team++)
+        cout << " " << *team;
+    cout << endl;
+}
+
+/* Runs an interactive session. Commands are read from standard input, and the tree is
+    rewritten after every change to the teams */
+static void runSession(AnalysisSession& session)
+{
+    cout << "Commands: +u TEAM, -u TEAM (similiar to us), +o TEAM, -o TEAM (similiar to opponent), teams, quit" << endl;
+    listSessionTeams(session);
+    writeSessionTree(session);
+    string command;
+    while (cin >> command) {
+        if ((command == string("quit")) || (command == string("exit")))
+            break;
+        else if (command == string("teams"))
+            listSessionTeams(session);
+        else if ((command == string("+u")) || (command == string("-u")) ||
+                 (command == string("+o")) || (command == string("-o"))) {
+            string team;
+            if (!(cin >> team))
+                break;
+            AnalysisSession::SimiliarSide side = (command[1] == 'u') ? AnalysisSession::similiar_to_us
+                                                                     : AnalysisSession::similiar_to_opponent;
+            bool changed;
+            if (command[0] == '+')
+                changed = session.addSimiliar(side, team);
+            else
+                changed = session.removeSimiliar(side, team);
+            if (changed)
+                writeSessionTree(session);
+            else if (command[0] == '+')
+                cout << team << " is already on the list or has no plays" << endl;
+            else
+                cout << team << " is not on the list" << endl;
+        } // Changing teams
+        else
+            cout << "Unknown command " << command << endl;
+    } // Loop through commands
+}
 
 int main(int argc, char **argv)
 {
     ofstream resultFile;
     try {
-        PlayLoader loader("..\\Data");
+        /* Options start with '--' and can appear anywhere. Strip them out first, so the
+            team arguments below are processed exactly as they always have been */
+        vector<string> args;
+        string dataDirectory(DefaultDataDirectory);
+        unsigned short firstSeason = 0; // Zero means use the loader's default seasons
+        unsigned short lastSeason = 0;
+        bool validOptions = true;
+        bool wantStats = false;
+#ifdef NFL_RUN_STATS
+        bool statsJson = false;
+#endif
+        bool wantMemory = false;
+#ifdef NFL_ALLOC_TRACKING
+        bool memoryJson = false;
+#endif
+        string traceFileName;
+        string publishName;
+        string attachName;
+        string writeColumnsName;
+        string columnsName;
+        bool sessionMode = false;
+        string scheduleName;
+        string presetName;
+        string cacheName;
+        string exportName;
+        unsigned short cpuPercent = 25;
+        int optionIndex;
+        for (optionIndex = 0; optionIndex < argc; optionIndex++) {
+            string option(argv[optionIndex]);
+            if ((optionIndex == 0) || (option.compare(0, 2, string("--")) != 0))
+                args.push_back(option);
+            else if ((option == string("--data")) && (optionIndex + 1 < argc)) {
+                optionIndex++;
+                dataDirectory = argv[optionIndex];
+            }
+            else if ((option == string("--seasons")) && (optionIndex + 2 < argc)) {
+                firstSeason = (unsigned short)atoi(argv[optionIndex + 1]);
+                lastSeason = (unsigned short)atoi(argv[optionIndex + 2]);
+                optionIndex += 2;
+                if ((firstSeason == 0) || (firstSeason > lastSeason))
+                    validOptions = false;
+            }
+            else if ((option == string("--threads")) && (optionIndex + 1 < argc)) {
+                optionIndex++;
+                ParallelSettings::setWorkerCount((unsigned short)atoi(argv[optionIndex]));
+            }
+            else if ((option == string("--trace")) && (optionIndex + 1 < argc)) {
+                optionIndex++;
+                traceFileName = argv[optionIndex];
+            }
+            else if ((option == string("--publish")) && (optionIndex + 1 < argc)) {
+                optionIndex++;
+                publishName = argv[optionIndex];
+            }
+            else if ((option == string("--attach")) && (optionIndex + 1 < argc)) {
+                optionIndex++;
+                attachName = argv[optionIndex];
+            }
+            else if ((option == string("--write-columns")) && (optionIndex + 1 < argc)) {
+                optionIndex++;
+                writeColumnsName = argv[optionIndex];
+            }
+            else if ((option == string("--columns")) && (optionIndex + 1 < argc)) {
+                optionIndex++;
+                columnsName = argv[optionIndex];
+            }
+            else if ((option == string("--schedule")) && (optionIndex + 1 < argc)) {
+                optionIndex++;
+                scheduleName = argv[optionIndex];
+            }
+            else if ((option == string("--presets")) && (optionIndex + 1 < argc)) {
+                optionIndex++;
+                presetName = argv[optionIndex];
+            }
+            else if ((option == string("--cache")) && (optionIndex + 1 < argc)) {
+                optionIndex++;
+                cacheName = argv[optionIndex];
+            }
+            else if ((option == string("--export")) && (optionIndex + 1 < argc)) {
+                optionIndex++;
+                exportName = argv[optionIndex];
+            }
+            else if ((option == string("--cpu-percent")) && (optionIndex + 1 < argc)) {
+                optionIndex++;
+                cpuPercent = (unsigned short)atoi(argv[optionIndex]);
+                if ((cpuPercent == 0) || (cpuPercent > 100))
+                    validOptions = false;
+            }
+            else if (option == string("--session"))
+                sessionMode = true;
+            else if (option == string("--binary-splits"))
+                DecisionNode::setSplitMode(DecisionNode::binary_split);
+            else if (option == string("--sampled-splits"))
+                DecisionNode::setSplitSelection(DecisionNode::sampled_selection);
+            else if ((option == string("--criterion")) && (optionIndex + 1 < argc)) {
+                optionIndex++;
+                string criterionName(argv[optionIndex]);
+                if (criterionName == string("entropy"))
+                    DecisionNode::setSplitCriterion(DecisionNode::entropy_criterion);
+                else if (criterionName == string("gini"))
+                    DecisionNode::setSplitCriterion(DecisionNode::gini_criterion);
+                else if (criterionName == string("gain-ratio"))
+                    DecisionNode::setSplitCriterion(DecisionNode::gain_ratio_criterion);
+                else
+                    validOptions = false;
+            }
+            else if ((option == string("--yardage")) && (optionIndex + 1 < argc)) {
+                optionIndex++;
+                short yardagePlayType = getYardagePlayType(string(argv[optionIndex]));
+                if (yardagePlayType == PlayHistogram::no_distances)
+                    validOptions = false;
+                else
+                    DecisionNode::setSplitTarget(DecisionNode::yardage_target, yardagePlayType);
+            }
+            else if ((option == string("--stats")) || (option == string("--stats-json"))) {
+                wantStats = true;
+#ifdef NFL_RUN_STATS
+                statsJson = (option == string("--stats-json"));
+#endif
+            }
+            else if ((option == string("--memory")) || (option == string("--memory-json"))) {
+                wantMemory = true;
+#ifdef NFL_ALLOC_TRACKING
+                memoryJson = (option == string("--memory-json"));
+#endif
+            }
+            else
+                validOptions = false;
+        } // Loop through arguments
+#ifndef NFL_RUN_STATS
+        if (wantStats)
+            cout << "Statistics not available, rebuild with NFL_RUN_STATS defined" << endl;
+#endif
+#ifndef NFL_ALLOC_TRACKING
+        if (wantMemory)
+            cout << "Memory tracking not available, rebuild with NFL_ALLOC_TRACKING defined" << endl;
+#endif
+#ifdef NFL_TRACE
+        if (!traceFileName.empty())
+            TraceLog::enable();
+#else
+        if (!traceFileName.empty())
+            cout << "Tracing not available, rebuild with NFL_TRACE defined" << endl;
+#endif
+
+        PlayLoader loader(dataDirectory);
         DataStore data;
 
         /* Extract the teams from the input. Order is given below */
         bool validInput = false;
         bool usSimiliar = false;
-        if (argc == 3)
+        if (args.size() == 3)
             validInput = true;
-        else if (argc >= 5) {
+        else if ((args.size() == 1) && (!publishName.empty()))
+            validInput = true; // Only publishing a league store
+        else if ((args.size() == 1) && (!columnsName.empty()))
+            validInput = true; // Teams come from the column file
+        else if ((args.size() == 1) && (!scheduleName.empty()))
+            validInput = true; // Teams come from the schedule
+        // A column file already holds its plays, so nothing else can select them
+        if ((!columnsName.empty()) && ((args.size() != 1) || (!publishName.empty()) || (!attachName.empty()) ||
+                                       (!writeColumnsName.empty()) || firstSeason))
+            validOptions = false;
+        // Trees from column files always count their splits
+        if (((!columnsName.empty()) || (!writeColumnsName.empty())) &&
+            (DecisionNode::getSplitSelection() == DecisionNode::sampled_selection))
+            validOptions = false;
+        else if (args.size() >= 5) {
             /* Third argument must be either -u for teams similiar to us or
                 -o for teams similiar to opponent */
-            string flag(argv[3]); // Argv[0] contains the program name
+            string flag(args[3]); // Args[0] contains the program name
             if (flag == string("-u")) {
                 validInput = true;
                 usSimiliar = true;
@@ -62,21 +353,66 @@ int main(int argc, char **argv)
             else if (flag == string("-o"))
                 validInput = true;
         } // Four or more arguments
+        // A session needs a matchup, and rewrites the tree after every change
+        if (sessionMode && ((args.size() < 3) || (!writeColumnsName.empty())))
+            validOptions = false;
+        // Precomputing fills the cache for every upcoming matchup, and only that
+        if ((!scheduleName.empty()) && ((args.size() != 1) || cacheName.empty() || sessionMode ||
+                                        (!columnsName.empty()) || (!writeColumnsName.empty())))
+            validOptions = false;
+        if ((!presetName.empty()) && scheduleName.empty())
+            validOptions = false;
+        // Exporting needs a tree built by this run
+        if ((!exportName.empty()) && (sessionMode || (!scheduleName.empty())))
+            validOptions = false;
+        // Column files aren't cached, since they are usually built for plays that change
+        if ((!cacheName.empty()) && ((!columnsName.empty()) || sessionMode))
+            validOptions = false;
 
-        if (!validInput) {
+        if ((!validInput) || (!validOptions)) {
             cout << "Invalid arguments. US OPPONENT [-u] [SIMILIAR US TEAMS] [-o] [SIMILIAR OTHER TEAMS]" << endl;
+            cout << "Options: [--data DIRECTORY] [--seasons FIRST LAST] [--threads COUNT] [--trace FILE] [--publish NAME] [--attach NAME] [--write-columns FILE] [--columns FILE] [--session] [--schedule FILE] [--presets FILE] [--cache DIRECTORY] [--export FILE] [--cpu-percent PERCENT] [--binary-splits] [--sampled-splits] [--criterion NAME] [--yardage TYPE] [--stats] [--stats-json] [--memory] [--memory-json]" << endl;
             exit(1);
         } // Invalid input
 
-        string thisTeam(argv[1]);
-        string otherTeam(argv[2]);
+        // Precomputing runs alongside interactive work, so it steps aside from the start
+        if (!scheduleName.empty())
+            Precomputer::lowerPriority();
+
+        /* Publishing loads every play of the seasons and attaches to the result, so this
+            process selects its plays the same way as any later one */
+        LeagueStore league;
+        if (!publishName.empty()) {
+            if (!firstSeason)
+                PlayLoader::getRecentSeasons(3, firstSeason, lastSeason);
+            league.loadSeasons(loader, firstSeason, lastSeason);
+            league.publish(publishName);
+            if (args.size() == 1) {
+                cout << "Published " << league.getPlayCount() << " plays from seasons " << firstSeason
+                     << " to " << lastSeason << " as " << publishName << endl;
+                return 0;
+            }
+            attachName = publishName;
+        } // Publishing a league store
+        if (!attachName.empty()) {
+            league.attach(attachName);
+            if (firstSeason && ((firstSeason != league.getFirstSeason()) || (lastSeason != league.getLastSeason())))
+                throw BaseException(__FILE__, __LINE__, "Seasons requested do not match the league store");
+        } // Using a league store
+
+        string thisTeam;
+        string otherTeam;
         vector <string> thisSimiliar;
         vector <string> otherSimiliar;
+        if (args.size() >= 3) {
+            thisTeam = args[1];
+            otherTeam = args[2];
+        }
 
-        if (argc >= 5) {
-            int argIndex;
-            for (argIndex = 4; argIndex < argc; argIndex++) {
-                string newTeam(argv[argIndex]);
+        if (args.size() >= 5) {
+            unsigned int argIndex;
+            for (argIndex = 4; argIndex < args.size(); argIndex++) {
+                string newTeam(args[argIndex]);
                 if (usSimiliar) {
                     if (newTeam == string("-o"))
                         usSimiliar = false;
@@ -92,33 +428,172 @@ int main(int argc, char **argv)
             } // Loop through arguments
         } // More than two teams specified
 
-        loader.loadPlays(thisTeam, otherTeam, thisSimiliar, otherSimiliar, 3, data);
-        PlayIndexSet dataView(data.getIndexes());
-        DecisionNode tree(dataView, data.getPlaySummaryStats());
+        /* A session keeps the league data for the whole run. Without a published store,
+            it loads every play of the seasons for its own use */
+        if (sessionMode) {
+            if (attachName.empty()) {
+                if (!firstSeason)
+                    PlayLoader::getRecentSeasons(3, firstSeason, lastSeason);
+                league.loadSeasons(loader, firstSeason, lastSeason);
+                league.attachLoaded();
+            }
+            AnalysisSession session(league, thisTeam, otherTeam, thisSimiliar, otherSimiliar);
+            runSession(session);
+            return 0;
+        } // Interactive session
+
+        // Precomputing builds many matchups, so it loads every play once like a session
+        if (!scheduleName.empty()) {
+            // The files are checked before loading, so any replaced during the load are built again later
+            string dataSource;
+            if (attachName.empty()) {
+                if (!firstSeason)
+                    PlayLoader::getRecentSeasons(3, firstSeason, lastSeason);
+                dataSource = TreeCache::getDirectorySource(dataDirectory, firstSeason, lastSeason);
+                league.loadSeasons(loader, firstSeason, lastSeason);
+                league.attachLoaded();
+            }
+            else
+                dataSource = TreeCache::getLeagueSource(attachName, league);
+            TreeCache cache(cacheName);
+            Precomputer precomputer(league, cache, dataSource);
+            if (!presetName.empty())
+                precomputer.readPresets(presetName);
+            precomputer.readSchedule(scheduleName, Precomputer::getToday());
+            unsigned int builtCount = precomputer.run(cpuPercent, cout);
+            cout << "Cached " << builtCount << " of " << precomputer.getMatchupCount() << " upcoming matchups" << endl;
+            return 0;
+        } // Precomputing
+
+        /* A cached result for exactly this run is copied to the result file instead of
+            building the tree again */
+        string cacheKey;
+        if (!cacheName.empty()) {
+            unsigned short keyFirstSeason = firstSeason;
+            unsigned short keyLastSeason = lastSeason;
+            string dataSource;
+            if (!attachName.empty()) {
+                keyFirstSeason = league.getFirstSeason();
+                keyLastSeason = league.getLastSeason();
+                dataSource = TreeCache::getLeagueSource(attachName, league);
+            }
+            else {
+                if (!keyFirstSeason)
+                    PlayLoader::getRecentSeasons(3, keyFirstSeason, keyLastSeason);
+                dataSource = TreeCache::getDirectorySource(dataDirectory, keyFirstSeason, keyLastSeason);
+            }
+            cacheKey = TreeCache::makeKey(thisTeam, otherTeam, thisSimiliar, otherSimiliar, keyFirstSeason,
+                                          keyLastSeason, dataSource);
+            // The cache only holds results, so an export always builds the tree
+            stringstream cachedResult;
+            if (exportName.empty() && TreeCache(cacheName).fetch(thisTeam, otherTeam, cacheKey, cachedResult)) {
+                resultFile.open("result.txt", std::ios::binary);
+                if (resultFile.is_open()) {
+                    resultFile << cachedResult.rdbuf();
+                    resultFile.close();
+                }
+                return 0;
+            }
+        } // Using a cache
+
+        /* Writing a column file streams the plays into it, from a league store or the play
+            files, and the tree is then built from the file. The plays are never all in memory */
+        if (!writeColumnsName.empty()) {
+            ColumnWriter writer(writeColumnsName, thisTeam, otherTeam, thisSimiliar, otherSimiliar);
+            if (!attachName.empty())
+                league.selectPlays(thisTeam, otherTeam, thisSimiliar, otherSimiliar, writer);
+            else {
+                if (!firstSeason)
+                    PlayLoader::getRecentSeasons(3, firstSeason, lastSeason);
+                writer.addSeasons(loader, firstSeason, lastSeason);
+            }
+            writer.finish();
+            columnsName = writeColumnsName;
+        } // Writing a column file
+
+        /* Plays come from a column file, a league store or the play files. The first
+            two build the tree straight from the file or segment, without a data store,
+            except that sampled splits need the order of a data store */
+        ColumnStore columns;
+        LeagueColumns leagueColumns;
+        OverallSummaryData columnSummaryData;
+        bool useLeagueColumns = ((!attachName.empty()) &&
+                                 (DecisionNode::getSplitSelection() != DecisionNode::sampled_selection));
+        if (!columnsName.empty()) {
+            columns.open(columnsName);
+            columns.getTeams(thisTeam, otherTeam, thisSimiliar, otherSimiliar);
+            columns.getSummaryData(columnSummaryData);
+        }
+        else if (useLeagueColumns) {
+            league.selectPlays(thisTeam, otherTeam, thisSimiliar, otherSimiliar, leagueColumns);
+            leagueColumns.getSummaryData(columnSummaryData);
+        }
+        else if (!attachName.empty())
+            league.selectPlays(thisTeam, otherTeam, thisSimiliar, otherSimiliar, data);
+        else if (firstSeason)
+            loader.loadPlays(thisTeam, otherTeam, thisSimiliar, otherSimiliar, firstSeason, lastSeason, data);
+        else
+            loader.loadPlays(thisTeam, otherTeam, thisSimiliar, otherSimiliar, 3, data);
+
+        STATS_TIMER(pipelineTimer, tree_build);
+        TRACE_BEGIN("tree_build");
+        DecisionNode* treeNode;
+        if (!columnsName.empty())
+            treeNode = new DecisionNode(columns, columnSummaryData);
+        else if (useLeagueColumns)
+            treeNode = new DecisionNode(leagueColumns, columnSummaryData);
+        else {
+            PlayIndexSet dataView(data.getIndexes());
+            treeNode = new DecisionNode(dataView, data.getPlaySummaryStats());
+        }
+        // Deleted at the end of the block, even on an exception
+        TreeOwner treeOwner(treeNode);
+        DecisionNode& tree = *treeNode;
+        TRACE_END("tree_build");
+        STATS_SWITCH(pipelineTimer, prune);
+        TRACE_BEGIN("prune");
         tree.pruneTree();
+        TRACE_END("prune");
 
         // Output the final decision tree
+        STATS_SWITCH(pipelineTimer, output);
+        TRACE_BEGIN("output");
         resultFile.open("result.txt");
         if (resultFile.is_open()) {
-            // Generate header
-            resultFile << "Us:" << thisTeam << " Opponent: " << otherTeam << " ";
-            if (!thisSimiliar.empty()) {
-                resultFile << "Similiar to Us:";
-                vector<string>::iterator index;
-                for (index = thisSimiliar.begin(); index != thisSimiliar.end(); index++)
-                    resultFile << *index << " ";
-            }
-            if (!otherSimiliar.empty()) {
-                resultFile << "Similiar to Other:";
-                vector<string>::iterator index;
-                for (index = otherSimiliar.begin(); index != otherSimiliar.end(); index++)
-                    resultFile << *index << " ";
-            }
-            resultFile << endl;
-
-            resultFile << tree << endl;
+            ResultWriter::write(resultFile, thisTeam, otherTeam, thisSimiliar, otherSimiliar, tree);
             resultFile.close();
         }
+        if (!cacheName.empty()) {
+            stringstream result;
+            ResultWriter::write(result, thisTeam, otherTeam, thisSimiliar, otherSimiliar, tree);
+            TreeCache(cacheName).store(thisTeam, otherTeam, cacheKey, result.str());
+        }
+        if (!exportName.empty()) {
+            ofstream exportFile(exportName.c_str());
+            if (!exportFile.is_open())
+                throw BaseException(__FILE__, __LINE__, "Could not create export file");
+            TreeExporter::write(exportFile, TreeExporter::getNamespaceName(thisTeam, otherTeam), thisTeam,
+                                otherTeam, thisSimiliar, otherSimiliar, tree);
+        }
+        TRACE_END("output");
+        STATS_STOP(pipelineTimer);
+#ifdef NFL_RUN_STATS
+        if (wantStats)
+            RunStats::report(cout, statsJson ? RunStats::json_format : RunStats::table_format);
+#endif
+#ifdef NFL_ALLOC_TRACKING
+        // Reported while the tree still exists, so live memory shows what a finished run holds
+        if (wantMemory)
+            AllocTracker::report(cout, memoryJson ? AllocTracker::json_format : AllocTracker::table_format);
+#endif
+#ifdef NFL_TRACE
+        if (!traceFileName.empty()) {
+            ofstream traceFile(traceFileName.c_str());
+            if (!traceFile.is_open())
+                throw BaseException(__FILE__, __LINE__, "Could not create trace file");
+            TraceLog::write(traceFile);
+        }
+#endif
     } // Try block
     catch (exception& e) { // Catch by reference so virtual methods work properly
         cout << "Exception: " << e.what() << " thrown" << endl;
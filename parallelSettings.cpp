@@ -0,0 +1,46 @@
+/* This file is part of NFLdecisionTree. It creates decision trees to classify
+    situations within NFL football games, and displays the plays historically
+    called in those situations given a set of opponents.
+
+    Copyright (C) 2013   Ezra Erb
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 3 as published
+    by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    I'd appreciate a note if you find this program useful or make
+    updates. Please contact me through LinkedIn (my profile also has
+    a link to the code depository)
+*/
+#include<thread>
+#include"parallelSettings.h"
+
+// Current setting. Only written before work starts, so it needs no protection
+static unsigned short WorkerCount = 1;
+
+// Number of worker threads to use. Always at least one
+unsigned short ParallelSettings::getWorkerCount()
+{
+    return WorkerCount;
+}
+
+// Sets the number of worker threads. Zero means one per available processor
+void ParallelSettings::setWorkerCount(unsigned short workerCount)
+{
+    WorkerCount = workerCount ? workerCount : getProcessorCount();
+}
+
+// Number of processors available, or one if it can't be determined
+unsigned short ParallelSettings::getProcessorCount()
+{
+    unsigned int processors = std::thread::hardware_concurrency();
+    return processors ? (unsigned short)processors : 1;
+}
@@ -0,0 +1,41 @@
+/* This file is part of NFLdecisionTree. It creates decision trees to classify
+    situations within NFL football games, and displays the plays historically
+    called in those situations given a set of opponents.
+
+    Copyright (C) 2013   Ezra Erb
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 3 as published
+    by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    I'd appreciate a note if you find this program useful or make
+    updates. Please contact me through LinkedIn (my profile also has
+    a link to the code depository)
+*/
+
+/* This class holds the number of worker threads parallel parts of the program may
+    use. It is set once from the command line before any work starts, and read by
+    anything that can split its work up. One means everything runs on the calling
+    thread, exactly as the program always has. The default is one, so parallel code
+    is only used when asked for.
+
+    Everything is static, since there is one setting per process */
+class ParallelSettings {
+public:
+    // Number of worker threads to use. Always at least one
+    static unsigned short getWorkerCount();
+
+    // Sets the number of worker threads. Zero means one per available processor
+    static void setWorkerCount(unsigned short workerCount);
+
+    // Number of processors available, or one if it can't be determined
+    static unsigned short getProcessorCount();
+};
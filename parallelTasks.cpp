@@ -0,0 +1,110 @@
+/* This file is part of NFLdecisionTree. It creates decision trees to classify
+    situations within NFL football games, and displays the plays historically
+    called in those situations given a set of opponents.
+
+    Copyright (C) 2013   Ezra Erb
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 3 as published
+    by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    I'd appreciate a note if you find this program useful or make
+    updates. Please contact me through LinkedIn (my profile also has
+    a link to the code depository)
+*/
+#include<vector>
+#include<thread>
+#include<atomic>
+#include<mutex>
+#include<exception>
+#include<system_error>
+#include"parallelSettings.h"
+#include"parallelTasks.h"
+
+using std::vector;
+using std::thread;
+using std::atomic;
+using std::mutex;
+using std::lock_guard;
+using std::exception_ptr;
+
+// Tasks of one run, shared by every thread running them
+struct TaskQueue {
+    ParallelTasks* tasks;
+    unsigned int taskCount;
+    atomic<unsigned int> nextTask;
+
+    // First exception thrown by a task, if any
+    mutex errorLock;
+    exception_ptr error;
+
+    // Runs tasks on one thread until none are left
+    void runTasks();
+};
+
+// Runs tasks on one thread until none are left
+void TaskQueue::runTasks()
+{
+    unsigned int taskNumber;
+    while ((taskNumber = nextTask++) < taskCount) {
+        try {
+            tasks->runTask(taskNumber);
+        }
+        catch (...) {
+            // Stop handing out tasks, and keep the first exception for the caller
+            nextTask = taskCount;
+            lock_guard<mutex> lock(errorLock);
+            if (!error)
+                error = std::current_exception();
+        }
+    } // Loop until no tasks are left
+}
+
+// Thread function, for threads other than the calling one
+static void runQueue(TaskQueue* queue)
+{
+    queue->runTasks();
+}
+
+// Destructor
+ParallelTasks::~ParallelTasks()
+{
+    // Nothing to do
+}
+
+/* Runs tasks [0...taskCount) and returns when all are done. Uses at most the worker
+    count of threads, including the calling one */
+void ParallelTasks::run(unsigned int taskCount)
+{
+    TaskQueue queue;
+    queue.tasks = this;
+    queue.taskCount = taskCount;
+    queue.nextTask = 0;
+
+    unsigned int threadCount = ParallelSettings::getWorkerCount();
+    if (threadCount > taskCount)
+        threadCount = taskCount;
+    vector<thread> threads;
+    try {
+        unsigned int threadIndex;
+        for (threadIndex = 1; threadIndex < threadCount; threadIndex++)
+            threads.push_back(thread(runQueue, &queue));
+    }
+    catch (std::system_error&) {
+        // The system is out of threads. The ones already started, and this one, do the work
+    }
+    queue.runTasks();
+    vector<thread>::iterator threadPtr;
+    for (threadPtr = threads.begin(); threadPtr != threads.end(); threadPtr++)
+        threadPtr->join();
+    if (queue.error)
+        std::rethrow_exception(queue.error);
+}
@@ -0,0 +1,54 @@
+/* This file is part of NFLdecisionTree. It creates decision trees to classify
+    situations within NFL football games, and displays the plays historically
+    called in those situations given a set of opponents.
+
+    Copyright (C) 2013   Ezra Erb
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 3 as published
+    by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    I'd appreciate a note if you find this program useful or make
+    updates. Please contact me through LinkedIn (my profile also has
+    a link to the code depository)
+*/
+/* This class runs a set of independent tasks over the worker threads allowed by
+    ParallelSettings, and returns once all of them are done. Callers derive from it,
+    holding whatever the tasks share, and implement runTask() for a single task.
+
+    The calling thread runs tasks too, so with one worker every task runs on it, in
+    order, and no thread is started. Tasks are handed out one at a time as threads
+    finish their last, so tasks of uneven size still balance. If any task throws, the
+    first exception is rethrown to the caller once the tasks already started finish;
+    tasks not yet started are skipped.
+
+    Threads are started for each run instead of waiting in a pool. Starting one costs
+    tens of microseconds, so only work far larger than that is worth running this way.
+    Callers check the size of their work before deciding to call run(); see
+    ParallelIndexPlays in dataStore.cpp and ParallelSplitPlays in playIndexSet.cpp */
+class ParallelTasks {
+public:
+    // Destructor
+    virtual ~ParallelTasks();
+
+    /* Runs tasks [0...taskCount) and returns when all are done. Uses at most the worker
+        count of threads, including the calling one */
+    void run(unsigned int taskCount);
+
+protected:
+    /* Runs a single task. Called from several threads at once, with a different task
+        number on each */
+    virtual void runTask(unsigned int taskNumber) = 0;
+
+private:
+    // The tasks of a run, shared between its threads. Defined in the source file
+    friend struct TaskQueue;
+};
@@ -0,0 +1,173 @@
+/* This file is part of NFLdecisionTree. It creates decision trees to classify
+    situations within NFL football games, and displays the plays historically
+    called in those situations given a set of opponents.
+
+    Copyright (C) 2013   Ezra Erb
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 3 as published
+    by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    I'd appreciate a note if you find this program useful or make
+    updates. Please contact me through LinkedIn (my profile also has
+    a link to the code depository)
+*/
+/* Hardware counters are only wanted along with the run statistics. The entire
+    file compiles to nothing otherwise */
+#ifdef NFL_PERF_COUNTERS
+#include<string>
+#include<cstring>
+#include<cerrno>
+#include"perfCounters.h"
+#include"allocTracker.h"
+
+#ifdef __linux__
+#include<linux/perf_event.h>
+#include<sys/syscall.h>
+#include<sys/ioctl.h>
+#include<unistd.h>
+#endif
+
+using std::string;
+
+// Names of the events for output. Must match the enum in the header
+static const char* EventNames[] = { "cycles", "instructions", "cache_misses", "branch_misses" };
+
+// Whether the counters have been opened, and which events worked
+static bool CountersOpened = false;
+static bool EventAvailable[PerfCounters::EventCount];
+static unsigned short OpenedEventCount = 0;
+static string UnavailableReason;
+
+#ifdef __linux__
+// Generic events matching the enum in the header
+static const unsigned long long EventConfigs[] = { PERF_COUNT_HW_CPU_CYCLES,
+                                                   PERF_COUNT_HW_INSTRUCTIONS,
+                                                   PERF_COUNT_HW_CACHE_MISSES,
+                                                   PERF_COUNT_HW_BRANCH_MISSES };
+
+/* All events are opened as one group, so they are scheduled onto the processor
+    together and a single read returns all of them. The first one opened leads the
+    group. Events that fail to open are left out of the group, so its order is
+    recorded seperately */
+static int GroupLeader = -1;
+static PerfCounters::Event GroupOrder[PerfCounters::EventCount];
+
+// There is no library wrapper for this system call
+static int openEvent(unsigned long long config, int groupLeader)
+{
+    struct perf_event_attr attributes;
+    memset(&attributes, 0, sizeof(attributes));
+    attributes.size = sizeof(attributes);
+    attributes.type = PERF_TYPE_HARDWARE;
+    attributes.config = config;
+    attributes.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+        PERF_FORMAT_TOTAL_TIME_RUNNING;
+    /* Counting only this program's own code is allowed at the default security
+        setting of most distributions, while counting the kernel is not */
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+    return (int)syscall(__NR_perf_event_open, &attributes, 0, -1, groupLeader, 0);
+}
+#endif
+
+// Opens the counters if not already done
+void PerfCounters::open()
+{
+    if (CountersOpened)
+        return;
+    CountersOpened = true;
+    ALLOC_SCOPE(stats_memory);
+    unsigned short index;
+    for (index = 0; index < EventCount; index++)
+        EventAvailable[index] = false;
+#ifdef __linux__
+    for (index = 0; index < EventCount; index++) {
+        int handle = openEvent(EventConfigs[index], GroupLeader);
+        if (handle < 0) {
+            // Only the first failure is interesting, the rest are usually the same
+            if (UnavailableReason.empty()) {
+                UnavailableReason = string(EventNames[index]) + ": " + strerror(errno);
+                if ((errno == EACCES) || (errno == EPERM))
+                    UnavailableReason += " (check /proc/sys/kernel/perf_event_paranoid)";
+            }
+            continue;
+        }
+        if (GroupLeader < 0)
+            GroupLeader = handle;
+        EventAvailable[index] = true;
+        GroupOrder[OpenedEventCount] = (Event)index;
+        OpenedEventCount++;
+    } // Loop through events
+    if (OpenedEventCount) {
+        UnavailableReason.clear();
+        ioctl(GroupLeader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(GroupLeader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+#else
+    UnavailableReason = "hardware counters are only supported on Linux";
+#endif
+}
+
+// Whether any counters could be opened. The first call opens them
+bool PerfCounters::isAvailable()
+{
+    open();
+    return OpenedEventCount > 0;
+}
+
+// Whether one particular event could be opened
+bool PerfCounters::isEventAvailable(Event event)
+{
+    open();
+    return EventAvailable[event];
+}
+
+// Explains why counters are not available
+const char* PerfCounters::getUnavailableReason()
+{
+    open();
+    return UnavailableReason.c_str();
+}
+
+// Reads the current value of every event
+void PerfCounters::read(unsigned long long values[])
+{
+    open();
+    unsigned short index;
+    for (index = 0; index < EventCount; index++)
+        values[index] = 0;
+#ifdef __linux__
+    if (!OpenedEventCount)
+        return;
+
+    // Group read format: event count, time enabled, time running, then the values
+    unsigned long long buffer[3 + EventCount];
+    ssize_t expected = (ssize_t)((3 + OpenedEventCount) * sizeof(unsigned long long));
+    if (::read(GroupLeader, buffer, sizeof(buffer)) < expected)
+        return;
+
+    /* If other programs are using the counters, the kernel rotates between them and
+        the counts cover only part of the time. Scale them to estimate the full count */
+    double scale = 1.0;
+    if ((buffer[2] > 0) && (buffer[2] < buffer[1]))
+        scale = (double)buffer[1] / (double)buffer[2];
+    for (index = 0; index < OpenedEventCount; index++)
+        values[GroupOrder[index]] = (unsigned long long)((double)buffer[3 + index] * scale);
+#endif
+}
+
+// Name of an event, for output
+const char* PerfCounters::getEventName(Event event)
+{
+    return EventNames[event];
+}
+#endif
@@ -0,0 +1,67 @@
+/* This file is part of NFLdecisionTree. It creates decision trees to classify
+    situations within NFL football games, and displays the plays historically
+    called in those situations given a set of opponents.
+
+    Copyright (C) 2013   Ezra Erb
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 3 as published
+    by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    I'd appreciate a note if you find this program useful or make
+    updates. Please contact me through LinkedIn (my profile also has
+    a link to the code depository)
+*/
+
+/* This class reads the processor's hardware performance counters, which show WHY
+    code is slow rather than just how slow it is. Low instructions per cycle with
+    many cache misses means the code is waiting on memory, while many branch misses
+    means the processor keeps guessing wrong about which way the code will go.
+
+    Counters are opened through the Linux perf_event_open system call, and only
+    count the thread that opened them. Many systems restrict them, and virtual
+    machines often don't provide them at all, so every method works when they are
+    missing; reads simply return zeros. Use isAvailable() to tell the difference.
+    Individual events can also be missing even when others work, so check
+    isEventAvailable() before trusting a count.
+
+    Everything is static, since the processor has only one set of counters */
+
+class PerfCounters {
+public:
+    // Events counted. WARNING: Must be kept in sync with the event table in perfCounters.cpp!
+    enum Event { cpu_cycles, instructions, cache_misses, branch_misses };
+
+    // Number of events, used to size arrays of readings
+    static const unsigned short EventCount = 4;
+
+    // Whether any counters could be opened. The first call opens them
+    static bool isAvailable();
+
+    // Whether one particular event could be opened
+    static bool isEventAvailable(Event event);
+
+    /* Explains why counters are not available. Empty if they are, or if some events
+        work and others don't */
+    static const char* getUnavailableReason();
+
+    /* Reads the current value of every event into an array of EventCount entries.
+        Missing events read as zero. If the kernel had to share the counters with
+        other programs, values are scaled up to estimate the full count */
+    static void read(unsigned long long values[]);
+
+    // Name of an event, for output
+    static const char* getEventName(Event event);
+
+private:
+    // Opens the counters if not already done
+    static void open();
+};
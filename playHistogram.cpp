@@ -0,0 +1,118 @@
+/* This file is part of NFLdecisionTree. It creates decision trees to classify
+    situations within NFL football games, and displays the plays historically
+    called in those situations given a set of opponents.
+
+    Copyright (C) 2013   Ezra Erb
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 3 as published
+    by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    I'd appreciate a note if you find this program useful or make
+    updates. Please contact me through LinkedIn (my profile also has
+    a link to the code depository)
+*/
+#include<vector>
+#include<ostream>
+#include<string>
+#include"singlePlay.h"
+#include"playIndexSet.h"
+#include"playHistogram.h"
+
+using std::vector;
+
+/* Creates a histogram with no plays. Distances are summed for the plays given, which
+    is either one of the values above or a play type */
+PlayHistogram::PlayHistogram(short distancePlays)
+    : _counts((getCategoryCount() + 1) * SinglePlay::getPlayTypeCount(), 0),
+      _categoryTotals(getCategoryCount(), 0), _distancePlays(distancePlays),
+      _distanceSums((distancePlays != no_distances) ? getCategoryCount() : 0, 0),
+      _distanceSquares((distancePlays != no_distances) ? getCategoryCount() : 0, 0)
+{
+    // All in the initialization list
+}
+
+// Counts the plays in a set of indexes and adds them to the histogram
+void PlayHistogram::addPlays(const PlayIndexSet& indexes)
+{
+    // Extract the characteristics with indexes. If empty, have nothing to do
+    if (indexes.getIndexesAvailable().empty())
+        return;
+
+    /* Every index holds all of the plays, so any one of them can be used to find them.
+        The category starts are found once here instead of for every play */
+    unsigned short categoryStarts[SinglePlay::score_differential + 1];
+    unsigned short characteristic;
+    for (characteristic = 0; characteristic <= (unsigned short)SinglePlay::score_differential; characteristic++)
+        categoryStarts[characteristic] = getCategoryStart((SinglePlay::PlayCharacteristic)characteristic);
+    unsigned short playTypeCount = SinglePlay::getPlayTypeCount();
+    unsigned short playTypeStart = getCategoryCount() * playTypeCount;
+
+    const CategoryIndex& catIndex = indexes.getIndex(*(indexes.getIndexesAvailable().begin()));
+    CategoryIndex::const_iterator categoryPtr;
+    PlayIndex::const_iterator playPtr;
+    for (categoryPtr = catIndex.begin(); categoryPtr != catIndex.end(); categoryPtr++)
+        for (playPtr = categoryPtr->begin(); playPtr != categoryPtr->end(); playPtr++) {
+            unsigned short playType = (unsigned short)(*playPtr)->getPlayType();
+            for (characteristic = 0; characteristic <= (unsigned short)SinglePlay::score_differential;
+                 characteristic++) {
+                unsigned short category = categoryStarts[characteristic] +
+                    (unsigned short)(*playPtr)->getValue((SinglePlay::PlayCharacteristic)characteristic);
+                _counts[(category * playTypeCount) + playType]++;
+                _categoryTotals[category]++;
+            } // For each characteristic
+            _counts[playTypeStart + playType]++;
+            // Distances are summed in the same pass, reading each play once
+            if ((_distancePlays != no_distances) && isDistanceSummed(playType)) {
+                long distance = (*playPtr)->getDistanceGained();
+                for (characteristic = 0; characteristic <= (unsigned short)SinglePlay::score_differential;
+                     characteristic++) {
+                    unsigned short category = categoryStarts[characteristic] +
+                        (unsigned short)(*playPtr)->getValue((SinglePlay::PlayCharacteristic)characteristic);
+                    _distanceSums[category] += distance;
+                    _distanceSquares[category] += distance * distance;
+                } // For each characteristic
+            } // Distance wanted
+        } // For each play
+}
+
+// Adds a single play to the histogram
+void PlayHistogram::addPlay(const SinglePlay& play)
+{
+    unsigned short playType = (unsigned short)play.getPlayType();
+    unsigned short characteristic;
+    for (characteristic = 0; characteristic <= (unsigned short)SinglePlay::score_differential; characteristic++) {
+        unsigned short category = getCategoryStart((SinglePlay::PlayCharacteristic)characteristic) +
+            (unsigned short)play.getValue((SinglePlay::PlayCharacteristic)characteristic);
+        _counts[(category * SinglePlay::getPlayTypeCount()) + playType]++;
+        _categoryTotals[category]++;
+        if ((_distancePlays != no_distances) && isDistanceSummed(playType)) {
+            _distanceSums[category] += play.getDistanceGained();
+            _distanceSquares[category] += (long)play.getDistanceGained() * (long)play.getDistanceGained();
+        } // Distance wanted
+    } // For each characteristic
+    _counts[(getCategoryCount() * SinglePlay::getPlayTypeCount()) + playType]++;
+}
+
+// Removes the counts of another histogram, which must hold a subset of these plays
+void PlayHistogram::subtract(const PlayHistogram& other)
+{
+    unsigned short index;
+    for (index = 0; index < _counts.size(); index++)
+        _counts[index] -= other._counts[index];
+    for (index = 0; index < _categoryTotals.size(); index++)
+        _categoryTotals[index] -= other._categoryTotals[index];
+    // Both sum distances for the same plays, or neither does
+    for (index = 0; index < _distanceSums.size(); index++) {
+        _distanceSums[index] -= other._distanceSums[index];
+        _distanceSquares[index] -= other._distanceSquares[index];
+    }
+}
@@ -0,0 +1,244 @@
+/* This file is part of NFLdecisionTree. It creates decision trees to classify
+    situations within NFL football games, and displays the plays historically
+    called in those situations given a set of opponents.
+
+    Copyright (C) 2013   Ezra Erb
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 3 as published
+    by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    I'd appreciate a note if you find this program useful or make
+    updates. Please contact me through LinkedIn (my profile also has
+    a link to the code depository)
+*/
+
+/* This class counts the plays in a set by type, for every category of every
+    characteristic. Its the data needed to choose how to split a decision node.
+
+    Counting is most of the work of building the tree, since every node needs counts
+    for all of its plays. A split divides the plays of a node between its children
+    without changing any of them, so the counts of one child are the counts of its
+    parent minus the counts of all the other children. The tree builder counts every
+    child but the largest directly and gets the largest by subtraction, which saves at
+    least half the counting. The counts are laid out in one array, so subtraction is a
+    single pass over it.
+
+    Counts are longs, so a node can hold any number of plays the data store can.
+
+    For trees split on yardage, the histogram also sums the distances gained, and their
+    squares, for each category. Those give the mean and variance of the distance for
+    any group of categories, so a split can be scored without going back to the plays.
+    The sums can be limited to plays of one type. They are only kept when asked for, since
+    they cost as much time to add up as the counts */
+using std::vector; // Header deliberately not included, clients make extensive use of it
+
+class PlayHistogram {
+public:
+    // Plays whose distances are summed, other than a single play type
+    enum DistancePlays { no_distances = -2, all_play_types = -1 };
+
+    /* Creates a histogram with no plays. Distances are summed for the plays given, which
+        is either one of the values above or a play type */
+    explicit PlayHistogram(short distancePlays = no_distances);
+
+    // Use the default copy constructor, assignment operator and destructor
+
+    // Counts the plays in a set of indexes and adds them to the histogram
+    void addPlays(const PlayIndexSet& indexes);
+
+    // Adds a single play to the histogram
+    void addPlay(const SinglePlay& play);
+
+    /* Counts plays held in columns, a column store or plays selected from a league store,
+        and adds them to the histogram. The plays are given by their rows, which should be
+        in increasing order so the columns are read front to back */
+    template<class Columns>
+    void addRows(const Columns& columns, const unsigned int* rows, unsigned long rowCount);
+
+    // Removes the counts of another histogram, which must hold a subset of these plays
+    void subtract(const PlayHistogram& other);
+
+    // Number of plays of a type
+    long getPlayTypeCount(SinglePlay::PlayType playType) const;
+
+    // Number of plays in a category of a characteristic
+    long getCategoryTotal(SinglePlay::PlayCharacteristic characteristic, unsigned short category) const;
+
+    // Number of plays of a type in a category of a characteristic
+    long getCount(SinglePlay::PlayCharacteristic characteristic, unsigned short category,
+                  SinglePlay::PlayType playType) const;
+
+    // Total number of plays
+    long getPlayTotal() const;
+
+    // Plays whose distances are summed, as passed to the constructor
+    short getDistancePlays() const;
+
+    /* Number of plays whose distances are summed in a category of a characteristic, and
+        the sums of their distances and squared distances */
+    long getDistanceCount(SinglePlay::PlayCharacteristic characteristic, unsigned short category) const;
+    long getDistanceSum(SinglePlay::PlayCharacteristic characteristic, unsigned short category) const;
+    long long getDistanceSquares(SinglePlay::PlayCharacteristic characteristic, unsigned short category) const;
+
+private:
+    /* Counts for each category of each characteristic, followed by the counts for each
+        play type. Characteristics follow one another in enum order, and each category
+        has an entry for each play type */
+    vector<long> _counts;
+
+    // Plays for each category of each characteristic, in the same order
+    vector<long> _categoryTotals;
+
+    /* Plays whose distances are summed, and the sums of their distances and squared
+        distances for each category. Empty if distances are not summed */
+    short _distancePlays;
+    vector<long> _distanceSums;
+    vector<long long> _distanceSquares;
+
+    // Returns whether the distance of a play of a type is summed
+    bool isDistanceSummed(unsigned short playType) const;
+
+    // Position of the first category of each characteristic, in categories
+    static unsigned short getCategoryStart(SinglePlay::PlayCharacteristic characteristic);
+
+    // Total number of categories over all characteristics
+    static unsigned short getCategoryCount();
+};
+
+// Position of the first category of each characteristic, in categories
+inline unsigned short PlayHistogram::getCategoryStart(SinglePlay::PlayCharacteristic characteristic)
+{
+    unsigned short start = 0;
+    unsigned short index;
+    for (index = 0; index < (unsigned short)characteristic; index++)
+        start += SinglePlay::getCategoryCount((SinglePlay::PlayCharacteristic)index);
+    return start;
+}
+
+// Total number of categories over all characteristics
+inline unsigned short PlayHistogram::getCategoryCount()
+{
+    // Score differential is the last characteristic
+    return getCategoryStart(SinglePlay::score_differential) +
+           SinglePlay::getCategoryCount(SinglePlay::score_differential);
+}
+
+// Number of plays of a type
+inline long PlayHistogram::getPlayTypeCount(SinglePlay::PlayType playType) const
+{
+    return _counts[(getCategoryCount() * SinglePlay::getPlayTypeCount()) + (unsigned short)playType];
+}
+
+// Number of plays in a category of a characteristic
+inline long PlayHistogram::getCategoryTotal(SinglePlay::PlayCharacteristic characteristic,
+                                            unsigned short category) const
+{
+    return _categoryTotals[getCategoryStart(characteristic) + category];
+}
+
+// Number of plays of a type in a category of a characteristic
+inline long PlayHistogram::getCount(SinglePlay::PlayCharacteristic characteristic, unsigned short category,
+                                    SinglePlay::PlayType playType) const
+{
+    return _counts[((getCategoryStart(characteristic) + category) * SinglePlay::getPlayTypeCount()) +
+                   (unsigned short)playType];
+}
+
+// Total number of plays
+inline long PlayHistogram::getPlayTotal() const
+{
+    // Every play is in exactly one category of the first characteristic
+    long playTotal = 0;
+    unsigned short category;
+    for (category = 0; category < SinglePlay::getCategoryCount(SinglePlay::down_number); category++)
+        playTotal += _categoryTotals[category];
+    return playTotal;
+}
+
+// Plays whose distances are summed, as passed to the constructor
+inline short PlayHistogram::getDistancePlays() const
+{
+    return _distancePlays;
+}
+
+// Number of plays whose distances are summed in a category of a characteristic
+inline long PlayHistogram::getDistanceCount(SinglePlay::PlayCharacteristic characteristic,
+                                            unsigned short category) const
+{
+    if (_distancePlays == all_play_types)
+        return getCategoryTotal(characteristic, category);
+    else
+        return getCount(characteristic, category, (SinglePlay::PlayType)_distancePlays);
+}
+
+// Sum of the distances summed in a category of a characteristic
+inline long PlayHistogram::getDistanceSum(SinglePlay::PlayCharacteristic characteristic,
+                                          unsigned short category) const
+{
+    return _distanceSums[getCategoryStart(characteristic) + category];
+}
+
+// Sum of the squares of the distances summed in a category of a characteristic
+inline long long PlayHistogram::getDistanceSquares(SinglePlay::PlayCharacteristic characteristic,
+                                                   unsigned short category) const
+{
+    return _distanceSquares[getCategoryStart(characteristic) + category];
+}
+
+// Returns whether the distance of a play of a type is summed
+inline bool PlayHistogram::isDistanceSummed(unsigned short playType) const
+{
+    return ((_distancePlays == all_play_types) || (_distancePlays == (short)playType));
+}
+
+/* Counts plays held in columns, a column store or plays selected from a league store,
+    and adds them to the histogram. The plays are given by their rows, which should be
+    in increasing order so the columns are read front to back */
+template<class Columns>
+void PlayHistogram::addRows(const Columns& columns, const unsigned int* rows, unsigned long rowCount)
+{
+    unsigned short categoryStarts[SinglePlay::score_differential + 1];
+    typename Columns::CategoryColumn categories[SinglePlay::score_differential + 1];
+    unsigned short characteristic;
+    for (characteristic = 0; characteristic <= (unsigned short)SinglePlay::score_differential; characteristic++) {
+        categoryStarts[characteristic] = getCategoryStart((SinglePlay::PlayCharacteristic)characteristic);
+        categories[characteristic] = columns.getCategories((SinglePlay::PlayCharacteristic)characteristic);
+    }
+    typename Columns::PlayTypeColumn playTypes = columns.getPlayTypes();
+    typename Columns::DistanceColumn distances = columns.getDistances();
+    unsigned short playTypeCount = SinglePlay::getPlayTypeCount();
+    unsigned short playTypeStart = getCategoryCount() * playTypeCount;
+
+    unsigned long rowIndex;
+    for (rowIndex = 0; rowIndex < rowCount; rowIndex++) {
+        unsigned int row = rows[rowIndex];
+        unsigned short playType = playTypes[row];
+        // Each category is read once, since reading a packed column costs more than an array
+        unsigned short playCategories[SinglePlay::score_differential + 1];
+        for (characteristic = 0; characteristic <= (unsigned short)SinglePlay::score_differential;
+             characteristic++) {
+            unsigned short category = categoryStarts[characteristic] + categories[characteristic][row];
+            playCategories[characteristic] = category;
+            _counts[(category * playTypeCount) + playType]++;
+            _categoryTotals[category]++;
+        } // For each characteristic
+        _counts[playTypeStart + playType]++;
+        if ((_distancePlays != no_distances) && isDistanceSummed(playType)) {
+            long distance = distances[row];
+            for (characteristic = 0; characteristic <= (unsigned short)SinglePlay::score_differential;
+                 characteristic++) {
+                _distanceSums[playCategories[characteristic]] += distance;
+                _distanceSquares[playCategories[characteristic]] += distance * distance;
+            } // For each characteristic
+        } // Distance wanted
+    } // For each play
+}
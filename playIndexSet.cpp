@@ -25,6 +25,9 @@
 #include"singlePlay.h"
 #include"playIndexSet.h"
 #include"baseException.h"
+#include"allocTracker.h"
+#include"parallelSettings.h"
+#include"parallelTasks.h"
 
 #include<iostream>
 using std::cerr;
@@ -33,6 +36,71 @@ using std::vector;
 using std::endl;
 using std::ostream;
 
+/* Nodes with this many plays split their indexes in parallel. Smaller splits finish in
+    less time than starting threads takes */
+static const unsigned long ParallelSplitPlays = 32768;
+
+// Splits the five indexes at once on worker threads, one per task
+class PlayIndexSet::SplitTasks : public ParallelTasks {
+public:
+    /* Splits by category if there are no groups. The results must already exist, and
+        the set keeps the first piece */
+    SplitTasks(PlayIndexSet& indexSet, vector<PlayIndexSet>& results,
+               SinglePlay::PlayCharacteristic playCharacteristic, const vector<short>* categoryGroups);
+
+    // Splits every index. They are split in parallel if there are enough plays
+    void splitAll(unsigned long playCount);
+
+protected:
+    virtual void runTask(unsigned int taskNumber);
+
+private:
+    PlayIndexSet& _indexSet;
+    vector<PlayIndexSet>& _results;
+    SinglePlay::PlayCharacteristic _playCharacteristic;
+    const vector<short>* _categoryGroups;
+};
+
+/* Splits by category if there are no groups. The results must already exist, and
+    the set keeps the first piece */
+PlayIndexSet::SplitTasks::SplitTasks(PlayIndexSet& indexSet, vector<PlayIndexSet>& results,
+                                     SinglePlay::PlayCharacteristic playCharacteristic,
+                                     const vector<short>* categoryGroups)
+    : _indexSet(indexSet), _results(results), _playCharacteristic(playCharacteristic),
+      _categoryGroups(categoryGroups)
+{
+    // All in the initialization list
+}
+
+// Splits every index. They are split in parallel if there are enough plays
+void PlayIndexSet::SplitTasks::splitAll(unsigned long playCount)
+{
+    unsigned int indexCount = (unsigned int)SinglePlay::score_differential + 1;
+    if ((ParallelSettings::getWorkerCount() > 1) && (playCount >= ParallelSplitPlays))
+        run(indexCount);
+    else {
+        unsigned int index;
+        for (index = 0; index < indexCount; index++)
+            runTask(index);
+    }
+}
+
+// Splits the index for one characteristic, by its place in the enum
+void PlayIndexSet::SplitTasks::runTask(unsigned int taskNumber)
+{
+    ALLOC_SCOPE(index_memory);
+    SinglePlay::PlayCharacteristic indexCharacteristic = (SinglePlay::PlayCharacteristic)taskNumber;
+    vector<CategoryIndex*> catPointers;
+    vector<PlayIndexSet>::iterator resultIterator;
+    for (resultIterator = _results.begin(); resultIterator != _results.end(); resultIterator++)
+        catPointers.push_back(resultIterator->getChangeableIndex(indexCharacteristic));
+    if (_categoryGroups == NULL)
+        _indexSet.splitIndex(_playCharacteristic, *_indexSet.getChangeableIndex(indexCharacteristic), catPointers);
+    else
+        _indexSet.splitIndexByGroups(_playCharacteristic, *_categoryGroups,
+                                     *_indexSet.getChangeableIndex(indexCharacteristic), catPointers);
+}
+
 // Default constructor.
 PlayIndexSet::PlayIndexSet()
     : _indexes(),_downIndex(),_distanceNeededIndex(), _fieldLocationIndex(), _timeRemainingIndex(),
@@ -47,13 +115,16 @@ PlayIndexSet::PlayIndexSet(const PlayIndexSet& other)
     _fieldLocationIndex(other._fieldLocationIndex), _timeRemainingIndex(other._timeRemainingIndex),
     _scoreDifferentialIndex(other._scoreDifferentialIndex), _emptyCatIndex()
 {
-    // All in the  intialization list
+    /* All in the  intialization list
+        NOTE: Memory tracking can't see into the initialization list, so callers making
+        copies should charge them to the index themselves */
 }
 
 // Assignment operator
 /* NOTE: This is here mostly for completeness. Using in in practice indicats some sort of problem */
 PlayIndexSet& PlayIndexSet::operator=(const PlayIndexSet& other)
 {
+    ALLOC_SCOPE(index_memory);
     _indexes = other._indexes;
     _downIndex = other._downIndex;
     _distanceNeededIndex = other._distanceNeededIndex;
@@ -74,6 +145,7 @@ void PlayIndexSet::setIndexes(const CategoryIndex& downIndex, const CategoryInde
         scoreDifferentialIndex.empty())
         throw BaseException(__FILE__, __LINE__, "Index create failed, some data indexes empty after build");
 
+    ALLOC_SCOPE(index_memory);
     _downIndex = downIndex;
     _distanceNeededIndex = distanceNeededIndex;
     _fieldLocationIndex = fieldLocationIndex;
@@ -96,13 +168,17 @@ void PlayIndexSet::setIndexes(const CategoryIndex& downIndex, const CategoryInde
     adds any value. This class will contain the first of the split indxes; the returned values will have the rest */
 vector<PlayIndexSet> PlayIndexSet::splitIndexByCharacteristic(SinglePlay::PlayCharacteristic playCharacteristic)
 {
+    ALLOC_SCOPE(index_memory);
     CategoryIndex splitingIndex = getIndex(playCharacteristic);
     // Count the number of categories with indexes. If one or less, nothing to do!
     CategoryIndex::const_iterator temp;
     unsigned short splitCount = 0;
+    unsigned long playCount = 0;
     for (temp = splitingIndex.begin(); temp != splitingIndex.end(); temp++)
-        if (!temp->empty())
+        if (!temp->empty()) {
             splitCount++;
+            playCount += temp->size();
+        }
     /* At this point, index for characteristic to split is either about to become
         redundant or already is. Drop it in either case */
     dropIndex(playCharacteristic);
@@ -121,39 +197,90 @@ vector<PlayIndexSet> PlayIndexSet::splitIndexByCharacteristic(SinglePlay::PlayCh
         for (resultIterator= result.begin(); resultIterator != result.end(); resultIterator++)
             resultIterator->_indexes = _indexes;
 
-        /* For every index, need to assemble a vector of pointers to the index
-            in the results vector, and use those to do the split */
-        vector<CategoryIndex*> catPointers;
-        vector<PlayIndexSet>::iterator resultCounter;
-
-        for (resultIterator = result.begin(); resultIterator != result.end(); resultIterator++)
-            catPointers.push_back(&(resultIterator->_downIndex));
-        splitIndex(playCharacteristic, _downIndex, catPointers);
-        catPointers.clear(); // Ensure index data does not carry over
-
-        for (resultIterator = result.begin(); resultIterator != result.end(); resultIterator++)
-            catPointers.push_back(&(resultIterator->_distanceNeededIndex));
-        splitIndex(playCharacteristic, _distanceNeededIndex, catPointers);
-        catPointers.clear(); // Ensure index data does not carry over!
-
-        for (resultIterator = result.begin(); resultIterator != result.end(); resultIterator++)
-            catPointers.push_back(&(resultIterator->_fieldLocationIndex));
-        splitIndex(playCharacteristic, _fieldLocationIndex, catPointers);
-        catPointers.clear(); // Ensure index data does not carry over!
-
-        for (resultIterator = result.begin(); resultIterator != result.end(); resultIterator++)
-            catPointers.push_back(&(resultIterator->_timeRemainingIndex));
-        splitIndex(playCharacteristic, _timeRemainingIndex, catPointers);
-        catPointers.clear(); // Ensure index data does not carry over!
-
-        for (resultIterator = result.begin(); resultIterator != result.end(); resultIterator++)
-            catPointers.push_back(&(resultIterator->_scoreDifferentialIndex));
-        splitIndex(playCharacteristic, _scoreDifferentialIndex, catPointers);
-        catPointers.clear(); // Ensure index data does not carry over!
+        /* Split every index, moving the pieces into the results. A dropped index is
+            empty, so splitting it does nothing */
+        SplitTasks tasks(*this, result, playCharacteristic, NULL);
+        tasks.splitAll(playCount);
         return result;
     } // Split into at least two categories
 }
 
+/* Splits an index into groups of categories of a characteristic. The groups give the
+    group number for every category, or -1 for categories without plays. Unlike splitting by
+    category, the index for the characteristic is kept, since a group holding several
+    categories can be split on it again. This class will contain group zero; the returned
+    values will have the rest, in group order */
+vector<PlayIndexSet> PlayIndexSet::splitIndexByGroups(SinglePlay::PlayCharacteristic playCharacteristic,
+                                                      const vector<short>& categoryGroups)
+{
+    ALLOC_SCOPE(index_memory);
+    short groupCount = 0;
+    vector<short>::const_iterator groupIndex;
+    for (groupIndex = categoryGroups.begin(); groupIndex != categoryGroups.end(); groupIndex++)
+        if (*groupIndex >= groupCount)
+            groupCount = *groupIndex + 1;
+    if (groupCount <= 1) {
+        // Nothing to do!
+        vector<PlayIndexSet> result;
+        return result;
+    }
+
+    // Split results. Remember that group zero ends up in the original object
+    vector<PlayIndexSet> result(groupCount - 1);
+    vector<PlayIndexSet>::iterator resultIterator;
+    for (resultIterator= result.begin(); resultIterator != result.end(); resultIterator++)
+        resultIterator->_indexes = _indexes;
+
+    SplitTasks tasks(*this, result, playCharacteristic, &categoryGroups);
+    tasks.splitAll(getPlayCount());
+    return result;
+}
+
+// Returns a category based index to change. Other types return NULL
+CategoryIndex* PlayIndexSet::getChangeableIndex(SinglePlay::PlayCharacteristic playCharacteristic)
+{
+    switch (playCharacteristic) {
+    case SinglePlay::down_number:
+        return &_downIndex;
+    case SinglePlay::distance_needed:
+        return &_distanceNeededIndex;
+    case SinglePlay::field_location:
+        return &_fieldLocationIndex;
+    case SinglePlay::time_remaining:
+        return &_timeRemainingIndex;
+    case SinglePlay::score_differential:
+        return &_scoreDifferentialIndex;
+    default:
+        return NULL;
+    }
+}
+
+// Split an index into groups of categories of a characteristic
+void PlayIndexSet::splitIndexByGroups(SinglePlay::PlayCharacteristic playCharacteristic,
+                                      const vector<short>& categoryGroups, CategoryIndex& existIndex,
+                                      vector<CategoryIndex*> newIndexes)
+{
+    if (existIndex.empty())
+        return; // Nothing to do!
+
+    /* Much simpler than splitting by category, since the number of groups is known up front.
+        Every group keeps all categories of the existing index, so they line up afterward */
+    vector<CategoryIndex> results(newIndexes.size() + 1, CategoryIndex(existIndex.size()));
+    unsigned short index;
+    PlayIndex::const_iterator playIndex;
+    for (index = 0; index < existIndex.size(); index++)
+        for (playIndex = existIndex[index].begin(); playIndex != existIndex[index].end(); playIndex++) {
+            short group = categoryGroups.at((*playIndex)->getValue(playCharacteristic));
+            if (group < 0)
+                throw BaseException(__FILE__, __LINE__, "Index split failed, play in category with no group");
+            results[group][index].push_back(*playIndex);
+        } // For each play in the category
+
+    existIndex.swap(results[0]);
+    for (index = 0; index < newIndexes.size(); index++)
+        newIndexes[index]->swap(results[index + 1]);
+}
+
 // Split an index by a category characteristic, into seperate indexes for each category
 void PlayIndexSet::splitIndexHelper(SinglePlay::PlayCharacteristic playCharacteristic, const PlayIndex& existIndex,
                                     vector<PlayIndex>& newIndexes)
@@ -181,7 +308,7 @@ void PlayIndexSet::splitIndex(SinglePlay::PlayCharacteristic playCharacteristic,
         index categories, then the split categories. Need to swap those two to get the
         wanted data structures for the return. Split categories with no results also
         get dropped, so this routine counts them as the splits proceed */
-    vector<short> splitCounts(SinglePlay::getCategoryCount(playCharacteristic));
+    vector<unsigned long> splitCounts(SinglePlay::getCategoryCount(playCharacteristic));
     vector<vector<PlayIndex> > results(existIndex.size());
 
     unsigned short index, index2;
@@ -67,12 +67,23 @@ class PlayIndexSet {
             class will contain the first of the split indxes; the returned values will have the rest */
         vector<PlayIndexSet> splitIndexByCharacteristic(SinglePlay::PlayCharacteristic playCharacteristic);
 
+        /* Splits an index into groups of categories of a characteristic. The groups give the
+            group number for every category, or -1 for categories without plays. Unlike the split
+            above, the index for the characteristic is kept, since a group holding several
+            categories can be split on it again. This class will contain group zero; the returned
+            values will have the rest, in group order */
+        vector<PlayIndexSet> splitIndexByGroups(SinglePlay::PlayCharacteristic playCharacteristic,
+                                                const vector<short>& categoryGroups);
+
         // Drops an index. This usually happens because it is redundant for splitting
         void dropIndex(SinglePlay::PlayCharacteristic playCharacteristic);
 
         // Returns characteristics with plays defined
         const PlayCharacteristicSet& getIndexesAvailable() const;
 
+        // Returns the number of plays in the indexes
+        unsigned long getPlayCount() const;
+
     private:
         /* Set of characteristics which have indexes. The set can either be derived on every
             call for the data or tracked seperately and updated with each drop. This clas does \
@@ -90,6 +101,15 @@ class PlayIndexSet {
             characteristics not indexed */
         CategoryIndex _emptyCatIndex;
 
+        /* Splits the five indexes at once on worker threads. The splits of different indexes
+            touch different data, so they don't need to wait for each other. Defined in the
+            source file */
+        class SplitTasks;
+        friend class SplitTasks;
+
+        // Returns a category based index to change. Other types return NULL
+        CategoryIndex* getChangeableIndex(SinglePlay::PlayCharacteristic playCharacteristic);
+
         // Split an index by a category characteristic
         /* NOTE: This method takes a vector of pointers. They should actually be references,
             but they can't be used in vectors because they don't have default values */
@@ -97,6 +117,11 @@ class PlayIndexSet {
                         vector<CategoryIndex*> newIndexes);
         void splitIndexHelper(SinglePlay::PlayCharacteristic playCharacteristic, const PlayIndex& existIndex,
                               vector<PlayIndex>& newIndexes);
+
+        // Split an index into groups of categories of a characteristic
+        void splitIndexByGroups(SinglePlay::PlayCharacteristic playCharacteristic,
+                                const vector<short>& categoryGroups, CategoryIndex& existIndex,
+                                vector<CategoryIndex*> newIndexes);
 };
 
 // Outputs a play index for debugging
@@ -168,3 +193,17 @@ inline const PlayCharacteristicSet& PlayIndexSet::getIndexesAvailable() const
 }
 
 
+
+// Returns the number of plays in the indexes
+inline unsigned long PlayIndexSet::getPlayCount() const
+{
+    // Every index holds all of the plays, so count any one of them
+    if (_indexes.empty())
+        return 0;
+    const CategoryIndex& catIndex = getIndex(*(_indexes.begin()));
+    unsigned long playCount = 0;
+    CategoryIndex::const_iterator index;
+    for (index = catIndex.begin(); index != catIndex.end(); index++)
+        playCount += index->size();
+    return playCount;
+}
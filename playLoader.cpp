@@ -30,9 +30,12 @@
 #include"singlePlay.h" // Needed by playIndexSet.h
 #include"playIndexSet.h" // Needed by dataStore.h
 #include"playStats.h" // Needed by dataStore.h
+#include"allocTracker.h" // Needed by dataStore.h
 #include"dataStore.h"
 #include"playLoader.h"
 #include"baseException.h"
+#include"runStats.h"
+#include"traceLog.h"
 
 using std::string;
 using std::ifstream;
@@ -75,61 +78,148 @@ PlayLoader::~PlayLoader()
         _playFile.close();
 }
 
-// Loads plays for the wanted teams for one season into the data store
-/* WARNING: Does NOT generate index data! */
-void PlayLoader::loadSingleSeason(const string& thisTeam, const string& otherTeam,
-                                  const vector<string>& thisSimiliar,
-                                  const vector<string>& otherSimiliar,
-                                  unsigned short seasonYear,
-                                  DataStore& dataStore)
+// Returns the name of the data file for a season in a directory
+string PlayLoader::getSeasonFileName(const string& directory, unsigned short seasonYear)
 {
-    // First, open the file
-    if (_playFile.is_open())
-        _playFile.close();
-
     // Assemble the file name. Format is XXXX_nfl_pbp_data.csv, where XXXX is the year
     /* The passed directory does not include the backslash needed before the filename,
-        so add it
+        so add it. Other platforms use a forward slash
         TRICKY NOTE: Notice the double backslash below. C++ uses '\' as an
         escape character. The first is the esacpe character needed to insert a
         litteral '\' in the string! */
     stringstream fullFileName;
-    fullFileName << _directory << "\\";
+#ifdef _WIN32
+    fullFileName << directory << "\\";
+#else
+    fullFileName << directory << "/";
+#endif
     fullFileName << seasonYear << "_nfl_pbp_data.csv";
+    return fullFileName.str();
+}
+
+// Opens the data file for a season, throwing if it does not exist
+void PlayLoader::openSeasonFile(unsigned short seasonYear)
+{
+    if (_playFile.is_open())
+        _playFile.close();
+
+    string fullFileName(getSeasonFileName(_directory, seasonYear));
     // Trace the full file path, to catch the error where the directory is wrong
-    _playFile.open(fullFileName.str().c_str());
+    _playFile.open(fullFileName.c_str());
     if (!_playFile.is_open()) {
         stringstream errorMessage;
-        errorMessage << "Error, could not open data file " << fullFileName.str();
+        errorMessage << "Error, could not open data file " << fullFileName;
         throw BaseException(__FILE__, __LINE__, errorMessage.str().c_str());
     }
+}
+
+// Loads the wanted plays of one season into a batch, after any already there
+void PlayLoader::loadSeason(const string& thisTeam, const string& otherTeam,
+                            const vector<string>& thisSimiliar, const vector<string>& otherSimiliar,
+                            unsigned short seasonYear, PlayBatch& batch)
+{
+    STATS_PHASE(season_load);
+    ALLOC_SCOPE(loader_memory);
+    TRACE_SCOPE("season_load", "season", seasonYear);
+    openSeasonFile(seasonYear);
 
     /* Some texts recommend always putting file reads in a try...catch block, to clean up
         properly. This code doesn't bother because the destructor will handle the file,
-        and the lack of an index creation call on the data store ensures consistent (and empty)
-        results on an exception */
+        and plays only reach a data store once the whole season has been read */
     string playText;
     // First line is a header. Read it to burn it
     getline(_playFile, playText);
     unsigned short sackCount = 0; // Number of sacks processed
     while (!_playFile.eof()) {
         // Read a play from the data file and process it
-        getline(_playFile, playText);
-        processPlay(playText, thisTeam, otherTeam, thisSimiliar, otherSimiliar, sackCount, dataStore);
+        {
+            STATS_TIMER(readTimer, file_read);
+            getline(_playFile, playText);
+        }
+        // The file normally ends with a line break, which produces an empty final line
+        if (!playText.empty()) {
+            STATS_COUNT(lines_scanned, 1);
+            processPlay(playText, thisTeam, otherTeam, thisSimiliar, otherSimiliar, sackCount, batch);
+        }
     }
     _playFile.close();
 }
 
-// Process a single play from a data file
+// Process a single play from a data file, adding it to the batch if it is wanted
 void PlayLoader::processPlay(const string& playString, const string& thisTeam, const string& otherTeam,
                              const vector<string>& thisSimiliar, const vector<string>& otherSimiliar,
-                             unsigned short& sackCount, DataStore& dataStore)
+                             unsigned short& sackCount, PlayBatch& batch)
+{
+    STATS_TIMER(lineTimer, line_parse);
+    PlayFields fields;
+    string::size_type pos;
+    if (!extractLeadingFields(playString, fields, pos))
+        return;
+
+    /* At this point, have enough information to determine whether this play is wanted
+        or not. It must fall within one of three categories
+        1. Offense matches wanted offense and defense matches wanted offense
+        2. Offense matches wanted offense and defense falls in list of similiar
+            defenses to wanted defense
+        3. Offense falls in list similiar offenses to wanted offense and defense
+            matches wanted defense
+        WARNING: This process is sensitive to both whitespace and capitalization, because
+        its more efficient for the caller to get this right that for this code to deal with
+        matching it. The current set of data files requires ALL CAPS and no whitespace */
+    STATS_SWITCH(lineTimer, filter);
+    bool haveMatch = false;
+    if (fields.offense == thisTeam) {
+        if (fields.defense == otherTeam)
+            haveMatch = true;
+        else
+            haveMatch = (find(otherSimiliar.begin(), otherSimiliar.end(), fields.defense) != otherSimiliar.end());
+    } // Offense matches the wanted team
+    else if (fields.defense == otherTeam)
+        haveMatch = (find(thisSimiliar.begin(), thisSimiliar.end(), fields.offense) != thisSimiliar.end());
+    else
+        haveMatch = false;
+    if (!haveMatch) {
+        STATS_COUNT(filter_rejects, 1);
+        return; // Not a wanted play
+    }
+    STATS_SWITCH(lineTimer, line_parse);
+
+    /* If get to here, want the play. Extract remaining data snd insert into the data store.
+        Some of it requires a tricky search of the description field */
+    if (!extractTrailingFields(playString, pos, fields))
+        return;
+
+    /* To get play type, yardage gained, and turnover, need to parse the description.
+        Thankfully, it has a standard format */
+    STATS_SWITCH(lineTimer, classification);
+    SinglePlay::PlayType playType = SinglePlay::punt;
+    short distanceGained = 0;
+    bool turnedOver = false;
+    bool havePlay = classifyDescription(fields.description, sackCount, playType, distanceGained, turnedOver);
+
+    // If found a play at this point, add it to the plays for the data store
+    if (havePlay) {
+        STATS_COUNT(plays_kept, 1);
+        batch.addPlay(playType, fields.down, fields.distanceNeeded, fields.yardLine,
+                      fields.minutes, fields.ownScore, fields.oppScore, distanceGained,
+                      turnedOver);
+    }
+    else
+        reportUnknownPlay(playString, fields.description);
+}
+
+/* Extracts the fields of a play line needed to decide whether it is wanted, up to
+    and including the down. Returns false if the line is badly formed or is not a
+    down play. Pos is left on the comma after the down */
+bool PlayLoader::extractLeadingFields(const string& playString, PlayFields& fields,
+                                      string::size_type& pos)
 {
     /* Play data is organized in the following fields:
         gameid,qtr,min,sec,off,def,down,togo,ydline,description,offscore,defscore,season
         They are extracted by searching for the commas */
-    unsigned int pos;
-    unsigned int prevPos;
+    /* NOTE: Positions must be string::size_type, not unsigned int. On 64 bit platforms
+        string::npos does not fit in an unsigned int, and the checks for it silently fail */
+    string::size_type prevPos;
     // First category is a game ID, burn it
     pos = playString.find_first_of(',');
     // Second category is quarter, burn it
@@ -140,9 +230,9 @@ void PlayLoader::processPlay(const string& playString, const string& thisTeam, c
     pos = playString.find_first_of(',', prevPos);
     if (pos == string::npos) { // Indicates badly formed input
         cerr << "Improperly formatted input: " << playString << endl;
-        return;
+        return false;
     }
-    unsigned short minutes = (unsigned short)extractNumeric(playString, prevPos, pos);
+    fields.minutes = (unsigned short)extractNumeric(playString, prevPos, pos);
 
     // Fourth category is seconds. Burn it
     pos = playString.find_first_of(',', pos + 1);
@@ -152,113 +242,119 @@ void PlayLoader::processPlay(const string& playString, const string& thisTeam, c
     pos = playString.find_first_of(',', prevPos);
     if (pos == string::npos) { // Indicates badly formed input
         cerr << "Improperly formatted input: " << playString << endl;
-        return;
+        return false;
     }
-    string offense(playString, prevPos, pos - prevPos);
+    fields.offense.assign(playString, prevPos, pos - prevPos);
 
     // Sixth category is defence, extract it
     prevPos = pos + 1; // Move off  the comma
     pos = playString.find_first_of(',', prevPos);
     if (pos == string::npos) { // Indicates badly formed input
         cerr << "Improperly formatted input: " << playString << endl;
-        return;
+        return false;
     }
-    string defense(playString, prevPos, pos - prevPos);
+    fields.defense.assign(playString, prevPos, pos - prevPos);
 
     // Seventh category is down, extract it
     prevPos = pos + 1; // Move off  the comma
     pos = playString.find_first_of(',', prevPos);
     if (pos == string::npos) { // Indicates badly formed input
         cerr << "Improperly formatted input: " << playString << endl;
-        return;
+        return false;
     }
     /* If the down is missing, this play is a non-down play like kickoffs
         and extra point attempts. The database deliberately ignores these */
     if (pos == prevPos)
-        return;
-    unsigned short down = (unsigned short)extractNumeric(playString, prevPos, pos);
-
-    /* At this point, have enough information to determine whether this play is wanted
-        or not. It must fall within one of three categories
-        1. Offense matches wanted offense and defense matches wanted offense
-        2. Offense matches wanted offense and defense falls in list of similiar
-            defenses to wanted defense
-        3. Offense falls in list similiar offenses to wanted offense and defense
-            matches wanted defense
-        WARNING: This process is sensitive to both whitespace and capitalization, because
-        its more efficient for the caller to get this right that for this code to deal with
-        matching it. The current set of data files requires ALL CAPS and no whitespace */
-    bool haveMatch = false;
-    if (offense == thisTeam) {
-        if (defense == otherTeam)
-            haveMatch = true;
-        else
-            haveMatch = (find(otherSimiliar.begin(), otherSimiliar.end(), defense) != otherSimiliar.end());
-    } // Offense matches the wanted team
-    else if (defense == otherTeam)
-        haveMatch = (find(thisSimiliar.begin(), thisSimiliar.end(), offense) != thisSimiliar.end());
-    else
-        haveMatch = false;
-    if (!haveMatch)
-        return; // Not a wanted play
-
-    /* If get to here, want the play. Extract remaining data snd insert into the data store.
-        Some of it requires a tricky search of the description field */
+        return false;
+    fields.down = (unsigned short)extractNumeric(playString, prevPos, pos);
+    return true;
+}
 
+/* Extracts the remaining fields of a play line, starting from the comma after the
+    down. Returns false if the line is badly formed */
+bool PlayLoader::extractTrailingFields(const string& playString, string::size_type pos,
+                                       PlayFields& fields)
+{
+    string::size_type prevPos;
     // Eighth category is distance needed, extract it.
     /* NOTE: If this is a non-down play, the distance won't be set either. They
-        are rejected above, so missing the distance here is an error */
+        are rejected before getting here, so missing the distance here is an error */
     prevPos = pos + 1; // Move off  the comma
     pos = playString.find_first_of(',', prevPos);
     if ((pos == string::npos) || (pos == prevPos)) {
         // Indicates badly formed input
         cerr << "Improperly formatted input: " << playString << endl;
-        return;
+        return false;
     }
-    unsigned short distanceNeeded = (unsigned short)extractNumeric(playString, prevPos, pos);
+    fields.distanceNeeded = (unsigned short)extractNumeric(playString, prevPos, pos);
 
     // Ninth category is position on the field, extract it.
     prevPos = pos + 1; // Move off  the comma
     pos = playString.find_first_of(',', prevPos);
     if (pos == string::npos) { // Indicates badly formed input
         cerr << "Improperly formatted input: " << playString << endl;
-        return;
+        return false;
     }
-    unsigned short yardLine = (unsigned short)extractNumeric(playString, prevPos, pos);
+    fields.yardLine = (unsigned short)extractNumeric(playString, prevPos, pos);
 
     // Tenth category is play description. This needs further processing. Extract it here
     prevPos = pos + 1; // Move off  the comma
     pos = playString.find_first_of(',', prevPos);
     if (pos == string::npos) { // Indicates badly formed input
         cerr << "Improperly formatted input: " << playString << endl;
-        return;
+        return false;
     }
-    string description(playString, prevPos, pos - prevPos);
+    fields.description.assign(playString, prevPos, pos - prevPos);
 
      // Eleventh category is offence current score, extract it.
     prevPos = pos + 1; // Move off  the comma
     pos = playString.find_first_of(',', prevPos);
     if (pos == string::npos) { // Indicates badly formed input
         cerr << "Improperly formatted input: " << playString << endl;
-        return;
+        return false;
     }
-    unsigned short ownScore = (unsigned short)extractNumeric(playString, prevPos, pos);
+    fields.ownScore = (unsigned short)extractNumeric(playString, prevPos, pos);
 
     // Twelveth category is defense current score, extract it.
     prevPos = pos + 1; // Move off  the comma
     pos = playString.find_first_of(',', prevPos);
     if (pos == string::npos) { // Indicates badly formed input
         cerr << "Improperly formatted input: " << playString << endl;
-        return;
+        return false;
     }
-    unsigned short oppScore = (unsigned short)extractNumeric(playString, prevPos, pos);
+    fields.oppScore = (unsigned short)extractNumeric(playString, prevPos, pos);
+    return true;
+}
 
-    /* To get play type, yardage gained, and turnover, need to parse the description.
-        Thankfully, it has a standard format */
-    SinglePlay::PlayType playType = SinglePlay::punt;
-    short distanceGained = 0;
-    bool turnedOver = false;
-    unsigned int wordLoc;
+// Reports a play line whose description could not be classified, unless it is a known non-play
+void PlayLoader::reportUnknownPlay(const string& playString, const string& description)
+{
+    /* Certain things indicate non-plays. Check for them. If the descrition
+        does not match any of them, output it as an unknown play type
+        1. Penalties after a play get their own play line
+        2. Kneel downs at the end of the game are ignored; their use is obvious
+        3. Spikes to stop the clock are ignored; their use is  pretty obvious
+        4. Video reviews get their own line
+        5. Some kickoffs mistakenly have a down listed
+    */
+
+    if ((description.find(string("PENALTY")) == string::npos) &&
+        (description.find(string("penalized")) == string::npos) &&
+        (description.find(string("kneels")) == string::npos) &&
+        (description.find(string("spiked")) == string::npos) &&
+        (description.find(string("kicked")) == string::npos) &&
+        (description.find(string(" play under review ")) == string::npos))
+        cerr << "UNKNOWN PLAY TYPE: " << playString << endl;
+}
+
+// Finds the play type, yardage gained, and turnover from a play description. Returns false if not a play
+bool PlayLoader::classifyDescription(const string& description, unsigned short& sackCount,
+                                     SinglePlay::PlayType& playType, short& distanceGained,
+                                     bool& turnedOver)
+{
+    /* Descriptions have a standard format, thankfully. Search for key phrases
+        in order, stopping at the first one that matches */
+    string::size_type wordLoc;
     bool havePlay = false;
 
     // ' pass ' or ' passed ' indicates a pass play
@@ -380,26 +476,7 @@ void PlayLoader::processPlay(const string& playString, const string& thisTeam, c
         wordLoc = description.find(string(" sacked "));
         if (wordLoc != string::npos) {
             wordLoc += 8; // Move to next word
-            switch (sackCount % 6) {
-            case 0:
-                playType = SinglePlay::pass_short_left;
-                break;
-            case 1:
-                playType = SinglePlay::pass_short_middle;
-                break;
-            case 2:
-                playType = SinglePlay::pass_short_right;
-                break;
-            case 3:
-                playType = SinglePlay::pass_deep_left;
-                break;
-            case 4:
-                playType = SinglePlay::pass_deep_middle;
-                break;
-            case 5:
-                playType = SinglePlay::pass_deep_right;
-                break;
-            } // Switch on number of processed sacks
+            playType = rotatedPassType(sackCount);
             sackCount++;
             extractPlayYardageTurnover(description, wordLoc, distanceGained, turnedOver);
             havePlay = true;
@@ -417,7 +494,7 @@ void PlayLoader::processPlay(const string& playString, const string& thisTeam, c
             if (description[wordLoc] != ' ')
                 wordLoc++; // On 'd '
             wordLoc++; // Move off space
-            unsigned int nextWordLoc = description.find(' ', wordLoc);
+            string::size_type nextWordLoc = description.find(' ', wordLoc);
             distanceGained = extractNumeric(description, wordLoc, nextWordLoc);
             turnedOver = false; // Successful punts are not considered turnovers
             havePlay = true;
@@ -433,7 +510,7 @@ void PlayLoader::processPlay(const string& playString, const string& thisTeam, c
             playType = SinglePlay::field_goal;
             if (description.compare(wordLoc + 12, 7, string("is GOOD")) == 0) {
                 wordLoc = description.rfind(' ', wordLoc - 1); // Skip over 'yard'
-                unsigned int prevWordLoc = description.rfind(' ', wordLoc - 1);
+                string::size_type prevWordLoc = description.rfind(' ', wordLoc - 1);
                 distanceGained = extractNumeric(description, prevWordLoc + 1, wordLoc);
             }
             else
@@ -452,26 +529,7 @@ void PlayLoader::processPlay(const string& playString, const string& thisTeam, c
             play types. */
         wordLoc = description.find(string(" FUMBLES (Aborted) "));
         if (wordLoc != string::npos) {
-            switch (sackCount % 6) {
-            case 0:
-                playType = SinglePlay::pass_short_left;
-                break;
-            case 1:
-                playType = SinglePlay::pass_short_middle;
-                break;
-            case 2:
-                playType = SinglePlay::pass_short_right;
-                break;
-            case 3:
-                playType = SinglePlay::pass_deep_left;
-                break;
-            case 4:
-                playType = SinglePlay::pass_deep_middle;
-                break;
-            case 5:
-                playType = SinglePlay::pass_deep_right;
-                break;
-            } // Switch on number of processed sacks
+            playType = rotatedPassType(sackCount);
             sackCount++;
             distanceGained = 0;
             turnedOver = true;
@@ -533,46 +591,24 @@ void PlayLoader::processPlay(const string& playString, const string& thisTeam, c
         if (wordLoc != string::npos) {
             playType = SinglePlay::run_middle;
             wordLoc += 6;
-            unsigned int nextWordLoc = description.find(' ', wordLoc);
+            string::size_type nextWordLoc = description.find(' ', wordLoc);
             distanceGained = extractNumeric(description, wordLoc, nextWordLoc);
             distanceGained *= -1; // Play had negative yardage
             turnedOver = false;
             havePlay = true;
         } // Have negative running play
     } // No play yet
-
-    // If found a play at this point, insert it in the data store
-    if (havePlay)
-        dataStore.insertPlay(playType, down, distanceNeeded, yardLine, minutes,
-                             ownScore, oppScore, distanceGained, turnedOver);
-    else {
-        /* Certain things indicate non-plays. Check for them. If the descrition
-            does not match any of them, output it as an unknown play type
-            1. Penalties after a play get their own play line
-            2. Kneel downs at the end of the game are ignored; their use is obvious
-            3. Spikes to stop the clock are ignored; their use is  pretty obvious
-            4. Video reviews get their own line
-            5. Some kickoffs mistakenly have a down listed
-        */
-
-        if ((description.find(string("PENALTY")) == string::npos) &&
-            (description.find(string("penalized")) == string::npos) &&
-            (description.find(string("kneels")) == string::npos) &&
-            (description.find(string("spiked")) == string::npos) &&
-            (description.find(string("kicked")) == string::npos) &&
-            (description.find(string(" play under review ")) == string::npos))
-            cerr << "UNKNOWN PLAY TYPE: " << playString << endl;
-    } // Not a known play type
+    return havePlay;
 }
 
 // Finds the yardage achieved from a play, and whether the ball was fumbled
-void PlayLoader::extractPlayYardageTurnover(const string& description, unsigned int pos,
+void PlayLoader::extractPlayYardageTurnover(const string& description, string::size_type pos,
                                             short& distanceGained, bool& turnedOver)
 {
     // Yards gained always appears as ' for XXX yards'. Search for the ' for ' to find it
-    unsigned int wordLoc = description.find(string(" for "), pos);
+    string::size_type wordLoc = description.find(string(" for "), pos);
     wordLoc += 5; // Skip over string
-    unsigned int nextWordLoc = description.find(' ', wordLoc);
+    string::size_type nextWordLoc = description.find(' ', wordLoc);
     // Plays of zero yards are listed as 'no gain'. Need to check for 'no '
     if (description.compare(wordLoc, nextWordLoc - wordLoc, string("no ")) == 0)
         distanceGained = 0;
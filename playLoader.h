@@ -60,29 +60,84 @@ public:
                    const vector<string>& thisSimiliar, const vector<string>& otherSimiliar,
                    unsigned short yearRange, DataStore& dataStore);
 
+    // Loads plays for an explicit range of seasons into a data store. Range is [first...last]
+    void loadPlays(const string& thisTeam, const string& otherTeam,
+                   const vector<string>& thisSimiliar, const vector<string>& otherSimiliar,
+                   unsigned short firstYear, unsigned short lastYear, DataStore& dataStore);
+
+    /* Loads the wanted plays of one season into a batch, after any already there, for
+        stores filled a season at a time. Busted pass plays get their types as though the
+        season were loaded on its own, as loadPlays() does */
+    void loadSeason(const string& thisTeam, const string& otherTeam,
+                    const vector<string>& thisSimiliar, const vector<string>& otherSimiliar,
+                    unsigned short seasonYear, PlayBatch& batch);
+
+    // Finds the seasons loaded for a range of the most recent seasons
+    static void getRecentSeasons(unsigned short yearRange, unsigned short& firstYear,
+                                 unsigned short& lastYear);
+
+    // Returns the name of the data file for a season in a directory
+    static string getSeasonFileName(const string& directory, unsigned short seasonYear);
+
+    /* Busted pass plays, like sacks, don't say what pass was called. They are evenly
+        divided between the pass play types in the order they appear in a season. Returns
+        the type for the busted pass play with the passed number */
+    static SinglePlay::PlayType rotatedPassType(unsigned short sackCount);
+
 private:
+    // The kernel benchmark times the private parsing methods directly
+    friend class KernelAccess;
+    // The league store reads every play of a season, so it uses the parsing methods as well
+    friend class LeagueStore;
+
+    // Fields of a single line of a data file
+    struct PlayFields {
+        unsigned short minutes;
+        string offense;
+        string defense;
+        unsigned short down;
+        unsigned short distanceNeeded;
+        unsigned short yardLine;
+        string description;
+        unsigned short ownScore;
+        unsigned short oppScore;
+    };
+
     // File to load plays from. Inside class to ensure always released
     ifstream _playFile;
     string _directory; // Where to file data files
 
-    // Loads plays for the wanted teams for one season into the data store
-    /* WARNING: Does NOT generate index data! */
-    void loadSingleSeason(const string& thisTeam, const string& otherTeam,
-                          const vector<string>& thisSimiliar,
-                          const vector<string>& otherSimiliar,
-                          unsigned short seasonYear,
-                          DataStore& dataStore);
+    // Opens the data file for a season, throwing if it does not exist
+    void openSeasonFile(unsigned short seasonYear);
 
-    // Process a single play from a data file
+    // Process a single play from a data file, adding it to the batch if it is wanted
     void processPlay(const string& playString, const string& thisTeam, const string& otherTeam,
                      const vector<string>& thisSimiliar, const vector<string>& otherSimiliar,
-                     unsigned short& sackCount, DataStore& dataStore);
+                     unsigned short& sackCount, PlayBatch& batch);
+
+    /* Extracts the fields of a play line needed to decide whether it is wanted, up to
+        and including the down. Returns false if the line is badly formed or is not a
+        down play. Pos is left on the comma after the down */
+    bool extractLeadingFields(const string& playString, PlayFields& fields, string::size_type& pos);
+
+    /* Extracts the remaining fields of a play line, starting from the comma after the
+        down. Returns false if the line is badly formed */
+    bool extractTrailingFields(const string& playString, string::size_type pos, PlayFields& fields);
+
+    // Reports a play line whose description could not be classified, unless it is a known non-play
+    void reportUnknownPlay(const string& playString, const string& description);
+
+    /* Finds the play type, yardage gained, and turnover from a play description.
+        Returns false if the description is not a play */
+    bool classifyDescription(const string& description, unsigned short& sackCount,
+                             SinglePlay::PlayType& playType, short& distanceGained,
+                             bool& turnedOver);
 
     // Extracts numeric data from the passed position of the input string. Range is [start...end)
-    short extractNumeric(const string& playString, unsigned int startPos, unsigned int endPos);
+    short extractNumeric(const string& playString, string::size_type startPos, string::size_type endPos);
 
     // Finds the yardage achieved from a play, and whether the ball was fumbled
-    void extractPlayYardageTurnover(const string& description, unsigned int pos,
+    void extractPlayYardageTurnover(const string& description, string::size_type pos,
                                     short& distanceGained, bool& turnedOver);
 
     // Prohibit copying, which screws up the file buffer
@@ -93,22 +148,66 @@ private:
 inline void PlayLoader::loadPlays(const string& thisTeam, const string& otherTeam,
                                   const vector<string>& thisSimiliar, const vector<string>& otherSimiliar,
                                   unsigned short yearRange, DataStore& dataStore)
+{
+    unsigned short firstYear;
+    unsigned short lastYear;
+    getRecentSeasons(yearRange, firstYear, lastYear);
+    loadPlays(thisTeam, otherTeam, thisSimiliar, otherSimiliar, firstYear, lastYear, dataStore);
+}
+
+// Finds the seasons loaded for a range of the most recent seasons
+inline void PlayLoader::getRecentSeasons(unsigned short yearRange, unsigned short& firstYear,
+                                         unsigned short& lastYear)
 {
     /* FUTURE DEVELOPMENT: Should use file system calls to find the range of years with play
         data. This routine hardcodes it */
-    unsigned short firstYear = 2008;
-    unsigned short lastYear = 2011;
+    firstYear = 2008;
+    lastYear = 2011;
     if (lastYear - yearRange + 1 > firstYear)
         firstYear = lastYear - yearRange + 1;
+}
+
+// Loads plays for an explicit range of seasons into a data store. Range is [first...last]
+inline void PlayLoader::loadPlays(const string& thisTeam, const string& otherTeam,
+                                  const vector<string>& thisSimiliar, const vector<string>& otherSimiliar,
+                                  unsigned short firstYear, unsigned short lastYear, DataStore& dataStore)
+{
+    /* Most recent seasons are loaded first, matching the order the original code used. Each
+        is inserted into the data store once it is read */
+    PlayBatch batch;
     unsigned short yearCounter;
-    for (yearCounter = lastYear; yearCounter >= firstYear; yearCounter--)
-        loadSingleSeason(thisTeam, otherTeam, thisSimiliar, otherSimiliar, yearCounter, dataStore);
+    for (yearCounter = lastYear; yearCounter >= firstYear; yearCounter--) {
+        batch.clear();
+        loadSeason(thisTeam, otherTeam, thisSimiliar, otherSimiliar, yearCounter, batch);
+        dataStore.insertPlays(batch);
+    }
     dataStore.buildIndexes();
 }
 
+/* Busted pass plays, like sacks, don't say what pass was called. They are evenly
+    divided between the pass play types in the order they appear in a season. Returns
+    the type for the busted pass play with the passed number */
+inline SinglePlay::PlayType PlayLoader::rotatedPassType(unsigned short sackCount)
+{
+    switch (sackCount % 6) {
+    case 0:
+        return SinglePlay::pass_short_left;
+    case 1:
+        return SinglePlay::pass_short_middle;
+    case 2:
+        return SinglePlay::pass_short_right;
+    case 3:
+        return SinglePlay::pass_deep_left;
+    case 4:
+        return SinglePlay::pass_deep_middle;
+    default:
+        return SinglePlay::pass_deep_right;
+    } // Switch on number of processed sacks
+}
+
 // Extracts numeric data from the passed position of the input string. Range is [start...end)
-inline short PlayLoader::extractNumeric(const string& playString, unsigned int startPos,
-                                        unsigned int endPos)
+inline short PlayLoader::extractNumeric(const string& playString, string::size_type startPos,
+                                        string::size_type endPos)
 {
     // This is not the cleanest way to do this, but it is the fastest
     return atoi(string(playString, startPos, endPos - startPos).c_str());
@@ -29,35 +29,48 @@
 #include"singlePlay.h"
 #include"playIndexSet.h"
 #include"playStats.h"
+#include"baseException.h"
 
 using std::make_pair;
 
-OverallPlaySummary::OverallPlaySummary(const DistanceVector& playDistances, short turnoverCount)
+OverallPlaySummary::OverallPlaySummary(const DistanceVector& playDistances, long turnoverCount)
+{
+    calculate(playDistances.empty() ? NULL : &playDistances[0], playDistances.size(), turnoverCount);
+}
+
+// Same as above, for distances held in an array
+OverallPlaySummary::OverallPlaySummary(const short* playDistances, long playCount, long turnoverCount)
+{
+    calculate(playDistances, playCount, turnoverCount);
+}
+
+// Calculates the statistics for a set of plays. Called by the constructors
+void OverallPlaySummary::calculate(const short* playDistances, long playCount, long turnoverCount)
 {
     // Calculate the stats from the data about the play
-    _totalCount = playDistances.size();
+    _totalCount = playCount;
     if (_totalCount > 0) {
         // Turnover percentage is in tenth of percent
         _turnoverPercentage = (turnoverCount * 1000) / _totalCount;
 
         // Sum the distance gained on all plays
-        short totalDistance = 0;
-        DistanceVector::const_iterator index;
-        for (index = playDistances.begin(); index != playDistances.end(); index++)
-            totalDistance += *index;
+        long totalDistance = 0;
+        long index;
+        for (index = 0; index < playCount; index++)
+            totalDistance += playDistances[index];
 
         _averageDistance = totalDistance / _totalCount;
 
         /* To calculate the variance, need the square of the distance between
-            the average and each value. Calculate using ints to avoid overflow */
-        int totalVariance = 0;
-        for (index = playDistances.begin(); index != playDistances.end(); index++)
-            totalVariance += ((int)(*index - _averageDistance) *
-                              (int)(*index - _averageDistance));
+            the average and each value. Calculate using longs to avoid overflow */
+        long totalVariance = 0;
+        for (index = 0; index < playCount; index++)
+            totalVariance += ((long)(playDistances[index] - _averageDistance) *
+                              (long)(playDistances[index] - _averageDistance));
 
         totalVariance /= _totalCount;
 
-        _distanceVariance = (short)sqrt(totalVariance);
+        _distanceVariance = (short)sqrt((double)totalVariance);
     }
     else {
         _averageDistance = 0;
@@ -66,37 +79,89 @@ OverallPlaySummary::OverallPlaySummary(const DistanceVector& playDistances, shor
     }
 }
 
-// Constructor
-DetailedPlaySummary::DetailedPlaySummary(const DistanceVector& playDistances, short turnoverCount,
-                                         short conditionPlayCount,
-                                         const OverallPlaySummary& overallTypeStatistics)
-    : _playDistances(playDistances), _turnoverCount(turnoverCount),
-      _groupStats(playDistances, turnoverCount), _overallStats(overallTypeStatistics)
+// Restores a summary from its statistics, such as one saved with a column store
+OverallPlaySummary::OverallPlaySummary(short averageDistance, short distanceVariance,
+                                       short turnoverPercentage, long totalCount)
+    : _averageDistance(averageDistance), _distanceVariance(distanceVariance),
+      _turnoverPercentage(turnoverPercentage), _totalCount(totalCount)
+{
+    // All in the initialization list
+}
+
+// Creates an empty pool
+DistancePool::DistancePool()
+    : _distances()
+{
+    // All in the initialization list
+}
+
+// Adds a set of distances, sorted, and returns where they start
+unsigned int DistancePool::add(const DistanceVector& distances)
+{
+    unsigned int start = _distances.size();
+    _distances.insert(_distances.end(), distances.begin(), distances.end());
+    sort(_distances.begin() + start, _distances.end());
+    return start;
+}
+
+// Adds a copy of sorted distances from another pool, and returns where they start
+unsigned int DistancePool::add(const short* distances, long distanceCount)
 {
-    sort(_playDistances.begin(), _playDistances.end());
+    unsigned int start = _distances.size();
+    _distances.insert(_distances.end(), distances, distances + distanceCount);
+    return start;
+}
+
+/* Adds the merge of two sets of sorted distances already in the pool, and returns
+    where the result starts */
+unsigned int DistancePool::merge(unsigned int firstStart, long firstCount, unsigned int secondStart,
+                                 long secondCount)
+{
+    /* Grow the pool first, since that can move it. The sources are all before the old
+        end, so they never overlap the result */
+    unsigned int start = _distances.size();
+    _distances.resize(start + firstCount + secondCount);
+    std::merge(_distances.begin() + firstStart, _distances.begin() + firstStart + firstCount,
+               _distances.begin() + secondStart, _distances.begin() + secondStart + secondCount,
+               _distances.begin() + start);
+    return start;
+}
 
+/* Constructor. The distances are added to the pool, which must outlive the summary
+    and any copies of it */
+DetailedPlaySummary::DetailedPlaySummary(const DistanceVector& playDistances, long turnoverCount,
+                                         long conditionPlayCount,
+                                         const OverallPlaySummary& overallTypeStatistics,
+                                         DistancePool& distancePool)
+    : _distancePool(&distancePool), _distanceStart(distancePool.add(playDistances)),
+      _playCount(playDistances.size()), _turnoverCount(turnoverCount),
+      _groupStats(playDistances, turnoverCount), _overallStats(overallTypeStatistics)
+{
     // Calculate percentages
-    _percentOfConditionPlays = ((short)_playDistances.size() * 1000) / conditionPlayCount;
-    _percentOfTypePlays = ((short)_playDistances.size() * 1000) / overallTypeStatistics.getTotalCount();
+    _percentOfConditionPlays = (_playCount * 1000) / conditionPlayCount;
+    _percentOfTypePlays = (_playCount * 1000) / overallTypeStatistics.getTotalCount();
 }
 
 /* Merge one summary into another. Used when combining statistics from
     similiar conditions */
-void DetailedPlaySummary::merge(const DetailedPlaySummary& other, short totalMergedPlays)
+void DetailedPlaySummary::merge(const DetailedPlaySummary& other, long totalMergedPlays)
 {
     /* WARNING: If statistics are merged for different types of plays, the results will
         be meaningless */
     // Overall data stays the same
 
-    _playDistances.insert(_playDistances.end(), other._playDistances.begin(),
-                          other._playDistances.end());
-    sort(_playDistances.begin(), _playDistances.end());
+    /* Both sets of distances are sorted, so merging them keeps them that way. The old
+        ones stay in the pool until it is compacted, since copies may still use them */
+    if (other._distancePool != _distancePool)
+        throw BaseException(__FILE__, __LINE__, "Play summary merge failed, summaries from different trees");
+    _distanceStart = _distancePool->merge(_distanceStart, _playCount, other._distanceStart, other._playCount);
+    _playCount += other._playCount;
     _turnoverCount += other._turnoverCount;
     // Calculate new statistics based on the combined play data
-    _groupStats = OverallPlaySummary(_playDistances, _turnoverCount);
+    _groupStats = OverallPlaySummary(getPlayDistances(), _playCount, _turnoverCount);
 
     // Calculate new percentages
-    _percentOfTypePlays = ((short)_playDistances.size() * 1000) / _overallStats.getTotalCount();
+    _percentOfTypePlays = (_playCount * 1000) / _overallStats.getTotalCount();
     updateConditionStats(totalMergedPlays);
 }
 
@@ -107,7 +172,7 @@ void PlaySummaryFactory::buildSummaryData(const PlayIndexSet& indexes, OverallSu
 
     // Assemble statistics about plays
     vector<DistanceVector> distances(SinglePlay::getPlayTypeCount());
-    vector<short> turnoverCounts(SinglePlay::getPlayTypeCount());
+    vector<long> turnoverCounts(SinglePlay::getPlayTypeCount());
     indexesToCounts(indexes, distances, turnoverCounts);
 
     // Convert to summary by play type
@@ -116,18 +181,56 @@ void PlaySummaryFactory::buildSummaryData(const PlayIndexSet& indexes, OverallSu
         data.push_back(OverallPlaySummary(distances[index3], turnoverCounts[index3]));
 }
 
+/* Same as above, from running totals of the plays of each type: their number, the sums
+    of their distances and squared distances, and their turnovers. Used when plays are
+    streamed instead of held. The summaries are exactly those built from the plays */
+void PlaySummaryFactory::buildSummaryData(const vector<long>& playCounts, const vector<long>& distanceSums,
+                                          const vector<long long>& distanceSquares,
+                                          const vector<long>& turnoverCounts, OverallSummaryData& data)
+{
+    data.clear();
+    unsigned short playType;
+    for (playType = 0; playType < playCounts.size(); playType++) {
+        long playCount = playCounts[playType];
+        if (playCount == 0) {
+            data.push_back(OverallPlaySummary((short)0, (short)0, (short)0, 0L));
+            continue;
+        }
+        /* The same integer arithmetic as OverallPlaySummary::calculate(). Its sum of squared
+            differences from the truncated average a expands to Q - 2aS + na^2, so the
+            totals give exactly the same result */
+        short averageDistance = distanceSums[playType] / playCount;
+        long long totalVariance = distanceSquares[playType] -
+                                  (2LL * averageDistance * distanceSums[playType]) +
+                                  ((long long)playCount * averageDistance * averageDistance);
+        totalVariance /= playCount;
+        data.push_back(OverallPlaySummary(averageDistance, (short)sqrt((double)totalVariance),
+                                          (short)((turnoverCounts[playType] * 1000) / playCount), playCount));
+    } // Loop through play types
+}
+
 // Create detailed data from a snapshot of the data store, and the summary of the overall data
 void PlaySummaryFactory::buildDetailedData(const PlayIndexSet& indexes, const OverallSummaryData& overallData,
-                                           DetailedPlayData& detailedData)
+                                           DistancePool& distancePool, DetailedPlayData& detailedData)
 {
-    detailedData.clear();
     // Assemble statistics about plays
     vector<DistanceVector> distances(SinglePlay::getPlayTypeCount());
-    vector<short> turnoverCounts(SinglePlay::getPlayTypeCount());
+    vector<long> turnoverCounts(SinglePlay::getPlayTypeCount());
     indexesToCounts(indexes, distances, turnoverCounts);
+    buildDetailedData(distances, turnoverCounts, overallData, distancePool, detailedData);
+}
+
+/* Same as above, from distances and turnover counts already assembled by play type.
+    Used when the plays are not in a data store */
+void PlaySummaryFactory::buildDetailedData(const vector<DistanceVector>& distances,
+                                           const vector<long>& turnoverCounts,
+                                           const OverallSummaryData& overallData,
+                                           DistancePool& distancePool, DetailedPlayData& detailedData)
+{
+    detailedData.clear();
 
     /* If distances were found, convert the play data to a summary and insert */
-    short totalPlayCount = 0;
+    long totalPlayCount = 0;
     unsigned short index3;
     // Find total number of plays in index, which is the number of distances returned
     for (index3 = 0; index3 < distances.size(); index3++)
@@ -137,11 +240,12 @@ void PlaySummaryFactory::buildDetailedData(const PlayIndexSet& indexes, const Ov
         if (!distances[index3].empty())
             detailedData.insert(make_pair((SinglePlay::PlayType)index3,
                                           DetailedPlaySummary(distances[index3], turnoverCounts[index3],
-                                                              totalPlayCount, overallData.at(index3))));
+                                                              totalPlayCount, overallData.at(index3),
+                                                              distancePool)));
 }
 
 void PlaySummaryFactory::indexesToCounts(const PlayIndexSet& indexes, vector<DistanceVector>& distances,
-                                         vector<short>& turnoverCounts)
+                                         vector<long>& turnoverCounts)
 {
     // If indexes have no data, routine has nothing to do
     if (indexes.getIndexesAvailable().empty())
@@ -169,7 +273,7 @@ void PlaySummaryFactory::mergeData(DetailedPlayData& result, const DetailedPlayD
     // Find the total number of plays in the combined summaries, needed below
     DetailedPlayData::iterator resultPtr;
     DetailedPlayData::const_iterator otherPtr;
-    short playCount = 0;
+    long playCount = 0;
     for (resultPtr = result.begin(); resultPtr != result.end(); resultPtr++)
         playCount += resultPtr->second.getPlayCount();
     for (otherPtr = other.begin(); otherPtr != other.end(); otherPtr++)
@@ -35,50 +35,107 @@ typedef vector<short> DistanceVector;
 
 class OverallPlaySummary {
 public:
-    OverallPlaySummary(const DistanceVector& playDistances, short turnoverCount);
+    OverallPlaySummary(const DistanceVector& playDistances, long turnoverCount);
+    // Same as above, for distances held in an array
+    OverallPlaySummary(const short* playDistances, long playCount, long turnoverCount);
+    // Restores a summary from its statistics, such as one saved with a column store
+    OverallPlaySummary(short averageDistance, short distanceVariance, short turnoverPercentage,
+                       long totalCount);
     // Use default copy constructor, assignment operator, and destructor
 
     // Getters
     short getAverageDistance() const;
     short getDistanceVariance() const;
     short getTurnoverPercentage() const;
-    short getTotalCount() const;
+    long getTotalCount() const;
 
 private:
     short _averageDistance; // Distance gained on play
     short _distanceVariance;
     short _turnoverPercentage;
-    short _totalCount;
+    long _totalCount;
+
+    // Calculates the statistics for a set of plays. Called by the constructors
+    void calculate(const short* playDistances, long playCount, long turnoverCount);
 };
 
 /* A full set of play data with one missing will be very rare, so use a vector
     indexed by play type to represent a collection of overall summary records */
 typedef vector<OverallPlaySummary> OverallSummaryData;
 
+/* Distances gained for the plays of many detailed summaries, held in one array. A tree
+    has hundreds of leaves with several play types each, and giving every summary its own
+    vector meant thousands of tiny allocations, with more each time pruning merged two of
+    them. Instead, each summary holds the start of its distances in the pool of its tree,
+    and the number of them. Distances are never changed once added, so copies of a summary
+    can share them.
+
+    Merging two summaries adds the merged distances to the end of the pool, leaving the
+    old ones unused. The tree compacts its pool once pruning is done, copying the distances
+    still in use into a new array in tree order, so the statistics for the whole tree end
+    up in one contiguous block */
+class DistancePool {
+public:
+    // Creates an empty pool
+    DistancePool();
+
+    // Use default copy constructor, assignment operator, and destructor
+
+    // Adds a set of distances, sorted, and returns where they start
+    unsigned int add(const DistanceVector& distances);
+
+    // Adds a copy of sorted distances from another pool, and returns where they start
+    unsigned int add(const short* distances, long distanceCount);
+
+    /* Adds the merge of two sets of sorted distances already in the pool, and returns
+        where the result starts */
+    unsigned int merge(unsigned int firstStart, long firstCount, unsigned int secondStart, long secondCount);
+
+    // Returns the distances starting at a given place
+    const short* getDistances(unsigned int start) const;
+
+    // Number of distances held, including ones no longer used
+    unsigned int getSize() const;
+
+    // Exchanges contents with another pool. Used to replace a pool with a compacted copy
+    void swap(DistancePool& other);
+
+private:
+    DistanceVector _distances;
+};
+
 // Detailed statistics about a group of plays of some type
 class DetailedPlaySummary {
 public:
-    DetailedPlaySummary(const DistanceVector& playDistances, short turnoverCount,
-                        short conditionPlayCount,
-                        const OverallPlaySummary& overallTypeStatistics);
+    /* Constructor. The distances are added to the pool, which must outlive the summary
+        and any copies of it */
+    DetailedPlaySummary(const DistanceVector& playDistances, long turnoverCount,
+                        long conditionPlayCount,
+                        const OverallPlaySummary& overallTypeStatistics,
+                        DistancePool& distancePool);
 
     // Use default copy constructor, assignment operator, and destructor
 
     /* Merge one summary into another. Used when combining statistics from
         similiar conditions */
-    void merge(const DetailedPlaySummary& other, short totalMergedPlays);
+    void merge(const DetailedPlaySummary& other, long totalMergedPlays);
 
     /* Changes the percentages for a given condition, to account for merges
         where the other set has no plays of this type */
-    void updateConditionStats(short totalMergedPlays);
+    void updateConditionStats(long totalMergedPlays);
+
+    /* Moves the distances to a new place in the same pool. Used when the pool is
+        compacted, and the caller must have copied them there already */
+    void relocateDistances(unsigned int distanceStart);
 
     // Getters
-    const DistanceVector& getPlayDistances() const;
+    // Distances of the plays, sorted. There are getPlayCount() of them
+    const short* getPlayDistances() const;
     short getAverageDistance() const; // Statistics on the above
     short getDistanceVariance() const;
 
-    short getPlayCount() const; // Number of plays of this type in these conditions
-    short getTurnoverCount() const; // Number of these plays turned over
+    long getPlayCount() const; // Number of plays of this type in these conditions
+    long getTurnoverCount() const; // Number of these plays turned over
     short getTurnoverPercentage() const; // In 0.1%
 
     // Play type as a percentage of plays for the given set of conditions
@@ -92,8 +149,12 @@ public:
     short getOverallTurnoverPercentage() const;
 
 private:
-    DistanceVector _playDistances;
-    short _turnoverCount; // Number of these plays turned over
+    // Distances of the plays, in the pool
+    DistancePool* _distancePool;
+    unsigned int _distanceStart;
+    long _playCount;
+
+    long _turnoverCount; // Number of these plays turned over
     // Statistics for plays in this group
     OverallPlaySummary _groupStats;
 
@@ -120,7 +181,21 @@ class PlaySummaryFactory {
 public:
     static void buildSummaryData(const PlayIndexSet& indexes, OverallSummaryData& data);
 
+    /* Same as above, from running totals of the plays of each type: their number, the sums
+        of their distances and squared distances, and their turnovers. Used when plays are
+        streamed instead of held. The summaries are exactly those built from the plays */
+    static void buildSummaryData(const vector<long>& playCounts, const vector<long>& distanceSums,
+                                 const vector<long long>& distanceSquares, const vector<long>& turnoverCounts,
+                                 OverallSummaryData& data);
+
+    // Distances of the plays are added to the pool
     static void buildDetailedData(const PlayIndexSet& indexes, const OverallSummaryData& overallData,
+                                  DistancePool& distancePool, DetailedPlayData& detailedData);
+
+    /* Same as above, from distances and turnover counts already assembled by play type.
+        Used when the plays are not in a data store */
+    static void buildDetailedData(const vector<DistanceVector>& distances, const vector<long>& turnoverCounts,
+                                  const OverallSummaryData& overallData, DistancePool& distancePool,
                                   DetailedPlayData& detailedData);
 
     // Merges two sets of play summaries together
@@ -130,7 +205,7 @@ private:
     // Assemble data about plays within an index, indexed by play type
     // WARNING: Vectors must be properly sized to number of play types beforehand
     static void indexesToCounts(const PlayIndexSet& indexes, vector<DistanceVector>& distances,
-                                vector<short>& turnoverCounts);
+                                vector<long>& turnoverCounts);
 };
 
 // Output operator
@@ -145,18 +220,25 @@ inline short OverallPlaySummary::getDistanceVariance() const
 inline short OverallPlaySummary::getTurnoverPercentage() const
 { return _turnoverPercentage; }
 
-inline short OverallPlaySummary::getTotalCount() const
+inline long OverallPlaySummary::getTotalCount() const
 { return _totalCount; }
 
 /* Changes the percentages for a given condition, to account for merges
     where the other set has no plays of this type */
-inline void DetailedPlaySummary::updateConditionStats(short totalMergedPlays)
+inline void DetailedPlaySummary::updateConditionStats(long totalMergedPlays)
+{
+    _percentOfConditionPlays = (_playCount * 1000) / totalMergedPlays;
+}
+
+/* Moves the distances to a new place in the same pool. Used when the pool is
+    compacted, and the caller must have copied them there already */
+inline void DetailedPlaySummary::relocateDistances(unsigned int distanceStart)
 {
-    _percentOfConditionPlays = ((short)_playDistances.size() * 1000) / totalMergedPlays;
+    _distanceStart = distanceStart;
 }
 
-inline const DistanceVector& DetailedPlaySummary::getPlayDistances() const
-{ return _playDistances ; }
+inline const short* DetailedPlaySummary::getPlayDistances() const
+{ return _distancePool->getDistances(_distanceStart); }
 
 inline short DetailedPlaySummary::getAverageDistance() const
 { return _groupStats.getAverageDistance() ; }
@@ -164,10 +246,10 @@ inline short DetailedPlaySummary::getAverageDistance() const
 inline short DetailedPlaySummary::getDistanceVariance() const
 { return _groupStats.getDistanceVariance() ; }
 
-inline short DetailedPlaySummary::getPlayCount() const
-{ return _playDistances.size(); }
+inline long DetailedPlaySummary::getPlayCount() const
+{ return _playCount; }
 
-inline short DetailedPlaySummary::getTurnoverCount() const
+inline long DetailedPlaySummary::getTurnoverCount() const
 { return _turnoverCount; }
 
 inline short DetailedPlaySummary::getTurnoverPercentage() const
@@ -190,3 +272,22 @@ inline short DetailedPlaySummary::getOverallDistanceVariance() const
 
 inline short DetailedPlaySummary::getOverallTurnoverPercentage() const
 { return _overallStats.getTurnoverPercentage(); }
+
+// Returns the distances starting at a given place
+inline const short* DistancePool::getDistances(unsigned int start) const
+{
+    // An empty pool has nowhere to point, and nothing in it to read
+    return _distances.empty() ? NULL : (&_distances[0] + start);
+}
+
+// Number of distances held, including ones no longer used
+inline unsigned int DistancePool::getSize() const
+{
+    return _distances.size();
+}
+
+// Exchanges contents with another pool. Used to replace a pool with a compacted copy
+inline void DistancePool::swap(DistancePool& other)
+{
+    _distances.swap(other._distances);
+}
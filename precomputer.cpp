@@ -0,0 +1,262 @@
+/* This file is part of NFLdecisionTree. It creates decision trees to classify
+    situations within NFL football games, and displays the plays historically
+    called in those situations given a set of opponents.
+
+    Copyright (C) 2013   Ezra Erb
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 3 as published
+    by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    I'd appreciate a note if you find this program useful or make
+    updates. Please contact me through LinkedIn (my profile also has
+    a link to the code depository)
+*/
+#include<string>
+#include<vector>
+#include<map>
+#include<algorithm>
+#include<fstream>
+#include<sstream>
+#include<iostream>
+#include<chrono>
+#include<thread>
+#include<ctime>
+#include<cstring>
+
+#include"baseException.h"
+#include"singlePlay.h" // Needed by playIndexSet.h
+#include"playIndexSet.h" // Needed by dataStore.h
+#include"playStats.h" // Needed by dataStore.h
+#include"allocTracker.h" // Needed by dataStore.h
+#include"dataStore.h"
+#include"playLoader.h" // Needed by leagueStore.h
+#include"leagueStore.h"
+#include"decisionNode.h"
+#include"resultWriter.h"
+#include"treeCache.h"
+#include"precomputer.h"
+#include"traceLog.h"
+
+#ifndef _WIN32
+#include<sys/resource.h>
+#endif
+#ifdef __linux__
+#include<sched.h>
+#endif
+
+using std::string;
+using std::vector;
+using std::map;
+using std::ifstream;
+using std::stringstream;
+using std::endl;
+using std::getline;
+
+// Returns whether a line of an input file holds nothing to read
+static bool isIgnoredLine(const string& line)
+{
+    string::size_type firstChar = line.find_first_not_of(" \t\r");
+    return ((firstChar == string::npos) || (line[firstChar] == '#'));
+}
+
+// Throws an error about a line of an input file
+static void throwLineError(const char* file, int line, const string& fileName, unsigned int lineNumber)
+{
+    stringstream errorMessage;
+    errorMessage << "Could not read line " << lineNumber << " of " << fileName;
+    throw BaseException(file, line, errorMessage.str().c_str());
+}
+
+/* Constructor. The league store must be attached, and both it and the cache must outlast
+    this object. The data source says where the league's plays came from, for cache keys */
+Precomputer::Precomputer(const LeagueStore& league, const TreeCache& cache, const string& dataSource)
+    : _league(league), _cache(cache), _dataSource(dataSource), _matchups(), _presets()
+{
+    // All in the initialization list
+}
+
+// Reads the similiar teams for each team from a preset file
+void Precomputer::readPresets(const string& fileName)
+{
+    ifstream presetFile(fileName.c_str());
+    if (!presetFile.is_open())
+        throw BaseException(__FILE__, __LINE__, "Could not open preset file");
+    string line;
+    unsigned int lineNumber = 0;
+    while (getline(presetFile, line)) {
+        lineNumber++;
+        if (isIgnoredLine(line))
+            continue;
+        stringstream fields(line);
+        string team;
+        fields >> team;
+        // A later line for the same team replaces an earlier one
+        vector<string>& similiar = _presets[team];
+        similiar.clear();
+        string similiarTeam;
+        while (fields >> similiarTeam)
+            similiar.push_back(similiarTeam);
+    }
+}
+
+/* Reads the games from a schedule file, keeping those on or after a date given as
+    YYYY-MM-DD. The matchups are put in date order, whatever the order of the file */
+void Precomputer::readSchedule(const string& fileName, const string& firstDate)
+{
+    ifstream scheduleFile(fileName.c_str());
+    if (!scheduleFile.is_open())
+        throw BaseException(__FILE__, __LINE__, "Could not open schedule file");
+    string line;
+    unsigned int lineNumber = 0;
+    while (getline(scheduleFile, line)) {
+        lineNumber++;
+        if (isIgnoredLine(line))
+            continue;
+        stringstream fields(line);
+        string gameDate;
+        string firstTeam;
+        string secondTeam;
+        if ((!(fields >> gameDate >> firstTeam >> secondTeam)) || (gameDate.size() != firstDate.size()))
+            throwLineError(__FILE__, __LINE__, fileName, lineNumber);
+        // Dates in this form sort the same as their text
+        if (gameDate < firstDate)
+            continue;
+        addMatchup(gameDate, firstTeam, secondTeam);
+        addMatchup(gameDate, secondTeam, firstTeam);
+    }
+    // Stable, so games on the same day stay in file order with both sides together
+    std::stable_sort(_matchups.begin(), _matchups.end(), isSooner);
+}
+
+/* Builds, prunes and caches the tree for every matchup, soonest first, reporting each
+    to a stream. After each build, rests long enough that building takes no more than
+    the given percentage of the time. Returns the number of trees cached */
+unsigned int Precomputer::run(unsigned short cpuPercent, ostream& log) const
+{
+    if ((cpuPercent == 0) || (cpuPercent > 100))
+        cpuPercent = 100;
+    unsigned int builtCount = 0;
+    vector<Matchup>::const_iterator matchup;
+    for (matchup = _matchups.begin(); matchup != _matchups.end(); matchup++) {
+        TRACE_SCOPE("precompute_matchup");
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        const vector<string>& thisSimiliar = getSimiliar(matchup->thisTeam);
+        const vector<string>& otherSimiliar = getSimiliar(matchup->otherTeam);
+        stringstream result;
+        if (!buildResult(*matchup, thisSimiliar, otherSimiliar, result)) {
+            log << matchup->thisTeam << " vs " << matchup->otherTeam << ": no plays, skipped" << endl;
+            continue;
+        }
+        _cache.store(matchup->thisTeam, matchup->otherTeam,
+                     TreeCache::makeKey(matchup->thisTeam, matchup->otherTeam, thisSimiliar, otherSimiliar,
+                                        _league.getFirstSeason(), _league.getLastSeason(), _dataSource),
+                     result.str());
+        builtCount++;
+        std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now() - start;
+        log << matchup->thisTeam << " vs " << matchup->otherTeam << ": cached in "
+            << std::chrono::duration<double, std::milli>(elapsed).count() << " ms" << endl;
+        // Rest so building takes cpuPercent of the time, the rest going to other work
+        if ((cpuPercent < 100) && (matchup + 1 != _matchups.end()))
+            std::this_thread::sleep_for(elapsed * (100 - cpuPercent) / cpuPercent);
+    } // Loop through matchups
+    return builtCount;
+}
+
+/* Builds the tree for a matchup and writes its result to a stream. Returns false if the
+    matchup has no plays. The tree is built straight from the league store, unless sampled
+    splits need the plays in a data store */
+bool Precomputer::buildResult(const Matchup& matchup, const vector<string>& thisSimiliar,
+                              const vector<string>& otherSimiliar, ostream& result) const
+{
+    if (DecisionNode::getSplitSelection() != DecisionNode::sampled_selection) {
+        LeagueColumns columns;
+        _league.selectPlays(matchup.thisTeam, matchup.otherTeam, thisSimiliar, otherSimiliar, columns);
+        if (columns.getPlayCount() == 0)
+            return false;
+        OverallSummaryData summaryData;
+        columns.getSummaryData(summaryData);
+        DecisionNode tree(columns, summaryData);
+        tree.pruneTree();
+        ResultWriter::write(result, matchup.thisTeam, matchup.otherTeam, thisSimiliar, otherSimiliar, tree);
+    } // Counted splits
+    else {
+        DataStore data;
+        _league.selectPlays(matchup.thisTeam, matchup.otherTeam, thisSimiliar, otherSimiliar, data);
+        PlayIndexSet dataView(data.getIndexes());
+        if (dataView.getPlayCount() == 0)
+            return false;
+        DecisionNode tree(dataView, data.getPlaySummaryStats());
+        tree.pruneTree();
+        ResultWriter::write(result, matchup.thisTeam, matchup.otherTeam, thisSimiliar, otherSimiliar, tree);
+    } // Sampled splits
+    return true;
+}
+
+// Lowers the priority of this process as far as it goes, so interactive work comes first
+void Precomputer::lowerPriority()
+{
+#ifndef _WIN32
+    // Failing just means running at normal priority, so errors are ignored
+    setpriority(PRIO_PROCESS, 0, 19);
+#endif
+#ifdef __linux__
+    // Linux can go further, running only when a processor would otherwise be idle
+    struct sched_param schedule;
+    schedule.sched_priority = 0;
+    sched_setscheduler(0, SCHED_IDLE, &schedule);
+#endif
+}
+
+// Returns today's date as YYYY-MM-DD
+string Precomputer::getToday()
+{
+    time_t now = time(NULL);
+    char dateText[16];
+    strftime(dateText, sizeof(dateText), "%Y-%m-%d", localtime(&now));
+    return string(dateText);
+}
+
+/* Adds a matchup, unless it is already on the list. A matchup listed again keeps the
+    earlier of its dates */
+void Precomputer::addMatchup(const string& gameDate, const string& thisTeam, const string& otherTeam)
+{
+    vector<Matchup>::iterator matchup;
+    for (matchup = _matchups.begin(); matchup != _matchups.end(); matchup++)
+        if ((matchup->thisTeam == thisTeam) && (matchup->otherTeam == otherTeam)) {
+            if (gameDate < matchup->gameDate)
+                matchup->gameDate = gameDate;
+            return;
+        }
+    Matchup newMatchup;
+    newMatchup.gameDate = gameDate;
+    newMatchup.thisTeam = thisTeam;
+    newMatchup.otherTeam = otherTeam;
+    _matchups.push_back(newMatchup);
+}
+
+// Returns whether a matchup is played before another, for sorting
+bool Precomputer::isSooner(const Matchup& first, const Matchup& second)
+{
+    // Dates in this form sort the same as their text
+    return (first.gameDate < second.gameDate);
+}
+
+// Returns the teams similiar to a team, which is empty if it has no preset
+const vector<string>& Precomputer::getSimiliar(const string& team) const
+{
+    static const vector<string> NoTeams;
+    map<string, vector<string> >::const_iterator preset = _presets.find(team);
+    if (preset == _presets.end())
+        return NoTeams;
+    else
+        return preset->second;
+}
@@ -0,0 +1,109 @@
+/* This file is part of NFLdecisionTree. It creates decision trees to classify
+    situations within NFL football games, and displays the plays historically
+    called in those situations given a set of opponents.
+
+    Copyright (C) 2013   Ezra Erb
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 3 as published
+    by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    I'd appreciate a note if you find this program useful or make
+    updates. Please contact me through LinkedIn (my profile also has
+    a link to the code depository)
+*/
+
+/* This class builds the trees for upcoming games ahead of time and caches them, so an
+    analyst's first query for the coming week is answered from the cache instead of
+    waiting for a build.
+
+    The games come from a schedule file, one game per line: the date as YYYY-MM-DD
+    followed by the two teams. Games before the start date are skipped. Each game is two
+    matchups, one from the side of each team. The similiar teams come from a preset file,
+    one team per line followed by the teams similiar to it, which are the same ones the
+    analyst would pass with -u or -o. In both files, blank lines and lines starting with
+    '#' are ignored.
+
+    Precomputing is meant to run in the background, at times when people are also using
+    the machine, so it lowers its own priority and rests after each build so it uses no
+    more than a set share of one processor */
+using std::string; // Header deliberately not included, clients should already have it
+using std::vector;
+using std::map;
+using std::ostream;
+
+class Precomputer {
+public:
+    /* Constructor. The league store must be attached, and both it and the cache must outlast
+        this object. The data source says where the league's plays came from, for cache keys */
+    Precomputer(const LeagueStore& league, const TreeCache& cache, const string& dataSource);
+
+    // Use the default destructor
+
+    // Reads the similiar teams for each team from a preset file
+    void readPresets(const string& fileName);
+
+    /* Reads the games from a schedule file, keeping those on or after a date given as
+        YYYY-MM-DD. The matchups are put in date order, whatever the order of the file */
+    void readSchedule(const string& fileName, const string& firstDate);
+
+    // Number of matchups to build
+    unsigned int getMatchupCount() const;
+
+    /* Builds, prunes and caches the tree for every matchup, soonest first, reporting each
+        to a stream. After each build, rests long enough that building takes no more than
+        the given percentage of the time. Returns the number of trees cached */
+    unsigned int run(unsigned short cpuPercent, ostream& log) const;
+
+    // Lowers the priority of this process as far as it goes, so interactive work comes first
+    static void lowerPriority();
+
+    // Returns today's date as YYYY-MM-DD
+    static string getToday();
+
+private:
+    struct Matchup {
+        string gameDate; // YYYY-MM-DD
+        string thisTeam;
+        string otherTeam;
+    };
+
+    const LeagueStore& _league;
+    const TreeCache& _cache;
+    string _dataSource;
+    vector<Matchup> _matchups;
+    map<string, vector<string> > _presets;
+
+    /* Adds a matchup, unless it is already on the list. A matchup listed again keeps the
+        earlier of its dates */
+    void addMatchup(const string& gameDate, const string& thisTeam, const string& otherTeam);
+
+    // Returns whether a matchup is played before another, for sorting
+    static bool isSooner(const Matchup& first, const Matchup& second);
+
+    // Returns the teams similiar to a team, which is empty if it has no preset
+    const vector<string>& getSimiliar(const string& team) const;
+
+    /* Builds the tree for a matchup and writes its result to a stream. Returns false if the
+        matchup has no plays */
+    bool buildResult(const Matchup& matchup, const vector<string>& thisSimiliar,
+                     const vector<string>& otherSimiliar, ostream& result) const;
+
+    // Prohibit copying; there is no need for it
+    Precomputer(const Precomputer& other);
+    Precomputer& operator=(const Precomputer& other);
+};
+
+// Number of matchups to build
+inline unsigned int Precomputer::getMatchupCount() const
+{
+    return (unsigned int)_matchups.size();
+}
@@ -0,0 +1,59 @@
+/* This file is part of NFLdecisionTree. It creates decision trees to classify
+    situations within NFL football games, and displays the plays historically
+    called in those situations given a set of opponents.
+
+    Copyright (C) 2013   Ezra Erb
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 3 as published
+    by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    I'd appreciate a note if you find this program useful or make
+    updates. Please contact me through LinkedIn (my profile also has
+    a link to the code depository)
+*/
+#include<ostream>
+#include<string>
+#include<vector>
+#include"singlePlay.h"
+#include"playIndexSet.h"
+#include"playStats.h"
+#include"decisionNode.h"
+#include"resultWriter.h"
+
+using std::ostream;
+using std::string;
+using std::vector;
+using std::endl;
+
+// Writes the header and tree to a stream
+void ResultWriter::write(ostream& stream, const string& thisTeam, const string& otherTeam,
+                         const vector<string>& thisSimiliar, const vector<string>& otherSimiliar,
+                         const DecisionNode& tree)
+{
+    // Generate header
+    stream << "Us:" << thisTeam << " Opponent: " << otherTeam << " ";
+    if (!thisSimiliar.empty()) {
+        stream << "Similiar to Us:";
+        vector<string>::const_iterator index;
+        for (index = thisSimiliar.begin(); index != thisSimiliar.end(); index++)
+            stream << *index << " ";
+    }
+    if (!otherSimiliar.empty()) {
+        stream << "Similiar to Other:";
+        vector<string>::const_iterator index;
+        for (index = otherSimiliar.begin(); index != otherSimiliar.end(); index++)
+            stream << *index << " ";
+    }
+    stream << endl;
+
+    stream << tree << endl;
+}
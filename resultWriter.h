@@ -0,0 +1,37 @@
+/* This file is part of NFLdecisionTree. It creates decision trees to classify
+    situations within NFL football games, and displays the plays historically
+    called in those situations given a set of opponents.
+
+    Copyright (C) 2013   Ezra Erb
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 3 as published
+    by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    I'd appreciate a note if you find this program useful or make
+    updates. Please contact me through LinkedIn (my profile also has
+    a link to the code depository)
+*/
+
+/* This class writes the result of a run: a header naming the teams, followed by
+    the decision tree. It exists seperately from the main program so benchmarks can
+    produce exactly the same output and compare it to a known good copy */
+using std::ostream; // Headers deliberately not included, clients should already have them
+using std::string;
+using std::vector;
+
+class ResultWriter {
+public:
+    // Writes the header and tree to a stream
+    static void write(ostream& stream, const string& thisTeam, const string& otherTeam,
+                      const vector<string>& thisSimiliar, const vector<string>& otherSimiliar,
+                      const DecisionNode& tree);
+};
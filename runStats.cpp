@@ -0,0 +1,425 @@
+/* This file is part of NFLdecisionTree. It creates decision trees to classify
+    situations within NFL football games, and displays the plays historically
+    called in those situations given a set of opponents.
+
+    Copyright (C) 2013   Ezra Erb
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 3 as published
+    by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    I'd appreciate a note if you find this program useful or make
+    updates. Please contact me through LinkedIn (my profile also has
+    a link to the code depository)
+*/
+/* The entire file compiles to nothing unless statistics are wanted. Hardware counters
+    imply them, but the header that handles that hasn't been included yet */
+#if defined(NFL_RUN_STATS) || defined(NFL_PERF_COUNTERS)
+#include<ostream>
+#include<string>
+#include<iomanip>
+#include<chrono>
+#include<ctime>
+#include<cstdlib>
+#include<new>
+#include<atomic>
+#include"runStats.h"
+#include"allocTracker.h"
+#ifdef NFL_PERF_COUNTERS
+#include"perfCounters.h"
+#endif
+
+using std::ostream;
+using std::string;
+using std::endl;
+using std::setw;
+using std::left;
+using std::right;
+using std::fixed;
+using std::setprecision;
+using std::atomic;
+
+// Names of the phases and counters for output. Must match the enums in the header
+static const char* PhaseNames[] = { "season_load", "file_read", "line_parse", "filter",
+                                    "classification", "build_indexes", "tree_build",
+                                    "prune", "output" };
+static const char* CounterNames[] = { "lines_scanned", "plays_kept", "filter_rejects",
+                                      "nodes_created", "nodes_pruned", "splits_evaluated",
+                                      "splits_sampled", "plays_sampled", "bytes_allocated" };
+
+/* Parent of each phase. Fine phases get CPU time from their parent; coarse phases
+    are their own parent */
+static const RunStats::Phase PhaseParents[] = { RunStats::season_load, RunStats::season_load,
+                                                RunStats::season_load, RunStats::season_load,
+                                                RunStats::season_load, RunStats::build_indexes,
+                                                RunStats::tree_build, RunStats::prune,
+                                                RunStats::output };
+
+static const unsigned short PhaseCount = sizeof(PhaseNames) / sizeof(PhaseNames[0]);
+static const unsigned short CounterCount = sizeof(CounterNames) / sizeof(CounterNames[0]);
+
+/* Accumulated data. Times are only recorded by the thread running the pipeline,
+    but counts can come from anywhere, including the allocator, so they are atomic */
+static double PhaseWallTimes[PhaseCount];
+static double PhaseCpuTimes[PhaseCount];
+static atomic<unsigned long long> Counters[CounterCount];
+
+// Work per tree level
+static unsigned long long LevelNodes[RunStats::MaxTreeLevels];
+static unsigned long long LevelPlays[RunStats::MaxTreeLevels];
+static double LevelWallTimes[RunStats::MaxTreeLevels];
+
+#ifdef NFL_PERF_COUNTERS
+static_assert(RunStats::EventCount == PerfCounters::EventCount, "Hardware event counts don't match");
+
+// Hardware counts per coarse phase and tree level
+static unsigned long long PhaseEvents[PhaseCount][RunStats::EventCount];
+static unsigned long long LevelEvents[RunStats::MaxTreeLevels][RunStats::EventCount];
+#endif
+
+// Converts a node depth into a tree level for recording
+static unsigned short depthToLevel(unsigned short depth)
+{
+    return (depth < RunStats::MaxTreeLevels) ? depth : RunStats::MaxTreeLevels - 1;
+}
+
+// Current time in seconds from some arbitrary starting point
+double RunStats::getWallSeconds()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+double RunStats::getCpuSeconds()
+{
+    return (double)clock() / (double)CLOCKS_PER_SEC;
+}
+
+// Accumulate time into a phase
+void RunStats::addTime(Phase phase, double wallSeconds, double cpuSeconds)
+{
+    PhaseWallTimes[phase] += wallSeconds;
+    PhaseCpuTimes[phase] += cpuSeconds;
+}
+
+// Accumulate a count
+void RunStats::addCount(Counter counter, unsigned long long count)
+{
+    Counters[counter].fetch_add(count, std::memory_order_relaxed);
+}
+
+// Accumulate the work of building one tree node into its level
+void RunStats::addLevel(unsigned short depth, unsigned long long playCount, double wallSeconds)
+{
+    unsigned short level = depthToLevel(depth);
+    LevelNodes[level]++;
+    LevelPlays[level] += playCount;
+    LevelWallTimes[level] += wallSeconds;
+}
+
+// Read hardware counters into an array of EventCount values
+void RunStats::readEvents(unsigned long long values[])
+{
+#ifdef NFL_PERF_COUNTERS
+    PerfCounters::read(values);
+#else
+    unsigned short index;
+    for (index = 0; index < EventCount; index++)
+        values[index] = 0;
+#endif
+}
+
+// Accumulate the difference from an earlier hardware counter reading into a phase
+void RunStats::addPhaseEvents(Phase phase, const unsigned long long startValues[])
+{
+#ifdef NFL_PERF_COUNTERS
+    unsigned long long values[EventCount];
+    PerfCounters::read(values);
+    unsigned short index;
+    for (index = 0; index < EventCount; index++)
+        PhaseEvents[phase][index] += values[index] - startValues[index];
+#else
+    // Nothing is counted without hardware counters
+    (void)phase;
+    (void)startValues;
+#endif
+}
+
+// Accumulate the difference from an earlier hardware counter reading into a tree level
+void RunStats::addLevelEvents(unsigned short depth, const unsigned long long startValues[])
+{
+#ifdef NFL_PERF_COUNTERS
+    unsigned long long values[EventCount];
+    PerfCounters::read(values);
+    unsigned short level = depthToLevel(depth);
+    unsigned short index;
+    for (index = 0; index < EventCount; index++)
+        LevelEvents[level][index] += values[index] - startValues[index];
+#else
+    // Nothing is counted without hardware counters
+    (void)depth;
+    (void)startValues;
+#endif
+}
+
+// Returns the current value of a count
+unsigned long long RunStats::getCount(Counter counter)
+{
+    return Counters[counter].load(std::memory_order_relaxed);
+}
+
+unsigned short RunStats::getPhaseCount()
+{
+    return PhaseCount;
+}
+
+unsigned short RunStats::getCounterCount()
+{
+    return CounterCount;
+}
+
+// Whether a phase records CPU time directly, and its parent if not
+bool RunStats::isFinePhase(Phase phase)
+{
+    return PhaseParents[phase] != phase;
+}
+
+RunStats::Phase RunStats::getParentPhase(Phase phase)
+{
+    return PhaseParents[phase];
+}
+
+double RunStats::getWallTime(Phase phase)
+{
+    return PhaseWallTimes[phase];
+}
+
+// Returns accumulated CPU time for a phase. Fine phases return an estimated CPU time
+double RunStats::getCpuTime(Phase phase)
+{
+    if (!isFinePhase(phase))
+        return PhaseCpuTimes[phase];
+    // Share of the parent CPU time in proportion to wall time
+    Phase parent = getParentPhase(phase);
+    if (PhaseWallTimes[parent] <= 0.0)
+        return 0.0;
+    return PhaseCpuTimes[parent] * (PhaseWallTimes[phase] / PhaseWallTimes[parent]);
+}
+
+#ifdef NFL_PERF_COUNTERS
+// Outputs the column headers for hardware counter tables
+static void outputEventHeader(ostream& stream, const char* firstColumn)
+{
+    stream << left << setw(20) << firstColumn << right << setw(16) << "Cycles"
+           << setw(16) << "Instructions" << setw(8) << "IPC" << setw(18) << "Cache miss/play"
+           << setw(18) << "Branch miss/play" << endl;
+}
+
+/* Outputs one set of hardware counts, either as table columns or as JSON fields
+    to add to an object. Events the processor doesn't support are marked as such */
+static void outputEvents(ostream& stream, const unsigned long long events[],
+                         unsigned long long playCount, RunStats::ReportFormat format)
+{
+    bool haveIpc = PerfCounters::isEventAvailable(PerfCounters::cpu_cycles) &&
+        PerfCounters::isEventAvailable(PerfCounters::instructions) && (events[PerfCounters::cpu_cycles] > 0);
+    double ipc = haveIpc ? (double)events[PerfCounters::instructions] / (double)events[PerfCounters::cpu_cycles] : 0.0;
+    unsigned short index;
+    if (format == RunStats::json_format) {
+        for (index = 0; index < PerfCounters::EventCount; index++) {
+            stream << ",\"" << PerfCounters::getEventName((PerfCounters::Event)index) << "\":";
+            if (PerfCounters::isEventAvailable((PerfCounters::Event)index))
+                stream << events[index];
+            else
+                stream << "null";
+        } // Loop through events
+        stream << ",\"ipc\":";
+        if (haveIpc)
+            stream << ipc;
+        else
+            stream << "null";
+        stream << ",\"cache_misses_per_play\":";
+        if (PerfCounters::isEventAvailable(PerfCounters::cache_misses) && playCount)
+            stream << (double)events[PerfCounters::cache_misses] / (double)playCount;
+        else
+            stream << "null";
+        stream << ",\"branch_misses_per_play\":";
+        if (PerfCounters::isEventAvailable(PerfCounters::branch_misses) && playCount)
+            stream << (double)events[PerfCounters::branch_misses] / (double)playCount;
+        else
+            stream << "null";
+    } // JSON output
+    else {
+        stream << right;
+        if (PerfCounters::isEventAvailable(PerfCounters::cpu_cycles))
+            stream << setw(16) << events[PerfCounters::cpu_cycles];
+        else
+            stream << setw(16) << "n/a";
+        if (PerfCounters::isEventAvailable(PerfCounters::instructions))
+            stream << setw(16) << events[PerfCounters::instructions];
+        else
+            stream << setw(16) << "n/a";
+        if (haveIpc)
+            stream << setw(8) << setprecision(2) << ipc;
+        else
+            stream << setw(8) << "n/a";
+        if (PerfCounters::isEventAvailable(PerfCounters::cache_misses) && playCount)
+            stream << setw(18) << setprecision(2) << (double)events[PerfCounters::cache_misses] / (double)playCount;
+        else
+            stream << setw(18) << "n/a";
+        if (PerfCounters::isEventAvailable(PerfCounters::branch_misses) && playCount)
+            stream << setw(18) << setprecision(2) << (double)events[PerfCounters::branch_misses] / (double)playCount;
+        else
+            stream << setw(18) << "n/a";
+        stream << setprecision(3);
+    } // Table output
+}
+#endif
+
+// Outputs everything collected so far
+void RunStats::report(ostream& stream, ReportFormat format)
+{
+    ALLOC_SCOPE(stats_memory);
+    unsigned short index;
+    if (format == json_format) {
+        stream << "{\"phases\":[";
+        for (index = 0; index < PhaseCount; index++) {
+            if (index)
+                stream << ",";
+            stream << "{\"name\":\"" << PhaseNames[index] << "\",\"wall_ms\":"
+                   << fixed << setprecision(3) << getWallTime((Phase)index) * 1000.0
+                   << ",\"cpu_ms\":" << getCpuTime((Phase)index) * 1000.0
+                   << ",\"cpu_estimated\":" << (isFinePhase((Phase)index) ? "true" : "false") << "}";
+        }
+        stream << "],\"counters\":{";
+        for (index = 0; index < CounterCount; index++) {
+            if (index)
+                stream << ",";
+            stream << "\"" << CounterNames[index] << "\":" << getCount((Counter)index);
+        }
+        stream << "},\"levels\":[";
+        bool firstLevel = true;
+        for (index = 0; index < MaxTreeLevels; index++)
+            if (LevelNodes[index]) {
+                if (!firstLevel)
+                    stream << ",";
+                firstLevel = false;
+                stream << "{\"level\":" << index << ",\"nodes\":" << LevelNodes[index]
+                       << ",\"plays\":" << LevelPlays[index] << ",\"wall_ms\":"
+                       << LevelWallTimes[index] * 1000.0;
+#ifdef NFL_PERF_COUNTERS
+                outputEvents(stream, LevelEvents[index], LevelPlays[index], format);
+#endif
+                stream << "}";
+            } // Level with nodes
+        stream << "]";
+#ifdef NFL_PERF_COUNTERS
+        stream << ",\"hardware\":{\"available\":" << (PerfCounters::isAvailable() ? "true" : "false")
+               << ",\"reason\":\"" << PerfCounters::getUnavailableReason() << "\",\"phases\":[";
+        bool firstPhase = true;
+        for (index = 0; index < PhaseCount; index++)
+            if (!isFinePhase((Phase)index)) {
+                if (!firstPhase)
+                    stream << ",";
+                firstPhase = false;
+                stream << "{\"name\":\"" << PhaseNames[index] << "\"";
+                outputEvents(stream, PhaseEvents[index], getCount(plays_kept), format);
+                stream << "}";
+            } // Coarse phase
+        stream << "]}";
+#endif
+        stream << "}" << endl;
+    } // JSON output
+    else {
+        stream << left << setw(20) << "Phase" << right << setw(12) << "Wall ms" << setw(12) << "CPU ms" << endl;
+        for (index = 0; index < PhaseCount; index++) {
+            // Indent fine phases under their parent
+            stream << left << setw(20)
+                   << (isFinePhase((Phase)index) ? string("  ") + PhaseNames[index] : string(PhaseNames[index]))
+                   << right << fixed << setprecision(3) << setw(12) << getWallTime((Phase)index) * 1000.0
+                   << setw(12) << getCpuTime((Phase)index) * 1000.0
+                   << (isFinePhase((Phase)index) ? "*" : "") << endl;
+        }
+        stream << "* CPU time estimated from the enclosing phase" << endl << endl;
+        stream << left << setw(20) << "Counter" << right << setw(12) << "Value" << endl;
+        for (index = 0; index < CounterCount; index++)
+            stream << left << setw(20) << CounterNames[index] << right << setw(12)
+                   << getCount((Counter)index) << endl;
+
+        stream << endl << left << setw(20) << "Tree level" << right << setw(12) << "Nodes"
+               << setw(12) << "Plays" << setw(12) << "Wall ms" << endl;
+        for (index = 0; index < MaxTreeLevels; index++)
+            if (LevelNodes[index])
+                stream << left << setw(20) << index << right << setw(12) << LevelNodes[index]
+                       << setw(12) << LevelPlays[index] << setw(12) << LevelWallTimes[index] * 1000.0
+                       << endl;
+
+#ifdef NFL_PERF_COUNTERS
+        stream << endl;
+        if (!PerfCounters::isAvailable())
+            stream << "Hardware counters not available: " << PerfCounters::getUnavailableReason() << endl;
+        else {
+            outputEventHeader(stream, "Phase");
+            for (index = 0; index < PhaseCount; index++)
+                if (!isFinePhase((Phase)index)) {
+                    stream << left << setw(20) << PhaseNames[index];
+                    outputEvents(stream, PhaseEvents[index], getCount(plays_kept), format);
+                    stream << endl;
+                } // Coarse phase
+            stream << "Per play values use plays kept" << endl << endl;
+
+            outputEventHeader(stream, "Tree level");
+            for (index = 0; index < MaxTreeLevels; index++)
+                if (LevelNodes[index]) {
+                    stream << left << setw(20) << index;
+                    outputEvents(stream, LevelEvents[index], LevelPlays[index], format);
+                    stream << endl;
+                } // Level with nodes
+            stream << "Per play values use plays in the level's nodes" << endl;
+        } // Counters available
+#endif
+    } // Table output
+}
+
+/* Count every byte allocated by replacing the global allocator. The array versions
+    and the other deletes call these by default. Compilers warn unless the sized deletes
+    are replaced along with them, so those and the array delete they need forward to
+    these. The allocation tracker replaces it too, and counts bytes for this class when
+    present */
+#ifndef NFL_ALLOC_TRACKING
+void* operator new(std::size_t size)
+{
+    RunStats::addCount(RunStats::bytes_allocated, size);
+    void* result = malloc(size ? size : 1);
+    if (!result)
+        throw std::bad_alloc();
+    return result;
+}
+
+void operator delete(void* pointer) noexcept
+{
+    free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+    operator delete(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+    operator delete(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept
+{
+    operator delete(pointer);
+}
+#endif
+#endif
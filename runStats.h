@@ -0,0 +1,247 @@
+/* This file is part of NFLdecisionTree. It creates decision trees to classify
+    situations within NFL football games, and displays the plays historically
+    called in those situations given a set of opponents.
+
+    Copyright (C) 2013   Ezra Erb
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 3 as published
+    by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    I'd appreciate a note if you find this program useful or make
+    updates. Please contact me through LinkedIn (my profile also has
+    a link to the code depository)
+*/
+
+/* This class collects timing and counts for each phase of a run, reported
+    with the --stats option. Instrumentation is expensive compared to the work
+    being measured inside the per-play loops, so it is compiled in only when
+    NFL_RUN_STATS is defined. Code being measured uses the macros at the bottom
+    of this file, which compile to nothing otherwise. This lets the
+    instrumentation stay in the production source without costing anything.
+
+    Phases come in two kinds. Coarse phases, like building the tree, run once
+    or a few times, and record both wall and CPU time. Fine phases, like parsing
+    a single line, run hundreds of thousands of times. Reading the CPU clock is
+    a system call on most platforms, which would distort them badly, so they
+    record wall time only. Their CPU time is reported as a share of their parent
+    coarse phase, in proportion to wall time
+
+    Defining NFL_PERF_COUNTERS as well adds hardware counter readings for each
+    coarse phase and each level of the decision tree (see perfCounters.h). It
+    implies NFL_RUN_STATS.
+
+    Everything is static, since there is only one run per process */
+
+#if defined(NFL_PERF_COUNTERS) && !defined(NFL_RUN_STATS)
+#define NFL_RUN_STATS
+#endif
+
+using std::ostream; // Header deliberately not included, clients should already have it
+
+class RunStats {
+public:
+    /* Phases of a run. WARNING: Must be kept in sync with the names and parents
+        in runStats.cpp! */
+    enum Phase { season_load, file_read, line_parse, filter, classification, build_indexes,
+                 tree_build, prune, output };
+
+    // Counts of interesting events
+    enum Counter { lines_scanned, plays_kept, filter_rejects, nodes_created, nodes_pruned,
+                   splits_evaluated, splits_sampled, plays_sampled, bytes_allocated };
+
+    // Report formats
+    enum ReportFormat { table_format, json_format };
+
+    // Tree levels recorded seperately. Deeper levels are combined into the last one
+    static const unsigned short MaxTreeLevels = 16;
+
+    // Number of hardware events. WARNING: Must match PerfCounters::EventCount!
+    static const unsigned short EventCount = 4;
+
+    // Current time in seconds from some arbitrary starting point
+    static double getWallSeconds();
+    static double getCpuSeconds();
+
+    // Accumulate time into a phase
+    static void addTime(Phase phase, double wallSeconds, double cpuSeconds);
+
+    // Accumulate a count
+    static void addCount(Counter counter, unsigned long long count);
+
+    // Returns the current value of a count
+    static unsigned long long getCount(Counter counter);
+
+    // Accumulate the work of building one tree node into its level
+    static void addLevel(unsigned short depth, unsigned long long playCount, double wallSeconds);
+
+    /* Read hardware counters into an array of EventCount values, and accumulate the
+        difference from an earlier reading into a phase or tree level. These do nothing
+        unless NFL_PERF_COUNTERS is defined */
+    static void readEvents(unsigned long long values[]);
+    static void addPhaseEvents(Phase phase, const unsigned long long startValues[]);
+    static void addLevelEvents(unsigned short depth, const unsigned long long startValues[]);
+
+    // Returns accumulated times for a phase. Fine phases return an estimated CPU time
+    static double getWallTime(Phase phase);
+    static double getCpuTime(Phase phase);
+
+    // Outputs everything collected so far
+    static void report(ostream& stream, ReportFormat format);
+
+    // Number of phases and counters, for iterating through them
+    static unsigned short getPhaseCount();
+    static unsigned short getCounterCount();
+
+    // Whether a phase records CPU time directly, and its parent if not
+    static bool isFinePhase(Phase phase);
+    static Phase getParentPhase(Phase phase);
+};
+
+/* Times a phase for as long as the object exists, or a series of phases that follow
+    one another, such as the steps in processing a single line. Switching phases charges
+    the time since the last switch to the previous phase. This handles early returns in
+    the code being measured, since the destructor charges whatever phase is current */
+class StatsTimer {
+public:
+    explicit StatsTimer(RunStats::Phase phase);
+    ~StatsTimer();
+
+    // Charge time so far to the current phase, and start timing a new one
+    void switchTo(RunStats::Phase phase);
+
+    // Charge time so far to the current phase, and stop timing
+    void stop();
+
+private:
+    RunStats::Phase _phase;
+    bool _running;
+    bool _finePhase; // Fine phases don't read the CPU clock or hardware counters
+    double _wallStart;
+    double _cpuStart;
+#ifdef NFL_PERF_COUNTERS
+    unsigned long long _eventStart[RunStats::EventCount];
+#endif
+
+    // Start timing a phase
+    void start(RunStats::Phase phase, double wallNow);
+
+    // Prohibit copying, which would record the time twice
+    StatsTimer(const StatsTimer& other);
+    StatsTimer& operator=(const StatsTimer& other);
+};
+
+inline StatsTimer::StatsTimer(RunStats::Phase phase)
+    : _phase(phase), _running(false), _finePhase(false), _wallStart(0.0), _cpuStart(0.0)
+{
+    start(phase, RunStats::getWallSeconds());
+}
+
+inline StatsTimer::~StatsTimer()
+{
+    stop();
+}
+
+// Start timing a phase
+inline void StatsTimer::start(RunStats::Phase phase, double wallNow)
+{
+    _phase = phase;
+    _running = true;
+    _finePhase = RunStats::isFinePhase(phase);
+    _wallStart = wallNow;
+    if (!_finePhase) {
+        _cpuStart = RunStats::getCpuSeconds();
+#ifdef NFL_PERF_COUNTERS
+        RunStats::readEvents(_eventStart);
+#endif
+    }
+}
+
+// Charge time so far to the current phase, and start timing a new one
+inline void StatsTimer::switchTo(RunStats::Phase phase)
+{
+    stop();
+    start(phase, RunStats::getWallSeconds());
+}
+
+// Charge time so far to the current phase, and stop timing
+inline void StatsTimer::stop()
+{
+    if (!_running)
+        return;
+    double cpuTime = 0.0;
+    if (!_finePhase) {
+#ifdef NFL_PERF_COUNTERS
+        // Read the counters first, so they include as little of the timing code as possible
+        RunStats::addPhaseEvents(_phase, _eventStart);
+#endif
+        cpuTime = RunStats::getCpuSeconds() - _cpuStart;
+    }
+    RunStats::addTime(_phase, RunStats::getWallSeconds() - _wallStart, cpuTime);
+    _running = false;
+}
+
+/* Measures the work of building a single tree node, excluding the nodes below it,
+    and charges it to the node's level in the tree. Unlike phases, this must be
+    stopped explicitly, since the node depth and play count are needed */
+class StatsLevelTimer {
+public:
+    StatsLevelTimer();
+
+    // Charge the work so far to a tree level
+    void stop(unsigned short depth, unsigned long long playCount);
+
+private:
+    double _wallStart;
+#ifdef NFL_PERF_COUNTERS
+    unsigned long long _eventStart[RunStats::EventCount];
+#endif
+};
+
+inline StatsLevelTimer::StatsLevelTimer()
+    : _wallStart(RunStats::getWallSeconds())
+{
+#ifdef NFL_PERF_COUNTERS
+    RunStats::readEvents(_eventStart);
+#endif
+}
+
+// Charge the work so far to a tree level
+inline void StatsLevelTimer::stop(unsigned short depth, unsigned long long playCount)
+{
+#ifdef NFL_PERF_COUNTERS
+    RunStats::addLevelEvents(depth, _eventStart);
+#endif
+    RunStats::addLevel(depth, playCount, RunStats::getWallSeconds() - _wallStart);
+}
+
+/* Instrumentation macros. These are the only things code being measured should use.
+    TRICKY NOTE: The phase objects need a unique name in case several are in the same
+    scope. The double macro is the standard way to paste the line number onto it */
+#ifdef NFL_RUN_STATS
+#define STATS_NAME_HELPER(name, line) name##line
+#define STATS_NAME(name, line) STATS_NAME_HELPER(name, line)
+#define STATS_PHASE(phase) StatsTimer STATS_NAME(statsTimer, __LINE__)(RunStats::phase)
+#define STATS_TIMER(name, phase) StatsTimer name(RunStats::phase)
+#define STATS_SWITCH(name, phase) name.switchTo(RunStats::phase)
+#define STATS_STOP(name) name.stop()
+#define STATS_COUNT(counter, count) RunStats::addCount(RunStats::counter, count)
+#define STATS_LEVEL_TIMER(name) StatsLevelTimer name
+#define STATS_LEVEL_STOP(name, depth, playCount) name.stop(depth, playCount)
+#else
+#define STATS_PHASE(phase)
+#define STATS_TIMER(name, phase)
+#define STATS_SWITCH(name, phase)
+#define STATS_STOP(name)
+#define STATS_COUNT(counter, count)
+#define STATS_LEVEL_TIMER(name)
+#define STATS_LEVEL_STOP(name, depth, playCount)
+#endif
@@ -24,6 +24,10 @@
 #include<vector>
 #include"singlePlay.h"
 
+#ifdef __SSE2__
+#include<emmintrin.h>
+#endif
+
 using std::ostream;
 
 // Constructor, supply all specified data
@@ -42,6 +46,109 @@ SinglePlay::SinglePlay(unsigned int refId, SinglePlay::PlayType playType, short
     _turnedOver = turnedOver;
 }
 
+// Constructor for plays whose situation is already converted to categories
+SinglePlay::SinglePlay(unsigned int refId, SinglePlay::PlayType playType, short down,
+                       SinglePlay::DistanceNeeded distanceNeeded, SinglePlay::FieldLocation fieldLocation,
+                       SinglePlay::TimeRemaining timeRemaining, SinglePlay::ScoreDifferential scoreDifferential,
+                       short distanceGained, bool turnedOver)
+{
+    _refId = refId;
+    _playType = playType;
+    _down = down;
+    _distanceNeeded = distanceNeeded;
+    _fieldLocation = fieldLocation;
+    _timeRemaining = timeRemaining;
+    _scoreDifferential = scoreDifferential;
+    _distanceGained = distanceGained;
+    _turnedOver = turnedOver;
+}
+
+#ifdef __SSE2__
+/* Stores the categories of eight values, given the sum of the compares against their
+    limits. Each compare gives -1 for values past the limit, so the sum is minus the
+    category */
+static inline void storeCategories(__m128i pastSum, unsigned char* categories)
+{
+    __m128i zero = _mm_setzero_si128();
+    _mm_storel_epi64((__m128i*)categories, _mm_packs_epi16(_mm_sub_epi16(zero, pastSum), zero));
+}
+#endif
+
+/* Same conversions as above, for whole columns of values at once. Each gives the
+    category of every value as its enum value. Where SSE2 is available, which is every
+    64 bit x86 processor, eight values are compared at once; compilers only vectorize
+    the plain loops at higher optimization levels. The limits must match the ones in
+    singlePlay.h, with <= written as < the next value up */
+void SinglePlay::categorizeDistances(const short* distancesNeeded, unsigned long count,
+                                     unsigned char* categories)
+{
+    unsigned long index = 0;
+#ifdef __SSE2__
+    for (; index + 8 <= count; index += 8) {
+        __m128i values = _mm_loadu_si128((const __m128i*)(distancesNeeded + index));
+        storeCategories(_mm_add_epi16(_mm_add_epi16(_mm_cmplt_epi16(values, _mm_set1_epi16(20)),
+                                                    _mm_cmplt_epi16(values, _mm_set1_epi16(11))),
+                                      _mm_add_epi16(_mm_cmplt_epi16(values, _mm_set1_epi16(5)),
+                                                    _mm_cmplt_epi16(values, _mm_set1_epi16(2)))),
+                        categories + index);
+    }
+#endif
+    for (; index < count; index++)
+        categories[index] = (unsigned char)distanceToDistanceNeeded(distancesNeeded[index]);
+}
+
+void SinglePlay::categorizeYardLines(const short* yardLines, unsigned long count, unsigned char* categories)
+{
+    unsigned long index = 0;
+#ifdef __SSE2__
+    for (; index + 8 <= count; index += 8) {
+        __m128i values = _mm_loadu_si128((const __m128i*)(yardLines + index));
+        storeCategories(_mm_add_epi16(_mm_cmplt_epi16(values, _mm_set1_epi16(90)),
+                                      _mm_cmplt_epi16(values, _mm_set1_epi16(11))),
+                        categories + index);
+    }
+#endif
+    for (; index < count; index++)
+        categories[index] = (unsigned char)yardsToFieldLocation(yardLines[index]);
+}
+
+void SinglePlay::categorizeMinutes(const short* minutes, unsigned long count, unsigned char* categories)
+{
+    unsigned long index = 0;
+#ifdef __SSE2__
+    for (; index + 8 <= count; index += 8) {
+        __m128i values = _mm_loadu_si128((const __m128i*)(minutes + index));
+        __m128i endOfHalf = _mm_and_si128(_mm_cmpgt_epi16(values, _mm_set1_epi16(29)),
+                                          _mm_cmplt_epi16(values, _mm_set1_epi16(32)));
+        storeCategories(_mm_or_si128(_mm_cmplt_epi16(values, _mm_set1_epi16(2)), endOfHalf),
+                        categories + index);
+    }
+#endif
+    for (; index < count; index++)
+        categories[index] = (unsigned char)minutesToTimeRemaining(minutes[index]);
+}
+
+void SinglePlay::categorizeScores(const short* ownScores, const short* oppScores, unsigned long count,
+                                  unsigned char* categories)
+{
+    unsigned long index = 0;
+#ifdef __SSE2__
+    for (; index + 8 <= count; index += 8) {
+        __m128i values = _mm_sub_epi16(_mm_loadu_si128((const __m128i*)(ownScores + index)),
+                                       _mm_loadu_si128((const __m128i*)(oppScores + index)));
+        __m128i pastSum = _mm_add_epi16(_mm_cmpgt_epi16(values, _mm_set1_epi16(-15)),
+                                        _mm_cmpgt_epi16(values, _mm_set1_epi16(-8)));
+        pastSum = _mm_add_epi16(pastSum, _mm_add_epi16(_mm_cmpgt_epi16(values, _mm_set1_epi16(-1)),
+                                                       _mm_cmpgt_epi16(values, _mm_setzero_si128())));
+        pastSum = _mm_add_epi16(pastSum, _mm_add_epi16(_mm_cmpgt_epi16(values, _mm_set1_epi16(7)),
+                                                       _mm_cmpgt_epi16(values, _mm_set1_epi16(14))));
+        storeCategories(pastSum, categories + index);
+    }
+#endif
+    for (; index < count; index++)
+        categories[index] = (unsigned char)scoreToScoreDifferential(ownScores[index], oppScores[index]);
+}
+
 // Output play type
 ostream& operator<<(ostream& stream, SinglePlay::PlayType playType)
 {
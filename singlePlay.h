@@ -80,13 +80,21 @@ class SinglePlay {
                    short yardLine, short minutes, short ownScore, short oppScore,
                    short distanceGained, bool turnedOver);
 
+        /* Constructor for plays whose situation is already converted to categories, like
+            those from the column converters below */
+        SinglePlay(unsigned int refId, PlayType playType, short down, DistanceNeeded distanceNeeded,
+                   FieldLocation fieldLocation, TimeRemaining timeRemaining,
+                   ScoreDifferential scoreDifferential, short distanceGained, bool turnedOver);
+
         // Returns the number of categories for a category based characeristic (0 for others)
         static unsigned short getCategoryCount(PlayCharacteristic playCharacteristic);
 
         // Returns the number of different types of plays processed
         static unsigned short getPlayTypeCount();
 
-        // Convert a distance needed into a distance category
+        /* Convert a distance needed into a distance category
+            WARNING: TreeExporter writes copies of this conversion and the three below
+            into exported trees. Change them there too! */
         static DistanceNeeded distanceToDistanceNeeded(short distanceNeeded);
 
          // Convert a field yardage into location
@@ -97,6 +105,18 @@ class SinglePlay {
 
         static ScoreDifferential scoreToScoreDifferential(short ownScore, short oppScore);
 
+        /* Same conversions as above, for whole columns of values at once. Each gives the
+            category of every value as its enum value. The loops have no branches, so
+            compilers can vectorize them */
+        static void categorizeDistances(const short* distancesNeeded, unsigned long count,
+                                        unsigned char* categories);
+        static void categorizeYardLines(const short* yardLines, unsigned long count,
+                                        unsigned char* categories);
+        static void categorizeMinutes(const short* minutes, unsigned long count,
+                                      unsigned char* categories);
+        static void categorizeScores(const short* ownScores, const short* oppScores,
+                                     unsigned long count, unsigned char* categories);
+
         /* Gets the reference ID for this play. The ID is used to trace it through the
             system for debugging purposes */
         unsigned int getRefId() const;
@@ -191,65 +211,38 @@ inline unsigned short SinglePlay::getCategoryCount(PlayCharacteristic playCharac
     }
 }
 
-// Convert a distance needed into a distance category
+/* Convert a distance needed into a distance category. The converters run for every
+    play loaded and every situation looked up, and the values are close to random, so
+    chains of ifs mispredict often. Instead, each counts the limits the value is past,
+    which compiles to compares and adds without branches
+    WARNING: Relies on the categories being in order, from the first limit passed to
+    the last! */
 inline SinglePlay::DistanceNeeded SinglePlay::distanceToDistanceNeeded(short distanceNeeded)
 {
-    /* NOTE: distance is done in increasing order, so most likely
-        values occur first */
-    if (distanceNeeded <= 1)
-        return one_or_less;
-    else if (distanceNeeded <= 4)
-        return four_to_one;
-    else if (distanceNeeded <= 10)
-        return ten_to_four;
-    else if (distanceNeeded < 20)
-        return twenty_to_ten;
-    else
-        return over_twenty;
+    return (DistanceNeeded)((distanceNeeded < 20) + (distanceNeeded <= 10) +
+                            (distanceNeeded <= 4) + (distanceNeeded <= 1));
 }
 
-
-
 // Convert a field yardage into location
 inline SinglePlay::FieldLocation SinglePlay::yardsToFieldLocation(short yardLine)
 {
     // In the data, yardage is always given in terms of offence yards to go
-    if (yardLine >= 90)
-        return own_red_zone;
-    else if (yardLine > 10)
-        return middle;
-    else
-        return opp_red_zone;
+    return (FieldLocation)((yardLine < 90) + (yardLine <= 10));
 }
 
 // Convert a minute count to time remaining category
 inline SinglePlay::TimeRemaining SinglePlay::minutesToTimeRemaining(short minutes)
 {
     // Game time in data is specifed in as time remaining in the overall game
-    if ((minutes < 2) || ((minutes >= 30) && (minutes < 32)))
-        return inside_two_minutes;
-    else
-        return outside_two_minutes;
+    return (TimeRemaining)((minutes < 2) | ((minutes >= 30) & (minutes < 32)));
 }
 
 // Convert two scores into a score differential category
 inline SinglePlay::ScoreDifferential SinglePlay::scoreToScoreDifferential(short ownScore, short oppScore)
 {
     short scoreDiff = ownScore - oppScore;
-    if (scoreDiff < -14)
-        return down_over_fourteen;
-    else if (scoreDiff < -7)
-        return down_over_seven;
-    else if (scoreDiff < 0)
-        return down_seven_less;
-    else if (!scoreDiff)
-        return even;
-    else if (scoreDiff <= 7)
-        return up_seven_less;
-    else if (scoreDiff <= 14)
-        return up_over_seven;
-    else
-        return up_over_fourteen;
+    return (ScoreDifferential)((scoreDiff >= -14) + (scoreDiff >= -7) + (scoreDiff >= 0) +
+                               (scoreDiff > 0) + (scoreDiff > 7) + (scoreDiff > 14));
 }
 
 inline unsigned int SinglePlay::getRefId() const
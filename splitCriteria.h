@@ -0,0 +1,162 @@
+/* This file is part of NFLdecisionTree. It creates decision trees to classify
+    situations within NFL football games, and displays the plays historically
+    called in those situations given a set of opponents.
+
+    Copyright (C) 2013   Ezra Erb
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 3 as published
+    by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    I'd appreciate a note if you find this program useful or make
+    updates. Please contact me through LinkedIn (my profile also has
+    a link to the code depository)
+*/
+#include<cmath> // Needed for inline methods
+
+/* These classes are the split criteria a decision tree can be built with. Each says how
+    mixed a group of plays is, called its impurity, and how to score a split from the drop
+    in impurity it gives. The tree splits on a characteristic whose score reaches the
+    criterion's minimum.
+
+    They are policies for the templated split kernels in DecisionNode. Every method is a
+    static inline, so each criterion gets its own copy of the kernels with the impurity
+    calculation built in, and nothing is looked up per play count. DecisionNode picks
+    the copy once for each split it evaluates.
+
+    Impurity is a sum over the play types in a group, so each criterion only supplies
+    the term for one play type:
+    - Entropy: -p log2 p, the information (in bits) needed to identify a play's type.
+    - Gini impurity: p(1 - p), the chance of mislabeling a play by drawing a label at
+      random from the group. It needs no logarithm, so it is the cheapest.
+    - Gain ratio (C4.5): entropy, with the gain divided by the information needed to
+      say which branch a play goes to. This corrects the bias of plain gain toward
+      characteristics with many categories. It is the program's original criterion.
+    See DecisionNode::getSplitScore for the full derivation */
+using std::vector; // Header deliberately not included, clients should already have it
+
+class GainRatioCriterion {
+public:
+    // Impurity from plays of one type within a group
+    static double getImpurity(long playCount, long groupCount);
+
+    // Converts the drop in impurity from a split into its score
+    static double getScore(double gain, long playTotal, const vector<long>& splitPlayTotals);
+
+    // Lowest score where a split is valuable
+    static double getMinimumScore();
+
+    // Largest difference between two scores, for sampling bounds
+    static double getScoreRange();
+};
+
+class EntropyCriterion {
+public:
+    // Impurity from plays of one type within a group
+    static double getImpurity(long playCount, long groupCount);
+
+    // Converts the drop in impurity from a split into its score
+    static double getScore(double gain, long playTotal, const vector<long>& splitPlayTotals);
+
+    // Lowest score where a split is valuable
+    static double getMinimumScore();
+
+    // Largest difference between two scores, for sampling bounds
+    static double getScoreRange();
+};
+
+class GiniCriterion {
+public:
+    // Impurity from plays of one type within a group
+    static double getImpurity(long playCount, long groupCount);
+
+    // Converts the drop in impurity from a split into its score
+    static double getScore(double gain, long playTotal, const vector<long>& splitPlayTotals);
+
+    // Lowest score where a split is valuable
+    static double getMinimumScore();
+
+    // Largest difference between two scores, for sampling bounds
+    static double getScoreRange();
+};
+
+inline double GainRatioCriterion::getImpurity(long playCount, long groupCount)
+{
+    double ratio = (double)playCount / (double)groupCount;
+    return -ratio * log2(ratio);
+}
+
+// The gain is divided by the intrinsic information of the split
+inline double GainRatioCriterion::getScore(double gain, long playTotal, const vector<long>& splitPlayTotals)
+{
+    double intrinsicValue = 0.0;
+    vector<long>::const_iterator splitTotal;
+    for (splitTotal = splitPlayTotals.begin(); splitTotal != splitPlayTotals.end(); splitTotal++)
+        intrinsicValue += getImpurity(*splitTotal, playTotal);
+    return gain / intrinsicValue;
+}
+
+inline double GainRatioCriterion::getMinimumScore()
+{
+    return 0.02;
+}
+
+// Ratios run from zero to one
+inline double GainRatioCriterion::getScoreRange()
+{
+    return 1.0;
+}
+
+inline double EntropyCriterion::getImpurity(long playCount, long groupCount)
+{
+    double ratio = (double)playCount / (double)groupCount;
+    return -ratio * log2(ratio);
+}
+
+inline double EntropyCriterion::getScore(double gain, long /* playTotal */, const vector<long>& /* splitPlayTotals */)
+{
+    return gain;
+}
+
+// Same as gain ratio. Gain is never more than the ratio, so this splits a little less often
+inline double EntropyCriterion::getMinimumScore()
+{
+    return 0.02;
+}
+
+// Gain is at most the entropy of the node, which is largest with every play type equally common
+inline double EntropyCriterion::getScoreRange()
+{
+    return log2((double)SinglePlay::getPlayTypeCount());
+}
+
+inline double GiniCriterion::getImpurity(long playCount, long groupCount)
+{
+    double ratio = (double)playCount / (double)groupCount;
+    return ratio * (1.0 - ratio);
+}
+
+inline double GiniCriterion::getScore(double gain, long /* playTotal */, const vector<long>& /* splitPlayTotals */)
+{
+    return gain;
+}
+
+/* Gini impurity is a third to a half of the entropy for the mixes of play types found in
+    practice, so the minimum is half that of entropy */
+inline double GiniCriterion::getMinimumScore()
+{
+    return 0.01;
+}
+
+inline double GiniCriterion::getScoreRange()
+{
+    return 1.0;
+}
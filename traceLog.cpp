@@ -0,0 +1,170 @@
+/* This file is part of NFLdecisionTree. It creates decision trees to classify
+    situations within NFL football games, and displays the plays historically
+    called in those situations given a set of opponents.
+
+    Copyright (C) 2013   Ezra Erb
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 3 as published
+    by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    I'd appreciate a note if you find this program useful or make
+    updates. Please contact me through LinkedIn (my profile also has
+    a link to the code depository)
+*/
+// The entire file compiles to nothing unless tracing is wanted
+#ifdef NFL_TRACE
+#include<ostream>
+#include<vector>
+#include<chrono>
+#include<atomic>
+#include"traceLog.h"
+
+using std::ostream;
+using std::vector;
+using std::endl;
+using std::atomic;
+
+// A single recorded event
+struct TraceEvent {
+    const char* name;
+    char phase; // B for begin, E for end, i for instant, as the format defines them
+    double timestamp; // Microseconds since recording started
+    const char* argNames[2];
+    long long argValues[2];
+};
+
+// Events recorded by one thread
+struct TraceBuffer {
+    unsigned int threadId;
+    vector<TraceEvent> events;
+    TraceBuffer* next; // Next buffer in the list of all of them
+};
+
+// Events per buffer to reserve up front, to avoid growing during short runs
+static const unsigned int InitialBufferSize = 4096;
+
+static atomic<bool> Enabled(false);
+static std::chrono::steady_clock::time_point StartTime;
+
+/* All buffers, newest first. Buffers are only added, never removed, until the program
+    ends. They are deliberately never freed, since threads may still hold them */
+static atomic<TraceBuffer*> BufferList(0);
+static atomic<unsigned int> NextThreadId(0);
+
+// This thread's buffer, created the first time it records
+static thread_local TraceBuffer* ThreadBuffer = 0;
+
+// Returns this thread's buffer, creating it if needed
+static TraceBuffer* getThreadBuffer()
+{
+    if (ThreadBuffer)
+        return ThreadBuffer;
+    TraceBuffer* buffer = new TraceBuffer;
+    buffer->threadId = NextThreadId.fetch_add(1);
+    buffer->events.reserve(InitialBufferSize);
+    // Push onto the front of the list. Retry if another thread got there first
+    buffer->next = BufferList.load();
+    while (!BufferList.compare_exchange_weak(buffer->next, buffer))
+        ; // Failed exchange reloads the list head into buffer->next
+    ThreadBuffer = buffer;
+    return buffer;
+}
+
+// Records one event in this thread's buffer
+static void record(const char* name, char phase, const char* argName1, long long argValue1,
+                   const char* argName2, long long argValue2)
+{
+    TraceEvent event;
+    event.name = name;
+    event.phase = phase;
+    event.timestamp = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - StartTime).count();
+    event.argNames[0] = argName1;
+    event.argValues[0] = argValue1;
+    event.argNames[1] = argName2;
+    event.argValues[1] = argValue2;
+    getThreadBuffer()->events.push_back(event);
+}
+
+// Starts recording. The time of this call is time zero in the trace
+void TraceLog::enable()
+{
+    StartTime = std::chrono::steady_clock::now();
+    Enabled.store(true);
+}
+
+// Whether recording is on
+bool TraceLog::isEnabled()
+{
+    return Enabled.load(std::memory_order_relaxed);
+}
+
+// Record events
+void TraceLog::begin(const char* name, const char* argName1, long long argValue1,
+                     const char* argName2, long long argValue2)
+{
+    if (isEnabled())
+        record(name, 'B', argName1, argValue1, argName2, argValue2);
+}
+
+void TraceLog::end(const char* name)
+{
+    if (isEnabled())
+        record(name, 'E', 0, 0, 0, 0);
+}
+
+void TraceLog::instant(const char* name, const char* argName1, long long argValue1,
+                       const char* argName2, long long argValue2)
+{
+    if (isEnabled())
+        record(name, 'i', argName1, argValue1, argName2, argValue2);
+}
+
+// Writes everything recorded as trace event JSON. No thread may be recording
+void TraceLog::write(ostream& stream)
+{
+    stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool firstEvent = true;
+    TraceBuffer* buffer;
+    for (buffer = BufferList.load(); buffer; buffer = buffer->next) {
+        // Name the thread, so the viewer labels its row
+        if (!firstEvent)
+            stream << ",";
+        firstEvent = false;
+        stream << endl << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->threadId
+               << ",\"args\":{\"name\":\"" << (buffer->threadId ? "worker " : "main ") << buffer->threadId << "\"}}";
+
+        vector<TraceEvent>::const_iterator index;
+        for (index = buffer->events.begin(); index != buffer->events.end(); index++) {
+            stream << "," << endl << "{\"name\":\"" << index->name << "\",\"ph\":\"" << index->phase
+                   << "\",\"ts\":" << std::fixed << index->timestamp << ",\"pid\":1,\"tid\":" << buffer->threadId;
+            // Instant events default to covering the whole process, which hides them
+            if (index->phase == 'i')
+                stream << ",\"s\":\"t\"";
+            if (index->argNames[0] || index->argNames[1]) {
+                stream << ",\"args\":{";
+                bool firstArg = true;
+                unsigned short argIndex;
+                for (argIndex = 0; argIndex < 2; argIndex++)
+                    if (index->argNames[argIndex]) {
+                        if (!firstArg)
+                            stream << ",";
+                        firstArg = false;
+                        stream << "\"" << index->argNames[argIndex] << "\":" << index->argValues[argIndex];
+                    }
+                stream << "}";
+            } // Event has arguments
+            stream << "}";
+        } // Loop through events
+    } // Loop through buffers
+    stream << endl << "]}" << endl;
+}
+#endif
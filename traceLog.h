@@ -0,0 +1,105 @@
+/* This file is part of NFLdecisionTree. It creates decision trees to classify
+    situations within NFL football games, and displays the plays historically
+    called in those situations given a set of opponents.
+
+    Copyright (C) 2013   Ezra Erb
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 3 as published
+    by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    I'd appreciate a note if you find this program useful or make
+    updates. Please contact me through LinkedIn (my profile also has
+    a link to the code depository)
+*/
+
+/* This class records a timeline of a run, written as Chrome trace event JSON which
+    can be opened in chrome://tracing or Perfetto. Totals, like those from --stats,
+    hide which particular season load or tree node took the time, and whether threads
+    sat waiting for each other. The timeline shows both.
+
+    Each thread records into its own buffer, so recording takes no locks and threads
+    never wait on each other to record. Buffers are linked into a list the first time
+    a thread records anything, which is the only shared update, and is done with a
+    single atomic exchange. The trace is written after all work is finished, so the
+    buffers are never read while being written.
+
+    Recording only happens once enable() is called, and the instrumentation macros
+    compile to nothing unless NFL_TRACE is defined.
+
+    Everything is static, since there is one timeline per process */
+
+using std::ostream; // Header deliberately not included, clients should already have it
+
+class TraceLog {
+public:
+    // Starts recording. The time of this call is time zero in the trace
+    static void enable();
+
+    // Whether recording is on
+    static bool isEnabled();
+
+    /* Record events. Names and argument names must be string constants, since only
+        the pointers are stored. Arguments with no name are left out */
+    static void begin(const char* name, const char* argName1 = 0, long long argValue1 = 0,
+                      const char* argName2 = 0, long long argValue2 = 0);
+    static void end(const char* name);
+    static void instant(const char* name, const char* argName1 = 0, long long argValue1 = 0,
+                        const char* argName2 = 0, long long argValue2 = 0);
+
+    // Writes everything recorded as trace event JSON. No thread may be recording
+    static void write(ostream& stream);
+};
+
+// Records a begin event on creation and the matching end event on destruction
+class TraceScope {
+public:
+    TraceScope(const char* name, const char* argName1 = 0, long long argValue1 = 0,
+               const char* argName2 = 0, long long argValue2 = 0);
+    ~TraceScope();
+
+private:
+    const char* _name;
+
+    // Prohibit copying, which would record the end twice
+    TraceScope(const TraceScope& other);
+    TraceScope& operator=(const TraceScope& other);
+};
+
+inline TraceScope::TraceScope(const char* name, const char* argName1, long long argValue1,
+                              const char* argName2, long long argValue2)
+    : _name(name)
+{
+    TraceLog::begin(name, argName1, argValue1, argName2, argValue2);
+}
+
+inline TraceScope::~TraceScope()
+{
+    TraceLog::end(_name);
+}
+
+/* Instrumentation macros. These are the only things code being traced should use.
+    TRACE_SCOPE takes a name followed by up to two name and value pairs.
+    TRICKY NOTE: The scope objects need a unique name in case several are in the same
+    block. The double macro is the standard way to paste the line number onto it */
+#ifdef NFL_TRACE
+#define TRACE_NAME_HELPER(name, line) name##line
+#define TRACE_NAME(name, line) TRACE_NAME_HELPER(name, line)
+#define TRACE_SCOPE(...) TraceScope TRACE_NAME(traceScope, __LINE__)(__VA_ARGS__)
+#define TRACE_BEGIN(...) TraceLog::begin(__VA_ARGS__)
+#define TRACE_END(name) TraceLog::end(name)
+#define TRACE_INSTANT(...) TraceLog::instant(__VA_ARGS__)
+#else
+#define TRACE_SCOPE(...)
+#define TRACE_BEGIN(...)
+#define TRACE_END(name)
+#define TRACE_INSTANT(...)
+#endif
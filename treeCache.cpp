@@ -0,0 +1,195 @@
+/* This file is part of NFLdecisionTree. It creates decision trees to classify
+    situations within NFL football games, and displays the plays historically
+    called in those situations given a set of opponents.
+
+    Copyright (C) 2013   Ezra Erb
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 3 as published
+    by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    I'd appreciate a note if you find this program useful or make
+    updates. Please contact me through LinkedIn (my profile also has
+    a link to the code depository)
+*/
+#include<string>
+#include<vector>
+#include<fstream>
+#include<sstream>
+#include<iostream>
+#include<cstdio>
+#include<cstring>
+
+#include"baseException.h"
+#include"singlePlay.h" // Needed by playIndexSet.h
+#include"playIndexSet.h" // Needed by decisionNode.h
+#include"playStats.h" // Needed by decisionNode.h
+#include"allocTracker.h" // Needed by dataStore.h
+#include"dataStore.h" // Needed by leagueStore.h
+#include"playLoader.h" // Needed by leagueStore.h
+#include"leagueStore.h"
+#include"decisionNode.h"
+#include"treeCache.h"
+
+#include<sys/types.h>
+#include<sys/stat.h>
+#ifndef _WIN32
+#include<unistd.h>
+#include<climits>
+#include<cstdlib>
+#endif
+
+using std::string;
+using std::vector;
+using std::ifstream;
+using std::ofstream;
+using std::stringstream;
+using std::getline;
+
+// Constructor. The directory must already exist
+TreeCache::TreeCache(const string& directory)
+    : _directory(directory)
+{
+    // All in the initialization list
+}
+
+/* Returns the key for a matchup, built with the current split options. The data source
+    names the plays used (see getDirectorySource and getLeagueSource) */
+string TreeCache::makeKey(const string& thisTeam, const string& otherTeam,
+                          const vector<string>& thisSimiliar, const vector<string>& otherSimiliar,
+                          unsigned short firstSeason, unsigned short lastSeason, const string& dataSource)
+{
+    stringstream key;
+    key << thisTeam << " " << otherTeam << " -u";
+    vector<string>::const_iterator team;
+    for (team = thisSimiliar.begin(); team != thisSimiliar.end(); team++)
+        key << " " << *team;
+    key << " -o";
+    for (team = otherSimiliar.begin(); team != otherSimiliar.end(); team++)
+        key << " " << *team;
+    key << " seasons " << firstSeason << "-" << lastSeason;
+    key << " " << dataSource;
+    key << ((DecisionNode::getSplitMode() == DecisionNode::binary_split) ? " binary" : " category");
+    key << ((DecisionNode::getSplitSelection() == DecisionNode::sampled_selection) ? " sampled" : " exact");
+    key << " " << DecisionNode::getCriterionName(DecisionNode::getSplitCriterion());
+    if (DecisionNode::getSplitTarget() == DecisionNode::yardage_target)
+        key << " yardage " << DecisionNode::getYardagePlayType();
+    return key.str();
+}
+
+/* Returns the full path of a file or directory, so the same data reached by different
+    relative paths gets the same key. Names that can't be resolved are returned as is */
+static string canonicalName(const string& name)
+{
+#ifdef _WIN32
+    return name;
+#else
+    char fullName[PATH_MAX];
+    if (realpath(name.c_str(), fullName) == NULL)
+        return name;
+    return string(fullName);
+#endif
+}
+
+/* Returns the data source for plays loaded from a directory, for a range of seasons,
+    [first...last]. Season files that don't exist are named as missing */
+string TreeCache::getDirectorySource(const string& dataDirectory, unsigned short firstSeason,
+                                     unsigned short lastSeason)
+{
+    string directory(canonicalName(dataDirectory));
+    stringstream source;
+    source << "data " << directory;
+    unsigned short seasonYear;
+    for (seasonYear = firstSeason; seasonYear <= lastSeason; seasonYear++) {
+        struct stat fileStatus;
+        source << " " << seasonYear << ":";
+        if (stat(PlayLoader::getSeasonFileName(directory, seasonYear).c_str(), &fileStatus) != 0)
+            source << "missing";
+        else
+            source << (unsigned long long)fileStatus.st_size << "@" << (long long)fileStatus.st_mtime;
+    }
+    return source.str();
+}
+
+// Returns the data source for plays from a league store, which must be attached
+string TreeCache::getLeagueSource(const string& leagueName, const LeagueStore& league)
+{
+    stringstream source;
+    // Names without a '/' are shared memory objects, not files
+    if (leagueName.find('/') == string::npos)
+        source << "league " << leagueName;
+    else
+        source << "league " << canonicalName(leagueName);
+    source << " generation " << league.getGeneration();
+    return source.str();
+}
+
+// Writes the cached result for a matchup to a stream. Returns false if there is none for this key
+bool TreeCache::fetch(const string& thisTeam, const string& otherTeam, const string& key, ostream& stream) const
+{
+    ifstream entry(getEntryName(thisTeam, otherTeam).c_str(), std::ios::binary);
+    if (!entry.is_open())
+        return false;
+    string entryKey;
+    if ((!getline(entry, entryKey)) || (entryKey != key))
+        return false;
+    stream << entry.rdbuf();
+    return true;
+}
+
+// Returns whether the cached result for a matchup has this key
+bool TreeCache::contains(const string& thisTeam, const string& otherTeam, const string& key) const
+{
+    ifstream entry(getEntryName(thisTeam, otherTeam).c_str(), std::ios::binary);
+    string entryKey;
+    return (entry.is_open() && getline(entry, entryKey) && (entryKey == key));
+}
+
+// Caches the result for a matchup, replacing any older one
+void TreeCache::store(const string& thisTeam, const string& otherTeam, const string& key, const string& result) const
+{
+    string entryName(getEntryName(thisTeam, otherTeam));
+    stringstream tempName;
+    tempName << entryName << ".tmp";
+#ifndef _WIN32
+    // Several precompute runs could share a cache, so each needs its own temporary file
+    tempName << "." << getpid();
+#endif
+    {
+        ofstream entry(tempName.str().c_str(), std::ios::binary);
+        if (!entry.is_open())
+            throw BaseException(__FILE__, __LINE__, "Could not create tree cache entry");
+        entry << key << "\n" << result;
+        entry.close();
+        if (entry.fail()) {
+            remove(tempName.str().c_str());
+            throw BaseException(__FILE__, __LINE__, "Could not write tree cache entry");
+        }
+    }
+#ifdef _WIN32
+    // Windows won't rename over an existing file
+    remove(entryName.c_str());
+#endif
+    if (rename(tempName.str().c_str(), entryName.c_str()) != 0) {
+        remove(tempName.str().c_str());
+        throw BaseException(__FILE__, __LINE__, "Could not replace tree cache entry");
+    }
+}
+
+// Returns the file name of the entry for a matchup
+string TreeCache::getEntryName(const string& thisTeam, const string& otherTeam) const
+{
+#ifdef _WIN32
+    return _directory + "\\" + thisTeam + "_" + otherTeam + ".tree";
+#else
+    return _directory + "/" + thisTeam + "_" + otherTeam + ".tree";
+#endif
+}
@@ -0,0 +1,81 @@
+/* This file is part of NFLdecisionTree. It creates decision trees to classify
+    situations within NFL football games, and displays the plays historically
+    called in those situations given a set of opponents.
+
+    Copyright (C) 2013   Ezra Erb
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 3 as published
+    by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    I'd appreciate a note if you find this program useful or make
+    updates. Please contact me through LinkedIn (my profile also has
+    a link to the code depository)
+*/
+
+/* This class caches finished results, the text written to result.txt, in a directory so
+    a run for a matchup someone built earlier can skip straight to the answer. Trees for the
+    coming week's games are built ahead of time by the precompute mode (see Precomputer),
+    so the first query for each is answered at once.
+
+    Each matchup has one entry, a file named after the two teams. The first line of the
+    entry is its key, which names everything that changes the tree: the teams, the
+    similiar teams in order, the seasons, where the plays come from and the split options.
+    A run only uses an entry whose key matches its own exactly, so changing anything builds
+    the tree again. The source names the plays themselves, not just where they live: the
+    full path of the data directory with the size and modification time of every season
+    file read, or the league store name with the generation stamp of its segment. Files or
+    a store replaced in place give a new key, so old entries are simply never used again.
+
+    Entries are written to a temporary file and renamed into place, so a run reading an
+    entry while it is replaced gets either the old or the new one, never a mix */
+using std::string; // Header deliberately not included, clients should already have it
+using std::vector;
+using std::ostream;
+
+class LeagueStore; // Only used by reference here
+
+class TreeCache {
+public:
+    // Constructor. The directory must already exist
+    explicit TreeCache(const string& directory);
+
+    // Use the default destructor
+
+    /* Returns the key for a matchup, built with the current split options. The data source
+        names the plays used (see getDirectorySource and getLeagueSource) */
+    static string makeKey(const string& thisTeam, const string& otherTeam,
+                          const vector<string>& thisSimiliar, const vector<string>& otherSimiliar,
+                          unsigned short firstSeason, unsigned short lastSeason, const string& dataSource);
+
+    /* Returns the data source for plays loaded from a directory, for a range of seasons,
+        [first...last]. Season files that don't exist are named as missing */
+    static string getDirectorySource(const string& dataDirectory, unsigned short firstSeason,
+                                     unsigned short lastSeason);
+
+    // Returns the data source for plays from a league store, which must be attached
+    static string getLeagueSource(const string& leagueName, const LeagueStore& league);
+
+    // Writes the cached result for a matchup to a stream. Returns false if there is none for this key
+    bool fetch(const string& thisTeam, const string& otherTeam, const string& key, ostream& stream) const;
+
+    // Returns whether the cached result for a matchup has this key
+    bool contains(const string& thisTeam, const string& otherTeam, const string& key) const;
+
+    // Caches the result for a matchup, replacing any older one
+    void store(const string& thisTeam, const string& otherTeam, const string& key, const string& result) const;
+
+private:
+    string _directory;
+
+    // Returns the file name of the entry for a matchup
+    string getEntryName(const string& thisTeam, const string& otherTeam) const;
+};
@@ -0,0 +1,359 @@
+/* This file is part of NFLdecisionTree. It creates decision trees to classify
+    situations within NFL football games, and displays the plays historically
+    called in those situations given a set of opponents.
+
+    Copyright (C) 2013   Ezra Erb
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 3 as published
+    by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    I'd appreciate a note if you find this program useful or make
+    updates. Please contact me through LinkedIn (my profile also has
+    a link to the code depository)
+*/
+#include<ostream>
+#include<sstream>
+#include<string>
+#include<vector>
+#include<map>
+#include"singlePlay.h"
+#include"playIndexSet.h" // Needed by decisionNode.h
+#include"playStats.h"
+#include"decisionNode.h"
+#include"treeExporter.h"
+
+using std::ostream;
+using std::stringstream;
+using std::string;
+using std::vector;
+using std::endl;
+
+// Names of the lookup parameters, in the order of SinglePlay::PlayCharacteristic
+static const char* CharacteristicParameters[] = { "down", "distanceNeeded", "fieldLocation",
+                                                  "timeRemaining", "scoreDifferential" };
+
+// Distances written on each line of the distance array
+static const unsigned short DistancesPerLine = 16;
+
+// Writes the indent for a line of generated code, four spaces per level
+static void writeIndent(ostream& stream, unsigned short indent)
+{
+    unsigned short level;
+    for (level = 0; level < indent; level++)
+        stream << "    ";
+}
+
+/* Writes the tree as a header. Everything in it is in a namespace with the given
+    name. The teams are only used for the comment at the top */
+void TreeExporter::write(ostream& stream, const string& namespaceName, const string& thisTeam,
+                         const string& otherTeam, const vector<string>& thisSimiliar,
+                         const vector<string>& otherSimiliar, const DecisionNode& tree)
+{
+    /* The lookup is written first, since walking the tree for it finds the leaves. It
+        goes at the end of the header, after the leaves it refers to */
+    vector<const DecisionNode*> leaves;
+    vector<bool> used(sizeof(CharacteristicParameters) / sizeof(CharacteristicParameters[0]), false);
+    stringstream lookup;
+    writeLookup(lookup, tree, 1, leaves, used);
+
+    stream << "/* Decision tree for " << thisTeam << " against " << otherTeam;
+    vector<string>::const_iterator team;
+    if (!thisSimiliar.empty()) {
+        stream << ", similiar to us:";
+        for (team = thisSimiliar.begin(); team != thisSimiliar.end(); team++)
+            stream << " " << *team;
+    }
+    if (!otherSimiliar.empty()) {
+        stream << ", similiar to opponent:";
+        for (team = otherSimiliar.begin(); team != otherSimiliar.end(); team++)
+            stream << " " << *team;
+    }
+    stream << endl;
+    stream << "    Generated by NFLdecisionTree with --export. Do not edit, export the tree again instead" << endl;
+    stream << endl;
+    stream << "    findLeaf() returns the leaf for a situation given as categories, with the values" << endl;
+    stream << "    SinglePlay uses for them, and findSituationLeaf() does the same for a situation" << endl;
+    stream << "    given as a down, yards to go, yard line, minutes left in the game and the scores." << endl;
+    stream << "    Both return -1 if no plays were seen in the situation. The plays of leaf N are" << endl;
+    stream << "    LeafPlays[Leaves[N].firstPlay] onward, Leaves[N].playCount of them */" << endl;
+    stream << "namespace " << namespaceName << " {" << endl;
+    stream << endl;
+    stream << "// Names of the play types, in the order of LeafPlay::playType" << endl;
+    stream << "static const char* const PlayTypeNames[] = {" << endl;
+    unsigned short playType;
+    for (playType = 0; playType < SinglePlay::getPlayTypeCount(); playType++) {
+        stream << "    \"" << (SinglePlay::PlayType)playType << "\"";
+        if (playType + 1 < SinglePlay::getPlayTypeCount())
+            stream << ",";
+        stream << endl;
+    }
+    stream << "};" << endl;
+    stream << endl;
+    stream << "// Statistics for the plays of one type in a leaf, the same ones result.txt shows" << endl;
+    stream << "struct LeafPlay {" << endl;
+    stream << "    unsigned char playType;" << endl;
+    stream << "    int playCount;" << endl;
+    stream << "    short percentOfLeafPlays; // In 0.1%" << endl;
+    stream << "    short percentOfTypePlays; // In 0.1%" << endl;
+    stream << "    short averageDistance;" << endl;
+    stream << "    short distanceVariance;" << endl;
+    stream << "    short turnoverPercentage; // In 0.1%" << endl;
+    stream << "    unsigned int firstDistance; // Distances gained, sorted, playCount of them in LeafDistances" << endl;
+    stream << "};" << endl;
+    stream << endl;
+    stream << "// The plays in a leaf, one LeafPlay per play type" << endl;
+    stream << "struct Leaf {" << endl;
+    stream << "    unsigned short firstPlay;" << endl;
+    stream << "    unsigned short playCount;" << endl;
+    stream << "};" << endl;
+    stream << endl;
+    writeLeaves(stream, leaves);
+    stream << endl;
+
+    /* The lookup on categories, then the conversions to them and the lookup on raw values.
+        Characteristics the tree never splits on are left unnamed, so compilers don't warn */
+    stream << "inline int findLeaf(";
+    unsigned short characteristic;
+    for (characteristic = 0; characteristic < used.size(); characteristic++) {
+        // Parameters after the third line up under the first
+        if (characteristic == SinglePlay::time_remaining)
+            stream << "," << endl << "                    ";
+        else if (characteristic)
+            stream << ", ";
+        if (used[characteristic])
+            stream << "int " << CharacteristicParameters[characteristic];
+        else
+            stream << "int /* " << CharacteristicParameters[characteristic] << " */";
+    }
+    stream << ")" << endl;
+    stream << "{" << endl;
+    stream << lookup.str();
+    stream << "}" << endl;
+    stream << endl;
+    /* WARNING: These must match the conversions in singlePlay.h. The categories are
+        written from the enums, so only the limits can differ */
+    stream << "// Conversions from a situation to categories, the same as SinglePlay makes" << endl;
+    stream << "inline int getDistanceNeeded(int distanceNeeded)" << endl;
+    stream << "{" << endl;
+    stream << "    if (distanceNeeded <= 1)" << endl;
+    stream << "        return " << (int)SinglePlay::one_or_less << ";" << endl;
+    stream << "    else if (distanceNeeded <= 4)" << endl;
+    stream << "        return " << (int)SinglePlay::four_to_one << ";" << endl;
+    stream << "    else if (distanceNeeded <= 10)" << endl;
+    stream << "        return " << (int)SinglePlay::ten_to_four << ";" << endl;
+    stream << "    else if (distanceNeeded < 20)" << endl;
+    stream << "        return " << (int)SinglePlay::twenty_to_ten << ";" << endl;
+    stream << "    else" << endl;
+    stream << "        return " << (int)SinglePlay::over_twenty << ";" << endl;
+    stream << "}" << endl;
+    stream << endl;
+    stream << "inline int getFieldLocation(int yardLine)" << endl;
+    stream << "{" << endl;
+    stream << "    if (yardLine >= 90)" << endl;
+    stream << "        return " << (int)SinglePlay::own_red_zone << ";" << endl;
+    stream << "    else if (yardLine > 10)" << endl;
+    stream << "        return " << (int)SinglePlay::middle << ";" << endl;
+    stream << "    else" << endl;
+    stream << "        return " << (int)SinglePlay::opp_red_zone << ";" << endl;
+    stream << "}" << endl;
+    stream << endl;
+    stream << "inline int getTimeRemaining(int minutes)" << endl;
+    stream << "{" << endl;
+    stream << "    if ((minutes < 2) || ((minutes >= 30) && (minutes < 32)))" << endl;
+    stream << "        return " << (int)SinglePlay::inside_two_minutes << ";" << endl;
+    stream << "    else" << endl;
+    stream << "        return " << (int)SinglePlay::outside_two_minutes << ";" << endl;
+    stream << "}" << endl;
+    stream << endl;
+    stream << "inline int getScoreDifferential(int ownScore, int oppScore)" << endl;
+    stream << "{" << endl;
+    stream << "    int scoreDiff = ownScore - oppScore;" << endl;
+    stream << "    if (scoreDiff < -14)" << endl;
+    stream << "        return " << (int)SinglePlay::down_over_fourteen << ";" << endl;
+    stream << "    else if (scoreDiff < -7)" << endl;
+    stream << "        return " << (int)SinglePlay::down_over_seven << ";" << endl;
+    stream << "    else if (scoreDiff < 0)" << endl;
+    stream << "        return " << (int)SinglePlay::down_seven_less << ";" << endl;
+    stream << "    else if (!scoreDiff)" << endl;
+    stream << "        return " << (int)SinglePlay::even << ";" << endl;
+    stream << "    else if (scoreDiff <= 7)" << endl;
+    stream << "        return " << (int)SinglePlay::up_seven_less << ";" << endl;
+    stream << "    else if (scoreDiff <= 14)" << endl;
+    stream << "        return " << (int)SinglePlay::up_over_seven << ";" << endl;
+    stream << "    else" << endl;
+    stream << "        return " << (int)SinglePlay::up_over_fourteen << ";" << endl;
+    stream << "}" << endl;
+    stream << endl;
+    stream << "inline int findSituationLeaf(int down, int distanceNeeded, int yardLine, int minutes," << endl;
+    stream << "                             int ownScore, int oppScore)" << endl;
+    stream << "{" << endl;
+    stream << "    return findLeaf(down, getDistanceNeeded(distanceNeeded), getFieldLocation(yardLine)," << endl;
+    stream << "                    getTimeRemaining(minutes), getScoreDifferential(ownScore, oppScore));" << endl;
+    stream << "}" << endl;
+    stream << endl;
+    stream << "} // namespace " << namespaceName << endl;
+}
+
+// Returns the default namespace for a matchup, nflTree_THIS_OTHER
+string TreeExporter::getNamespaceName(const string& thisTeam, const string& otherTeam)
+{
+    return string("nflTree_") + thisTeam + string("_") + otherTeam;
+}
+
+/* Writes the lookup code for a node and everything below it, indented by the given
+    amount. Leaves with plays are added to the list, and their code returns their
+    place in it. Characteristics split on are flagged in the used list */
+void TreeExporter::writeLookup(ostream& stream, const DecisionNode& node, unsigned short indent,
+                               vector<const DecisionNode*>& leaves, vector<bool>& used)
+{
+    if (node.isLeaf()) {
+        writeIndent(stream, indent);
+        // A leaf without plays is the same as a situation never seen
+        if (node._playData.empty())
+            stream << "return -1;" << endl;
+        else {
+            stream << "return " << leaves.size() << ";" << endl;
+            leaves.push_back(&node);
+        }
+        return;
+    }
+
+    /* Each child gets the case labels of all the categories leading to it. Categories
+        with no child, which had no plays when the tree was built, go to the default */
+    used[node._decisionValue] = true;
+    writeIndent(stream, indent);
+    stream << "switch (" << CharacteristicParameters[node._decisionValue] << ") {" << endl;
+    short childIndex;
+    short category;
+    for (childIndex = 0; childIndex < (short)node._childNodes.size(); childIndex++) {
+        for (category = 0; category < (short)node._categoryChildMapping.size(); category++)
+            if (node._categoryChildMapping[category] == childIndex) {
+                writeIndent(stream, indent);
+                stream << "case " << category << ": // ";
+                writeCategoryName(stream, node._decisionValue, category);
+                stream << endl;
+            }
+        writeLookup(stream, *node._childNodes[childIndex], indent + 1, leaves, used);
+    } // Loop through children
+    writeIndent(stream, indent);
+    stream << "default:" << endl;
+    writeIndent(stream, indent + 1);
+    stream << "return -1;" << endl;
+    writeIndent(stream, indent);
+    stream << "}" << endl;
+}
+
+// Writes the plays, with their distances, for every leaf in the list
+void TreeExporter::writeLeaves(ostream& stream, const vector<const DecisionNode*>& leaves)
+{
+    /* The distances of every play type of every leaf go in one array, in leaf order,
+        like the distance pool of the tree once it is compacted */
+    stream << "static const short LeafDistances[] = {";
+    unsigned int distanceCount = 0;
+    vector<const DecisionNode*>::const_iterator leaf;
+    DetailedPlayData::const_iterator playPtr;
+    long index;
+    for (leaf = leaves.begin(); leaf != leaves.end(); leaf++)
+        for (playPtr = (*leaf)->_playData.begin(); playPtr != (*leaf)->_playData.end(); playPtr++) {
+            const short* distances = playPtr->second.getPlayDistances();
+            for (index = 0; index < playPtr->second.getPlayCount(); index++) {
+                if (distanceCount)
+                    stream << ",";
+                if (!(distanceCount % DistancesPerLine)) {
+                    stream << endl;
+                    writeIndent(stream, 1);
+                }
+                else
+                    stream << " ";
+                stream << distances[index];
+                distanceCount++;
+            }
+        } // Loop through play types of each leaf
+    // Arrays can't be empty
+    if (!distanceCount) {
+        stream << endl;
+        writeIndent(stream, 1);
+        stream << "0";
+    }
+    stream << endl << "};" << endl;
+    stream << endl;
+
+    stream << "static const LeafPlay LeafPlays[] = {" << endl;
+    unsigned int firstDistance = 0;
+    DetailedPlayData::const_iterator nextPlay;
+    for (leaf = leaves.begin(); leaf != leaves.end(); leaf++)
+        for (playPtr = (*leaf)->_playData.begin(); playPtr != (*leaf)->_playData.end(); playPtr++) {
+            const DetailedPlaySummary& summary = playPtr->second;
+            writeIndent(stream, 1);
+            stream << "{ " << (int)playPtr->first << ", " << summary.getPlayCount() << ", "
+                   << summary.getPercentOfConditionPlays() << ", " << summary.getPercentOfTypePlays() << ", "
+                   << summary.getAverageDistance() << ", " << summary.getDistanceVariance() << ", "
+                   << summary.getTurnoverPercentage() << ", " << firstDistance << " }";
+            firstDistance += summary.getPlayCount();
+            // Every leaf has plays, so only the last play of the last leaf has no comma
+            nextPlay = playPtr;
+            nextPlay++;
+            if ((leaf + 1 != leaves.end()) || (nextPlay != (*leaf)->_playData.end()))
+                stream << ",";
+            stream << " // Leaf " << (leaf - leaves.begin()) << ", " << playPtr->first << endl;
+        } // Loop through play types of each leaf
+    if (leaves.empty()) {
+        writeIndent(stream, 1);
+        stream << "{ 0, 0, 0, 0, 0, 0, 0, 0 }" << endl;
+    }
+    stream << "};" << endl;
+    stream << endl;
+
+    stream << "static const Leaf Leaves[] = {" << endl;
+    unsigned short firstPlay = 0;
+    for (leaf = leaves.begin(); leaf != leaves.end(); leaf++) {
+        writeIndent(stream, 1);
+        stream << "{ " << firstPlay << ", " << (*leaf)->_playData.size() << " }";
+        if (leaf + 1 != leaves.end())
+            stream << ",";
+        stream << endl;
+        firstPlay += (unsigned short)(*leaf)->_playData.size();
+    }
+    if (leaves.empty()) {
+        writeIndent(stream, 1);
+        stream << "{ 0, 0 }" << endl;
+    }
+    stream << "};" << endl;
+    stream << endl;
+    stream << "static const int LeafCount = " << leaves.size() << ";" << endl;
+}
+
+// Writes the name of a category of a characteristic, for comments
+void TreeExporter::writeCategoryName(ostream& stream, SinglePlay::PlayCharacteristic characteristic,
+                                     short category)
+{
+    switch (characteristic) {
+    case SinglePlay::distance_needed:
+        stream << (SinglePlay::DistanceNeeded)category;
+        break;
+
+    case SinglePlay::field_location:
+        stream << (SinglePlay::FieldLocation)category;
+        break;
+
+    case SinglePlay::time_remaining:
+        stream << (SinglePlay::TimeRemaining)category;
+        break;
+
+    case SinglePlay::score_differential:
+        stream << (SinglePlay::ScoreDifferential)category;
+        break;
+
+    default:
+        stream << "Down " << category;
+    } // Switch on characteristic
+}
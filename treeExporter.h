@@ -0,0 +1,58 @@
+/* This file is part of NFLdecisionTree. It creates decision trees to classify
+    situations within NFL football games, and displays the plays historically
+    called in those situations given a set of opponents.
+
+    Copyright (C) 2013   Ezra Erb
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 3 as published
+    by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    I'd appreciate a note if you find this program useful or make
+    updates. Please contact me through LinkedIn (my profile also has
+    a link to the code depository)
+*/
+
+/* This class exports a pruned tree as a self-contained C++ header, for programs that
+    only need to look up situations in a finished tree. The tree becomes a function of
+    nested switch statements over the situation categories, which returns the number
+    of a leaf. The plays of each leaf are static const arrays, so the tree needs no
+    building or loading at all, and the compiler can optimize the lookup like any other
+    code. The header has no includes and does not need this program to compile */
+using std::ostream; // Headers deliberately not included, clients should already have them
+using std::string;
+using std::vector;
+
+class TreeExporter {
+public:
+    /* Writes the tree as a header. Everything in it is in a namespace with the given
+        name. The teams are only used for the comment at the top */
+    static void write(ostream& stream, const string& namespaceName, const string& thisTeam,
+                      const string& otherTeam, const vector<string>& thisSimiliar,
+                      const vector<string>& otherSimiliar, const DecisionNode& tree);
+
+    // Returns the default namespace for a matchup, nflTree_THIS_OTHER
+    static string getNamespaceName(const string& thisTeam, const string& otherTeam);
+
+private:
+    /* Writes the lookup code for a node and everything below it, indented by the given
+        amount. Leaves with plays are added to the list, and their code returns their
+        place in it. Characteristics split on are flagged in the used list */
+    static void writeLookup(ostream& stream, const DecisionNode& node, unsigned short indent,
+                            vector<const DecisionNode*>& leaves, vector<bool>& used);
+
+    // Writes the plays, with their distances, for every leaf in the list
+    static void writeLeaves(ostream& stream, const vector<const DecisionNode*>& leaves);
+
+    // Writes the name of a category of a characteristic, for comments
+    static void writeCategoryName(ostream& stream, SinglePlay::PlayCharacteristic characteristic,
+                                  short category);
+};
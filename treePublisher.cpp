@@ -0,0 +1,178 @@
+/* This file is part of NFLdecisionTree. It creates decision trees to classify
+    situations within NFL football games, and displays the plays historically
+    called in those situations given a set of opponents.
+
+    Copyright (C) 2013   Ezra Erb
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 3 as published
+    by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    I'd appreciate a note if you find this program useful or make
+    updates. Please contact me through LinkedIn (my profile also has
+    a link to the code depository)
+*/
+#include<vector>
+#include<ostream>
+#include<atomic>
+#include<mutex>
+#include<utility>
+#include"singlePlay.h"
+#include"playIndexSet.h" // Needed by playStats.h
+#include"playStats.h" // Needed by decisionNode.h
+#include"decisionNode.h"
+#include"treePublisher.h"
+#include"baseException.h"
+
+using std::vector;
+using std::atomic;
+using std::mutex;
+using std::lock_guard;
+using std::pair;
+using std::make_pair;
+
+/* Epoch announced by a reader slot that is not reading. Epochs start above it, so any
+    reading slot has a larger value */
+static const unsigned long long NotReading = 0;
+
+/* One slot for each reader. The announced epoch is written on every query, so each slot
+    gets its own cache line; otherwise readers on different processors would keep taking
+    the line from each other */
+struct ReaderSlot {
+    atomic<unsigned long long> epoch;
+    atomic<bool> claimed;
+    char padding[64 - sizeof(atomic<unsigned long long>) - sizeof(atomic<bool>)];
+};
+
+struct TreePublisher::PublisherState {
+    atomic<DecisionNode*> currentTree;
+    atomic<unsigned long long> epoch;
+    ReaderSlot readers[MaxReaders];
+
+    // Retired trees, with the first epoch whose readers can't be using them
+    mutex writerLock;
+    vector<pair<DecisionNode*, unsigned long long> > retiredTrees;
+};
+
+// Creates a publisher with no tree
+TreePublisher::TreePublisher()
+    : _state(new PublisherState())
+{
+    _state->currentTree.store(NULL);
+    _state->epoch.store(NotReading + 1);
+    unsigned short readerId;
+    for (readerId = 0; readerId < MaxReaders; readerId++) {
+        _state->readers[readerId].epoch.store(NotReading);
+        _state->readers[readerId].claimed.store(false);
+    }
+}
+
+/* Destructor. Deletes the current tree and any retired ones.
+    WARNING: No reader may still be reading */
+TreePublisher::~TreePublisher()
+{
+    delete _state->currentTree.load();
+    vector<pair<DecisionNode*, unsigned long long> >::iterator retired;
+    for (retired = _state->retiredTrees.begin(); retired != _state->retiredTrees.end(); retired++)
+        delete retired->first;
+    delete _state;
+}
+
+/* Publishes a new tree, which the publisher then owns. Readers that start after this
+    get the new tree. The old one is retired and deleted once no reader can still be
+    using it */
+void TreePublisher::publish(DecisionNode* tree)
+{
+    lock_guard<mutex> lock(_state->writerLock);
+    /* Swap first, then move to the next epoch. A reader that sees the new epoch must see
+        the new tree as well, since the accesses are sequentially consistent */
+    DecisionNode* oldTree = _state->currentTree.exchange(tree);
+    unsigned long long newEpoch = _state->epoch.fetch_add(1) + 1;
+    if (oldTree != NULL)
+        _state->retiredTrees.push_back(make_pair(oldTree, newEpoch));
+    reclaimLocked();
+}
+
+// Deletes retired trees no reader can still be using. Publishing does this as well
+void TreePublisher::reclaim()
+{
+    lock_guard<mutex> lock(_state->writerLock);
+    reclaimLocked();
+}
+
+// Deletes retired trees no reader can still be using. The writer lock must be held
+void TreePublisher::reclaimLocked()
+{
+    if (_state->retiredTrees.empty())
+        return;
+
+    /* Find the oldest epoch a reader is reading in. A tree retired at a later epoch than
+        that could still be in use. TRICKY NOTE: A reader may have read the epoch but not
+        announced it yet, so the scan misses it. That is safe: it announces before loading
+        the tree pointer, and the swap came before this scan, so it loads the new tree */
+    unsigned long long oldestEpoch = _state->epoch.load();
+    unsigned short readerId;
+    for (readerId = 0; readerId < MaxReaders; readerId++) {
+        unsigned long long readerEpoch = _state->readers[readerId].epoch.load();
+        if ((readerEpoch != NotReading) && (readerEpoch < oldestEpoch))
+            oldestEpoch = readerEpoch;
+    }
+
+    vector<pair<DecisionNode*, unsigned long long> > stillUsed;
+    vector<pair<DecisionNode*, unsigned long long> >::iterator retired;
+    for (retired = _state->retiredTrees.begin(); retired != _state->retiredTrees.end(); retired++)
+        if (retired->second <= oldestEpoch)
+            delete retired->first;
+        else
+            stillUsed.push_back(*retired);
+    _state->retiredTrees.swap(stillUsed);
+}
+
+// Number of trees retired but not yet deleted
+unsigned int TreePublisher::getRetiredCount() const
+{
+    lock_guard<mutex> lock(_state->writerLock);
+    return _state->retiredTrees.size();
+}
+
+// Claims a reader slot, for the calling thread to read with. Throws if all are taken
+unsigned short TreePublisher::registerReader()
+{
+    unsigned short readerId;
+    for (readerId = 0; readerId < MaxReaders; readerId++) {
+        bool expected = false;
+        if (_state->readers[readerId].claimed.compare_exchange_strong(expected, true))
+            return readerId;
+    }
+    throw BaseException(__FILE__, __LINE__, "Tree publisher has no reader slots left");
+}
+
+// Releases a reader slot. The thread must not be reading with it
+void TreePublisher::unregisterReader(unsigned short readerId)
+{
+    _state->readers[readerId].epoch.store(NotReading);
+    _state->readers[readerId].claimed.store(false);
+}
+
+// Starts a read for a reader slot, and returns the current tree
+const DecisionNode* TreePublisher::startRead(unsigned short readerId) const
+{
+    /* Announce the epoch, then load the tree. Both are sequentially consistent, so a
+        writer scanning the slots either sees the announcement or this load sees its swap */
+    _state->readers[readerId].epoch.store(_state->epoch.load());
+    return _state->currentTree.load();
+}
+
+// Ends a read for a reader slot
+void TreePublisher::endRead(unsigned short readerId) const
+{
+    _state->readers[readerId].epoch.store(NotReading, std::memory_order_release);
+}
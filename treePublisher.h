@@ -0,0 +1,120 @@
+/* This file is part of NFLdecisionTree. It creates decision trees to classify
+    situations within NFL football games, and displays the plays historically
+    called in those situations given a set of opponents.
+
+    Copyright (C) 2013   Ezra Erb
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 3 as published
+    by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    I'd appreciate a note if you find this program useful or make
+    updates. Please contact me through LinkedIn (my profile also has
+    a link to the code depository)
+*/
+
+/* This class lets a serving process keep answering queries from a decision tree while a
+    new tree for the same matchup is built. Queries must not wait for the build, and must
+    never see a tree that is being deleted.
+
+    It uses read-copy-update with epochs. The publisher holds a pointer to the current
+    tree and an epoch counter. A reader announces the epoch it started in, then loads the
+    pointer; no locks, and nothing a writer does makes it wait. Publishing a new tree swaps
+    the pointer and moves to the next epoch. The old tree is retired, not deleted, and is
+    only deleted once every reader still reading announced an epoch after the swap, since
+    those readers must have loaded the new pointer. Readers that were reading the old tree
+    finish with it undisturbed.
+
+    Each reader thread claims a slot before reading, and holds it for as long as it reads.
+    Slots are few and fixed, so deciding whether a tree is still in use means scanning
+    them, which only writers do. Writers are serialized with a lock between themselves.
+
+    WARNING: A slot can only be used by one ReadGuard at a time */
+class TreePublisher {
+public:
+    // Most reader slots that can be claimed at once
+    static const unsigned short MaxReaders = 64;
+
+    // Creates a publisher with no tree
+    TreePublisher();
+
+    /* Destructor. Deletes the current tree and any retired ones.
+        WARNING: No reader may still be reading */
+    ~TreePublisher();
+
+    /* Publishes a new tree, which the publisher then owns. Readers that start after this
+        get the new tree. The old one is retired and deleted once no reader can still be
+        using it */
+    void publish(DecisionNode* tree);
+
+    // Deletes retired trees no reader can still be using. Publishing does this as well
+    void reclaim();
+
+    // Number of trees retired but not yet deleted
+    unsigned int getRetiredCount() const;
+
+    // Claims a reader slot, for the calling thread to read with. Throws if all are taken
+    unsigned short registerReader();
+
+    // Releases a reader slot. The thread must not be reading with it
+    void unregisterReader(unsigned short readerId);
+
+    /* Gives a reader the current tree for as long as the guard exists. The tree is
+        NULL if nothing has been published yet */
+    class ReadGuard {
+    public:
+        ReadGuard(const TreePublisher& publisher, unsigned short readerId);
+        ~ReadGuard();
+
+        const DecisionNode* getTree() const;
+
+    private:
+        const TreePublisher& _publisher;
+        unsigned short _readerId;
+        const DecisionNode* _tree;
+
+        // Prohibit copying, which would end the read twice
+        ReadGuard(const ReadGuard& other);
+        ReadGuard& operator=(const ReadGuard& other);
+    };
+
+private:
+    // Atomics and the writer lock. Defined in the source file, so clients don't need the headers
+    struct PublisherState;
+    PublisherState* _state;
+
+    // Starts and ends a read for a reader slot. Starting returns the current tree
+    const DecisionNode* startRead(unsigned short readerId) const;
+    void endRead(unsigned short readerId) const;
+
+    // Deletes retired trees no reader can still be using. The writer lock must be held
+    void reclaimLocked();
+
+    // Prohibit copying, which would delete the trees twice
+    TreePublisher(const TreePublisher& other);
+    TreePublisher& operator=(const TreePublisher& other);
+};
+
+inline TreePublisher::ReadGuard::ReadGuard(const TreePublisher& publisher, unsigned short readerId)
+    : _publisher(publisher), _readerId(readerId), _tree(publisher.startRead(readerId))
+{
+    // All in the initialization list
+}
+
+inline TreePublisher::ReadGuard::~ReadGuard()
+{
+    _publisher.endRead(_readerId);
+}
+
+inline const DecisionNode* TreePublisher::ReadGuard::getTree() const
+{
+    return _tree;
+}
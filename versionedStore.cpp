@@ -0,0 +1,239 @@
+/* This file is part of NFLdecisionTree. It creates decision trees to classify
+    situations within NFL football games, and displays the plays historically
+    called in those situations given a set of opponents.
+
+    Copyright (C) 2013   Ezra Erb
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 3 as published
+    by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    I'd appreciate a note if you find this program useful or make
+    updates. Please contact me through LinkedIn (my profile also has
+    a link to the code depository)
+*/
+#include<vector>
+#include<ostream>
+#include<mutex>
+#include"singlePlay.h"
+#include"playIndexSet.h"
+#include"playStats.h"
+#include"allocTracker.h"
+#include"dataStore.h" // Needed for PlayBatch
+#include"versionedStore.h"
+#include"baseException.h"
+
+using std::vector;
+using std::mutex;
+using std::lock_guard;
+
+/* A published version of the store. The indexes only refer to plays inserted before it
+    was published, so it never changes. Pins count the snapshots using it */
+struct VersionedStore::Version {
+    unsigned long long number;
+    unsigned long playCount;
+    PlayIndexSet indexes;
+    OverallSummaryData summaryData;
+    unsigned int pins;
+};
+
+struct VersionedStore::StoreState {
+    // Guards the current version, the retired versions and all pin counts
+    mutex versionLock;
+    Version* currentVersion;
+    vector<Version*> retiredVersions;
+
+    // Serializes inserting and publishing
+    mutex writerLock;
+};
+
+// Creates an empty store. Its first version, zero, has no plays
+VersionedStore::VersionedStore()
+    : _state(new StoreState()), _chunks(), _playCount(0),
+      _downIndex(SinglePlay::getCategoryCount(SinglePlay::down_number)),
+      _distanceNeededIndex(SinglePlay::getCategoryCount(SinglePlay::distance_needed)),
+      _fieldLocationIndex(SinglePlay::getCategoryCount(SinglePlay::field_location)),
+      _timeRemainingIndex(SinglePlay::getCategoryCount(SinglePlay::time_remaining)),
+      _scoreDifferentialIndex(SinglePlay::getCategoryCount(SinglePlay::score_differential))
+{
+    _state->currentVersion = new Version();
+    _state->currentVersion->number = 0;
+    _state->currentVersion->playCount = 0;
+    _state->currentVersion->pins = 0;
+}
+
+/* Destructor. Deletes the plays and every version.
+    WARNING: No snapshot may still exist */
+VersionedStore::~VersionedStore()
+{
+    delete _state->currentVersion;
+    vector<Version*>::iterator version;
+    for (version = _state->retiredVersions.begin(); version != _state->retiredVersions.end(); version++)
+        delete *version;
+    delete _state;
+    vector<PlayVector*>::iterator chunk;
+    for (chunk = _chunks.begin(); chunk != _chunks.end(); chunk++)
+        delete *chunk;
+}
+
+/* Inserts every play of a batch. They are not seen by readers until the next
+    publish(). The batch is unchanged */
+void VersionedStore::insertPlays(const PlayBatch& batch)
+{
+    lock_guard<mutex> lock(_state->writerLock);
+    ALLOC_SCOPE(data_store_memory);
+    unsigned long batchPlay = 0;
+    while (batchPlay < batch.size()) {
+        /* Start a new chunk when the last is full. Chunks are reserved at full size,
+            so adding plays never moves the ones readers may be using */
+        if (_chunks.empty() || (_chunks.back()->size() == ChunkSize)) {
+            _chunks.push_back(new PlayVector());
+            _chunks.back()->reserve(ChunkSize);
+        }
+        PlayVector& chunk = *_chunks.back();
+        unsigned long chunkStart = chunk.size();
+        unsigned long count = ChunkSize - chunkStart;
+        if (count > batch.size() - batchPlay)
+            count = batch.size() - batchPlay;
+        batch.appendPlays(batchPlay, count, _playCount, chunk);
+
+        // Index the new plays. Versions published later get copies
+        PlayIterator play;
+        for (play = chunk.begin() + chunkStart; play != chunk.end(); play++) {
+            _downIndex[(unsigned short)play->getDown()].push_back(play);
+            _distanceNeededIndex[(unsigned short)play->getDistanceNeeded()].push_back(play);
+            _fieldLocationIndex[(unsigned short)play->getFieldLocation()].push_back(play);
+            _timeRemainingIndex[(unsigned short)play->getTimeRemaining()].push_back(play);
+            _scoreDifferentialIndex[(unsigned short)play->getScoreDifferential()].push_back(play);
+        }
+        batchPlay += count;
+        _playCount += count;
+    } // Loop through chunks the batch fills
+}
+
+/* Publishes a version holding every play inserted so far, which readers that start
+    afterward see, and returns its number. Builds the indexes and summary data of the
+    new version, so it takes about as long as DataStore::buildIndexes() */
+unsigned long long VersionedStore::publish()
+{
+    lock_guard<mutex> writerLock(_state->writerLock);
+    ALLOC_SCOPE(index_memory);
+
+    // Build the new version before taking the version lock, so readers never wait for it
+    Version* newVersion = new Version();
+    newVersion->playCount = _playCount;
+    newVersion->pins = 0;
+    if (_playCount) {
+        newVersion->indexes.setIndexes(_downIndex, _distanceNeededIndex, _fieldLocationIndex,
+                                       _timeRemainingIndex, _scoreDifferentialIndex);
+        PlaySummaryFactory::buildSummaryData(newVersion->indexes, newVersion->summaryData);
+    }
+
+    /* Replace the current version. It is deleted now if no snapshot uses it, otherwise
+        retired until the last one goes. Deleting happens outside the lock, since freeing
+        the indexes takes a while */
+    Version* unusedVersion = NULL;
+    unsigned long long newNumber;
+    {
+        lock_guard<mutex> versionLock(_state->versionLock);
+        Version* oldVersion = _state->currentVersion;
+        newNumber = oldVersion->number + 1;
+        newVersion->number = newNumber;
+        _state->currentVersion = newVersion;
+        if (oldVersion->pins)
+            _state->retiredVersions.push_back(oldVersion);
+        else
+            unusedVersion = oldVersion;
+    }
+    delete unusedVersion;
+    return newNumber;
+}
+
+// Number of plays inserted, published or not
+unsigned long VersionedStore::getInsertedCount() const
+{
+    lock_guard<mutex> lock(_state->writerLock);
+    return _playCount;
+}
+
+// Number of versions no longer current but still pinned by snapshots
+unsigned int VersionedStore::getRetiredCount() const
+{
+    lock_guard<mutex> lock(_state->versionLock);
+    return _state->retiredVersions.size();
+}
+
+// Pins the current version and returns it
+VersionedStore::Version* VersionedStore::pinCurrent() const
+{
+    lock_guard<mutex> lock(_state->versionLock);
+    _state->currentVersion->pins++;
+    return _state->currentVersion;
+}
+
+// Unpins a version, deleting it if it is no longer current and has no other snapshots
+void VersionedStore::unpin(Version* version) const
+{
+    bool unused = false;
+    {
+        lock_guard<mutex> lock(_state->versionLock);
+        version->pins--;
+        if ((!version->pins) && (version != _state->currentVersion)) {
+            vector<Version*>::iterator retired;
+            for (retired = _state->retiredVersions.begin(); retired != _state->retiredVersions.end(); retired++)
+                if (*retired == version) {
+                    _state->retiredVersions.erase(retired);
+                    break;
+                }
+            unused = true;
+        }
+    }
+    if (unused)
+        delete version;
+}
+
+// Pins the current version of a store
+VersionedStore::Snapshot::Snapshot(const VersionedStore& store)
+    : _store(store), _version(store.pinCurrent())
+{
+    // All in the initialization list
+}
+
+// Destructor. Unpins the version, deleting it if it is no longer current
+VersionedStore::Snapshot::~Snapshot()
+{
+    _store.unpin(_version);
+}
+
+unsigned long long VersionedStore::Snapshot::getVersion() const
+{
+    return _version->number;
+}
+
+// Number of plays in the version
+unsigned long VersionedStore::Snapshot::getPlayCount() const
+{
+    return _version->playCount;
+}
+
+/* Returns index data for the version. A COPY is returned so the client can
+    manipulate it as plays are divided up */
+PlayIndexSet VersionedStore::Snapshot::getIndexes() const
+{
+    ALLOC_SCOPE(index_memory);
+    return _version->indexes;
+}
+
+// Summary data of all plays in the version
+const OverallSummaryData& VersionedStore::Snapshot::getPlaySummaryStats() const
+{
+    return _version->summaryData;
+}
@@ -0,0 +1,133 @@
+/* This file is part of NFLdecisionTree. It creates decision trees to classify
+    situations within NFL football games, and displays the plays historically
+    called in those situations given a set of opponents.
+
+    Copyright (C) 2013   Ezra Erb
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 3 as published
+    by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    I'd appreciate a note if you find this program useful or make
+    updates. Please contact me through LinkedIn (my profile also has
+    a link to the code depository)
+*/
+
+/* This class holds plays that keep arriving, a live feed during a game for example,
+    while trees are built from them. A data store can't do this: indexes are built once
+    all plays are in, and adding plays after can move the ones already indexed.
+
+    Readers work from versions. Publishing makes a new version from every play inserted
+    so far, with its own indexes and summary data, and readers that start after it see
+    the new version. A reader pins the version it starts with in a Snapshot, and the
+    version stays exactly as it was for as long as the snapshot exists, however many
+    plays are inserted and versions published in the meantime. A version no longer
+    current is deleted when its last snapshot goes away.
+
+    Plays are held in chunks of fixed size which are never moved or reallocated, so the
+    indexes of every version stay valid while more plays are added. The plays of a version
+    are never changed, only plays after them are written, so readers need no locks to use
+    them. Taking and releasing a snapshot, and replacing the current version, take a lock
+    for a few instructions each; nothing holds it while building or inserting. A tree
+    build never blocks inserts, and inserts never change a build in progress.
+
+    Inserting and publishing must be done by one thread at a time. They are serialized
+    with a lock between themselves */
+using std::vector; // Header deliberately not included, clients make extensive use of it
+
+class VersionedStore {
+    // A published version of the store. Defined in the source file, like the state below
+    struct Version;
+
+public:
+    // Plays in each chunk. A chunk never grows beyond this, so it is never reallocated
+    static const unsigned long ChunkSize = 8192;
+
+    // Creates an empty store. Its first version, zero, has no plays
+    VersionedStore();
+
+    /* Destructor. Deletes the plays and every version.
+        WARNING: No snapshot may still exist */
+    ~VersionedStore();
+
+    /* Inserts every play of a batch. They are not seen by readers until the next
+        publish(). The batch is unchanged */
+    void insertPlays(const PlayBatch& batch);
+
+    /* Publishes a version holding every play inserted so far, which readers that start
+        afterward see, and returns its number. Builds the indexes and summary data of the
+        new version, so it takes about as long as DataStore::buildIndexes() */
+    unsigned long long publish();
+
+    // Number of plays inserted, published or not
+    unsigned long getInsertedCount() const;
+
+    // Number of versions no longer current but still pinned by snapshots
+    unsigned int getRetiredCount() const;
+
+    /* A version of the store, pinned for as long as the snapshot exists. Its indexes and
+        summary data are used exactly like those of a data store */
+    class Snapshot {
+    public:
+        // Pins the current version of a store
+        explicit Snapshot(const VersionedStore& store);
+
+        // Destructor. Unpins the version, deleting it if it is no longer current
+        ~Snapshot();
+
+        unsigned long long getVersion() const;
+
+        // Number of plays in the version
+        unsigned long getPlayCount() const;
+
+        /* Returns index data for the version. A COPY is returned so the client can
+            manipulate it as plays are divided up */
+        PlayIndexSet getIndexes() const;
+
+        // Summary data of all plays in the version
+        const OverallSummaryData& getPlaySummaryStats() const;
+
+    private:
+        const VersionedStore& _store;
+        Version* _version;
+
+        // Prohibit copying, which would unpin the version twice
+        Snapshot(const Snapshot& other);
+        Snapshot& operator=(const Snapshot& other);
+    };
+
+private:
+    // Versions, the current version and the lock for it. Defined in the source file, so clients don't need the headers
+    struct StoreState;
+    StoreState* _state;
+
+    // Plays inserted so far, in chunks that are never reallocated
+    vector<PlayVector*> _chunks;
+    unsigned long _playCount;
+
+    /* Indexes of every play inserted so far. Each version gets a copy when published,
+        so plays are only indexed once */
+    CategoryIndex _downIndex;
+    CategoryIndex _distanceNeededIndex;
+    CategoryIndex _fieldLocationIndex;
+    CategoryIndex _timeRemainingIndex;
+    CategoryIndex _scoreDifferentialIndex;
+
+    // Pins the current version and returns it
+    Version* pinCurrent() const;
+
+    // Unpins a version, deleting it if it is no longer current and has no other snapshots
+    void unpin(Version* version) const;
+
+    // Prohibit copying, which would delete the plays twice
+    VersionedStore(const VersionedStore& other);
+    VersionedStore& operator=(const VersionedStore& other);
+};